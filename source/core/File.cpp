@@ -1,5 +1,7 @@
 #include "File.h"
 
+#include "Core/memory/MemoryTracker.h"
+
 #include <cstdio>
 #include <cassert>
 #include <memory>
@@ -22,7 +24,8 @@ namespace Core
 			}
 		}
 
-		delete m_Buffer;
+		MemoryTracker::Get().OnFree(m_Buffer);
+		delete[] m_Buffer;
 		m_Buffer = nullptr;
 	}
 
@@ -48,6 +51,7 @@ namespace Core
 			if(FILE* hFile = fopen(m_Filepath, buff))
 			{
 				fwrite(m_Buffer, 1, m_FileSize, hFile);
+				fclose(hFile);
 			}
 		}
 	}
@@ -81,8 +85,10 @@ namespace Core
 		{
 			const uint32 newSize = static_cast<uint32>(static_cast<float>(m_FileSize + (element_size * nof_elements)) * 1.5f);
 			char* buffer = new char[newSize];
+			MemoryTracker::Get().OnAllocate(buffer, newSize, EMemoryTag_Assets);
 			memcpy(&buffer[0], &m_Buffer[0], m_FileSize);
 			m_AllocatedSize = newSize;
+			MemoryTracker::Get().OnFree(m_Buffer);
 			delete[] m_Buffer;
 			m_Buffer = nullptr;
 			m_Buffer = buffer;
@@ -107,6 +113,7 @@ namespace Core
 	{
 		constexpr int allocSize = 1024;
 		m_Buffer = new char[allocSize];
+		MemoryTracker::Get().OnAllocate(m_Buffer, allocSize, EMemoryTag_Assets);
 		m_AllocatedSize = allocSize;
 	}
 
@@ -119,9 +126,10 @@ namespace Core
 			rewind(hFile);
 
 			m_Buffer = new char[m_FileSize];
-			memset(m_Buffer, 0, m_FileSize);
+			MemoryTracker::Get().OnAllocate(m_Buffer, m_FileSize, EMemoryTag_Assets);
 
-			fread(m_Buffer, 1, m_FileSize, hFile);
+			// fread fills the buffer, a short read leaves the size at what was read
+			m_FileSize = (uint32)fread(m_Buffer, 1, m_FileSize, hFile);
 			fclose(hFile);
 		}
 	}
@@ -0,0 +1,39 @@
+#include "FixedTimestep.h"
+
+#include "logger/Debug.h"
+
+namespace Core
+{
+	void FixedTimestep::Init(float step, uint32 maxSteps)
+	{
+		ASSERT(step > 0.f, "Fixed timestep has to be positive!");
+		ASSERT(maxSteps > 0, "Fixed timestep needs at least one step per frame!");
+		m_Step = step;
+		m_MaxSteps = maxSteps;
+		m_Accumulator = 0.0;
+		m_DroppedTime = 0.0;
+		m_StepCount = 0;
+	}
+
+	uint32 FixedTimestep::Advance(float dt)
+	{
+		m_Accumulator += dt;
+
+		const double maxTime = (double)m_Step * m_MaxSteps;
+		if(m_Accumulator > maxTime)
+		{
+			m_DroppedTime += m_Accumulator - maxTime;
+			m_Accumulator = maxTime;
+		}
+
+		uint32 steps = 0;
+		while(m_Accumulator >= m_Step)
+		{
+			m_Accumulator -= m_Step;
+			steps++;
+		}
+		m_StepCount += steps;
+		return steps;
+	}
+
+}; // namespace Core
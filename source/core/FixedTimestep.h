@@ -0,0 +1,47 @@
+#pragma once
+#include "Core/Types.h"
+
+/*
+	Runs the simulation at a fixed rate no matter how fast frames are rendered.
+
+	The frame time goes into an accumulator and is taken out again in whole steps. After the steps the accumulator
+	holds the part of a step the render frame is ahead of the last simulated state, GetAlpha is that fraction. The
+	renderer blends the last two simulated states by it, so motion stays smooth when the frame rate and the step
+	rate don't line up.
+
+	A frame that took too long would need more and more steps to catch up, which makes the next frame take longer
+	still. No more than maxSteps are run per frame, the time beyond that is dropped and the simulation slows down
+	instead.
+*/
+
+namespace Core
+{
+	class FixedTimestep
+	{
+	public:
+		FixedTimestep() = default;
+		~FixedTimestep() = default;
+
+		void Init(float step, uint32 maxSteps);
+
+		/* adds the frame time, returns how many steps to simulate this frame */
+		uint32 Advance(float dt);
+
+		float GetStep() const { return m_Step; }
+
+		/* between 0 and 1, how far past the last simulated state the frame is */
+		float GetAlpha() const { return (float)(m_Accumulator / m_Step); }
+
+		uint64 GetStepCount() const { return m_StepCount; }
+		float GetDroppedTime() const { return (float)m_DroppedTime; }
+
+	private:
+		// the accumulator runs for the whole session, a double keeps it from drifting
+		double m_Accumulator = 0.0;
+		double m_DroppedTime = 0.0;
+		float m_Step = 1.f / 60.f;
+		uint32 m_MaxSteps = 4;
+		uint64 m_StepCount = 0;
+	};
+
+}; // namespace Core
@@ -0,0 +1,501 @@
+#include "IoService.h"
+
+#include "logger/Debug.h"
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef __linux__
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#endif
+
+namespace Core
+{
+#ifdef __linux__
+	/*
+		The rings are shared with the kernel, the tail of the submission ring and the head of the completion ring
+		are ours and published with release stores, the other ends are the kernel's and read with acquire loads.
+		Every read in flight owns a slot, the slot index is the user data of its submission.
+	*/
+	struct IoService::IoRing
+	{
+		~IoRing()
+		{
+			if(m_Sqes)
+				munmap(m_Sqes, m_SqesSize);
+			if(m_CqRing && m_CqRing != m_SqRing)
+				munmap(m_CqRing, m_CqRingSize);
+			if(m_SqRing)
+				munmap(m_SqRing, m_SqRingSize);
+			if(m_Fd >= 0)
+				close(m_Fd);
+		}
+
+		bool Init(uint32 depth)
+		{
+			io_uring_params params;
+			memset(&params, 0, sizeof(params));
+			m_Fd = (int)syscall(__NR_io_uring_setup, depth, &params);
+			if(m_Fd < 0)
+				return false;
+
+			m_SqRingSize = params.sq_off.array + params.sq_entries * sizeof(uint32);
+			m_CqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+			const bool singleMap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+			if(singleMap)
+				m_SqRingSize = m_CqRingSize = m_SqRingSize > m_CqRingSize ? m_SqRingSize : m_CqRingSize;
+
+			m_SqRing = Map(m_SqRingSize, IORING_OFF_SQ_RING);
+			m_CqRing = singleMap ? m_SqRing : Map(m_CqRingSize, IORING_OFF_CQ_RING);
+			m_SqesSize = params.sq_entries * sizeof(io_uring_sqe);
+			m_Sqes = (io_uring_sqe*)Map(m_SqesSize, IORING_OFF_SQES);
+			if(!m_SqRing || !m_CqRing || !m_Sqes)
+				return false;
+
+			m_SqTail = (uint32*)(m_SqRing + params.sq_off.tail);
+			m_SqMask = *(uint32*)(m_SqRing + params.sq_off.ring_mask);
+			m_SqArray = (uint32*)(m_SqRing + params.sq_off.array);
+			m_CqHead = (uint32*)(m_CqRing + params.cq_off.head);
+			m_CqTail = (uint32*)(m_CqRing + params.cq_off.tail);
+			m_CqMask = *(uint32*)(m_CqRing + params.cq_off.ring_mask);
+			m_Cqes = (io_uring_cqe*)(m_CqRing + params.cq_off.cqes);
+			m_Entries = params.sq_entries;
+			return true;
+		}
+
+		uint8* Map(size_t size, uint64 offset)
+		{
+			void* memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_Fd, (off_t)offset);
+			return memory == MAP_FAILED ? nullptr : (uint8*)memory;
+		}
+
+		/* queued until the next Enter */
+		void PrepareRead(int fd, uint64 offset, void* buffer, uint32 size, iovec* vector, uint64 userData)
+		{
+			vector->iov_base = buffer;
+			vector->iov_len = size;
+
+			const uint32 tail = *m_SqTail;
+			const uint32 index = tail & m_SqMask;
+			io_uring_sqe* sqe = &m_Sqes[index];
+			memset(sqe, 0, sizeof(io_uring_sqe));
+			sqe->opcode = IORING_OP_READV;
+			sqe->fd = fd;
+			sqe->off = offset;
+			sqe->addr = (uint64)vector;
+			sqe->len = 1;
+			sqe->user_data = userData;
+			m_SqArray[index] = index;
+			__atomic_store_n(m_SqTail, tail + 1, __ATOMIC_RELEASE);
+		}
+
+		/* submits what was prepared and blocks until at least one read completed, returns 0 or the errno */
+		int Enter(uint32 submitCount)
+		{
+			// a failed call submitted nothing, what the kernel did not take stays in the ring for the next call
+			m_Unsubmitted += submitCount;
+			for(;;)
+			{
+				const long result =
+					syscall(__NR_io_uring_enter, m_Fd, m_Unsubmitted, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+				if(result >= 0)
+				{
+					m_Unsubmitted -= (uint32)result;
+					return 0;
+				}
+				if(errno != EINTR && errno != EAGAIN)
+					return errno;
+			}
+		}
+
+		template <typename Function>
+		void Reap(Function&& function)
+		{
+			uint32 head = *m_CqHead;
+			const uint32 tail = __atomic_load_n(m_CqTail, __ATOMIC_ACQUIRE);
+			for(; head != tail; ++head)
+			{
+				const io_uring_cqe& cqe = m_Cqes[head & m_CqMask];
+				function(cqe.user_data, (int64)cqe.res);
+			}
+			__atomic_store_n(m_CqHead, head, __ATOMIC_RELEASE);
+		}
+
+		int m_Fd = -1;
+		uint32 m_Entries = 0;
+		uint32 m_Unsubmitted = 0;
+		uint8* m_SqRing = nullptr;
+		uint8* m_CqRing = nullptr;
+		size_t m_SqRingSize = 0;
+		size_t m_CqRingSize = 0;
+		io_uring_sqe* m_Sqes = nullptr;
+		size_t m_SqesSize = 0;
+
+		uint32* m_SqTail = nullptr;
+		uint32* m_SqArray = nullptr;
+		uint32 m_SqMask = 0;
+		uint32* m_CqHead = nullptr;
+		uint32* m_CqTail = nullptr;
+		io_uring_cqe* m_Cqes = nullptr;
+		uint32 m_CqMask = 0;
+	};
+#else
+	struct IoService::IoRing
+	{
+	};
+#endif
+
+	namespace
+	{
+		/* direct reads only come back short at the end of the file, the rest of it would be an unaligned read */
+		bool IsReadAtEnd(const IoRequest& request, uint32 total)
+		{
+			return (request.m_File.m_Flags & EIoOpen_Unbuffered) && total % IoService::s_UnbufferedAlignment != 0;
+		}
+	}; // namespace
+
+	IoService::IoService() = default;
+
+	IoService::~IoService() { Destroy(); }
+
+	void IoService::Init(uint32 queueDepth, uint32 workerCount, bool useIoUring)
+	{
+		ASSERT(m_Threads.empty(), "IoService is already running!");
+		m_Quit = false;
+		m_RingFailed = false;
+		m_QueueDepth = queueDepth > 0 ? queueDepth : 1;
+
+#ifdef __linux__
+		if(useIoUring)
+		{
+			m_Ring = std::make_unique<IoRing>();
+			if(m_Ring->Init(m_QueueDepth))
+			{
+				m_QueueDepth = m_QueueDepth < m_Ring->m_Entries ? m_QueueDepth : m_Ring->m_Entries;
+				m_Threads.emplace_back(&IoService::RingLoop, this);
+				return;
+			}
+			LOG_MESSAGE("io_uring is not available, errno %d, falling back to threads", errno);
+			m_Ring.reset();
+		}
+#endif
+
+		// more threads than reads in flight would only wait
+		workerCount = workerCount > 0 ? workerCount : 1;
+		workerCount = workerCount < m_QueueDepth ? workerCount : m_QueueDepth;
+		for(uint32 i = 0; i < workerCount; ++i)
+			m_Threads.emplace_back(&IoService::WorkerLoop, this);
+	}
+
+	void IoService::Destroy()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_Lock);
+			m_Quit = true;
+		}
+		m_WakeUp.notify_all();
+
+		for(std::thread& thread : m_Threads)
+			thread.join();
+		m_Threads.clear();
+		m_Ring.reset();
+	}
+
+	void IoService::Submit(const IoRequest* requests, uint32 count, IoBatch* batch)
+	{
+		if(batch)
+			batch->m_Pending += count;
+
+		{
+			std::lock_guard<std::mutex> lock(m_Lock);
+			ASSERT(!m_Threads.empty(), "Submitting to an IoService that is not running!");
+			for(uint32 i = 0; i < count; ++i)
+			{
+				const IoRequest& request = requests[i];
+				if(request.m_File.m_Flags & EIoOpen_Unbuffered)
+				{
+					ASSERT((uintptr_t)request.m_Buffer % s_UnbufferedAlignment == 0, "Unaligned unbuffered read!");
+					ASSERT(request.m_Offset % s_UnbufferedAlignment == 0, "Unaligned unbuffered read!");
+					ASSERT(request.m_Size % s_UnbufferedAlignment == 0, "Unaligned unbuffered read!");
+				}
+
+				PendingRead read;
+				read.m_Request = request;
+				read.m_Batch = batch;
+				m_Pending[request.m_Priority].push_back(std::move(read));
+			}
+		}
+		m_WakeUp.notify_all();
+	}
+
+	void IoService::Wait(const IoBatch& batch)
+	{
+		std::unique_lock<std::mutex> lock(m_Lock);
+		m_Completed.wait(lock, [&batch]() { return batch.IsDone(); });
+	}
+
+	bool IoService::HasPending() const
+	{
+		for(const std::deque<PendingRead>& queue : m_Pending)
+		{
+			if(!queue.empty())
+				return true;
+		}
+		return false;
+	}
+
+	bool IoService::PopPending(PendingRead* read)
+	{
+		for(std::deque<PendingRead>& queue : m_Pending)
+		{
+			if(queue.empty())
+				continue;
+			*read = std::move(queue.front());
+			queue.pop_front();
+			return true;
+		}
+		return false;
+	}
+
+	void IoService::Complete(PendingRead& read, int64 result)
+	{
+		if(read.m_Request.m_Callback)
+			read.m_Request.m_Callback(read.m_Request, result);
+
+		if(!read.m_Batch)
+			return;
+
+		if(result < 0)
+			read.m_Batch->m_Failed++;
+
+		// under the lock, a waiter can not miss the notify between checking the batch and going to sleep
+		std::lock_guard<std::mutex> lock(m_Lock);
+		read.m_Batch->m_Pending--;
+		m_Completed.notify_all();
+	}
+
+	void IoService::WorkerLoop()
+	{
+		for(;;)
+		{
+			PendingRead read;
+			{
+				std::unique_lock<std::mutex> lock(m_Lock);
+				m_WakeUp.wait(lock, [this]() {
+					return HasPending() ? m_InFlight < m_QueueDepth : m_Quit;
+				});
+				if(!PopPending(&read))
+					return; // quitting and everything is done
+				m_InFlight++;
+			}
+
+			Complete(read, ReadBlocking(read.m_Request));
+
+			{
+				std::lock_guard<std::mutex> lock(m_Lock);
+				m_InFlight--;
+			}
+			m_WakeUp.notify_one();
+		}
+	}
+
+	void IoService::RingLoop()
+	{
+#ifdef __linux__
+		std::vector<PendingRead> slots(m_QueueDepth);
+		std::vector<uint32> slotRead(m_QueueDepth, 0); // bytes earlier short reads of the slot already got
+		std::vector<iovec> vectors(m_QueueDepth);
+		std::vector<uint32> freeSlots;
+		std::vector<uint32> resubmits;
+		for(uint32 i = 0; i < m_QueueDepth; ++i)
+			freeSlots.push_back(m_QueueDepth - 1 - i);
+
+		auto prepare = [&](uint32 slot) {
+			const IoRequest& request = slots[slot].m_Request;
+			const uint32 done = slotRead[slot];
+			m_Ring->PrepareRead((int)request.m_File.m_Handle, request.m_Offset + done, (uint8*)request.m_Buffer + done,
+								request.m_Size - done, &vectors[slot], slot);
+		};
+		auto finish = [&](uint32 slot, int64 result) {
+			Complete(slots[slot], result);
+			slots[slot] = PendingRead();
+			slotRead[slot] = 0;
+			freeSlots.push_back(slot);
+		};
+
+		for(;;)
+		{
+			// like pread a read can come back short before the end of the file, the rest goes out again first
+			uint32 submitCount = (uint32)resubmits.size();
+			for(uint32 slot : resubmits)
+				prepare(slot);
+			resubmits.clear();
+
+			{
+				// with reads in flight new requests are picked up when the next one completes
+				std::unique_lock<std::mutex> lock(m_Lock);
+				if(freeSlots.size() == m_QueueDepth)
+				{
+					m_WakeUp.wait(lock, [this]() { return m_Quit || HasPending(); });
+					if(!HasPending())
+						return;
+				}
+
+				while(!freeSlots.empty() && PopPending(&slots[freeSlots.back()]))
+				{
+					const uint32 slot = freeSlots.back();
+					freeSlots.pop_back();
+					prepare(slot);
+					submitCount++;
+				}
+			}
+
+			const int error = m_Ring->Enter(submitCount);
+			m_Ring->Reap([&](uint64 userData, int64 result) {
+				const uint32 slot = (uint32)userData;
+				const IoRequest& request = slots[slot].m_Request;
+				if(result > 0 && slotRead[slot] + result < request.m_Size &&
+				   !IsReadAtEnd(request, slotRead[slot] + (uint32)result))
+				{
+					slotRead[slot] += (uint32)result;
+					resubmits.push_back(slot);
+					return;
+				}
+				finish(slot, result < 0 ? result : slotRead[slot] + result);
+			});
+
+			if(error != 0)
+			{
+				// nothing more comes out of the ring, what it still holds fails and a thread takes over
+				LOG_MESSAGE("io_uring_enter failed, errno %d, falling back to a thread", error);
+				std::vector<bool> isFree(m_QueueDepth, false);
+				for(uint32 slot : freeSlots)
+					isFree[slot] = true;
+				for(uint32 slot = 0; slot < m_QueueDepth; ++slot)
+				{
+					if(!isFree[slot])
+						finish(slot, -(int64)error);
+				}
+				m_RingFailed = true;
+				WorkerLoop();
+				return;
+			}
+		}
+#endif
+	}
+
+#ifdef _WIN32
+	IoFile IoService::OpenFile(const char* filepath, uint32 flags)
+	{
+		// Windows runs the reads of a synchronous handle one after the other, whatever thread they come from
+		DWORD attributes = FILE_FLAG_OVERLAPPED;
+		if(flags & EIoOpen_Unbuffered)
+			attributes |= FILE_FLAG_NO_BUFFERING;
+		HANDLE handle =
+			CreateFileA(filepath, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, attributes, nullptr);
+
+		IoFile file;
+		file.m_Handle = (intptr_t)handle;
+		file.m_Flags = flags;
+		return file;
+	}
+
+	void IoService::CloseFile(IoFile file)
+	{
+		if(file.IsValid())
+			CloseHandle((HANDLE)file.m_Handle);
+	}
+
+	uint64 IoService::GetFileSize(IoFile file)
+	{
+		LARGE_INTEGER size;
+		if(!file.IsValid() || !GetFileSizeEx((HANDLE)file.m_Handle, &size))
+			return 0;
+		return (uint64)size.QuadPart;
+	}
+
+	int64 IoService::ReadBlocking(const IoRequest& request)
+	{
+		// the handle is overlapped, every read waits on an event of its own so the reads of the threads overlap
+		OVERLAPPED overlapped = {};
+		overlapped.Offset = (DWORD)request.m_Offset;
+		overlapped.OffsetHigh = (DWORD)(request.m_Offset >> 32);
+		overlapped.hEvent = CreateEventA(nullptr, TRUE, FALSE, nullptr);
+		if(!overlapped.hEvent)
+			return -(int64)GetLastError();
+
+		const HANDLE handle = (HANDLE)request.m_File.m_Handle;
+		DWORD bytesRead = 0;
+		BOOL success = ReadFile(handle, request.m_Buffer, request.m_Size, nullptr, &overlapped);
+		if(success || GetLastError() == ERROR_IO_PENDING)
+			success = GetOverlappedResult(handle, &overlapped, &bytesRead, TRUE);
+		const DWORD error = success ? ERROR_SUCCESS : GetLastError();
+		CloseHandle(overlapped.hEvent);
+
+		if(!success)
+			return error == ERROR_HANDLE_EOF ? 0 : -(int64)error;
+		return (int64)bytesRead;
+	}
+#else
+	IoFile IoService::OpenFile(const char* filepath, uint32 flags)
+	{
+		int openFlags = O_RDONLY | O_CLOEXEC;
+#ifdef O_DIRECT
+		if(flags & EIoOpen_Unbuffered)
+			openFlags |= O_DIRECT;
+#endif
+
+		IoFile file;
+		file.m_Handle = open(filepath, openFlags);
+		file.m_Flags = flags;
+		return file;
+	}
+
+	void IoService::CloseFile(IoFile file)
+	{
+		if(file.IsValid())
+			close((int)file.m_Handle);
+	}
+
+	uint64 IoService::GetFileSize(IoFile file)
+	{
+		struct stat info;
+		if(!file.IsValid() || fstat((int)file.m_Handle, &info) != 0)
+			return 0;
+		return (uint64)info.st_size;
+	}
+
+	int64 IoService::ReadBlocking(const IoRequest& request)
+	{
+		// pread can return less than asked for before the end of the file, it is read until it returns 0
+		uint8* buffer = (uint8*)request.m_Buffer;
+		uint32 total = 0;
+		while(total < request.m_Size)
+		{
+			const ssize_t result = pread((int)request.m_File.m_Handle, buffer + total, request.m_Size - total,
+										 (off_t)(request.m_Offset + total));
+			if(result < 0 && errno == EINTR)
+				continue;
+			if(result < 0)
+				return -(int64)errno;
+			if(result == 0)
+				break;
+			total += (uint32)result;
+			if(IsReadAtEnd(request, total))
+				break;
+		}
+		return total;
+	}
+#endif
+
+}; // namespace Core
@@ -0,0 +1,136 @@
+#pragma once
+#include "Types.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+	Asynchronous reads of file ranges into memory owned by the caller.
+
+	Requests wait in one queue per priority and are handed to the backend highest priority first, with at most
+	the queue depth in flight at once. On Linux the backend is an io_uring that a single thread submits to and
+	reaps, elsewhere (or when the kernel refuses io_uring) a few threads do blocking positional reads. If the ring
+	fails later its reads fail and its thread goes on with blocking reads. On Windows the files are opened overlapped,
+	the reads of the threads do not queue up behind each other on the handle. Callbacks run on those threads, the
+	buffer of a request has to stay alive until its callback has run.
+
+	Files opened unbuffered bypass the OS cache, their buffers, offsets and sizes have to be multiples of
+	s_UnbufferedAlignment.
+*/
+
+namespace Core
+{
+	enum EIoPriority
+	{
+		EIoPriority_High,
+		EIoPriority_Normal,
+		EIoPriority_Low,
+		EIoPriority_Count
+	};
+
+	enum EIoOpen
+	{
+		EIoOpen_Default = 0,
+		EIoOpen_Unbuffered = 1, // O_DIRECT / FILE_FLAG_NO_BUFFERING
+	};
+
+	struct IoFile
+	{
+		intptr_t m_Handle = -1; // a file descriptor or a HANDLE
+		uint32 m_Flags = 0;
+
+		bool IsValid() const { return m_Handle != -1; }
+	};
+
+	/* counts the requests of one or more submits until they completed, it has to outlive them */
+	class IoBatch
+	{
+	public:
+		bool IsDone() const { return m_Pending.load() == 0; }
+		uint32 GetFailedCount() const { return m_Failed.load(); }
+
+	private:
+		friend class IoService;
+		std::atomic<uint32> m_Pending{ 0 };
+		std::atomic<uint32> m_Failed{ 0 };
+	};
+
+	struct IoRequest
+	{
+		/* result is the number of bytes read, less than the size at the end of the file, negative on errors */
+		typedef std::function<void(const IoRequest& request, int64 result)> Callback;
+
+		IoFile m_File;
+		uint64 m_Offset = 0;
+		void* m_Buffer = nullptr;
+		uint32 m_Size = 0;
+		EIoPriority m_Priority = EIoPriority_Normal;
+		Callback m_Callback; // optional
+	};
+
+	class IoService
+	{
+	public:
+		static constexpr uint32 s_UnbufferedAlignment = 4096;
+
+		IoService();
+		~IoService();
+
+		IoService(const IoService&) = delete;
+		IoService& operator=(const IoService&) = delete;
+
+		/* workerCount is only used without io_uring, useIoUring false forces the threads (for testing them) */
+		void Init(uint32 queueDepth = 64, uint32 workerCount = 4, bool useIoUring = true);
+		/* finishes everything that was submitted */
+		void Destroy();
+
+		static IoFile OpenFile(const char* filepath, uint32 flags = EIoOpen_Default);
+		static void CloseFile(IoFile file);
+		static uint64 GetFileSize(IoFile file);
+
+		/* the requests are copied, batch can be null */
+		void Submit(const IoRequest* requests, uint32 count, IoBatch* batch = nullptr);
+		void Wait(const IoBatch& batch);
+
+		bool IsUsingIoUring() const { return m_Ring != nullptr && !m_RingFailed; }
+		uint32 GetQueueDepth() const { return m_QueueDepth; }
+
+	private:
+		struct IoRing;
+
+		struct PendingRead
+		{
+			IoRequest m_Request;
+			IoBatch* m_Batch = nullptr;
+		};
+
+		bool HasPending() const;
+		/* the oldest request of the highest priority, m_Lock has to be held */
+		bool PopPending(PendingRead* read);
+		void Complete(PendingRead& read, int64 result);
+
+		void WorkerLoop();
+		void RingLoop();
+		static int64 ReadBlocking(const IoRequest& request);
+
+		std::unique_ptr<IoRing> m_Ring;
+		std::vector<std::thread> m_Threads;
+		uint32 m_QueueDepth = 0;
+		std::atomic<bool> m_RingFailed{ false }; // the ring thread went on as a worker
+
+		std::mutex m_Lock;
+		std::condition_variable m_WakeUp; // new requests or quitting
+		std::condition_variable m_Completed;
+		std::deque<PendingRead> m_Pending[EIoPriority_Count];
+		uint32 m_InFlight = 0; // thread backend only, the ring thread counts its own
+		bool m_Quit = false;
+	};
+
+}; // namespace Core
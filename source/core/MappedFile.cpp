@@ -0,0 +1,189 @@
+#include "MappedFile.h"
+
+#include "logger/Debug.h"
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Core
+{
+	MappedFile::MappedFile(const char* filepath, EFileAccess access) { Open(filepath, access); }
+
+	MappedFile::~MappedFile() { Close(); }
+
+	MappedFile::MappedFile(MappedFile&& other) { Take(other); }
+
+	MappedFile& MappedFile::operator=(MappedFile&& other)
+	{
+		if(this != &other)
+		{
+			Close();
+			Take(other);
+		}
+		return *this;
+	}
+
+	void MappedFile::Take(MappedFile& other)
+	{
+		m_Data = other.m_Data;
+		m_Size = other.m_Size;
+		m_IsOpen = other.m_IsOpen;
+#ifdef _WIN32
+		m_File = other.m_File;
+		m_Mapping = other.m_Mapping;
+		other.m_File = nullptr;
+		other.m_Mapping = nullptr;
+#endif
+		other.m_Data = nullptr;
+		other.m_Size = 0;
+		other.m_IsOpen = false;
+	}
+
+	Span<const uint8> MappedFile::GetView(uint64 offset, uint64 size) const
+	{
+		if(offset >= m_Size)
+			return Span<const uint8>();
+		if(size > m_Size - offset)
+			size = m_Size - offset;
+		return Span<const uint8>(m_Data + offset, (size_t)size);
+	}
+
+#ifdef _WIN32
+	bool MappedFile::Open(const char* filepath, EFileAccess access)
+	{
+		Close();
+
+		const DWORD flags = access == EFileAccess_Sequential ? FILE_FLAG_SEQUENTIAL_SCAN
+							: access == EFileAccess_Random	 ? FILE_FLAG_RANDOM_ACCESS
+															 : FILE_ATTRIBUTE_NORMAL;
+		HANDLE file = CreateFileA(filepath, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, flags, nullptr);
+		if(file == INVALID_HANDLE_VALUE)
+			return false;
+
+		LARGE_INTEGER size;
+		if(!GetFileSizeEx(file, &size))
+		{
+			CloseHandle(file);
+			return false;
+		}
+
+		m_File = file;
+		m_Size = (uint64)size.QuadPart;
+		m_IsOpen = true;
+
+		// a mapping of an empty file can not be created
+		if(m_Size == 0)
+			return true;
+
+		m_Mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if(m_Mapping)
+			m_Data = (const uint8*)MapViewOfFile(m_Mapping, FILE_MAP_READ, 0, 0, 0);
+
+		if(!m_Data)
+		{
+			LOG_MESSAGE("Failed to map %s", filepath);
+			Close();
+			return false;
+		}
+		return true;
+	}
+
+	void MappedFile::Close()
+	{
+		if(m_Data)
+			UnmapViewOfFile(m_Data);
+		if(m_Mapping)
+			CloseHandle(m_Mapping);
+		if(m_File)
+			CloseHandle(m_File);
+
+		m_Data = nullptr;
+		m_Mapping = nullptr;
+		m_File = nullptr;
+		m_Size = 0;
+		m_IsOpen = false;
+	}
+
+	void MappedFile::WillNeed(uint64 offset, uint64 size) const
+	{
+		Span<const uint8> view = GetView(offset, size);
+		if(view.IsEmpty())
+			return;
+
+		WIN32_MEMORY_RANGE_ENTRY range;
+		range.VirtualAddress = (void*)view.GetData();
+		range.NumberOfBytes = view.Size();
+		PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+	}
+#else
+	bool MappedFile::Open(const char* filepath, EFileAccess access)
+	{
+		Close();
+
+		const int file = open(filepath, O_RDONLY | O_CLOEXEC);
+		if(file < 0)
+			return false;
+
+		struct stat info;
+		if(fstat(file, &info) != 0)
+		{
+			close(file);
+			return false;
+		}
+
+		m_Size = (uint64)info.st_size;
+		m_IsOpen = true;
+		if(m_Size == 0)
+		{
+			close(file);
+			return true;
+		}
+
+		// the mapping keeps its own reference to the file
+		void* data = mmap(nullptr, (size_t)m_Size, PROT_READ, MAP_PRIVATE, file, 0);
+		close(file);
+		if(data == MAP_FAILED)
+		{
+			LOG_MESSAGE("Failed to map %s", filepath);
+			Close();
+			return false;
+		}
+
+		m_Data = (const uint8*)data;
+		if(access == EFileAccess_Sequential)
+			madvise(data, (size_t)m_Size, MADV_SEQUENTIAL);
+		else if(access == EFileAccess_Random)
+			madvise(data, (size_t)m_Size, MADV_RANDOM);
+		return true;
+	}
+
+	void MappedFile::Close()
+	{
+		if(m_Data)
+			munmap((void*)m_Data, (size_t)m_Size);
+
+		m_Data = nullptr;
+		m_Size = 0;
+		m_IsOpen = false;
+	}
+
+	void MappedFile::WillNeed(uint64 offset, uint64 size) const
+	{
+		Span<const uint8> view = GetView(offset, size);
+		if(view.IsEmpty())
+			return;
+
+		// madvise wants a page aligned start
+		const size_t pageSize = (size_t)sysconf(_SC_PAGESIZE);
+		const size_t start = (size_t)view.GetData() & ~(pageSize - 1);
+		madvise((void*)start, (size_t)view.GetData() + view.Size() - start, MADV_WILLNEED);
+	}
+#endif
+
+}; // namespace Core
@@ -0,0 +1,60 @@
+#pragma once
+#include "Types.h"
+#include "Core/containers/Span.h"
+
+/*
+	A read only memory mapping of a whole file.
+
+	The file is paged in by the OS as it is touched, nothing is copied into a buffer of our own and pages that were
+	read before come straight from the file cache. GetData and GetView hand out spans into the mapping, they are valid
+	until the file is closed. The access hint tells the OS how the file will be read so it can read ahead or not.
+*/
+
+namespace Core
+{
+	enum EFileAccess
+	{
+		EFileAccess_Normal,
+		EFileAccess_Sequential, // read ahead aggressively, pages behind can be dropped early
+		EFileAccess_Random,		// no read ahead
+	};
+
+	class MappedFile
+	{
+	public:
+		MappedFile() = default;
+		MappedFile(const char* filepath, EFileAccess access = EFileAccess_Sequential);
+		~MappedFile();
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+		MappedFile(MappedFile&& other);
+		MappedFile& operator=(MappedFile&& other);
+
+		/* an empty file opens fine and has an empty span */
+		bool Open(const char* filepath, EFileAccess access = EFileAccess_Sequential);
+		void Close();
+
+		bool IsOpen() const { return m_IsOpen; }
+		uint64 GetSize() const { return m_Size; }
+		Span<const uint8> GetData() const { return Span<const uint8>(m_Data, (size_t)m_Size); }
+
+		/* a range of the file, clamped to its end */
+		Span<const uint8> GetView(uint64 offset, uint64 size) const;
+
+		/* asks the OS to start reading the range in the background, before it is touched */
+		void WillNeed(uint64 offset, uint64 size) const;
+
+	private:
+		void Take(MappedFile& other);
+
+		const uint8* m_Data = nullptr;
+		uint64 m_Size = 0;
+		bool m_IsOpen = false;
+#ifdef _WIN32
+		void* m_File = nullptr;
+		void* m_Mapping = nullptr;
+#endif
+	};
+
+}; // namespace Core
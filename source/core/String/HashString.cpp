@@ -1,37 +1,35 @@
 #include "HashString.h"
-#include "Core/utilities/utilities.h"
+#include "HashStringTable.h"
+
+#include "logger/Debug.h"
+
+#include <cstring>
+
 namespace Core
 {
-	HashString::HashString(const HashString& str)
-		: m_Hash(str.m_Hash)
-#ifdef _DEBUG
-		, m_DebugString(str.m_DebugString)
-#endif
+	HashString HashString::Intern(const char* str)
 	{
+		const HashString hashString(str);
+		// the table only logs collisions, an interned name losing its hash is a bug here
+		VERIFY(strcmp(HashStringTable::Get().Add(hashString.m_Hash, str), str) == 0, "HashString collision!");
+		return hashString;
 	}
 
-	HashString::HashString(const char* str) { m_Hash = Hash(str); }
-
-	const char* HashString::debug_str() const
+	const char* HashString::GetString() const
 	{
+		if(const char* str = HashStringTable::Get().Find(m_Hash))
+			return str;
 #ifdef _DEBUG
 		return m_DebugString;
 #else
-		return "no string in final";
+		return nullptr;
 #endif
 	}
 
-	HashString& HashString::operator=(const HashString& str)
+	const char* HashString::debug_str() const
 	{
-		m_Hash = str.m_Hash;
-#ifdef _DEBUG
-		m_DebugString = str.m_DebugString;
-#endif
-		return *this;
+		const char* str = GetString();
+		return str ? str : "no string in final";
 	}
 
-	bool HashString::operator==(uint64 hash) const { return m_Hash == hash; }
-
-	bool HashString::operator==(const HashString& hashStr) const { return m_Hash == hashStr.m_Hash; }
-
-} // namespace Core
+}; // namespace Core
@@ -1,25 +1,82 @@
 #pragma once
 #include "Core/Types.h"
+
+#include <cstddef>
+
+/*
+	A string reduced to its 64 bit FNV-1a hash.
+
+	The hash is constexpr and the same at compile time and at run time, "name"_hs is HashString("name").GetHash()
+	folded into a constant, so hashed names work as switch labels and as map keys that are never hashed at run time.
+
+	A HashString only keeps the hash. Strings that have to come back from it, for tools and logs, are interned into
+	the HashStringTable, which holds a copy of every interned string and catches two strings with the same hash.
+*/
+
 namespace Core
 {
-    class HashString
-    {
-    public:
-        HashString( const HashString& str );
-        HashString( const char* str );
+	constexpr uint64 s_StringHashBasis = 14695981039346656037ull;
+	constexpr uint64 s_StringHashPrime = 1099511628211ull;
+
+	constexpr uint64 StringHash(const char* str, size_t length)
+	{
+		uint64 hash = s_StringHashBasis;
+		for(size_t i = 0; i < length; ++i)
+			hash = (hash ^ (uint8)str[i]) * s_StringHashPrime;
+		return hash;
+	}
 
+	constexpr uint64 StringHash(const char* str)
+	{
+		uint64 hash = s_StringHashBasis;
+		for(; *str; ++str)
+			hash = (hash ^ (uint8)*str) * s_StringHashPrime;
+		return hash;
+	}
+
+	class HashString
+	{
+	public:
+		constexpr HashString(const char* str)
+			: m_Hash(StringHash(str))
+#ifdef _DEBUG
+			, m_DebugString(str)
+#endif
+		{
+		}
+
+		constexpr explicit HashString(uint64 hash)
+			: m_Hash(hash)
+		{
+		}
+
+		constexpr HashString(const HashString& str) = default;
+		HashString& operator=(const HashString& str) = default;
+
+		/* hashes str and adds it to the HashStringTable, so GetString finds it again */
+		static HashString Intern(const char* str);
+
+		/* the interned string, in debug builds also the one it was made from, otherwise nullptr */
+		const char* GetString() const;
 		const char* debug_str() const;
 
-        HashString& operator=( const HashString& str );
+		constexpr bool operator==(const HashString& hashStr) const { return m_Hash == hashStr.m_Hash; }
+		constexpr bool operator==(uint64 hash) const { return m_Hash == hash; }
+		constexpr bool operator!=(const HashString& hashStr) const { return m_Hash != hashStr.m_Hash; }
 
-        bool operator==( const HashString& hashStr ) const;
-        bool operator==( uint64 hash ) const;
+		constexpr uint64 GetHash() const { return m_Hash; }
 
-    private:
-        uint64 m_Hash = 0;
+	private:
+		uint64 m_Hash = 0;
 #ifdef _DEBUG
-        const char* m_DebugString;
+		const char* m_DebugString = nullptr;
 #endif
-    };
+	};
+
+}; // namespace Core
 
-}; // namespace Core
\ No newline at end of file
+/* "name"_hs is the hash of name, at global scope so every namespace can use it */
+constexpr uint64 operator""_hs(const char* str, size_t length)
+{
+	return Core::StringHash(str, length);
+}
@@ -0,0 +1,54 @@
+#include "HashStringTable.h"
+
+#include "logger/Debug.h"
+
+#include <cstring>
+
+namespace Core
+{
+	HashStringTable& HashStringTable::Get()
+	{
+		static HashStringTable* table = new HashStringTable;
+		return *table;
+	}
+
+	const char* HashStringTable::Add(uint64 hash, const char* str)
+	{
+		std::lock_guard<std::mutex> lock(m_Lock);
+		if(const char** existing = m_Strings.Find(hash))
+		{
+			if(strcmp(*existing, str) != 0)
+			{
+				LOG_MESSAGE("HashString collision: \"%s\" and \"%s\" have the same hash", *existing, str);
+				m_Collisions++;
+			}
+			return *existing;
+		}
+
+		const size_t length = strlen(str) + 1;
+		char* copy = m_Storage.Allocate<char>(length);
+		memcpy(copy, str, length);
+		m_Strings.Insert(hash, copy);
+		return copy;
+	}
+
+	const char* HashStringTable::Find(uint64 hash) const
+	{
+		std::lock_guard<std::mutex> lock(m_Lock);
+		const char* const* str = m_Strings.Find(hash);
+		return str ? *str : nullptr;
+	}
+
+	uint32 HashStringTable::GetCount() const
+	{
+		std::lock_guard<std::mutex> lock(m_Lock);
+		return m_Strings.GetCount();
+	}
+
+	uint32 HashStringTable::GetCollisionCount() const
+	{
+		std::lock_guard<std::mutex> lock(m_Lock);
+		return m_Collisions;
+	}
+
+}; // namespace Core
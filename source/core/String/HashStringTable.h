@@ -0,0 +1,40 @@
+#pragma once
+#include "Core/Types.h"
+#include "Core/containers/HashMap.h"
+#include "Core/memory/LinearArena.h"
+
+#include <mutex>
+
+/*
+	Maps HashString hashes back to their strings.
+
+	Adding a string copies it into the table, the copies stay until the program ends. Adding a different string with
+	a hash that is already taken is a collision, it is logged and counted and the first string keeps the hash,
+	HashString::Intern asserts on it. Every call takes a lock, interning belongs to loading and tools, not to per
+	frame code.
+*/
+
+namespace Core
+{
+	class HashStringTable
+	{
+	public:
+		/* never destroyed, strings interned by static objects stay valid */
+		static HashStringTable& Get();
+
+		/* returns the table's copy of the string that owns the hash, on a collision that is not str */
+		const char* Add(uint64 hash, const char* str);
+		/* nullptr when nothing with this hash was added */
+		const char* Find(uint64 hash) const;
+
+		uint32 GetCount() const;
+		uint32 GetCollisionCount() const;
+
+	private:
+		mutable std::mutex m_Lock;
+		HashMap<uint64, const char*> m_Strings;
+		LinearArena m_Storage;
+		uint32 m_Collisions = 0;
+	};
+
+}; // namespace Core
@@ -1,118 +1,323 @@
 #pragma once
 #include "core/Types.h"
+#include "core/memory/MemoryTracker.h"
 #include "logger/debug.h"
+#include <cstring>
 #include <initializer_list>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+/*
+	A dynamic array over uninitialized storage.
+
+	Elements are constructed when they are added and destroyed when they are removed, so any type works, and
+	trivially copyable types are copied and grown with memcpy. Moving an array takes its buffer. The first
+	InlineCapacity elements live inside the array itself and only going past them allocates. The allocator is a
+	std style allocator, by default one that reports to the MemoryTracker, an ArenaAllocator works as well.
+*/
 
 namespace Core
 {
+	template <typename T, uint32 Count>
+	struct GrowingArrayInline
+	{
+		T* GetData() { return (T*)m_Data; }
+		const T* GetData() const { return (const T*)m_Data; }
+		alignas(T) uint8 m_Data[sizeof(T) * Count];
+	};
+
 	template <typename T>
+	struct GrowingArrayInline<T, 0>
+	{
+		T* GetData() { return nullptr; }
+		const T* GetData() const { return nullptr; }
+	};
+
+	template <typename T, uint32 InlineCapacity = 0, typename Allocator = TrackedAllocator<T, EMemoryTag_Core>>
 	class GrowingArray
 	{
 	public:
-		GrowingArray();
-		~GrowingArray();
-		GrowingArray(int32 size)
-			: m_Capacity(size)
-			, m_Data(new T[m_Capacity])
+		static constexpr uint32 s_DefaultCapacity = 10;
+
+		/* without inline storage a few elements are reserved up front, otherwise the array starts inline */
+		GrowingArray()
+			: GrowingArray(InlineCapacity == 0 ? (int32)s_DefaultCapacity : 0)
+		{
+		}
+
+		/* reserves capacity, the array starts empty */
+		explicit GrowingArray(int32 capacity, const Allocator& allocator = Allocator())
+			: m_Allocator(allocator)
+		{
+			m_Data = m_Inline.GetData();
+			m_Capacity = InlineCapacity;
+			Reserve((uint32)capacity);
+		}
+
+		explicit GrowingArray(const Allocator& allocator)
+			: GrowingArray(0, allocator)
 		{
 		}
 
 		GrowingArray(std::initializer_list<T> initList)
+			: GrowingArray((int32)initList.size())
+		{
+			CopyConstruct(m_Data, initList.begin(), (uint32)initList.size());
+			m_Size = (uint32)initList.size();
+		}
+
+		GrowingArray(const GrowingArray& other)
+			: GrowingArray((int32)other.m_Capacity, other.m_Allocator)
 		{
-			m_Capacity = initList.size();
-			m_Size = m_Capacity;
-			m_Data = new T[m_Capacity];
-			memcpy(m_Data, initList.begin(), m_Capacity * sizeof(T));
+			CopyConstruct(m_Data, other.m_Data, other.m_Size);
+			m_Size = other.m_Size;
+		}
+
+		GrowingArray(GrowingArray&& other)
+			: m_Allocator(std::move(other.m_Allocator))
+		{
+			m_Data = m_Inline.GetData();
+			m_Capacity = InlineCapacity;
+			Take(other);
 		}
 
-		GrowingArray(const GrowingArray<T>& other) { *this = other; }
+		~GrowingArray()
+		{
+			Destroy(m_Data, m_Size);
+			Deallocate();
+		}
 
-		GrowingArray<T>& operator=(const GrowingArray<T>& other)
+		GrowingArray& operator=(const GrowingArray& other)
 		{
+			if(this == &other)
+				return *this;
+
+			// the buffer is kept when the copy fits
+			RemoveAll();
+			Reserve(other.m_Size);
+			CopyConstruct(m_Data, other.m_Data, other.m_Size);
 			m_Size = other.m_Size;
-			m_Capacity = other.m_Capacity;
-			m_Data = new T[m_Capacity];
-			memcpy(&m_Data[0], &other.m_Data[0], sizeof(T) * m_Size);
+			return *this;
+		}
+
+		GrowingArray& operator=(GrowingArray&& other)
+		{
+			if(this == &other)
+				return *this;
+
+			Destroy(m_Data, m_Size);
+			Deallocate();
+			m_Allocator = std::move(other.m_Allocator);
+			m_Data = m_Inline.GetData();
+			m_Size = 0;
+			m_Capacity = InlineCapacity;
+			Take(other);
 			return *this;
 		}
 
 		T& operator[](uint32 index) { return m_Data[index]; }
 		const T& operator[](uint32 index) const { return m_Data[index]; }
 
+		/* removes everything and sets the capacity to size, the array is empty afterwards */
 		void ReInit(int32 size)
 		{
-			delete[] m_Data;
-			m_Capacity = size;
-			m_Data = new T[m_Capacity];
+			RemoveAll();
+			const uint32 capacity = (uint32)size > InlineCapacity ? (uint32)size : InlineCapacity;
+			if(capacity != m_Capacity)
+				Reallocate(capacity);
 		}
 
 		/*
-			Does change the size of the array, deletes the old array completely.
+			Does change the size of the array, the old elements are removed and size value initialized ones take
+			their place.
 		*/
 		void ReSize(int32 size)
 		{
 			ReInit(size);
+			for(uint32 i = 0; i < (uint32)size; ++i)
+				new(&m_Data[i]) T();
 			m_Size = size;
 		}
 
+		/* capacity never goes down here, only in ShrinkToFit */
+		void Reserve(uint32 capacity)
+		{
+			if(capacity > m_Capacity)
+				Reallocate(capacity);
+		}
+
+		/* back to the inline buffer when the elements fit into it */
+		void ShrinkToFit()
+		{
+			const uint32 capacity = m_Size > InlineCapacity ? m_Size : InlineCapacity;
+			if(capacity < m_Capacity)
+				Reallocate(capacity);
+		}
+
 		uint32 Size() const { return m_Size; }
 		uint32 Capacity() const { return m_Capacity; }
+		bool IsEmpty() const { return m_Size == 0; }
+		T* GetData() { return m_Data; }
+		const T* GetData() const { return m_Data; }
 
+		/* overwrites the element at index, which has to exist */
 		void Insert(const T& object, int32 index) { m_Data[index] = object; }
 
-		void Add(const T& object)
-		{
+		void Add(const T& object) { Emplace(object); }
+		void Add(T&& object) { Emplace(std::move(object)); }
 
+		template <typename... Args>
+		T& Emplace(Args&&... args)
+		{
 			if(m_Size == m_Capacity)
-			{
-				ASSERT(false, "Array is full. Can't add more to it. Will grow.");
-				Grow(m_Capacity * 2);
-			}
+				return EmplaceGrow(std::forward<Args>(args)...);
 
-			if(m_Size < m_Capacity)
-				m_Data[m_Size++] = object;
+			T* object = new(&m_Data[m_Size]) T(std::forward<Args>(args)...);
+			m_Size++;
+			return *object;
 		}
 
 		T& GetLast() { return m_Data[m_Size - 1]; }
 		T& GetFirst() { return m_Data[0]; }
 
-		void RemoveCyclicAtIndex(uint32 index) { m_Data[index--] = GetLast(); }
+		void RemoveLast()
+		{
+			ASSERT(m_Size > 0, "Removing from an empty array!");
+			m_Data[--m_Size].~T();
+		}
+
+		/* the last element takes the place of the removed one, the order is not kept */
+		void RemoveCyclicAtIndex(uint32 index)
+		{
+			ASSERT(index < m_Size, "Index is out of range!");
+			if(index != m_Size - 1)
+				m_Data[index] = std::move(GetLast());
+			RemoveLast();
+		}
+
+		/* destroys the elements and keeps the capacity */
+		void RemoveAll()
+		{
+			Destroy(m_Data, m_Size);
+			m_Size = 0;
+		}
+
+		const Allocator& GetAllocator() const { return m_Allocator; }
 
 		typedef T* iterator;
 		typedef const T* const_iterator;
-		iterator begin() { return &m_Data[0]; }
-		const_iterator begin() const { return &m_Data[0]; }
-		iterator end() { return &m_Data[m_Size]; }
-		const_iterator end() const { return &m_Data[m_Size]; }
+		iterator begin() { return m_Data; }
+		const_iterator begin() const { return m_Data; }
+		iterator end() { return m_Data + m_Size; }
+		const_iterator end() const { return m_Data + m_Size; }
 
 	private:
-		void Grow(int32 size)
+		static constexpr bool s_Trivial = std::is_trivially_copyable<T>::value;
+
+		bool IsInline() const { return InlineCapacity > 0 && m_Data == m_Inline.GetData(); }
+
+		static void CopyConstruct(T* destination, const T* source, uint32 count)
 		{
-			m_Capacity = size;
-			T* memory = new T[m_Capacity];
-			memcpy(memory, m_Data, sizeof(T) * m_Size);
-			delete[] m_Data;
-			m_Data = memory;
+			if constexpr(s_Trivial)
+			{
+				if(count > 0)
+					memcpy(destination, source, sizeof(T) * count);
+				return;
+			}
+			for(uint32 i = 0; i < count; ++i)
+				new(&destination[i]) T(source[i]);
 		}
 
-		uint32 m_Size = 0;
-		uint32 m_Capacity = 10;
-		T* m_Data = nullptr;
-	};
+		/* the source elements are gone afterwards */
+		static void MoveConstruct(T* destination, T* source, uint32 count)
+		{
+			if constexpr(s_Trivial)
+			{
+				if(count > 0)
+					memcpy(destination, source, sizeof(T) * count);
+				return;
+			}
+			for(uint32 i = 0; i < count; ++i)
+			{
+				new(&destination[i]) T(std::move(source[i]));
+				source[i].~T();
+			}
+		}
 
-	template <typename T>
-	GrowingArray<T>::GrowingArray()
-	{
-		m_Data = new T[m_Capacity];
-	}
+		static void Destroy(T* data, uint32 count)
+		{
+			if constexpr(!std::is_trivially_destructible<T>::value)
+			{
+				for(uint32 i = 0; i < count; ++i)
+					data[i].~T();
+			}
+		}
 
-	template <typename T>
-	GrowingArray<T>::~GrowingArray()
-	{
-		delete[] m_Data;
-		m_Data = nullptr;
-		m_Size = 0;
-		m_Capacity = 0;
-	}
+		T* Allocate(uint32 capacity)
+		{
+			if(capacity <= InlineCapacity)
+				return m_Inline.GetData();
+			return m_Allocator.allocate(capacity);
+		}
+
+		void Deallocate()
+		{
+			if(m_Data && !IsInline())
+				m_Allocator.deallocate(m_Data, m_Capacity);
+		}
+
+		void Reallocate(uint32 capacity)
+		{
+			T* data = Allocate(capacity);
+			if(data != m_Data)
+			{
+				MoveConstruct(data, m_Data, m_Size);
+				Deallocate();
+			}
+			m_Data = data;
+			m_Capacity = capacity;
+		}
+
+		// the new element is constructed before the old ones move, it can be a reference to one of them
+		template <typename... Args>
+		T& EmplaceGrow(Args&&... args)
+		{
+			const uint32 capacity = m_Capacity > 0 ? m_Capacity * 2 : 4;
+			T* data = Allocate(capacity);
+			T* object = new(&data[m_Size]) T(std::forward<Args>(args)...);
+			MoveConstruct(data, m_Data, m_Size);
+			Deallocate();
+			m_Data = data;
+			m_Capacity = capacity;
+			m_Size++;
+			return *object;
+		}
+
+		// this array is empty on its inline buffer, other is left the same way
+		void Take(GrowingArray& other)
+		{
+			if(other.IsInline())
+			{
+				MoveConstruct(m_Data, other.m_Data, other.m_Size);
+				m_Size = other.m_Size;
+			}
+			else
+			{
+				m_Data = other.m_Data;
+				m_Size = other.m_Size;
+				m_Capacity = other.m_Capacity;
+			}
+			other.m_Data = other.m_Inline.GetData();
+			other.m_Size = 0;
+			other.m_Capacity = InlineCapacity;
+		}
+
+		T* m_Data = nullptr;
+		uint32 m_Size = 0;
+		uint32 m_Capacity = 0;
+		Allocator m_Allocator;
+		GrowingArrayInline<T, InlineCapacity> m_Inline;
+	};
 
 }; // namespace Core
@@ -0,0 +1,471 @@
+#pragma once
+#include "Core/Types.h"
+#include "Hasher.h"
+#include "Core/memory/MemoryTracker.h"
+#include "logger/Debug.h"
+
+#include <cstring>
+#include <emmintrin.h>
+#include <new>
+#include <utility>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+/*
+	Open addressing hash map and hash set.
+
+	Entries sit in one flat array with linear probing and Robin Hood insertion, an entry never sits further from its
+	home slot than the entries it passed, so the table stays sorted by home slot and probes stay short. Next to the
+	entries is one control byte per slot, 7 bits of the hash or empty. A lookup compares 16 control bytes at once
+	with SSE2, only looks at the entries whose bits match and stops at the first empty slot, no entry lies past an
+	empty slot from its home. Erasing shifts the following entries of the run back, there are no tombstones.
+
+	Lookups take anything the hasher has Hash and Equal overloads for, a map keyed by HashString finds by a hash
+	that was computed earlier. The hash of a key can also be computed once with GetHash and passed to Find and
+	Insert.
+
+	Entries move when the table grows and when an entry is erased, pointers into it are only good until the next
+	insert or erase. The allocator is a std style allocator of bytes, by default the tracked Core one.
+*/
+
+namespace Core
+{
+	template <typename Key, typename Entry, typename KeyHasher, typename Allocator>
+	class HashTable
+	{
+	public:
+		static constexpr uint32 s_GroupSize = 16;
+		static constexpr uint32 s_MinCapacity = 16;
+
+		explicit HashTable(const Allocator& allocator = Allocator())
+			: m_Allocator(allocator)
+		{
+		}
+
+		~HashTable() { Destroy(); }
+
+		HashTable(const HashTable&) = delete;
+		HashTable& operator=(const HashTable&) = delete;
+
+		HashTable(HashTable&& other)
+			: m_Allocator(other.m_Allocator)
+		{
+			Take(other);
+		}
+
+		HashTable& operator=(HashTable&& other)
+		{
+			if(this != &other)
+			{
+				Destroy();
+				m_Allocator = other.m_Allocator;
+				Take(other);
+			}
+			return *this;
+		}
+
+		template <typename LookupKey>
+		static uint64 GetHash(const LookupKey& key)
+		{
+			return KeyHasher::Hash(key);
+		}
+
+		/* makes room for count entries without growing */
+		void Reserve(uint32 count)
+		{
+			uint32 capacity = s_MinCapacity;
+			while(capacity - capacity / 8 < count)
+				capacity *= 2;
+			if(capacity > m_Capacity)
+				Rehash(capacity);
+		}
+
+		/* destroys every entry and keeps the memory */
+		void Clear()
+		{
+			for(uint32 slot = 0; slot < m_Capacity; ++slot)
+			{
+				if(m_Control[slot] != s_Empty)
+					m_Entries[slot].~Entry();
+			}
+			if(m_Capacity > 0)
+				memset(m_Control, s_Empty, m_Capacity + s_GroupSize);
+			m_Count = 0;
+		}
+
+		/* destroys every entry and frees the memory */
+		void Destroy()
+		{
+			Clear();
+			if(m_Memory)
+				m_Allocator.deallocate(m_Memory, GetAllocationSize(m_Capacity));
+			m_Memory = nullptr;
+			m_Entries = nullptr;
+			m_Control = nullptr;
+			m_Distances = nullptr;
+			m_Capacity = 0;
+		}
+
+		uint32 GetCount() const { return m_Count; }
+		uint32 GetCapacity() const { return m_Capacity; }
+		bool IsEmpty() const { return m_Count == 0; }
+
+		template <typename EntryType, typename TableType>
+		class Iterator
+		{
+		public:
+			Iterator(TableType* table, uint32 slot)
+				: m_Table(table)
+				, m_Slot(slot)
+			{
+				SkipEmpty();
+			}
+
+			EntryType& operator*() const { return m_Table->m_Entries[m_Slot]; }
+			EntryType* operator->() const { return &m_Table->m_Entries[m_Slot]; }
+			bool operator!=(const Iterator& other) const { return m_Slot != other.m_Slot; }
+			Iterator& operator++()
+			{
+				m_Slot++;
+				SkipEmpty();
+				return *this;
+			}
+
+		private:
+			void SkipEmpty()
+			{
+				while(m_Slot < m_Table->m_Capacity && m_Table->m_Control[m_Slot] == s_Empty)
+					m_Slot++;
+			}
+
+			TableType* m_Table;
+			uint32 m_Slot;
+		};
+
+		typedef Iterator<Entry, HashTable> iterator;
+		typedef Iterator<const Entry, const HashTable> const_iterator;
+
+		/* in slot order, nothing may be inserted or erased while iterating */
+		iterator begin() { return iterator(this, 0); }
+		iterator end() { return iterator(this, m_Capacity); }
+		const_iterator begin() const { return const_iterator(this, 0); }
+		const_iterator end() const { return const_iterator(this, m_Capacity); }
+
+	protected:
+		static constexpr uint32 s_NotFound = ~0u;
+
+		template <typename LookupKey>
+		uint32 FindSlot(const LookupKey& key, uint64 hash) const
+		{
+			if(m_Count == 0)
+				return s_NotFound;
+
+			const uint32 mask = m_Capacity - 1;
+			const __m128i tag = _mm_set1_epi8((char)GetTag(hash));
+			const __m128i empty = _mm_set1_epi8((char)s_Empty);
+			uint32 index = (uint32)hash & mask;
+			for(;;)
+			{
+				const __m128i group = _mm_loadu_si128((const __m128i*)&m_Control[index]);
+				uint32 matches = (uint32)_mm_movemask_epi8(_mm_cmpeq_epi8(group, tag));
+				const uint32 empties = (uint32)_mm_movemask_epi8(_mm_cmpeq_epi8(group, empty));
+
+				// only the slots before the first empty one belong to the run
+				if(empties)
+					matches &= (empties & (0u - empties)) - 1;
+				while(matches)
+				{
+					const uint32 slot = (index + LowestBit(matches)) & mask;
+					if(KeyHasher::Equal(m_Entries[slot].m_Key, key))
+						return slot;
+					matches &= matches - 1;
+				}
+
+				if(empties)
+					return s_NotFound;
+				index = (index + s_GroupSize) & mask;
+			}
+		}
+
+		/* the key must not be in the table yet, args construct the entry */
+		template <typename... Args>
+		Entry* InsertNew(uint64 hash, Args&&... args)
+		{
+			for(;;)
+			{
+				if(m_Count + 1 > m_Capacity - m_Capacity / 8)
+					Rehash(m_Capacity > 0 ? m_Capacity * 2 : s_MinCapacity);
+
+				const uint32 mask = m_Capacity - 1;
+				uint32 slot = (uint32)hash & mask;
+				uint32 distance = 0;
+
+				// past every entry that is as far or further from its home
+				while(m_Control[slot] != s_Empty && m_Distances[slot] >= distance)
+				{
+					slot = (slot + 1) & mask;
+					distance++;
+				}
+
+				// the rest of the run moves up one slot, the distances have to fit into a byte
+				bool overflow = distance >= s_MaxDistance;
+				uint32 last = slot;
+				while(m_Control[last] != s_Empty)
+				{
+					overflow |= m_Distances[last] + 1u >= s_MaxDistance;
+					last = (last + 1) & mask;
+				}
+				if(overflow)
+				{
+					Rehash(m_Capacity * 2);
+					continue;
+				}
+
+				while(last != slot)
+				{
+					const uint32 previous = (last - 1) & mask;
+					new(&m_Entries[last]) Entry(std::move(m_Entries[previous]));
+					m_Entries[previous].~Entry();
+					SetControl(last, m_Control[previous]);
+					m_Distances[last] = m_Distances[previous] + 1;
+					last = previous;
+				}
+
+				Entry* entry = new(&m_Entries[slot]) Entry{ std::forward<Args>(args)... };
+				SetControl(slot, GetTag(hash));
+				m_Distances[slot] = (uint8)distance;
+				m_Count++;
+				return entry;
+			}
+		}
+
+		void EraseSlot(uint32 slot)
+		{
+			const uint32 mask = m_Capacity - 1;
+			m_Entries[slot].~Entry();
+
+			// entries that are not in their home slot move back into the hole
+			uint32 next = (slot + 1) & mask;
+			while(m_Control[next] != s_Empty && m_Distances[next] > 0)
+			{
+				new(&m_Entries[slot]) Entry(std::move(m_Entries[next]));
+				m_Entries[next].~Entry();
+				SetControl(slot, m_Control[next]);
+				m_Distances[slot] = m_Distances[next] - 1;
+				slot = next;
+				next = (next + 1) & mask;
+			}
+			SetControl(slot, s_Empty);
+			m_Count--;
+		}
+
+		Entry* m_Entries = nullptr;
+
+	private:
+		static constexpr uint8 s_Empty = 0x80;
+		static constexpr uint32 s_MaxDistance = 255;
+
+		static uint8 GetTag(uint64 hash) { return (uint8)(hash >> 57); }
+
+		static uint32 LowestBit(uint32 mask)
+		{
+#if defined(_MSC_VER)
+			unsigned long index;
+			_BitScanForward(&index, mask);
+			return (uint32)index;
+#else
+			return (uint32)__builtin_ctz(mask);
+#endif
+		}
+
+		// entries, then the control bytes with the first group repeated at the end, then the distances
+		static size_t GetAllocationSize(uint32 capacity)
+		{
+			return sizeof(Entry) * capacity + alignof(Entry) - 1 + capacity + s_GroupSize + capacity;
+		}
+
+		// a group load that runs off the end reads the copies of the first control bytes
+		void SetControl(uint32 slot, uint8 control)
+		{
+			m_Control[slot] = control;
+			if(slot < s_GroupSize)
+				m_Control[m_Capacity + slot] = control;
+		}
+
+		void Rehash(uint32 capacity)
+		{
+			uint8* memory = m_Allocator.allocate(GetAllocationSize(capacity));
+			const size_t address = ((size_t)memory + alignof(Entry) - 1) & ~(size_t)(alignof(Entry) - 1);
+
+			Entry* entries = m_Entries;
+			uint8* control = m_Control;
+			uint8* oldMemory = m_Memory;
+			const uint32 oldCapacity = m_Capacity;
+
+			m_Memory = memory;
+			m_Entries = (Entry*)address;
+			m_Control = (uint8*)(m_Entries + capacity);
+			m_Distances = m_Control + capacity + s_GroupSize;
+			m_Capacity = capacity;
+			m_Count = 0;
+			memset(m_Control, s_Empty, capacity + s_GroupSize);
+
+			for(uint32 slot = 0; slot < oldCapacity; ++slot)
+			{
+				if(control[slot] == s_Empty)
+					continue;
+				InsertNew(KeyHasher::Hash(entries[slot].m_Key), std::move(entries[slot]));
+				entries[slot].~Entry();
+			}
+			if(oldMemory)
+				m_Allocator.deallocate(oldMemory, GetAllocationSize(oldCapacity));
+		}
+
+		void Take(HashTable& other)
+		{
+			m_Memory = other.m_Memory;
+			m_Entries = other.m_Entries;
+			m_Control = other.m_Control;
+			m_Distances = other.m_Distances;
+			m_Capacity = other.m_Capacity;
+			m_Count = other.m_Count;
+			other.m_Memory = nullptr;
+			other.m_Entries = nullptr;
+			other.m_Control = nullptr;
+			other.m_Distances = nullptr;
+			other.m_Capacity = 0;
+			other.m_Count = 0;
+		}
+
+		Allocator m_Allocator;
+		uint8* m_Memory = nullptr;
+		uint8* m_Control = nullptr;
+		uint8* m_Distances = nullptr; // from the home slot
+		uint32 m_Capacity = 0; // a power of two
+		uint32 m_Count = 0;
+	};
+
+	template <typename Key, typename Value>
+	struct HashMapEntry
+	{
+		Key m_Key;
+		Value m_Value;
+	};
+
+	template <typename Key, typename Value, typename KeyHasher = Hasher<Key>,
+			  typename Allocator = TrackedAllocator<uint8, EMemoryTag_Core>>
+	class HashMap : public HashTable<Key, HashMapEntry<Key, Value>, KeyHasher, Allocator>
+	{
+	public:
+		typedef HashTable<Key, HashMapEntry<Key, Value>, KeyHasher, Allocator> Table;
+		using Table::Table;
+
+		/* nullptr when the key is not in the map */
+		template <typename LookupKey>
+		Value* Find(const LookupKey& key)
+		{
+			return Find(key, KeyHasher::Hash(key));
+		}
+
+		template <typename LookupKey>
+		Value* Find(const LookupKey& key, uint64 hash)
+		{
+			const uint32 slot = this->FindSlot(key, hash);
+			return slot != Table::s_NotFound ? &this->m_Entries[slot].m_Value : nullptr;
+		}
+
+		template <typename LookupKey>
+		const Value* Find(const LookupKey& key) const
+		{
+			return const_cast<HashMap*>(this)->Find(key);
+		}
+
+		template <typename LookupKey>
+		bool Contains(const LookupKey& key) const
+		{
+			return this->FindSlot(key, KeyHasher::Hash(key)) != Table::s_NotFound;
+		}
+
+		/* returns false and leaves the value alone when the key is already there */
+		bool Insert(const Key& key, Value value) { return Insert(key, std::move(value), KeyHasher::Hash(key)); }
+
+		bool Insert(const Key& key, Value value, uint64 hash)
+		{
+			if(this->FindSlot(key, hash) != Table::s_NotFound)
+				return false;
+			this->InsertNew(hash, key, std::move(value));
+			return true;
+		}
+
+		/* default constructs the value when the key is not there yet */
+		Value& operator[](const Key& key)
+		{
+			const uint64 hash = KeyHasher::Hash(key);
+			const uint32 slot = this->FindSlot(key, hash);
+			if(slot != Table::s_NotFound)
+				return this->m_Entries[slot].m_Value;
+			return this->InsertNew(hash, key, Value())->m_Value;
+		}
+
+		template <typename LookupKey>
+		bool Erase(const LookupKey& key)
+		{
+			const uint32 slot = this->FindSlot(key, KeyHasher::Hash(key));
+			if(slot == Table::s_NotFound)
+				return false;
+			this->EraseSlot(slot);
+			return true;
+		}
+	};
+
+	template <typename Key>
+	struct HashSetEntry
+	{
+		Key m_Key;
+	};
+
+	template <typename Key, typename KeyHasher = Hasher<Key>,
+			  typename Allocator = TrackedAllocator<uint8, EMemoryTag_Core>>
+	class HashSet : public HashTable<Key, HashSetEntry<Key>, KeyHasher, Allocator>
+	{
+	public:
+		typedef HashTable<Key, HashSetEntry<Key>, KeyHasher, Allocator> Table;
+		using Table::Table;
+
+		template <typename LookupKey>
+		bool Contains(const LookupKey& key) const
+		{
+			return Contains(key, KeyHasher::Hash(key));
+		}
+
+		template <typename LookupKey>
+		bool Contains(const LookupKey& key, uint64 hash) const
+		{
+			return this->FindSlot(key, hash) != Table::s_NotFound;
+		}
+
+		/* false when the key was already there */
+		bool Insert(const Key& key) { return Insert(key, KeyHasher::Hash(key)); }
+
+		bool Insert(const Key& key, uint64 hash)
+		{
+			if(this->FindSlot(key, hash) != Table::s_NotFound)
+				return false;
+			this->InsertNew(hash, key);
+			return true;
+		}
+
+		template <typename LookupKey>
+		bool Erase(const LookupKey& key)
+		{
+			const uint32 slot = this->FindSlot(key, KeyHasher::Hash(key));
+			if(slot == Table::s_NotFound)
+				return false;
+			this->EraseSlot(slot);
+			return true;
+		}
+	};
+
+}; // namespace Core
@@ -0,0 +1,60 @@
+#pragma once
+#include "Core/Types.h"
+#include "Core/String/HashString.h"
+
+#include <string>
+#include <type_traits>
+
+/*
+	Hashers for HashMap and HashSet.
+
+	A hasher has Hash overloads for the key and for anything else the key can be looked up by, and Equal overloads
+	comparing a stored key to each of them. The table takes its slot from the low bits of the hash and a tag from
+	the high bits, so every hash goes through MixHash to spread the key over all 64 bits.
+*/
+
+namespace Core
+{
+	/* the 64 bit finalizer of MurmurHash3 */
+	inline uint64 MixHash(uint64 hash)
+	{
+		hash ^= hash >> 33;
+		hash *= 0xff51afd7ed558ccdull;
+		hash ^= hash >> 33;
+		hash *= 0xc4ceb9fe1a85ec53ull;
+		hash ^= hash >> 33;
+		return hash;
+	}
+
+	/* integers, enums and pointers */
+	template <typename Key>
+	struct Hasher
+	{
+		static_assert(std::is_integral<Key>::value || std::is_enum<Key>::value || std::is_pointer<Key>::value,
+					  "No hasher for this key type!");
+
+		static uint64 Hash(Key key) { return MixHash((uint64)key); }
+		static bool Equal(Key a, Key b) { return a == b; }
+	};
+
+	/* the string is hashed once when the HashString is made, lookups can also use a hash computed earlier */
+	template <>
+	struct Hasher<HashString>
+	{
+		static uint64 Hash(const HashString& key) { return MixHash(key.GetHash()); }
+		static uint64 Hash(uint64 hash) { return MixHash(hash); }
+		static bool Equal(const HashString& a, const HashString& b) { return a == b; }
+		static bool Equal(const HashString& a, uint64 hash) { return a == hash; }
+	};
+
+	/* looked up by const char* without making a std::string */
+	template <>
+	struct Hasher<std::string>
+	{
+		static uint64 Hash(const std::string& key) { return MixHash(StringHash(key.c_str(), key.length())); }
+		static uint64 Hash(const char* key) { return MixHash(StringHash(key)); }
+		static bool Equal(const std::string& a, const std::string& b) { return a == b; }
+		static bool Equal(const std::string& a, const char* b) { return a == b; }
+	};
+
+}; // namespace Core
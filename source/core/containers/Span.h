@@ -0,0 +1,65 @@
+#pragma once
+#include "Core/Types.h"
+#include "logger/Debug.h"
+
+#include <cstddef>
+#include <type_traits>
+
+/*
+	A pointer and a count, for handing out memory owned by someone else without copying it.
+	The span does not keep the memory alive, it is only valid as long as the owner is.
+*/
+
+namespace Core
+{
+	template <typename T>
+	class Span
+	{
+	public:
+		Span() = default;
+		Span(T* data, size_t size)
+			: m_Data(data)
+			, m_Size(size)
+		{
+		}
+
+		/* a span of const T from a span of T */
+		template <typename U, typename = std::enable_if_t<std::is_same<const U, T>::value>>
+		Span(const Span<U>& other)
+			: m_Data(other.GetData())
+			, m_Size(other.Size())
+		{
+		}
+
+		T& operator[](size_t index) const { return m_Data[index]; }
+
+		T* GetData() const { return m_Data; }
+		size_t Size() const { return m_Size; }
+		size_t SizeInBytes() const { return m_Size * sizeof(T); }
+		bool IsEmpty() const { return m_Size == 0; }
+
+		Span SubSpan(size_t offset, size_t count) const
+		{
+			ASSERT(offset + count <= m_Size, "Sub span is out of range!");
+			return Span(m_Data + offset, count);
+		}
+
+		/* the same bytes seen as U, the span has to be a whole number of suitably aligned U */
+		template <typename U>
+		Span<U> As() const
+		{
+			static_assert(std::is_trivially_copyable<std::remove_const_t<U>>::value, "Only plain data can be cast!");
+			ASSERT(SizeInBytes() % sizeof(U) == 0, "Span is not a whole number of elements!");
+			ASSERT((size_t)m_Data % alignof(U) == 0, "Span is not aligned for the element type!");
+			return Span<U>((U*)m_Data, SizeInBytes() / sizeof(U));
+		}
+
+		T* begin() const { return m_Data; }
+		T* end() const { return m_Data + m_Size; }
+
+	private:
+		T* m_Data = nullptr;
+		size_t m_Size = 0;
+	};
+
+}; // namespace Core
@@ -0,0 +1,99 @@
+#include "EntityCommandBuffer.h"
+
+#include "logger/Debug.h"
+
+#include <cstring>
+
+namespace Core
+{
+	void EntityCommandBuffer::Record(Command command, Entity entity, const ComponentId* ids, const void* const* data,
+									 uint32 count)
+	{
+		uint32 size = sizeof(Header) + count * sizeof(ComponentId);
+		if(data)
+		{
+			for(uint32 i = 0; i < count; ++i)
+				size += ComponentRegistry::GetInfo(ids[i]).m_Size;
+		}
+
+		std::lock_guard<std::mutex> lock(m_Lock);
+		const size_t start = m_Stream.size();
+		m_Stream.resize(start + size);
+		uint8* write = &m_Stream[start];
+
+		Header header;
+		header.m_Command = command;
+		header.m_Entity = entity;
+		header.m_Count = count;
+		header.m_Size = size;
+		memcpy(write, &header, sizeof(Header));
+		write += sizeof(Header);
+
+		memcpy(write, ids, count * sizeof(ComponentId));
+		write += count * sizeof(ComponentId);
+
+		if(data)
+		{
+			for(uint32 i = 0; i < count; ++i)
+			{
+				const uint32 componentSize = ComponentRegistry::GetInfo(ids[i]).m_Size;
+				memcpy(write, data[i], componentSize);
+				write += componentSize;
+			}
+		}
+	}
+
+	void EntityCommandBuffer::Playback(World* world)
+	{
+		// the stream is byte packed, copy out what is read instead of pointing into it
+		std::vector<ComponentId> ids;
+		std::vector<const void*> data;
+
+		size_t read = 0;
+		while(read < m_Stream.size())
+		{
+			Header header;
+			memcpy(&header, &m_Stream[read], sizeof(Header));
+			const uint8* payload = &m_Stream[read + sizeof(Header)];
+			read += header.m_Size;
+
+			ids.resize(header.m_Count);
+			if(header.m_Count > 0)
+				memcpy(ids.data(), payload, header.m_Count * sizeof(ComponentId));
+
+			switch(header.m_Command)
+			{
+				case Command::Create:
+				{
+					// component data is only read through memcpy, unaligned pointers are fine
+					const uint8* component = payload + header.m_Count * sizeof(ComponentId);
+					data.resize(header.m_Count);
+					for(uint32 i = 0; i < header.m_Count; ++i)
+					{
+						data[i] = component;
+						component += ComponentRegistry::GetInfo(ids[i]).m_Size;
+					}
+					world->CreateEntity(ids.data(), data.data(), header.m_Count);
+					break;
+				}
+				case Command::Destroy:
+					if(world->IsAlive(header.m_Entity))
+						world->DestroyEntity(header.m_Entity);
+					break;
+				case Command::Add:
+					if(world->IsAlive(header.m_Entity))
+						world->AddComponent(header.m_Entity, ids[0], payload + sizeof(ComponentId));
+					break;
+				case Command::Remove:
+					if(world->IsAlive(header.m_Entity))
+						world->RemoveComponent(header.m_Entity, ids[0]);
+					break;
+				default:
+					ASSERT(false, "Unknown entity command!");
+					break;
+			}
+		}
+		m_Stream.clear();
+	}
+
+}; // namespace Core
@@ -0,0 +1,76 @@
+#pragma once
+#include "World.h"
+
+#include <mutex>
+#include <vector>
+
+/*
+	Structural changes recorded while a query runs and applied to the world afterwards.
+
+	Recording is thread safe, systems running in ParallelForEach can share one buffer. The commands are applied in
+	the order they were recorded, component data is copied into the buffer when recording.
+*/
+
+namespace Core
+{
+	class EntityCommandBuffer
+	{
+	public:
+		EntityCommandBuffer() = default;
+		~EntityCommandBuffer() = default;
+
+		template <typename... Ts>
+		void Create(const Ts&... components)
+		{
+			const ComponentId ids[] = { ComponentRegistry::GetId<Ts>()..., 0 };
+			const void* const data[] = { &components..., nullptr };
+			Record(Command::Create, Entity(), ids, data, (uint32)sizeof...(Ts));
+		}
+
+		void Destroy(Entity entity) { Record(Command::Destroy, entity, nullptr, nullptr, 0); }
+
+		template <typename T>
+		void Add(Entity entity, const T& component)
+		{
+			const ComponentId id = ComponentRegistry::GetId<T>();
+			const void* data = &component;
+			Record(Command::Add, entity, &id, &data, 1);
+		}
+
+		template <typename T>
+		void Remove(Entity entity)
+		{
+			const ComponentId id = ComponentRegistry::GetId<T>();
+			Record(Command::Remove, entity, &id, nullptr, 1);
+		}
+
+		/* applies and clears the commands, commands on entities that died in the meantime are skipped */
+		void Playback(World* world);
+
+		bool IsEmpty() const { return m_Stream.empty(); }
+
+	private:
+		enum class Command : uint32
+		{
+			Create,
+			Destroy,
+			Add,
+			Remove,
+		};
+
+		/* a command is its header, the component ids and then the component data, data may be null */
+		struct Header
+		{
+			Command m_Command;
+			Entity m_Entity;
+			uint32 m_Count;
+			uint32 m_Size; // of the whole command
+		};
+
+		void Record(Command command, Entity entity, const ComponentId* ids, const void* const* data, uint32 count);
+
+		std::mutex m_Lock;
+		std::vector<uint8> m_Stream;
+	};
+
+}; // namespace Core
@@ -0,0 +1,325 @@
+#include "TransformHierarchy.h"
+
+#include "Core/memory/ArenaAllocator.h"
+#include "Core/memory/FrameMemory.h"
+#include "Core/threading/ThreadPool.h"
+#include "Core/profiler/Profiler.h"
+#include "logger/Debug.h"
+
+#include <algorithm>
+
+namespace Core
+{
+	constexpr uint32 s_NodesPerJob = 1024;
+
+	template <typename T>
+	static void Permute(std::vector<T>* values, const std::vector<uint32>& order)
+	{
+		std::vector<T> sorted(values->size());
+		for(size_t i = 0; i < order.size(); ++i)
+			sorted[i] = (*values)[order[i]];
+		values->swap(sorted);
+	}
+
+	TransformId TransformHierarchy::Create(TransformId parent)
+	{
+		ASSERT(parent == s_NoParent || parent < m_Slots.size(), "Parent transform does not exist!");
+
+		const TransformId id = (TransformId)m_Slots.size();
+		const uint32 slot = (uint32)m_Ids.size();
+		m_Slots.push_back(slot);
+		m_Ids.push_back(id);
+		m_Parents.push_back(parent == s_NoParent ? s_NoParent : m_Slots[parent]);
+		m_SubtreeEnds.push_back(slot + 1);
+		m_PositionX.push_back(0.f);
+		m_PositionY.push_back(0.f);
+		m_PositionZ.push_back(0.f);
+		m_RotationX.push_back(0.f);
+		m_RotationY.push_back(0.f);
+		m_RotationZ.push_back(0.f);
+		m_RotationW.push_back(1.f);
+		m_ScaleX.push_back(1.f);
+		m_ScaleY.push_back(1.f);
+		m_ScaleZ.push_back(1.f);
+		m_Dirty.push_back(0);
+		m_World.push_back(Matrix44f::Identity());
+
+		// appending keeps parents in front of their children but splits the parent's subtree, sorted on Update
+		m_Unsorted = true;
+		return id;
+	}
+
+	void TransformHierarchy::SetLocal(TransformId id, const Vector4f& position, const Vector4f& rotation,
+									  const Vector4f& scale)
+	{
+		SetPosition(id, position);
+		SetRotation(id, rotation);
+		SetScale(id, scale);
+	}
+
+	void TransformHierarchy::SetPosition(TransformId id, const Vector4f& position)
+	{
+		const uint32 slot = m_Slots[id];
+		m_PositionX[slot] = position.x;
+		m_PositionY[slot] = position.y;
+		m_PositionZ[slot] = position.z;
+		MarkDirty(slot);
+	}
+
+	void TransformHierarchy::SetRotation(TransformId id, const Vector4f& rotation)
+	{
+		const uint32 slot = m_Slots[id];
+		m_RotationX[slot] = rotation.x;
+		m_RotationY[slot] = rotation.y;
+		m_RotationZ[slot] = rotation.z;
+		m_RotationW[slot] = rotation.w;
+		MarkDirty(slot);
+	}
+
+	void TransformHierarchy::SetScale(TransformId id, const Vector4f& scale)
+	{
+		const uint32 slot = m_Slots[id];
+		m_ScaleX[slot] = scale.x;
+		m_ScaleY[slot] = scale.y;
+		m_ScaleZ[slot] = scale.z;
+		MarkDirty(slot);
+	}
+
+	Vector4f TransformHierarchy::GetPosition(TransformId id) const
+	{
+		const uint32 slot = m_Slots[id];
+		return { m_PositionX[slot], m_PositionY[slot], m_PositionZ[slot], 1.f };
+	}
+
+	TransformId TransformHierarchy::GetParent(TransformId id) const
+	{
+		const uint32 parent = m_Parents[m_Slots[id]];
+		return parent == s_NoParent ? s_NoParent : m_Ids[parent];
+	}
+
+	void TransformHierarchy::MarkDirty(uint32 slot)
+	{
+		if(m_Dirty[slot])
+			return;
+
+		m_Dirty[slot] = 1;
+		m_DirtySlots.push_back(slot);
+	}
+
+	uint32 TransformHierarchy::Update(ThreadPool* pool)
+	{
+		PROFILE_FUNCTION();
+		if(m_Unsorted)
+			Sort();
+
+		if(m_DirtySlots.empty())
+			return 0;
+
+		// a dirty node inside a subtree that is already dirty is covered by it
+		std::sort(m_DirtySlots.begin(), m_DirtySlots.end());
+		m_Ranges.clear();
+		uint32 covered = 0;
+		uint32 updated = 0;
+		for(uint32 slot : m_DirtySlots)
+		{
+			m_Dirty[slot] = 0;
+			if(slot < covered)
+				continue;
+
+			covered = m_SubtreeEnds[slot];
+			updated += covered - slot;
+			Split(slot, covered);
+		}
+		m_DirtySlots.clear();
+
+		// ranges are packed into jobs of about s_NodesPerJob nodes, every range has an up to date parent
+		ScratchScope scratch;
+		ArenaVector<uint32> jobStarts(scratch.GetArena());
+		jobStarts.reserve(m_Ranges.size() + 1);
+		uint32 nodes = s_NodesPerJob;
+		for(uint32 i = 0; i < (uint32)m_Ranges.size(); ++i)
+		{
+			if(nodes >= s_NodesPerJob)
+			{
+				jobStarts.push_back(i);
+				nodes = 0;
+			}
+			nodes += m_Ranges[i].m_End - m_Ranges[i].m_Begin;
+		}
+		jobStarts.push_back((uint32)m_Ranges.size());
+
+		auto updateRanges = [&](uint32 job) {
+			for(uint32 range = jobStarts[job]; range < jobStarts[job + 1]; ++range)
+			{
+				for(uint32 slot = m_Ranges[range].m_Begin; slot < m_Ranges[range].m_End; ++slot)
+					ComputeWorld(slot);
+			}
+		};
+
+		const uint32 jobCount = (uint32)jobStarts.size() - 1;
+		if(pool)
+		{
+			pool->Dispatch(jobCount, updateRanges);
+		}
+		else
+		{
+			for(uint32 job = 0; job < jobCount; ++job)
+				updateRanges(job);
+		}
+		return updated;
+	}
+
+	void TransformHierarchy::Split(uint32 begin, uint32 end)
+	{
+		// a range too big for one job has its root done right away, the subtrees of its children become the ranges
+		m_Pending.push_back({ begin, end });
+		while(!m_Pending.empty())
+		{
+			const Range range = m_Pending.back();
+			m_Pending.pop_back();
+			if(range.m_End - range.m_Begin <= s_NodesPerJob)
+			{
+				m_Ranges.push_back(range);
+				continue;
+			}
+
+			ComputeWorld(range.m_Begin);
+			for(uint32 child = range.m_Begin + 1; child < range.m_End; child = m_SubtreeEnds[child])
+				m_Pending.push_back({ child, m_SubtreeEnds[child] });
+		}
+	}
+
+	void TransformHierarchy::ComputeWorld(uint32 slot)
+	{
+		const float x = m_RotationX[slot];
+		const float y = m_RotationY[slot];
+		const float z = m_RotationZ[slot];
+		const float w = m_RotationW[slot];
+		const float scaleX = m_ScaleX[slot];
+		const float scaleY = m_ScaleY[slot];
+		const float scaleZ = m_ScaleZ[slot];
+
+		// rows are the rotated and scaled axes, the translation is the last row
+		Matrix44f local;
+		local[0] = (1.f - 2.f * (y * y + z * z)) * scaleX;
+		local[1] = 2.f * (x * y + w * z) * scaleX;
+		local[2] = 2.f * (x * z - w * y) * scaleX;
+		local[3] = 0.f;
+		local[4] = 2.f * (x * y - w * z) * scaleY;
+		local[5] = (1.f - 2.f * (x * x + z * z)) * scaleY;
+		local[6] = 2.f * (y * z + w * x) * scaleY;
+		local[7] = 0.f;
+		local[8] = 2.f * (x * z + w * y) * scaleZ;
+		local[9] = 2.f * (y * z - w * x) * scaleZ;
+		local[10] = (1.f - 2.f * (x * x + y * y)) * scaleZ;
+		local[11] = 0.f;
+		local[12] = m_PositionX[slot];
+		local[13] = m_PositionY[slot];
+		local[14] = m_PositionZ[slot];
+		local[15] = 1.f;
+
+		const uint32 parent = m_Parents[slot];
+		Matrix44f& world = m_World[slot];
+		if(parent == s_NoParent)
+		{
+			world = local;
+		}
+		else
+		{
+			// local first, then the parent's world
+			world = m_World[parent];
+			world *= local;
+		}
+	}
+
+	void TransformHierarchy::Sort()
+	{
+		const uint32 count = (uint32)m_Ids.size();
+
+		// children grouped by parent, in creation order
+		std::vector<uint32> firstChild(count + 1, 0);
+		for(uint32 slot = 0; slot < count; ++slot)
+		{
+			if(m_Parents[slot] != s_NoParent)
+				firstChild[m_Parents[slot] + 1]++;
+		}
+		for(uint32 slot = 0; slot < count; ++slot)
+			firstChild[slot + 1] += firstChild[slot];
+
+		std::vector<uint32> children(firstChild[count]);
+		std::vector<uint32> fill(firstChild.begin(), firstChild.end() - 1);
+		for(uint32 slot = 0; slot < count; ++slot)
+		{
+			if(m_Parents[slot] != s_NoParent)
+				children[fill[m_Parents[slot]]++] = slot;
+		}
+
+		// depth first, children are pushed in reverse so they come out in creation order
+		std::vector<uint32> order;
+		std::vector<uint32> stack;
+		order.reserve(count);
+		for(uint32 root = 0; root < count; ++root)
+		{
+			if(m_Parents[root] != s_NoParent)
+				continue;
+
+			stack.push_back(root);
+			while(!stack.empty())
+			{
+				const uint32 slot = stack.back();
+				stack.pop_back();
+				order.push_back(slot);
+				for(uint32 i = firstChild[slot + 1]; i > firstChild[slot]; --i)
+					stack.push_back(children[i - 1]);
+			}
+		}
+		ASSERT(order.size() == count, "Transform hierarchy has a cycle!");
+
+		std::vector<uint32> newSlots(count);
+		for(uint32 slot = 0; slot < count; ++slot)
+			newSlots[order[slot]] = slot;
+
+		for(uint32& parent : m_Parents)
+		{
+			if(parent != s_NoParent)
+				parent = newSlots[parent];
+		}
+
+		Permute(&m_Ids, order);
+		Permute(&m_Parents, order);
+		Permute(&m_PositionX, order);
+		Permute(&m_PositionY, order);
+		Permute(&m_PositionZ, order);
+		Permute(&m_RotationX, order);
+		Permute(&m_RotationY, order);
+		Permute(&m_RotationZ, order);
+		Permute(&m_RotationW, order);
+		Permute(&m_ScaleX, order);
+		Permute(&m_ScaleY, order);
+		Permute(&m_ScaleZ, order);
+		Permute(&m_World, order);
+
+		for(uint32 slot = 0; slot < count; ++slot)
+			m_Slots[m_Ids[slot]] = slot;
+
+		// children come after their parent, walking backwards finishes every subtree before its parent is reached
+		for(uint32 slot = 0; slot < count; ++slot)
+			m_SubtreeEnds[slot] = slot + 1;
+		for(uint32 slot = count; slot-- > 0;)
+		{
+			if(m_Parents[slot] != s_NoParent)
+				m_SubtreeEnds[m_Parents[slot]] = std::max(m_SubtreeEnds[m_Parents[slot]], m_SubtreeEnds[slot]);
+		}
+
+		// the dirty slots are stale, every root is updated instead
+		std::fill(m_Dirty.begin(), m_Dirty.end(), (uint8)0);
+		m_DirtySlots.clear();
+		for(uint32 slot = 0; slot < count; ++slot)
+		{
+			if(m_Parents[slot] == s_NoParent)
+				MarkDirty(slot);
+		}
+		m_Unsorted = false;
+	}
+
+}; // namespace Core
@@ -0,0 +1,90 @@
+#pragma once
+#include "Core/Types.h"
+#include "Core/math/Matrix44.h"
+
+#include <vector>
+
+/*
+	Parent and child transforms.
+
+	The local position, rotation and scale of every node live in separate arrays, and the nodes are kept in depth
+	first order: a parent comes before its children and every subtree is one contiguous range. Update only touches
+	the subtrees below nodes that changed. The dirty subtrees are disjoint ranges, so they are recomputed in parallel,
+	a range that is too big for one job is split into the subtrees of its children.
+
+	Nodes are created in any order, the depth first order is restored by the next Update. Ids stay the same when the
+	nodes move around inside the arrays.
+*/
+
+namespace Core
+{
+	class ThreadPool;
+
+	typedef uint32 TransformId;
+	constexpr TransformId s_NoParent = ~0u;
+
+	class TransformHierarchy
+	{
+	public:
+		TransformHierarchy() = default;
+		~TransformHierarchy() = default;
+
+		/* new nodes sit at the origin of their parent */
+		TransformId Create(TransformId parent = s_NoParent);
+
+		/* rotation is a unit quaternion, xyz is the axis times sin(angle / 2) and w is cos(angle / 2) */
+		void SetLocal(TransformId id, const Vector4f& position, const Vector4f& rotation, const Vector4f& scale);
+		void SetPosition(TransformId id, const Vector4f& position);
+		void SetRotation(TransformId id, const Vector4f& rotation);
+		void SetScale(TransformId id, const Vector4f& scale);
+
+		Vector4f GetPosition(TransformId id) const;
+		TransformId GetParent(TransformId id) const;
+
+		/* as of the last Update */
+		const Matrix44f& GetWorld(TransformId id) const { return m_World[m_Slots[id]]; }
+
+		/* returns how many world matrices were recomputed */
+		uint32 Update(ThreadPool* pool = nullptr);
+
+		uint32 GetCount() const { return (uint32)m_Slots.size(); }
+
+	private:
+		struct Range
+		{
+			uint32 m_Begin;
+			uint32 m_End;
+		};
+
+		void MarkDirty(uint32 slot);
+		void Sort();
+		void Split(uint32 begin, uint32 end);
+		void ComputeWorld(uint32 slot);
+
+		// by id, where the node currently is in the arrays below
+		std::vector<uint32> m_Slots;
+
+		// by slot
+		std::vector<TransformId> m_Ids;
+		std::vector<uint32> m_Parents; // slot of the parent, s_NoParent for roots
+		std::vector<uint32> m_SubtreeEnds;
+		std::vector<float> m_PositionX;
+		std::vector<float> m_PositionY;
+		std::vector<float> m_PositionZ;
+		std::vector<float> m_RotationX;
+		std::vector<float> m_RotationY;
+		std::vector<float> m_RotationZ;
+		std::vector<float> m_RotationW;
+		std::vector<float> m_ScaleX;
+		std::vector<float> m_ScaleY;
+		std::vector<float> m_ScaleZ;
+		std::vector<uint8> m_Dirty;
+		std::vector<Matrix44f> m_World;
+
+		std::vector<uint32> m_DirtySlots;
+		std::vector<Range> m_Ranges;
+		std::vector<Range> m_Pending;
+		bool m_Unsorted = false;
+	};
+
+}; // namespace Core
@@ -0,0 +1,323 @@
+#include "World.h"
+
+#include "Core/memory/MemoryTracker.h"
+#include "Core/threading/ThreadPool.h"
+#include "logger/Debug.h"
+
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+#include <new>
+
+namespace Core
+{
+	static std::mutex s_RegistryLock;
+	static ComponentInfo s_Components[s_MaxComponents];
+	static uint32 s_ComponentCount = 0;
+
+	ComponentId ComponentRegistry::Register(uint32 size, uint32 alignment)
+	{
+		std::lock_guard<std::mutex> lock(s_RegistryLock);
+		ASSERT(s_ComponentCount < s_MaxComponents, "Too many component types for the mask!");
+		ASSERT(alignment <= Archetype::s_ChunkAlignment, "Component is aligned beyond the chunk alignment!");
+		s_Components[s_ComponentCount].m_Size = size;
+		s_Components[s_ComponentCount].m_Alignment = alignment;
+		return s_ComponentCount++;
+	}
+
+	const ComponentInfo& ComponentRegistry::GetInfo(ComponentId id)
+	{
+		return s_Components[id];
+	}
+
+	Archetype::Archetype(ComponentMask mask) : m_Mask(mask)
+	{
+		uint32 rowSize = sizeof(Entity);
+		for(ComponentId id = 0; id < s_MaxComponents; ++id)
+		{
+			if(!Has(id))
+				continue;
+
+			m_Components.push_back(id);
+			rowSize += ComponentRegistry::GetInfo(id).m_Size;
+		}
+
+		// leave room for aligning every array, then place the arrays one after the other
+		const uint32 padding = (uint32)(m_Components.size() + 1) * s_ChunkAlignment;
+		ASSERT(rowSize + padding <= s_ChunkSize, "Components do not fit into a chunk!");
+		m_Capacity = (s_ChunkSize - padding) / rowSize;
+
+		uint32 offset = m_Capacity * sizeof(Entity);
+		for(ComponentId id : m_Components)
+		{
+			// 16 at least, math types load with aligned SSE
+			const ComponentInfo& info = ComponentRegistry::GetInfo(id);
+			const uint32 alignment = std::max(info.m_Alignment, 16u);
+			offset = (offset + alignment - 1) & ~(alignment - 1);
+			m_Offsets[id] = offset;
+			offset += m_Capacity * info.m_Size;
+		}
+		ASSERT(offset <= s_ChunkSize, "Chunk layout overflows!");
+	}
+
+	static uint8* AllocateChunk()
+	{
+		uint8* data = (uint8*)::operator new(Archetype::s_ChunkSize, std::align_val_t(Archetype::s_ChunkAlignment));
+		MemoryTracker::Get().OnAllocate(data, Archetype::s_ChunkSize, EMemoryTag_Core);
+		return data;
+	}
+
+	static void FreeChunk(uint8* data)
+	{
+		MemoryTracker::Get().OnFree(data);
+		::operator delete(data, std::align_val_t(Archetype::s_ChunkAlignment));
+	}
+
+	Archetype::~Archetype()
+	{
+		for(Chunk& chunk : m_Chunks)
+			FreeChunk(chunk.m_Data);
+	}
+
+	void Archetype::Push(Entity entity, uint32* chunk, uint32* row)
+	{
+		if(m_Chunks.empty() || m_Chunks.back().m_Count == m_Capacity)
+		{
+			Chunk newChunk;
+			newChunk.m_Data = AllocateChunk();
+			m_Chunks.push_back(newChunk);
+		}
+
+		*chunk = (uint32)m_Chunks.size() - 1;
+		Chunk& last = m_Chunks.back();
+		*row = last.m_Count++;
+		((Entity*)last.m_Data)[*row] = entity;
+		m_EntityCount++;
+	}
+
+	Entity Archetype::Remove(uint32 chunk, uint32 row)
+	{
+		Chunk& last = m_Chunks.back();
+		const uint32 lastRow = last.m_Count - 1;
+		Entity moved;
+
+		if(&m_Chunks[chunk] != &last || row != lastRow)
+		{
+			uint8* data = m_Chunks[chunk].m_Data;
+			moved = ((Entity*)last.m_Data)[lastRow];
+			((Entity*)data)[row] = moved;
+			for(ComponentId id : m_Components)
+			{
+				const uint32 size = ComponentRegistry::GetInfo(id).m_Size;
+				memcpy(data + m_Offsets[id] + row * size, last.m_Data + m_Offsets[id] + lastRow * size, size);
+			}
+		}
+
+		m_EntityCount--;
+		if(--last.m_Count == 0)
+		{
+			FreeChunk(last.m_Data);
+			m_Chunks.pop_back();
+		}
+		return moved;
+	}
+
+	Entity World::CreateEntity(const ComponentId* ids, const void* const* data, uint32 count)
+	{
+		ASSERT(m_Iterating == 0, "Structural change while iterating, use an EntityCommandBuffer!");
+
+		ComponentMask mask = 0;
+		for(uint32 i = 0; i < count; ++i)
+			mask |= ComponentMask(1) << ids[i];
+
+		Entity entity;
+		if(!m_FreeRecords.empty())
+		{
+			entity.m_Index = m_FreeRecords.back();
+			m_FreeRecords.pop_back();
+		}
+		else
+		{
+			entity.m_Index = (uint32)m_Records.size();
+			m_Records.push_back(Record());
+		}
+
+		Record& record = m_Records[entity.m_Index];
+		entity.m_Generation = record.m_Generation;
+		record.m_Archetype = GetArchetype(mask);
+		record.m_Archetype->Push(entity, &record.m_Chunk, &record.m_Row);
+
+		for(uint32 i = 0; i < count; ++i)
+			memcpy(GetComponent(entity, ids[i]), data[i], ComponentRegistry::GetInfo(ids[i]).m_Size);
+
+		m_EntityCount++;
+		return entity;
+	}
+
+	void World::DestroyEntity(Entity entity)
+	{
+		ASSERT(m_Iterating == 0, "Structural change while iterating, use an EntityCommandBuffer!");
+		ASSERT(IsAlive(entity), "Destroying a dead entity!");
+
+		Record& record = m_Records[entity.m_Index];
+		Remove(&record);
+		record.m_Archetype = nullptr;
+		if(++record.m_Generation == 0)
+			record.m_Generation = 1;
+		m_FreeRecords.push_back(entity.m_Index);
+		m_EntityCount--;
+	}
+
+	bool World::IsAlive(Entity entity) const
+	{
+		return GetRecord(entity) != nullptr;
+	}
+
+	void World::AddComponent(Entity entity, ComponentId id, const void* data)
+	{
+		ASSERT(m_Iterating == 0, "Structural change while iterating, use an EntityCommandBuffer!");
+		ASSERT(IsAlive(entity), "Adding a component to a dead entity!");
+
+		const Record& record = m_Records[entity.m_Index];
+		if(!record.m_Archetype->Has(id))
+			Move(entity, GetArchetype(record.m_Archetype->GetMask() | (ComponentMask(1) << id)));
+
+		memcpy(GetComponent(entity, id), data, ComponentRegistry::GetInfo(id).m_Size);
+	}
+
+	void World::RemoveComponent(Entity entity, ComponentId id)
+	{
+		ASSERT(m_Iterating == 0, "Structural change while iterating, use an EntityCommandBuffer!");
+		ASSERT(IsAlive(entity), "Removing a component from a dead entity!");
+
+		const Record& record = m_Records[entity.m_Index];
+		if(record.m_Archetype->Has(id))
+			Move(entity, GetArchetype(record.m_Archetype->GetMask() & ~(ComponentMask(1) << id)));
+	}
+
+	void* World::GetComponent(Entity entity, ComponentId id) const
+	{
+		const Record* record = GetRecord(entity);
+		if(!record || !record->m_Archetype->Has(id))
+			return nullptr;
+
+		const uint32 size = ComponentRegistry::GetInfo(id).m_Size;
+		return (uint8*)record->m_Archetype->GetArray(record->m_Chunk, id) + record->m_Row * size;
+	}
+
+	Query* World::CreateQuery(ComponentMask include, ComponentMask exclude)
+	{
+		for(const std::unique_ptr<Query>& query : m_Queries)
+		{
+			if(query->m_Include == include && query->m_Exclude == exclude)
+				return query.get();
+		}
+
+		Query* query = new Query();
+		query->m_Include = include;
+		query->m_Exclude = exclude;
+		for(const auto& archetype : m_Archetypes)
+		{
+			const ComponentMask mask = archetype.m_Key;
+			if((mask & include) == include && (mask & exclude) == 0)
+				query->m_Archetypes.push_back(archetype.m_Value.get());
+		}
+		m_Queries.emplace_back(query);
+		return query;
+	}
+
+	Archetype* World::GetArchetype(ComponentMask mask)
+	{
+		if(std::unique_ptr<Archetype>* existing = m_Archetypes.Find(mask))
+			return existing->get();
+
+		Archetype* archetype = new Archetype(mask);
+		m_Archetypes.Insert(mask, std::unique_ptr<Archetype>(archetype));
+		for(const std::unique_ptr<Query>& query : m_Queries)
+		{
+			if((mask & query->m_Include) == query->m_Include && (mask & query->m_Exclude) == 0)
+				query->m_Archetypes.push_back(archetype);
+		}
+		return archetype;
+	}
+
+	const World::Record* World::GetRecord(Entity entity) const
+	{
+		if(entity.m_Index >= m_Records.size())
+			return nullptr;
+
+		const Record& record = m_Records[entity.m_Index];
+		if(record.m_Generation != entity.m_Generation || !record.m_Archetype)
+			return nullptr;
+		return &record;
+	}
+
+	void World::Move(Entity entity, Archetype* target)
+	{
+		Record& record = m_Records[entity.m_Index];
+		Archetype* source = record.m_Archetype;
+
+		uint32 chunk = 0;
+		uint32 row = 0;
+		target->Push(entity, &chunk, &row);
+
+		for(ComponentId id : source->m_Components)
+		{
+			if(!target->Has(id))
+				continue;
+
+			const uint32 size = ComponentRegistry::GetInfo(id).m_Size;
+			memcpy((uint8*)target->GetArray(chunk, id) + row * size,
+				   (const uint8*)source->GetArray(record.m_Chunk, id) + record.m_Row * size, size);
+		}
+
+		Remove(&record);
+		record.m_Archetype = target;
+		record.m_Chunk = chunk;
+		record.m_Row = row;
+	}
+
+	void World::Remove(Record* record)
+	{
+		const Entity moved = record->m_Archetype->Remove(record->m_Chunk, record->m_Row);
+		if(moved.m_Generation == 0)
+			return;
+
+		Record& movedRecord = m_Records[moved.m_Index];
+		movedRecord.m_Chunk = record->m_Chunk;
+		movedRecord.m_Row = record->m_Row;
+	}
+
+	uint32 World::GetEntityCount(const Query* query) const
+	{
+		uint32 count = 0;
+		for(const Archetype* archetype : query->m_Archetypes)
+			count += archetype->GetEntityCount();
+		return count;
+	}
+
+	void World::GatherChunks(const Query* query)
+	{
+		m_ChunkRefs.clear();
+		for(Archetype* archetype : query->m_Archetypes)
+		{
+			for(uint32 chunk = 0; chunk < archetype->GetChunkCount(); ++chunk)
+				m_ChunkRefs.push_back({ archetype, chunk });
+		}
+	}
+
+	void World::DispatchChunks(ThreadPool* pool, const std::function<void(uint32)>& job)
+	{
+		const uint32 jobCount = (uint32)m_ChunkRefs.size();
+		if(pool)
+		{
+			pool->Dispatch(jobCount, job);
+		}
+		else
+		{
+			for(uint32 i = 0; i < jobCount; ++i)
+				job(i);
+		}
+	}
+
+}; // namespace Core
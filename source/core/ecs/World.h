@@ -0,0 +1,283 @@
+#pragma once
+#include "Core/Types.h"
+#include "Core/containers/HashMap.h"
+
+#include <functional>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+/*
+	Archetype based entity component system.
+
+	Every distinct set of components is an archetype. The entities of an archetype live in fixed size chunks, a chunk
+	stores its entities followed by one tightly packed array per component, so a system that reads two components
+	streams through two arrays and touches nothing else. Removing an entity moves the last entity of the archetype
+	into the hole, chunks stay dense.
+
+	Adding or removing a component moves the entity to another archetype. These structural changes are not allowed
+	while a query is being iterated, record them into an EntityCommandBuffer and play it back afterwards.
+
+	Queries are cached, a query keeps the list of archetypes that match it and new archetypes are added to the
+	queries as they are created. Chunks move components with memcpy and never run their destructors, components must
+	be plain data that owns nothing.
+*/
+
+namespace Core
+{
+	class ThreadPool;
+
+	struct Entity
+	{
+		uint32 m_Index = 0;
+		uint32 m_Generation = 0; // live entities start at generation 1, a default entity is never alive
+
+		bool operator==(const Entity& other) const
+		{
+			return m_Index == other.m_Index && m_Generation == other.m_Generation;
+		}
+		bool operator!=(const Entity& other) const { return !(*this == other); }
+	};
+
+	typedef uint32 ComponentId;
+	typedef uint64 ComponentMask;
+	constexpr uint32 s_MaxComponents = 64;
+
+	struct ComponentInfo
+	{
+		uint32 m_Size = 0;
+		uint32 m_Alignment = 0;
+	};
+
+	/* ids are handed out the first time a component type is used */
+	class ComponentRegistry
+	{
+	public:
+		template <typename T>
+		static ComponentId GetId()
+		{
+			static_assert(std::is_trivially_destructible<T>::value,
+						  "Components are moved with memcpy and never destroyed!");
+			static const ComponentId id = Register(sizeof(T), alignof(T));
+			return id;
+		}
+
+		template <typename... Ts>
+		static ComponentMask GetMask()
+		{
+			return (ComponentMask(0) | ... | (ComponentMask(1) << GetId<Ts>()));
+		}
+
+		static const ComponentInfo& GetInfo(ComponentId id);
+
+	private:
+		static ComponentId Register(uint32 size, uint32 alignment);
+	};
+
+	class Archetype
+	{
+	public:
+		static constexpr uint32 s_ChunkSize = 16 * 1024;
+		static constexpr uint32 s_ChunkAlignment = 64;
+
+		struct Chunk
+		{
+			uint8* m_Data = nullptr;
+			uint32 m_Count = 0;
+		};
+
+		explicit Archetype(ComponentMask mask);
+		~Archetype();
+
+		ComponentMask GetMask() const { return m_Mask; }
+		uint32 GetCapacity() const { return m_Capacity; }
+		uint32 GetChunkCount() const { return (uint32)m_Chunks.size(); }
+		uint32 GetEntityCount() const { return m_EntityCount; }
+		const Chunk& GetChunk(uint32 chunk) const { return m_Chunks[chunk]; }
+
+		Entity* GetEntities(uint32 chunk) const { return (Entity*)m_Chunks[chunk].m_Data; }
+		void* GetArray(uint32 chunk, ComponentId id) const { return m_Chunks[chunk].m_Data + m_Offsets[id]; }
+
+		template <typename T>
+		T* GetArray(uint32 chunk) const
+		{
+			return (T*)GetArray(chunk, ComponentRegistry::GetId<T>());
+		}
+
+		bool Has(ComponentId id) const { return (m_Mask & (ComponentMask(1) << id)) != 0; }
+
+	private:
+		friend class World;
+
+		/* appends an entity with uninitialized components, returns its chunk and row */
+		void Push(Entity entity, uint32* chunk, uint32* row);
+
+		/* fills the hole with the last entity and returns it, a default entity when the hole was the last one */
+		Entity Remove(uint32 chunk, uint32 row);
+
+		ComponentMask m_Mask = 0;
+		uint32 m_Capacity = 0;
+		uint32 m_EntityCount = 0;
+		uint32 m_Offsets[s_MaxComponents] = {};
+		std::vector<ComponentId> m_Components;
+		std::vector<Chunk> m_Chunks;
+	};
+
+	struct Query
+	{
+		ComponentMask m_Include = 0;
+		ComponentMask m_Exclude = 0;
+		std::vector<Archetype*> m_Archetypes;
+	};
+
+	class World
+	{
+	public:
+		World() = default;
+		~World() = default;
+
+		World(const World&) = delete;
+		World& operator=(const World&) = delete;
+
+		template <typename... Ts>
+		Entity CreateEntity(const Ts&... components)
+		{
+			const ComponentId ids[] = { ComponentRegistry::GetId<Ts>()..., 0 };
+			const void* const data[] = { &components..., nullptr };
+			return CreateEntity(ids, data, (uint32)sizeof...(Ts));
+		}
+
+		void DestroyEntity(Entity entity);
+		bool IsAlive(Entity entity) const;
+
+		template <typename T>
+		void AddComponent(Entity entity, const T& component)
+		{
+			AddComponent(entity, ComponentRegistry::GetId<T>(), &component);
+		}
+
+		template <typename T>
+		void RemoveComponent(Entity entity)
+		{
+			RemoveComponent(entity, ComponentRegistry::GetId<T>());
+		}
+
+		/* nullptr when the entity does not have the component */
+		template <typename T>
+		T* GetComponent(Entity entity) const
+		{
+			return (T*)GetComponent(entity, ComponentRegistry::GetId<T>());
+		}
+
+		template <typename T>
+		bool HasComponent(Entity entity) const
+		{
+			return GetComponent(entity, ComponentRegistry::GetId<T>()) != nullptr;
+		}
+
+		/* type erased versions, for the command buffer */
+		Entity CreateEntity(const ComponentId* ids, const void* const* data, uint32 count);
+		void AddComponent(Entity entity, ComponentId id, const void* data);
+		void RemoveComponent(Entity entity, ComponentId id);
+		void* GetComponent(Entity entity, ComponentId id) const;
+
+		/* entities with all of Ts and none of exclude, the same query is returned for the same masks */
+		template <typename... Ts>
+		Query* CreateQuery(ComponentMask exclude = 0)
+		{
+			return CreateQuery(ComponentRegistry::GetMask<Ts...>(), exclude);
+		}
+		Query* CreateQuery(ComponentMask include, ComponentMask exclude);
+
+		/* function(uint32 count, const Entity* entities, Ts* arrays...) once per chunk */
+		template <typename... Ts, typename Function>
+		void ForEachChunk(const Query* query, Function function)
+		{
+			IterationScope scope(this);
+			for(Archetype* archetype : query->m_Archetypes)
+			{
+				for(uint32 chunk = 0; chunk < archetype->GetChunkCount(); ++chunk)
+					function(archetype->GetChunk(chunk).m_Count, (const Entity*)archetype->GetEntities(chunk),
+							 archetype->GetArray<Ts>(chunk)...);
+			}
+		}
+
+		/* function(Ts&... components) once per entity */
+		template <typename... Ts, typename Function>
+		void ForEach(const Query* query, Function function)
+		{
+			ForEachChunk<Ts...>(query, [&](uint32 count, const Entity*, Ts*... arrays) {
+				for(uint32 i = 0; i < count; ++i)
+					function(arrays[i]...);
+			});
+		}
+
+		/* like ForEach with one job per chunk, function runs on several threads at once */
+		template <typename... Ts, typename Function>
+		void ParallelForEach(const Query* query, ThreadPool* pool, Function function)
+		{
+			IterationScope scope(this);
+			GatherChunks(query);
+			auto job = [&](uint32 index) {
+				const ChunkRef& ref = m_ChunkRefs[index];
+				const uint32 count = ref.m_Archetype->GetChunk(ref.m_Chunk).m_Count;
+				RunChunk(count, function, ref.m_Archetype->GetArray<Ts>(ref.m_Chunk)...);
+			};
+			DispatchChunks(pool, job);
+		}
+
+		uint32 GetEntityCount() const { return m_EntityCount; }
+		/* the entities the query matches */
+		uint32 GetEntityCount(const Query* query) const;
+		uint32 GetArchetypeCount() const { return m_Archetypes.GetCount(); }
+
+	private:
+		struct Record
+		{
+			Archetype* m_Archetype = nullptr;
+			uint32 m_Chunk = 0;
+			uint32 m_Row = 0;
+			uint32 m_Generation = 1;
+		};
+
+		struct ChunkRef
+		{
+			Archetype* m_Archetype;
+			uint32 m_Chunk;
+		};
+
+		/* structural changes assert while a scope is open */
+		struct IterationScope
+		{
+			explicit IterationScope(World* world) : m_World(world) { m_World->m_Iterating++; }
+			~IterationScope() { m_World->m_Iterating--; }
+			World* m_World;
+		};
+
+		template <typename Function, typename... Ts>
+		static void RunChunk(uint32 count, Function& function, Ts*... arrays)
+		{
+			for(uint32 i = 0; i < count; ++i)
+				function(arrays[i]...);
+		}
+
+		Archetype* GetArchetype(ComponentMask mask);
+		const Record* GetRecord(Entity entity) const;
+
+		/* moves the entity and the components both archetypes have, the new components are left uninitialized */
+		void Move(Entity entity, Archetype* target);
+		void Remove(Record* record);
+
+		void GatherChunks(const Query* query);
+		void DispatchChunks(ThreadPool* pool, const std::function<void(uint32)>& job);
+
+		HashMap<ComponentMask, std::unique_ptr<Archetype>> m_Archetypes;
+		std::vector<std::unique_ptr<Query>> m_Queries;
+		std::vector<Record> m_Records;
+		std::vector<uint32> m_FreeRecords;
+		std::vector<ChunkRef> m_ChunkRefs;
+		uint32 m_EntityCount = 0;
+		uint32 m_Iterating = 0;
+	};
+
+}; // namespace Core
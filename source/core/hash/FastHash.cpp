@@ -0,0 +1,366 @@
+#include "FastHash.h"
+
+#include <cstring>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define FASTHASH_AVX2
+#elif defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define FASTHASH_SSE2
+#endif
+
+namespace Core
+{
+	// short inputs, from wyhash
+	constexpr uint64 s_Secret[4] = { 0x2d358dccaa6c78a5ull, 0x8bb84b93962eacc9ull, 0x4b33a62ed433d4a3ull,
+									 0x4d5a2da51de1aa47ull };
+
+	// long inputs, lanes 0 to 22 key the stripes of a block, 16 to 23 key the scramble and the final merge
+	alignas(32) constexpr uint64 s_Keys[24] = {
+		0x1ac046dda8e86e2aull, 0xbe2c3b00b1d348c8ull, 0x9b1a66a95412ff75ull, 0xc448c2b1f05f7e4cull,
+		0xc111ca6b8f6e73c4ull, 0xb54861920d05b01dull, 0x8d61500f4a7bbe16ull, 0x5e0c25471f89e02eull,
+		0x48105a3d28f0e221ull, 0x2169f8846b637746ull, 0x3d628782e0c0d863ull, 0xa5ddb2216078aa40ull,
+		0xc8119d17f0571101ull, 0x98e2e2eb8f33280full, 0x8cd1e28860679cc4ull, 0x9dca6189c923aef3ull,
+		0x9d8d3071ba4f04c4ull, 0x5d395ada34220c26ull, 0xe6de42a441a1e28eull, 0x308fbf68cc864f59ull,
+		0x216a3c81332862f9ull, 0xbaceca0a77f3132eull, 0xdf2a2215339ca69cull, 0x3e4c11a103a5d859ull,
+	};
+
+	constexpr uint64 s_AccumulatorInit[8] = {
+		0x6d0f173ffec5f603ull, 0x0bf4bc630d193bb6ull, 0x5f76c4ad104b57fdull, 0x99ca459f4e93f651ull,
+		0x4751799d68cf88a0ull, 0xa6b1639e3b42b61cull, 0x278b01031924ea35ull, 0x430253eb7e993605ull,
+	};
+
+	constexpr uint32 s_StripesPerBlock = 16;
+	constexpr uint32 s_StripeSize = 64;
+	constexpr uint32 s_ShortSize = 128;
+	constexpr uint64 s_ScramblePrime = 0x9e3779b1ull;
+
+	static uint64 Read64(const uint8* data)
+	{
+		uint64 value;
+		memcpy(&value, data, sizeof(value));
+		return value;
+	}
+
+	static uint64 Read32(const uint8* data)
+	{
+		uint32 value;
+		memcpy(&value, data, sizeof(value));
+		return value;
+	}
+
+	static void Multiply128(uint64 a, uint64 b, uint64* low, uint64* high)
+	{
+#if defined(_MSC_VER) && defined(_M_X64)
+		*low = _umul128(a, b, high);
+#else
+		const unsigned __int128 product = (unsigned __int128)a * b;
+		*low = (uint64)product;
+		*high = (uint64)(product >> 64);
+#endif
+	}
+
+	static uint64 Avalanche(uint64 hash)
+	{
+		hash ^= hash >> 37;
+		hash *= 0x165667919e3779f9ull;
+		hash ^= hash >> 32;
+		return hash;
+	}
+
+	static uint64 MixSeed(uint64 seed)
+	{
+		return seed ^ HashMix(seed ^ s_Secret[0], s_Secret[1]);
+	}
+
+	static Hash128 HashShort(const uint8* data, size_t size, uint64 seed)
+	{
+		seed = MixSeed(seed);
+
+		uint64 a = 0;
+		uint64 b = 0;
+		if(size <= 16)
+		{
+			if(size >= 4)
+			{
+				// two overlapping reads from each end cover 4 to 16 bytes
+				const size_t step = (size >> 3) << 2;
+				a = (Read32(data) << 32) | Read32(data + step);
+				b = (Read32(data + size - 4) << 32) | Read32(data + size - 4 - step);
+			}
+			else if(size > 0)
+			{
+				a = ((uint64)data[0] << 16) | ((uint64)data[size >> 1] << 8) | data[size - 1];
+			}
+		}
+		else
+		{
+			size_t remaining = size;
+			const uint8* read = data;
+			while(remaining > 16)
+			{
+				seed = HashMix(Read64(read) ^ s_Secret[1], Read64(read + 8) ^ seed);
+				read += 16;
+				remaining -= 16;
+			}
+			a = Read64(data + size - 16);
+			b = Read64(data + size - 8);
+		}
+
+		uint64 low;
+		uint64 high;
+		Multiply128(a ^ s_Secret[1], b ^ seed, &low, &high);
+
+		Hash128 hash;
+		hash.m_Low = HashMix(low ^ s_Secret[0] ^ size, high ^ s_Secret[1]);
+		hash.m_High = HashMix(low ^ s_Secret[2] ^ size, high ^ s_Secret[3]);
+		return hash;
+	}
+
+	// acc[i] += lo32(d ^ k) * hi32(d ^ k) and the neighbouring lane's data
+	static void AccumulateScalar(uint64* accumulators, const uint8* stripe, const uint64* keys)
+	{
+		for(uint32 lane = 0; lane < 8; ++lane)
+		{
+			const uint64 data = Read64(stripe + lane * 8);
+			const uint64 keyed = data ^ keys[lane];
+			accumulators[lane ^ 1] += data;
+			accumulators[lane] += (keyed & 0xffffffffull) * (keyed >> 32);
+		}
+	}
+
+	static void ScrambleScalar(uint64* accumulators)
+	{
+		for(uint32 lane = 0; lane < 8; ++lane)
+		{
+			uint64 accumulator = accumulators[lane];
+			accumulator ^= accumulator >> 47;
+			accumulator ^= s_Keys[16 + lane];
+			accumulators[lane] = accumulator * s_ScramblePrime;
+		}
+	}
+
+#if defined(FASTHASH_AVX2)
+	static void AccumulateSimd(uint64* accumulators, const uint8* stripe, const uint64* keys)
+	{
+		for(uint32 i = 0; i < 2; ++i)
+		{
+			__m256i* accumulator = (__m256i*)accumulators + i;
+			const __m256i data = _mm256_loadu_si256((const __m256i*)stripe + i);
+			const __m256i keyed = _mm256_xor_si256(data, _mm256_loadu_si256((const __m256i*)keys + i));
+			const __m256i product = _mm256_mul_epu32(keyed, _mm256_srli_epi64(keyed, 32));
+			const __m256i swapped = _mm256_shuffle_epi32(data, _MM_SHUFFLE(1, 0, 3, 2));
+			const __m256i sum = _mm256_add_epi64(_mm256_loadu_si256(accumulator), _mm256_add_epi64(product, swapped));
+			_mm256_storeu_si256(accumulator, sum);
+		}
+	}
+
+	static void ScrambleSimd(uint64* accumulators)
+	{
+		const __m256i prime = _mm256_set1_epi32((int)s_ScramblePrime);
+		for(uint32 i = 0; i < 2; ++i)
+		{
+			__m256i* accumulator = (__m256i*)accumulators + i;
+			__m256i value = _mm256_loadu_si256(accumulator);
+			value = _mm256_xor_si256(value, _mm256_srli_epi64(value, 47));
+			value = _mm256_xor_si256(value, _mm256_load_si256((const __m256i*)&s_Keys[16] + i));
+			const __m256i low = _mm256_mul_epu32(value, prime);
+			const __m256i high = _mm256_mul_epu32(_mm256_srli_epi64(value, 32), prime);
+			_mm256_storeu_si256(accumulator, _mm256_add_epi64(low, _mm256_slli_epi64(high, 32)));
+		}
+	}
+#elif defined(FASTHASH_SSE2)
+	static void AccumulateSimd(uint64* accumulators, const uint8* stripe, const uint64* keys)
+	{
+		for(uint32 i = 0; i < 4; ++i)
+		{
+			__m128i* accumulator = (__m128i*)accumulators + i;
+			const __m128i data = _mm_loadu_si128((const __m128i*)stripe + i);
+			const __m128i keyed = _mm_xor_si128(data, _mm_loadu_si128((const __m128i*)keys + i));
+			const __m128i product = _mm_mul_epu32(keyed, _mm_srli_epi64(keyed, 32));
+			const __m128i swapped = _mm_shuffle_epi32(data, _MM_SHUFFLE(1, 0, 3, 2));
+			const __m128i sum = _mm_add_epi64(_mm_loadu_si128(accumulator), _mm_add_epi64(product, swapped));
+			_mm_storeu_si128(accumulator, sum);
+		}
+	}
+
+	static void ScrambleSimd(uint64* accumulators)
+	{
+		const __m128i prime = _mm_set1_epi32((int)s_ScramblePrime);
+		for(uint32 i = 0; i < 4; ++i)
+		{
+			__m128i* accumulator = (__m128i*)accumulators + i;
+			__m128i value = _mm_loadu_si128(accumulator);
+			value = _mm_xor_si128(value, _mm_srli_epi64(value, 47));
+			value = _mm_xor_si128(value, _mm_load_si128((const __m128i*)&s_Keys[16] + i));
+			const __m128i low = _mm_mul_epu32(value, prime);
+			const __m128i high = _mm_mul_epu32(_mm_srli_epi64(value, 32), prime);
+			_mm_storeu_si128(accumulator, _mm_add_epi64(low, _mm_slli_epi64(high, 32)));
+		}
+	}
+#else
+	static void AccumulateSimd(uint64* accumulators, const uint8* stripe, const uint64* keys)
+	{
+		AccumulateScalar(accumulators, stripe, keys);
+	}
+
+	static void ScrambleSimd(uint64* accumulators)
+	{
+		ScrambleScalar(accumulators);
+	}
+#endif
+
+	static void InitAccumulators(uint64* accumulators, uint64 seed)
+	{
+		seed = MixSeed(seed);
+		for(uint32 lane = 0; lane < 8; ++lane)
+			accumulators[lane] = s_AccumulatorInit[lane] ^ seed;
+	}
+
+	/* the stripe index within its block picks the keys, every 16 stripes the accumulators are scrambled */
+	template <bool Simd>
+	static void ConsumeStripes(uint64* accumulators, uint32* stripe, const uint8* data, size_t count)
+	{
+		for(size_t i = 0; i < count; ++i)
+		{
+			if(Simd)
+				AccumulateSimd(accumulators, data + i * s_StripeSize, &s_Keys[*stripe]);
+			else
+				AccumulateScalar(accumulators, data + i * s_StripeSize, &s_Keys[*stripe]);
+
+			if(++*stripe == s_StripesPerBlock)
+			{
+				if(Simd)
+					ScrambleSimd(accumulators);
+				else
+					ScrambleScalar(accumulators);
+				*stripe = 0;
+			}
+		}
+	}
+
+	/* the last partial stripe is padded with zeros, the size tells it apart from real zeros */
+	template <bool Simd>
+	static Hash128 FinishLong(const uint64* accumulators, uint32 stripe, const uint8* tail, size_t tailSize,
+							  uint64 size)
+	{
+		alignas(32) uint64 state[8];
+		memcpy(state, accumulators, sizeof(state));
+		if(tailSize > 0)
+		{
+			alignas(16) uint8 padded[s_StripeSize] = {};
+			memcpy(padded, tail, tailSize);
+			ConsumeStripes<Simd>(state, &stripe, padded, 1);
+		}
+
+		Hash128 hash;
+		hash.m_Low = size * 0x9e3779b185ebca87ull;
+		hash.m_High = ~size * 0xc2b2ae3d27d4eb4full;
+		for(uint32 lane = 0; lane < 8; lane += 2)
+		{
+			hash.m_Low += HashMix(state[lane] ^ s_Keys[16 + lane], state[lane + 1] ^ s_Keys[17 + lane]);
+			hash.m_High += HashMix(state[lane] ^ s_Keys[lane], state[lane + 1] ^ s_Keys[lane + 1]);
+		}
+		hash.m_Low = Avalanche(hash.m_Low);
+		hash.m_High = Avalanche(hash.m_High);
+		return hash;
+	}
+
+	template <bool Simd>
+	static Hash128 HashLong(const uint8* data, size_t size, uint64 seed)
+	{
+		alignas(32) uint64 accumulators[8];
+		uint32 stripe = 0;
+		InitAccumulators(accumulators, seed);
+
+		const size_t stripes = size / s_StripeSize;
+		ConsumeStripes<Simd>(accumulators, &stripe, data, stripes);
+		return FinishLong<Simd>(accumulators, stripe, data + stripes * s_StripeSize, size % s_StripeSize, size);
+	}
+
+	uint64 Hash64(const void* data, size_t size, uint64 seed)
+	{
+		return Hash128Bit(data, size, seed).m_Low;
+	}
+
+	Hash128 Hash128Bit(const void* data, size_t size, uint64 seed)
+	{
+		if(size <= s_ShortSize)
+			return HashShort((const uint8*)data, size, seed);
+		return HashLong<true>((const uint8*)data, size, seed);
+	}
+
+	uint64 Hash64Reference(const void* data, size_t size, uint64 seed)
+	{
+		if(size <= s_ShortSize)
+			return HashShort((const uint8*)data, size, seed).m_Low;
+		return HashLong<false>((const uint8*)data, size, seed).m_Low;
+	}
+
+	void HashStream::Reset(uint64 seed)
+	{
+		m_Seed = seed;
+		m_Size = 0;
+		m_Stripe = 0;
+		m_Buffered = 0;
+		m_Long = false;
+		InitAccumulators(m_Accumulators, seed);
+	}
+
+	void HashStream::Update(const void* data, size_t size)
+	{
+		const uint8* read = (const uint8*)data;
+		m_Size += size;
+
+		// up to s_ShortSize bytes could still be a short hash, they wait in the buffer
+		if(!m_Long)
+		{
+			if(m_Buffered + size <= s_ShortSize)
+			{
+				memcpy(m_Buffer + m_Buffered, read, size);
+				m_Buffered += (uint32)size;
+				return;
+			}
+
+			const uint32 fill = s_ShortSize - m_Buffered;
+			memcpy(m_Buffer + m_Buffered, read, fill);
+			ConsumeStripes<true>(m_Accumulators, &m_Stripe, m_Buffer, s_ShortSize / s_StripeSize);
+			m_Buffered = 0;
+			m_Long = true;
+			read += fill;
+			size -= fill;
+		}
+
+		if(m_Buffered > 0)
+		{
+			const uint32 fill = (uint32)(size < s_StripeSize - m_Buffered ? size : s_StripeSize - m_Buffered);
+			memcpy(m_Buffer + m_Buffered, read, fill);
+			m_Buffered += fill;
+			read += fill;
+			size -= fill;
+			if(m_Buffered < s_StripeSize)
+				return;
+			ConsumeStripes<true>(m_Accumulators, &m_Stripe, m_Buffer, 1);
+			m_Buffered = 0;
+		}
+
+		const size_t stripes = size / s_StripeSize;
+		ConsumeStripes<true>(m_Accumulators, &m_Stripe, read, stripes);
+		m_Buffered = (uint32)(size - stripes * s_StripeSize);
+		memcpy(m_Buffer, read + stripes * s_StripeSize, m_Buffered);
+	}
+
+	uint64 HashStream::Finish() const
+	{
+		return Finish128().m_Low;
+	}
+
+	Hash128 HashStream::Finish128() const
+	{
+		if(!m_Long)
+			return HashShort(m_Buffer, m_Buffered, m_Seed);
+		return FinishLong<true>(m_Accumulators, m_Stripe, m_Buffer, m_Buffered, m_Size);
+	}
+
+}; // namespace Core
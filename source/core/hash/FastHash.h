@@ -0,0 +1,92 @@
+#pragma once
+#include "Core/Types.h"
+
+#include <cstddef>
+#include <type_traits>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+/*
+	Fast non-cryptographic 64 and 128 bit hashing of memory.
+
+	Up to 128 bytes are hashed wyhash style, 16 bytes at a time folded through 64x64 -> 128 bit multiplies. Longer
+	inputs go through eight 64 bit accumulators fed 64 byte stripes, xxHash3 style, with a scramble every 16 stripes.
+	The stripe loop uses AVX2 when the build enables it, SSE2 on every other x64 build and plain C++ elsewhere, all
+	three give the same hashes. Hash64Reference is the plain C++ version, for checking the others.
+
+	HashStream hashes data that arrives in pieces and gives the same hash as hashing it in one go. The hashes are
+	meant for hash tables, caches and change detection, never for anything that has to withstand an attacker.
+*/
+
+namespace Core
+{
+	struct Hash128
+	{
+		uint64 m_Low = 0;
+		uint64 m_High = 0;
+
+		bool operator==(const Hash128& other) const { return m_Low == other.m_Low && m_High == other.m_High; }
+		bool operator!=(const Hash128& other) const { return !(*this == other); }
+	};
+
+	uint64 Hash64(const void* data, size_t size, uint64 seed = 0);
+	Hash128 Hash128Bit(const void* data, size_t size, uint64 seed = 0);
+	uint64 Hash64Reference(const void* data, size_t size, uint64 seed = 0);
+
+	/* the low and high halves of a * b folded together */
+	inline uint64 HashMix(uint64 a, uint64 b)
+	{
+#if defined(_MSC_VER) && defined(_M_X64)
+		uint64 high;
+		const uint64 low = _umul128(a, b, &high);
+		return low ^ high;
+#else
+		const unsigned __int128 product = (unsigned __int128)a * b;
+		return (uint64)product ^ (uint64)(product >> 64);
+#endif
+	}
+
+	/* folds a hash into seed, for hashing a struct member by member */
+	inline uint64 HashCombine(uint64 seed, uint64 hash)
+	{
+		return HashMix(seed ^ 0x2d358dccaa6c78a5ull, hash ^ 0x8bb84b93962eacc9ull);
+	}
+
+	/* every byte of value is hashed, padding included, so padded structs have to be zeroed before they are filled */
+	template <typename T>
+	uint64 HashPod(const T& value, uint64 seed = 0)
+	{
+		static_assert(std::is_trivially_copyable<T>::value, "Only plain data can be hashed as memory!");
+		return Hash64(&value, sizeof(T), seed);
+	}
+
+	class HashStream
+	{
+	public:
+		explicit HashStream(uint64 seed = 0) { Reset(seed); }
+
+		void Reset(uint64 seed = 0);
+		void Update(const void* data, size_t size);
+
+		/* the hash of everything so far, more can be added afterwards */
+		uint64 Finish() const;
+		Hash128 Finish128() const;
+
+		uint64 GetSize() const { return m_Size; }
+
+	private:
+		static constexpr uint32 s_ShortSize = 128;
+		static constexpr uint32 s_StripeSize = 64;
+
+		alignas(32) uint64 m_Accumulators[8];
+		uint64 m_Seed = 0;
+		uint64 m_Size = 0;
+		uint32 m_Stripe = 0; // within the current block of 16
+		uint32 m_Buffered = 0;
+		bool m_Long = false; // more than s_ShortSize bytes, the stripes are running
+		alignas(16) uint8 m_Buffer[s_ShortSize];
+	};
+
+}; // namespace Core
@@ -0,0 +1,55 @@
+#pragma once
+#include "LinearArena.h"
+
+#include <vector>
+
+/*
+	Lets STL containers allocate from a LinearArena. Deallocating does nothing, the memory comes back when the arena
+	is rewound or reset, so the container must not outlive that. A growing vector leaves its old buffers behind in
+	the arena, reserve the size up front where it is known.
+*/
+
+namespace Core
+{
+	template <typename T>
+	class ArenaAllocator
+	{
+	public:
+		typedef T value_type;
+
+		ArenaAllocator(LinearArena* arena)
+			: m_Arena(arena)
+		{
+		}
+
+		template <typename U>
+		ArenaAllocator(const ArenaAllocator<U>& other)
+			: m_Arena(other.GetArena())
+		{
+		}
+
+		T* allocate(size_t count) { return m_Arena->Allocate<T>(count); }
+		void deallocate(T*, size_t) {}
+
+		LinearArena* GetArena() const { return m_Arena; }
+
+		template <typename U>
+		bool operator==(const ArenaAllocator<U>& other) const
+		{
+			return m_Arena == other.GetArena();
+		}
+
+		template <typename U>
+		bool operator!=(const ArenaAllocator<U>& other) const
+		{
+			return m_Arena != other.GetArena();
+		}
+
+	private:
+		LinearArena* m_Arena;
+	};
+
+	template <typename T>
+	using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
+}; // namespace Core
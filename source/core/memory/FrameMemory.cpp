@@ -0,0 +1,18 @@
+#include "FrameMemory.h"
+
+namespace Core
+{
+	LinearArena& GetFrameArena()
+	{
+		static LinearArena frameArena;
+		return frameArena;
+	}
+
+	LinearArena& GetScratch()
+	{
+		// threads that never take scratch memory never allocate a block
+		thread_local LinearArena scratch;
+		return scratch;
+	}
+
+}; // namespace Core
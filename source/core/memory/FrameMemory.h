@@ -0,0 +1,46 @@
+#pragma once
+#include "LinearArena.h"
+
+/*
+	Memory for transient allocations, each one costs a pointer bump.
+
+	The frame arena belongs to the game thread and holds what lives until the end of the frame, the main loop resets
+	it after the frame was handed to the render thread. Nothing in it may be kept across frames or read by another
+	thread after the frame ended.
+
+	Every thread has its own scratch arena, used as a stack. A ScratchScope remembers where the scratch arena was and
+	rewinds it when it goes out of scope, so scratch memory is freed in the reverse order it was taken.
+*/
+
+namespace Core
+{
+	LinearArena& GetFrameArena();
+	LinearArena& GetScratch();
+
+	class ScratchScope
+	{
+	public:
+		ScratchScope()
+			: m_Arena(GetScratch())
+			, m_Marker(m_Arena.GetMarker())
+		{
+		}
+		~ScratchScope() { m_Arena.Rewind(m_Marker); }
+
+		ScratchScope(const ScratchScope&) = delete;
+		ScratchScope& operator=(const ScratchScope&) = delete;
+
+		LinearArena* GetArena() { return &m_Arena; }
+
+		template <typename T>
+		T* Allocate(size_t count)
+		{
+			return m_Arena.Allocate<T>(count);
+		}
+
+	private:
+		LinearArena& m_Arena;
+		LinearArena::Marker m_Marker;
+	};
+
+}; // namespace Core
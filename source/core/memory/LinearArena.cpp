@@ -0,0 +1,110 @@
+#include "LinearArena.h"
+#include "MemoryTracker.h"
+
+#include "logger/Debug.h"
+
+namespace Core
+{
+	LinearArena::~LinearArena()
+	{
+		Destroy();
+	}
+
+	void LinearArena::Init(size_t blockSize)
+	{
+		ASSERT(blockSize > 0, "Arena blocks can't be empty!");
+		Destroy();
+		m_BlockSize = blockSize;
+	}
+
+	void LinearArena::Destroy()
+	{
+		for(const Block& block : m_Blocks)
+			FreeBlock(block);
+		m_Blocks.clear();
+		m_Block = 0;
+		m_Offset = 0;
+		m_BlockStart = 0;
+		m_Peak = 0;
+	}
+
+	void* LinearArena::AllocateSlow(size_t size, size_t alignment)
+	{
+		ASSERT((alignment > 0 && (alignment & (alignment - 1)) == 0), "Alignment has to be a power of two!");
+
+		// the rest of the current block is skipped, so are later blocks that are too small
+		const size_t needed = size + alignment - 1;
+		if(!m_Blocks.empty())
+		{
+			m_BlockStart += m_Blocks[m_Block].m_Size;
+			m_Block++;
+		}
+		while(m_Block < m_Blocks.size() && m_Blocks[m_Block].m_Size < needed)
+		{
+			m_BlockStart += m_Blocks[m_Block].m_Size;
+			m_Block++;
+		}
+
+		if(m_Block == m_Blocks.size())
+		{
+			const size_t blockSize = needed > m_BlockSize ? needed : m_BlockSize;
+			m_Blocks.push_back(AllocateBlock(blockSize));
+		}
+
+		const Block& block = m_Blocks[m_Block];
+		const size_t offset = Align(0, block.m_Memory, alignment);
+		m_Offset = offset + size;
+		return block.m_Memory + offset;
+	}
+
+	void LinearArena::Rewind(const Marker& marker)
+	{
+		ASSERT((marker.m_Block < m_Block || (marker.m_Block == m_Block && marker.m_Offset <= m_Offset)),
+			   "Rewinding past the current offset!");
+		m_Peak = GetPeak();
+		m_BlockStart = 0;
+		for(uint32 block = 0; block < marker.m_Block; ++block)
+			m_BlockStart += m_Blocks[block].m_Size;
+		m_Block = marker.m_Block;
+		m_Offset = marker.m_Offset;
+	}
+
+	void LinearArena::Reset()
+	{
+		m_Peak = GetPeak();
+		m_Block = 0;
+		m_Offset = 0;
+		m_BlockStart = 0;
+		if(m_Blocks.size() <= 1)
+			return;
+
+		// the blocks together held this frame, next time it fits into one
+		const size_t capacity = GetCapacity();
+		for(const Block& block : m_Blocks)
+			FreeBlock(block);
+		m_Blocks.clear();
+		m_Blocks.push_back(AllocateBlock(capacity));
+	}
+
+	LinearArena::Block LinearArena::AllocateBlock(size_t size)
+	{
+		Block block = { new uint8[size], size };
+		MemoryTracker::Get().OnAllocate(block.m_Memory, size, EMemoryTag_Core);
+		return block;
+	}
+
+	void LinearArena::FreeBlock(const Block& block)
+	{
+		MemoryTracker::Get().OnFree(block.m_Memory);
+		delete[] block.m_Memory;
+	}
+
+	size_t LinearArena::GetCapacity() const
+	{
+		size_t capacity = 0;
+		for(const Block& block : m_Blocks)
+			capacity += block.m_Size;
+		return capacity;
+	}
+
+}; // namespace Core
@@ -0,0 +1,112 @@
+#pragma once
+#include "Core/Types.h"
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+/*
+	A bump allocator for memory that is thrown away all at once.
+
+	Allocating moves an offset forward in the current block and nothing is freed on its own. Rewind goes back to a
+	marker and Reset goes back to the start. The blocks are kept, so an arena that reached its high water mark does
+	not touch the heap again. When a block runs out the next one is used or a new one is allocated, Reset folds them
+	into a single block big enough for all of them.
+
+	Not thread safe, every thread uses its own arena.
+*/
+
+namespace Core
+{
+	class LinearArena
+	{
+	public:
+		struct Marker
+		{
+			uint32 m_Block;
+			size_t m_Offset;
+		};
+
+		static constexpr size_t s_DefaultBlockSize = 64 * 1024;
+
+		LinearArena() = default;
+		~LinearArena();
+
+		LinearArena(const LinearArena&) = delete;
+		LinearArena& operator=(const LinearArena&) = delete;
+
+		/* the first block is allocated on the first allocation */
+		void Init(size_t blockSize);
+		void Destroy();
+
+		void* Allocate(size_t size, size_t alignment = alignof(std::max_align_t))
+		{
+			if(m_Block < m_Blocks.size())
+			{
+				const Block& block = m_Blocks[m_Block];
+				const size_t offset = Align(m_Offset, block.m_Memory, alignment);
+				if(offset + size <= block.m_Size)
+				{
+					m_Offset = offset + size;
+					return block.m_Memory + offset;
+				}
+			}
+			return AllocateSlow(size, alignment);
+		}
+
+		/* uninitialized, for types that are filled in right away */
+		template <typename T>
+		T* Allocate(size_t count)
+		{
+			return (T*)Allocate(sizeof(T) * count, alignof(T));
+		}
+
+		/* default initialized, nothing is ever destroyed so only trivially destructible types */
+		template <typename T>
+		T* New(size_t count)
+		{
+			static_assert(std::is_trivially_destructible<T>::value, "Arena objects are never destroyed!");
+			T* objects = Allocate<T>(count);
+			for(size_t i = 0; i < count; ++i)
+				new(&objects[i]) T;
+			return objects;
+		}
+
+		Marker GetMarker() const { return { m_Block, m_Offset }; }
+		void Rewind(const Marker& marker);
+		void Reset();
+
+		/* bytes handed out since the last reset, including padding and the unused ends of full blocks */
+		size_t GetUsed() const { return m_BlockStart + m_Offset; }
+		size_t GetPeak() const { return m_Peak > GetUsed() ? m_Peak : GetUsed(); }
+		size_t GetCapacity() const;
+		uint32 GetBlockCount() const { return (uint32)m_Blocks.size(); }
+
+	private:
+		struct Block
+		{
+			uint8* m_Memory;
+			size_t m_Size;
+		};
+
+		// alignment is a power of two
+		static size_t Align(size_t offset, const uint8* memory, size_t alignment)
+		{
+			const size_t address = (size_t)memory + offset;
+			return ((address + alignment - 1) & ~(alignment - 1)) - (size_t)memory;
+		}
+
+		void* AllocateSlow(size_t size, size_t alignment);
+		static Block AllocateBlock(size_t size);
+		static void FreeBlock(const Block& block);
+
+		std::vector<Block> m_Blocks;
+		uint32 m_Block = 0;
+		size_t m_Offset = 0;
+		size_t m_BlockStart = 0; // bytes in the blocks before the current one
+		size_t m_Peak = 0;
+		size_t m_BlockSize = s_DefaultBlockSize;
+	};
+
+}; // namespace Core
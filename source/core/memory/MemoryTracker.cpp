@@ -0,0 +1,138 @@
+#include "MemoryTracker.h"
+
+#include "logger/Debug.h"
+
+#include <algorithm>
+
+namespace Core
+{
+	MemoryTracker& MemoryTracker::Get()
+	{
+		static MemoryTracker* tracker = new MemoryTracker;
+		return *tracker;
+	}
+
+	const char* MemoryTracker::GetTagName(EMemoryTag tag)
+	{
+		static const char* names[] = { "Core", "Graphics", "Assets", "GPU device local", "GPU host visible" };
+		static_assert(sizeof(names) / sizeof(names[0]) == EMemoryTag_Count, "A memory tag has no name!");
+		return tag < EMemoryTag_Count ? names[tag] : "Unknown";
+	}
+
+	void MemoryTracker::OnAllocate(uint64 id, uint64 size, EMemoryTag tag)
+	{
+		if(size == 0)
+			return;
+
+		std::lock_guard<std::mutex> lock(m_Lock);
+		Allocation& allocation = m_Allocations[id];
+		ASSERT(allocation.m_Size == 0, "Memory was reported twice without being freed!");
+		allocation.m_Id = id;
+		allocation.m_Size = size;
+		allocation.m_Sequence = ++m_Sequence;
+		allocation.m_Tag = tag;
+
+		TagStats& stats = m_Tags[tag];
+		stats.m_LiveBytes += size;
+		stats.m_PeakBytes = std::max(stats.m_PeakBytes, stats.m_LiveBytes);
+		stats.m_LiveCount++;
+		stats.m_TotalCount++;
+		m_FrameCount[tag]++;
+		m_FrameBytes[tag] += size;
+	}
+
+	void MemoryTracker::OnFree(uint64 id)
+	{
+		std::lock_guard<std::mutex> lock(m_Lock);
+		auto it = m_Allocations.find(id);
+		if(it == m_Allocations.end())
+			return;
+
+		TagStats& stats = m_Tags[it->second.m_Tag];
+		stats.m_LiveBytes -= it->second.m_Size;
+		stats.m_LiveCount--;
+		m_Allocations.erase(it);
+	}
+
+	void MemoryTracker::SetBudget(EMemoryTag tag, uint64 bytes)
+	{
+		std::lock_guard<std::mutex> lock(m_Lock);
+		m_Tags[tag].m_Budget = bytes;
+	}
+
+	bool MemoryTracker::IsOverBudget(EMemoryTag tag) const
+	{
+		std::lock_guard<std::mutex> lock(m_Lock);
+		return m_Tags[tag].m_Budget > 0 && m_Tags[tag].m_LiveBytes > m_Tags[tag].m_Budget;
+	}
+
+	void MemoryTracker::NewFrame()
+	{
+		std::lock_guard<std::mutex> lock(m_Lock);
+		for(uint32 tag = 0; tag < EMemoryTag_Count; ++tag)
+		{
+			TagStats& stats = m_Tags[tag];
+			stats.m_FrameCount = m_FrameCount[tag];
+			stats.m_FrameBytes = m_FrameBytes[tag];
+			m_FrameCount[tag] = 0;
+			m_FrameBytes[tag] = 0;
+
+			// only the frame a tag goes over is reported, not every frame it stays there
+			const bool overBudget = stats.m_Budget > 0 && stats.m_LiveBytes > stats.m_Budget;
+			if(overBudget && !m_OverBudget[tag])
+			{
+				LOG_MESSAGE("%s memory is over budget: %llu of %llu bytes", GetTagName((EMemoryTag)tag),
+							(unsigned long long)stats.m_LiveBytes, (unsigned long long)stats.m_Budget);
+			}
+			m_OverBudget[tag] = overBudget;
+		}
+	}
+
+	MemoryTracker::TagStats MemoryTracker::GetStats(EMemoryTag tag) const
+	{
+		std::lock_guard<std::mutex> lock(m_Lock);
+		return m_Tags[tag];
+	}
+
+	MemoryTracker::Snapshot MemoryTracker::TakeSnapshot() const
+	{
+		std::lock_guard<std::mutex> lock(m_Lock);
+		Snapshot snapshot;
+		for(uint32 tag = 0; tag < EMemoryTag_Count; ++tag)
+		{
+			snapshot.m_LiveBytes[tag] = (int64)m_Tags[tag].m_LiveBytes;
+			snapshot.m_LiveCount[tag] = (int64)m_Tags[tag].m_LiveCount;
+		}
+		snapshot.m_Sequence = m_Sequence;
+		return snapshot;
+	}
+
+	MemoryTracker::Snapshot MemoryTracker::Diff(const Snapshot& before, const Snapshot& after)
+	{
+		Snapshot diff;
+		for(uint32 tag = 0; tag < EMemoryTag_Count; ++tag)
+		{
+			diff.m_LiveBytes[tag] = after.m_LiveBytes[tag] - before.m_LiveBytes[tag];
+			diff.m_LiveCount[tag] = after.m_LiveCount[tag] - before.m_LiveCount[tag];
+		}
+		diff.m_Sequence = after.m_Sequence - before.m_Sequence;
+		return diff;
+	}
+
+	void MemoryTracker::GetAllocationsSince(const Snapshot& snapshot, std::vector<Allocation>* allocationsOut) const
+	{
+		allocationsOut->clear();
+		{
+			std::lock_guard<std::mutex> lock(m_Lock);
+			for(const auto& entry : m_Allocations)
+			{
+				if(entry.second.m_Sequence > snapshot.m_Sequence)
+					allocationsOut->push_back(entry.second);
+			}
+		}
+
+		std::sort(allocationsOut->begin(), allocationsOut->end(),
+				  [](const Allocation& a, const Allocation& b) { return a.m_Sequence < b.m_Sequence; });
+	}
+
+}; // namespace Core
@@ -0,0 +1,155 @@
+#pragma once
+#include "Core/Types.h"
+
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+/*
+	Live CPU and GPU memory by category.
+
+	Allocations report themselves with an id that stays the same until they are freed, the address for CPU memory
+	or the handle for GPU memory, and one of the tags below. The tracker keeps live bytes, peak, counts and the
+	allocations of the last frame for every tag, and warns once when a tag goes over its budget.
+
+	A snapshot holds the totals and where the allocation sequence was. Diffing two snapshots gives what every tag
+	gained, GetAllocationsSince lists the allocations made after a snapshot that are still alive, which is where
+	leaks show up.
+
+	Reporting takes a lock, it is meant for the allocations that go to the system, not for arena allocations.
+*/
+
+namespace Core
+{
+	enum EMemoryTag : uint8
+	{
+		EMemoryTag_Core,
+		EMemoryTag_Graphics,
+		EMemoryTag_Assets,
+		EMemoryTag_GpuDeviceLocal,
+		EMemoryTag_GpuHostVisible,
+		EMemoryTag_Count
+	};
+
+	class MemoryTracker
+	{
+	public:
+		struct TagStats
+		{
+			uint64 m_LiveBytes = 0;
+			uint64 m_PeakBytes = 0;
+			uint64 m_LiveCount = 0;
+			uint64 m_TotalCount = 0;
+			uint64 m_FrameCount = 0; // allocations during the last finished frame
+			uint64 m_FrameBytes = 0;
+			uint64 m_Budget = 0; // 0 is no budget
+		};
+
+		struct Allocation
+		{
+			uint64 m_Id = 0;
+			uint64 m_Size = 0;
+			uint64 m_Sequence = 0;
+			EMemoryTag m_Tag = EMemoryTag_Core;
+		};
+
+		struct Snapshot
+		{
+			int64 m_LiveBytes[EMemoryTag_Count] = {};
+			int64 m_LiveCount[EMemoryTag_Count] = {};
+			uint64 m_Sequence = 0;
+		};
+
+		MemoryTracker() = default;
+		~MemoryTracker() = default;
+
+		/* never destroyed, static objects free their memory after main returns */
+		static MemoryTracker& Get();
+		static const char* GetTagName(EMemoryTag tag);
+
+		/* nothing is tracked for size 0 */
+		void OnAllocate(uint64 id, uint64 size, EMemoryTag tag);
+		void OnAllocate(const void* address, uint64 size, EMemoryTag tag)
+		{
+			OnAllocate((uint64)(uintptr_t)address, size, tag);
+		}
+
+		/* ids that were never reported are ignored */
+		void OnFree(uint64 id);
+		void OnFree(const void* address) { OnFree((uint64)(uintptr_t)address); }
+
+		void SetBudget(EMemoryTag tag, uint64 bytes);
+		bool IsOverBudget(EMemoryTag tag) const;
+
+		/* once per frame, closes the frame's allocation counts and warns about tags that went over their budget */
+		void NewFrame();
+
+		TagStats GetStats(EMemoryTag tag) const;
+
+		Snapshot TakeSnapshot() const;
+		/* what every tag gained from before to after */
+		static Snapshot Diff(const Snapshot& before, const Snapshot& after);
+		/* the allocations made after the snapshot that are still alive, oldest first */
+		void GetAllocationsSince(const Snapshot& snapshot, std::vector<Allocation>* allocationsOut) const;
+
+	private:
+		mutable std::mutex m_Lock;
+		std::unordered_map<uint64, Allocation> m_Allocations;
+		TagStats m_Tags[EMemoryTag_Count];
+		uint64 m_FrameCount[EMemoryTag_Count] = {};
+		uint64 m_FrameBytes[EMemoryTag_Count] = {};
+		bool m_OverBudget[EMemoryTag_Count] = {};
+		uint64 m_Sequence = 0;
+	};
+
+	/* std::allocator that reports to the tracker under Tag, for containers that should show up in the budget */
+	template <typename T, EMemoryTag Tag>
+	class TrackedAllocator
+	{
+	public:
+		typedef T value_type;
+
+		template <typename U>
+		struct rebind
+		{
+			typedef TrackedAllocator<U, Tag> other;
+		};
+
+		TrackedAllocator() = default;
+
+		template <typename U>
+		TrackedAllocator(const TrackedAllocator<U, Tag>&)
+		{
+		}
+
+		T* allocate(size_t count)
+		{
+			T* memory = std::allocator<T>().allocate(count);
+			MemoryTracker::Get().OnAllocate(memory, sizeof(T) * count, Tag);
+			return memory;
+		}
+
+		void deallocate(T* memory, size_t count)
+		{
+			MemoryTracker::Get().OnFree(memory);
+			std::allocator<T>().deallocate(memory, count);
+		}
+
+		template <typename U>
+		bool operator==(const TrackedAllocator<U, Tag>&) const
+		{
+			return true;
+		}
+
+		template <typename U>
+		bool operator!=(const TrackedAllocator<U, Tag>&) const
+		{
+			return false;
+		}
+	};
+
+	template <typename T, EMemoryTag Tag>
+	using TrackedVector = std::vector<T, TrackedAllocator<T, Tag>>;
+
+}; // namespace Core
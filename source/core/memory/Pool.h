@@ -0,0 +1,177 @@
+#pragma once
+#include "Core/Types.h"
+#include "MemoryTracker.h"
+#include "logger/Debug.h"
+
+#include <new>
+#include <utility>
+#include <vector>
+
+/*
+	Objects of one type in fixed size slabs, addressed through generational handles.
+
+	A handle is the slot index in the low bits and the slot's generation in the high bits. Destroying an object
+	bumps the generation of its slot, so handles to it stop resolving when the slot is reused. 32 bit handles have
+	20 index bits and 12 generation bits, 64 bit handles 32 of each. Generations start at 1, 0 is never a valid
+	handle. Handles are plain integers, they can go into GPU buffers and sort keys, and handles of the same
+	generation sort by slot.
+
+	Free slots form a list through the slabs, the last slot freed is the first one reused. Creating and destroying
+	are O(1), objects never move and a slab is never given back before the pool is cleared.
+*/
+
+namespace Core
+{
+	template <typename HandleType>
+	struct HandleLayout
+	{
+		static constexpr uint32 s_IndexBits = sizeof(HandleType) == 4 ? 20 : 32;
+		static constexpr uint32 s_GenerationBits = sizeof(HandleType) * 8 - s_IndexBits;
+		static constexpr uint32 s_MaxIndex = (uint32)(((uint64)1 << s_IndexBits) - 1);
+		static constexpr uint32 s_MaxGeneration = (uint32)(((uint64)1 << s_GenerationBits) - 1);
+
+		static HandleType Make(uint32 index, uint32 generation)
+		{
+			return ((HandleType)generation << s_IndexBits) | (HandleType)index;
+		}
+		static uint32 GetIndex(HandleType handle) { return (uint32)(handle & s_MaxIndex); }
+		static uint32 GetGeneration(HandleType handle) { return (uint32)(handle >> s_IndexBits); }
+	};
+
+	template <typename T, typename HandleType = uint32>
+	class Pool
+	{
+	public:
+		typedef HandleLayout<HandleType> Layout;
+		static constexpr uint32 s_SlabSize = 64;
+
+		Pool() = default;
+		~Pool() { Clear(); }
+
+		Pool(const Pool&) = delete;
+		Pool& operator=(const Pool&) = delete;
+
+		template <typename... Args>
+		HandleType Create(Args&&... args)
+		{
+			if(m_FirstFree == s_EndOfList)
+				AddSlab();
+
+			const uint32 index = m_FirstFree;
+			Slot& slot = GetSlot(index);
+			m_FirstFree = slot.m_NextFree;
+			slot.m_NextFree = s_Alive;
+			new(slot.m_Object) T(std::forward<Args>(args)...);
+			m_Count++;
+			return Layout::Make(index, slot.m_Generation);
+		}
+
+		/* returns false for handles that are stale or were never valid */
+		bool Destroy(HandleType handle)
+		{
+			Slot* slot = Find(handle);
+			if(!slot)
+				return false;
+
+			((T*)slot->m_Object)->~T();
+			slot->m_Generation = slot->m_Generation == Layout::s_MaxGeneration ? 1 : slot->m_Generation + 1;
+			slot->m_NextFree = m_FirstFree;
+			m_FirstFree = Layout::GetIndex(handle);
+			m_Count--;
+			return true;
+		}
+
+		/* nullptr for handles that are stale or were never valid */
+		T* Get(HandleType handle)
+		{
+			Slot* slot = Find(handle);
+			return slot ? (T*)slot->m_Object : nullptr;
+		}
+		const T* Get(HandleType handle) const { return const_cast<Pool*>(this)->Get(handle); }
+		bool IsValid(HandleType handle) const { return Get(handle) != nullptr; }
+
+		/* function(HandleType handle, T& object) for every live object, in slot order */
+		template <typename Function>
+		void ForEach(Function&& function)
+		{
+			for(uint32 index = 0; index < GetCapacity(); ++index)
+			{
+				Slot& slot = GetSlot(index);
+				if(slot.m_NextFree == s_Alive)
+					function(Layout::Make(index, slot.m_Generation), *(T*)slot.m_Object);
+			}
+		}
+
+		/* destroys every object and frees the slabs, handles from before stay invalid */
+		void Clear()
+		{
+			ForEach([this](HandleType handle, T&) { Destroy(handle); });
+
+			// the generations are kept for when the slots come back
+			if(m_Generations.size() < GetCapacity())
+				m_Generations.resize(GetCapacity());
+			for(uint32 index = 0; index < GetCapacity(); ++index)
+				m_Generations[index] = GetSlot(index).m_Generation;
+			for(Slot* slab : m_Slabs)
+			{
+				MemoryTracker::Get().OnFree(slab);
+				delete[] slab;
+			}
+			m_Slabs.clear();
+			m_FirstFree = s_EndOfList;
+		}
+
+		uint32 GetCount() const { return m_Count; }
+		uint32 GetCapacity() const { return (uint32)m_Slabs.size() * s_SlabSize; }
+
+	private:
+		static constexpr uint32 s_EndOfList = ~0u;
+		static constexpr uint32 s_Alive = ~0u - 1;
+
+		struct Slot
+		{
+			alignas(T) uint8 m_Object[sizeof(T)];
+			uint32 m_Generation;
+			uint32 m_NextFree; // s_Alive while the slot holds an object
+		};
+
+		Slot& GetSlot(uint32 index) { return m_Slabs[index / s_SlabSize][index % s_SlabSize]; }
+
+		Slot* Find(HandleType handle)
+		{
+			const uint32 index = Layout::GetIndex(handle);
+			if(index >= GetCapacity())
+				return nullptr;
+
+			Slot& slot = GetSlot(index);
+			if(slot.m_NextFree != s_Alive || slot.m_Generation != Layout::GetGeneration(handle))
+				return nullptr;
+			return &slot;
+		}
+
+		void AddSlab()
+		{
+			const uint32 first = GetCapacity();
+			ASSERT(first + s_SlabSize - 1 <= Layout::s_MaxIndex, "Pool is out of handle indices!");
+
+			// the new slots go on the free list in slot order
+			Slot* slab = new Slot[s_SlabSize];
+			MemoryTracker::Get().OnAllocate(slab, sizeof(Slot) * s_SlabSize, EMemoryTag_Core);
+			m_Slabs.push_back(slab);
+			if(m_Generations.size() < GetCapacity())
+				m_Generations.resize(GetCapacity(), 1);
+			for(uint32 i = 0; i < s_SlabSize; ++i)
+			{
+				slab[i].m_Generation = m_Generations[first + i];
+				slab[i].m_NextFree = i + 1 < s_SlabSize ? first + i + 1 : m_FirstFree;
+			}
+			m_FirstFree = first;
+		}
+
+		std::vector<Slot*> m_Slabs;
+		std::vector<uint32> m_Generations;
+		uint32 m_FirstFree = s_EndOfList;
+		uint32 m_Count = 0;
+	};
+
+}; // namespace Core
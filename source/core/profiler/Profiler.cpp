@@ -0,0 +1,273 @@
+#include "Profiler.h"
+
+#include "Core/File.h"
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+namespace Core
+{
+	std::atomic<Profiler*> Profiler::m_Instance{ nullptr };
+	std::atomic<uint32> Profiler::s_Generations{ 0 };
+
+	thread_local Profiler::ThreadBuffer* Profiler::s_ThreadBuffer = nullptr;
+	thread_local uint32 Profiler::s_ThreadGeneration = 0;
+
+	Profiler& Profiler::Get()
+	{
+		Profiler* instance = m_Instance.load(std::memory_order_acquire);
+		if(instance)
+			return *instance;
+
+		// the first scope can open on any thread, when two threads race the loser throws its profiler away
+		Profiler* created = new Profiler;
+		created->m_Generation = ++s_Generations;
+		if(!m_Instance.compare_exchange_strong(instance, created, std::memory_order_acq_rel))
+		{
+			delete created;
+			return *instance;
+		}
+		return *created;
+	}
+
+	void Profiler::Destroy() { delete m_Instance.exchange(nullptr); }
+
+	Profiler::~Profiler()
+	{
+		for(ThreadBuffer* buffer : m_Buffers)
+			delete buffer;
+		m_Buffers.clear();
+	}
+
+	uint64 Profiler::Now()
+	{
+		return (uint64)std::chrono::duration_cast<std::chrono::nanoseconds>(
+				   std::chrono::steady_clock::now().time_since_epoch())
+			.count();
+	}
+
+	Profiler::ThreadBuffer* Profiler::GetThreadBuffer()
+	{
+		// the buffer a thread cached for a destroyed profiler went with it
+		Profiler& profiler = Get();
+		if(!s_ThreadBuffer || s_ThreadGeneration != profiler.m_Generation)
+		{
+			ThreadBuffer* buffer = new ThreadBuffer;
+
+			std::lock_guard<std::mutex> lock(profiler.m_RegisterLock);
+			buffer->m_ThreadIndex = (uint32)profiler.m_Buffers.size();
+			profiler.m_Buffers.push_back(buffer);
+			s_ThreadBuffer = buffer;
+			s_ThreadGeneration = profiler.m_Generation;
+		}
+		return s_ThreadBuffer;
+	}
+
+	void Profiler::Push(EEventType type, const char* name, int64 value)
+	{
+		ThreadBuffer* buffer = GetThreadBuffer();
+
+		const uint32 head = buffer->m_Head.load(std::memory_order_relaxed);
+		const uint32 tail = buffer->m_Tail.load(std::memory_order_acquire);
+		if(head - tail >= s_BufferCapacity)
+		{
+			buffer->m_Dropped.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+
+		Event& event = buffer->m_Events[head & (s_BufferCapacity - 1)];
+		event.m_Timestamp = Now();
+		event.m_Name = name;
+		event.m_Value = value;
+		event.m_Type = type;
+
+		buffer->m_Head.store(head + 1, std::memory_order_release);
+	}
+
+	void Profiler::Begin(const char* name) { Push(EEventType_Begin, name, 0); }
+
+	void Profiler::End() { Push(EEventType_End, nullptr, 0); }
+
+	void Profiler::Counter(const char* name, int64 value) { Push(EEventType_Counter, name, value); }
+
+	void Profiler::Collect(ThreadBuffer* buffer, Frame& frame)
+	{
+		const uint32 head = buffer->m_Head.load(std::memory_order_acquire);
+		uint32 tail = buffer->m_Tail.load(std::memory_order_relaxed);
+
+		for(; tail != head; ++tail)
+		{
+			const Event& event = buffer->m_Events[tail & (s_BufferCapacity - 1)];
+			switch(event.m_Type)
+			{
+				case EEventType_Begin:
+				{
+					if(buffer->m_OpenCount < s_MaxDepth)
+					{
+						buffer->m_OpenBegin[buffer->m_OpenCount] = event.m_Timestamp;
+						buffer->m_OpenName[buffer->m_OpenCount] = event.m_Name;
+					}
+					buffer->m_OpenCount++;
+				}
+				break;
+				case EEventType_End:
+				{
+					if(buffer->m_OpenCount == 0)
+						break;
+
+					const uint32 depth = --buffer->m_OpenCount;
+					if(depth >= s_MaxDepth)
+						break;
+
+					Scope scope;
+					scope.m_Name = buffer->m_OpenName[depth];
+					scope.m_Begin = buffer->m_OpenBegin[depth];
+					scope.m_End = event.m_Timestamp;
+					scope.m_ThreadIndex = buffer->m_ThreadIndex;
+					scope.m_Depth = depth;
+					frame.m_Scopes.push_back(scope);
+				}
+				break;
+				case EEventType_Counter:
+				{
+					CounterSample counter;
+					counter.m_Name = event.m_Name;
+					counter.m_Timestamp = event.m_Timestamp;
+					counter.m_Value = event.m_Value;
+					counter.m_ThreadIndex = buffer->m_ThreadIndex;
+					frame.m_Counters.push_back(counter);
+				}
+				break;
+				default:
+					break;
+			}
+		}
+
+		buffer->m_Tail.store(tail, std::memory_order_release);
+	}
+
+	void Profiler::NewFrame()
+	{
+		const uint64 now = Now();
+
+		{
+			std::lock_guard<std::mutex> lock(m_RegisterLock);
+			for(ThreadBuffer* buffer : m_Buffers)
+				Collect(buffer, m_CurrentFrame);
+		}
+
+		if(m_CurrentFrame.m_Begin == 0)
+			m_CurrentFrame.m_Begin = now;
+		m_CurrentFrame.m_End = now;
+
+		if(m_Capturing && m_CapturedScopes.size() < s_MaxCapturedScopes)
+		{
+			m_CapturedScopes.insert(m_CapturedScopes.end(), m_CurrentFrame.m_Scopes.begin(),
+									m_CurrentFrame.m_Scopes.end());
+			m_CapturedCounters.insert(m_CapturedCounters.end(), m_CurrentFrame.m_Counters.begin(),
+									  m_CurrentFrame.m_Counters.end());
+			m_CapturedFrames.push_back(now);
+		}
+
+		std::swap(m_LastFrame, m_CurrentFrame);
+		m_CurrentFrame.m_Scopes.clear();
+		m_CurrentFrame.m_Counters.clear();
+		m_CurrentFrame.m_Begin = now;
+		m_CurrentFrame.m_End = now;
+	}
+
+	void Profiler::StartCapture()
+	{
+		m_CapturedScopes.clear();
+		m_CapturedCounters.clear();
+		m_CapturedFrames.clear();
+		m_CaptureStart = Now();
+		m_Capturing = true;
+	}
+
+	void Profiler::StopCapture() { m_Capturing = false; }
+
+	uint32 Profiler::GetThreadCount() const
+	{
+		std::lock_guard<std::mutex> lock(m_RegisterLock);
+		return (uint32)m_Buffers.size();
+	}
+
+	uint64 Profiler::GetDroppedEvents() const
+	{
+		std::lock_guard<std::mutex> lock(m_RegisterLock);
+		uint64 dropped = 0;
+		for(const ThreadBuffer* buffer : m_Buffers)
+			dropped += buffer->m_Dropped.load(std::memory_order_relaxed);
+		return dropped;
+	}
+
+	static void AppendEscaped(std::string& out, const char* str)
+	{
+		for(const char* c = str ? str : "unknown"; *c; ++c)
+		{
+			if(*c == '"' || *c == '\\')
+				out += '\\';
+			out += *c;
+		}
+	}
+
+	bool Profiler::ExportChromeTrace(const char* filepath) const
+	{
+		if(m_CapturedScopes.empty() && m_CapturedCounters.empty())
+			return false;
+
+		const uint64 origin = m_CaptureStart;
+
+		std::string json;
+		json.reserve(m_CapturedScopes.size() * 96);
+		json += "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+
+		char buffer[256];
+		bool first = true;
+		auto separator = [&]() {
+			if(!first)
+				json += ",\n";
+			first = false;
+		};
+
+		// timestamps are in microseconds in the chrome trace format
+		for(const Scope& scope : m_CapturedScopes)
+		{
+			separator();
+			json += "{\"name\":\"";
+			AppendEscaped(json, scope.m_Name);
+			snprintf(buffer, sizeof(buffer), "\",\"ph\":\"X\",\"pid\":0,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+					 scope.m_ThreadIndex, (double)(int64)(scope.m_Begin - origin) / 1000.0,
+					 (double)(scope.m_End - scope.m_Begin) / 1000.0);
+			json += buffer;
+		}
+
+		for(const CounterSample& counter : m_CapturedCounters)
+		{
+			separator();
+			json += "{\"name\":\"";
+			AppendEscaped(json, counter.m_Name);
+			snprintf(buffer, sizeof(buffer), "\",\"ph\":\"C\",\"pid\":0,\"tid\":%u,\"ts\":%.3f,\"args\":{\"value\":%lld}}",
+					 counter.m_ThreadIndex, (double)(int64)(counter.m_Timestamp - origin) / 1000.0,
+					 (long long)counter.m_Value);
+			json += buffer;
+		}
+
+		for(uint64 frame : m_CapturedFrames)
+		{
+			separator();
+			snprintf(buffer, sizeof(buffer), "{\"name\":\"Frame\",\"ph\":\"i\",\"s\":\"g\",\"pid\":0,\"tid\":0,\"ts\":%.3f}",
+					 (double)(int64)(frame - origin) / 1000.0);
+			json += buffer;
+		}
+
+		json += "\n]}\n";
+
+		File file(filepath, File::WRITE_FILE);
+		file.Write(json.data(), 1, (uint32)json.size());
+		return true;
+	}
+
+}; // namespace Core
@@ -0,0 +1,157 @@
+#pragma once
+#include "Core/Types.h"
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+/*
+	CPU instrumentation.
+
+	PROFILE_SCOPE / PROFILE_FUNCTION record a begin and an end timestamp into a ring buffer owned by the
+	calling thread. Recording never locks, the only lock is taken once per thread when its buffer is registered.
+	PROFILE_FRAME is called once per frame from the main loop, it drains every thread buffer, pairs the begin/end
+	events into scopes and keeps the last frame around for the flame view.
+
+	Everything compiles away when PROFILER_ENABLED is not defined.
+*/
+
+#ifdef PROFILER_ENABLED
+#define PROFILE_CONCAT_IMPL(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_IMPL(a, b)
+#define PROFILE_SCOPE(name) Core::ScopedProfileEvent PROFILE_CONCAT(_profile_scope_, __LINE__)(name)
+#define PROFILE_FUNCTION() PROFILE_SCOPE(__FUNCTION__)
+#define PROFILE_COUNTER(name, value) Core::Profiler::Counter(name, (int64)(value))
+#define PROFILE_FRAME() Core::Profiler::Get().NewFrame()
+#else
+#define PROFILE_SCOPE(name)
+#define PROFILE_FUNCTION()
+#define PROFILE_COUNTER(name, value)
+#define PROFILE_FRAME()
+#endif
+
+namespace Core
+{
+	class Profiler
+	{
+	public:
+		enum EEventType : uint8
+		{
+			EEventType_Begin,
+			EEventType_End,
+			EEventType_Counter,
+		};
+
+		struct Event
+		{
+			uint64 m_Timestamp = 0; // nanoseconds
+			const char* m_Name = nullptr;
+			int64 m_Value = 0;
+			EEventType m_Type = EEventType_Begin;
+		};
+
+		/* A begin/end pair that has been resolved by the collector */
+		struct Scope
+		{
+			const char* m_Name = nullptr;
+			uint64 m_Begin = 0;
+			uint64 m_End = 0;
+			uint32 m_ThreadIndex = 0;
+			uint32 m_Depth = 0;
+		};
+
+		struct CounterSample
+		{
+			const char* m_Name = nullptr;
+			uint64 m_Timestamp = 0;
+			int64 m_Value = 0;
+			uint32 m_ThreadIndex = 0;
+		};
+
+		struct Frame
+		{
+			uint64 m_Begin = 0;
+			uint64 m_End = 0;
+			std::vector<Scope> m_Scopes;
+			std::vector<CounterSample> m_Counters;
+		};
+
+		static Profiler& Get();
+		static void Destroy();
+
+		static void Begin(const char* name);
+		static void End();
+		static void Counter(const char* name, int64 value);
+		static uint64 Now();
+
+		/* drains all the thread buffers and closes the current frame */
+		void NewFrame();
+
+		void StartCapture();
+		void StopCapture();
+		bool IsCapturing() const { return m_Capturing; }
+
+		/* writes the captured frames as chrome://tracing / Perfetto JSON */
+		bool ExportChromeTrace(const char* filepath) const;
+
+		const Frame& GetLastFrame() const { return m_LastFrame; }
+		uint32 GetThreadCount() const;
+		uint64 GetDroppedEvents() const;
+
+	private:
+		static constexpr uint32 s_BufferCapacity = 1 << 14; // must be a power of two
+		static constexpr uint32 s_MaxDepth = 64;
+		static constexpr uint32 s_MaxCapturedScopes = 1 << 20;
+
+		/* single producer (the owning thread) single consumer (the collector) */
+		struct ThreadBuffer
+		{
+			Event m_Events[s_BufferCapacity];
+			std::atomic<uint32> m_Head{ 0 };
+			std::atomic<uint32> m_Tail{ 0 };
+			std::atomic<uint64> m_Dropped{ 0 };
+			uint32 m_ThreadIndex = 0;
+
+			/* collector side */
+			uint64 m_OpenBegin[s_MaxDepth]{};
+			const char* m_OpenName[s_MaxDepth]{};
+			uint32 m_OpenCount = 0;
+		};
+
+		Profiler() = default;
+		~Profiler();
+
+		static ThreadBuffer* GetThreadBuffer();
+		static void Push(EEventType type, const char* name, int64 value);
+
+		void Collect(ThreadBuffer* buffer, Frame& frame);
+
+		static std::atomic<Profiler*> m_Instance;
+		static std::atomic<uint32> s_Generations;
+		/* the buffer belongs to the profiler of that generation, after a Destroy the thread registers again */
+		static thread_local ThreadBuffer* s_ThreadBuffer;
+		static thread_local uint32 s_ThreadGeneration;
+
+		uint32 m_Generation = 0;
+
+		mutable std::mutex m_RegisterLock;
+		std::vector<ThreadBuffer*> m_Buffers;
+
+		Frame m_CurrentFrame;
+		Frame m_LastFrame;
+
+		std::vector<Scope> m_CapturedScopes;
+		std::vector<CounterSample> m_CapturedCounters;
+		std::vector<uint64> m_CapturedFrames;
+		uint64 m_CaptureStart = 0;
+		bool m_Capturing = false;
+	};
+
+	class ScopedProfileEvent
+	{
+	public:
+		ScopedProfileEvent(const char* name) { Profiler::Begin(name); }
+		~ScopedProfileEvent() { Profiler::End(); }
+	};
+
+}; // namespace Core
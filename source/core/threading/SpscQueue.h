@@ -0,0 +1,84 @@
+#pragma once
+#include "Core/Types.h"
+#include "logger/Debug.h"
+
+#include <atomic>
+#include <vector>
+
+/*
+	A bounded queue between exactly one producer thread and one consumer thread, without locks.
+
+	The producer only writes the tail and the consumer only writes the head, each reads the other's index with
+	acquire ordering and publishes its own with release ordering, so a slot is never read before it was written or
+	written before it was read. The indices count up forever and are masked into the ring, the capacity is a power
+	of two. Push fails instead of blocking when the queue is full.
+*/
+
+namespace Core
+{
+	template <typename T>
+	class SpscQueue
+	{
+	public:
+		SpscQueue() = default;
+		~SpscQueue() = default;
+
+		/* not thread safe, before either side starts */
+		void Init(uint32 capacity)
+		{
+			ASSERT((capacity > 0 && (capacity & (capacity - 1)) == 0), "Queue capacity has to be a power of two!");
+			m_Slots.resize(capacity);
+			m_Mask = capacity - 1;
+			m_Head.store(0, std::memory_order_relaxed);
+			m_Tail.store(0, std::memory_order_relaxed);
+			m_CachedHead = 0;
+			m_CachedTail = 0;
+		}
+
+		/* producer */
+		bool Push(const T& value)
+		{
+			const uint32 tail = m_Tail.load(std::memory_order_relaxed);
+			if(tail - m_CachedHead > m_Mask)
+			{
+				// only go to the consumer's cache line when the queue looks full
+				m_CachedHead = m_Head.load(std::memory_order_acquire);
+				if(tail - m_CachedHead > m_Mask)
+					return false;
+			}
+
+			m_Slots[tail & m_Mask] = value;
+			m_Tail.store(tail + 1, std::memory_order_release);
+			return true;
+		}
+
+		/* consumer */
+		bool Pop(T* valueOut)
+		{
+			const uint32 head = m_Head.load(std::memory_order_relaxed);
+			if(head == m_CachedTail)
+			{
+				m_CachedTail = m_Tail.load(std::memory_order_acquire);
+				if(head == m_CachedTail)
+					return false;
+			}
+
+			*valueOut = m_Slots[head & m_Mask];
+			m_Head.store(head + 1, std::memory_order_release);
+			return true;
+		}
+
+		uint32 GetCapacity() const { return m_Mask + 1; }
+
+	private:
+		std::vector<T> m_Slots;
+		uint32 m_Mask = 0;
+
+		// the two sides sit on their own cache lines, each with the last index it saw of the other side
+		alignas(64) std::atomic<uint32> m_Head{ 0 };
+		uint32 m_CachedTail = 0;
+		alignas(64) std::atomic<uint32> m_Tail{ 0 };
+		uint32 m_CachedHead = 0;
+	};
+
+}; // namespace Core
@@ -0,0 +1,104 @@
+#include "ThreadPool.h"
+
+namespace Core
+{
+	ThreadPool::~ThreadPool() { Destroy(); }
+
+	uint32 ThreadPool::DefaultWorkerCount()
+	{
+		const uint32 cores = std::thread::hardware_concurrency();
+		return cores > 1 ? cores - 1 : 0;
+	}
+
+	void ThreadPool::Init(uint32 workerCount)
+	{
+		Destroy();
+
+		m_Quit = false;
+		m_Workers.reserve(workerCount);
+		for(uint32 i = 0; i < workerCount; ++i)
+			m_Workers.emplace_back(&ThreadPool::WorkerLoop, this);
+	}
+
+	void ThreadPool::Destroy()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_Lock);
+			m_Quit = true;
+		}
+		m_WakeUp.notify_all();
+
+		for(std::thread& worker : m_Workers)
+			worker.join();
+		m_Workers.clear();
+	}
+
+	void ThreadPool::Dispatch(uint32 jobCount, const Job& job)
+	{
+		if(jobCount == 0)
+			return;
+
+		if(m_Workers.empty() || jobCount == 1)
+		{
+			for(uint32 i = 0; i < jobCount; ++i)
+				job(i);
+			return;
+		}
+
+		std::lock_guard<std::mutex> dispatchLock(m_DispatchLock);
+		{
+			std::lock_guard<std::mutex> lock(m_Lock);
+			m_Job = &job;
+			m_JobCount = jobCount;
+			m_NextJob.store(0, std::memory_order_relaxed);
+			++m_Generation;
+		}
+		m_WakeUp.notify_all();
+
+		RunJobs(&job, jobCount);
+
+		// every job index is taken, wait for the workers still running theirs. Workers waking up after the batch is
+		// cleared find nothing to do.
+		std::unique_lock<std::mutex> lock(m_Lock);
+		m_Idle.wait(lock, [this]() { return m_ActiveWorkers == 0; });
+		m_Job = nullptr;
+		m_JobCount = 0;
+	}
+
+	void ThreadPool::WorkerLoop()
+	{
+		uint64 generation = 0;
+		for(;;)
+		{
+			const Job* job = nullptr;
+			uint32 jobCount = 0;
+			{
+				std::unique_lock<std::mutex> lock(m_Lock);
+				m_WakeUp.wait(lock, [this, generation]() { return m_Quit || m_Generation != generation; });
+				if(m_Quit)
+					return;
+
+				generation = m_Generation;
+				if(!m_Job)
+					continue;
+
+				job = m_Job;
+				jobCount = m_JobCount;
+				++m_ActiveWorkers;
+			}
+
+			RunJobs(job, jobCount);
+
+			std::lock_guard<std::mutex> lock(m_Lock);
+			if(--m_ActiveWorkers == 0)
+				m_Idle.notify_all();
+		}
+	}
+
+	void ThreadPool::RunJobs(const Job* job, uint32 jobCount)
+	{
+		for(uint32 index = m_NextJob.fetch_add(1); index < jobCount; index = m_NextJob.fetch_add(1))
+			(*job)(index);
+	}
+
+}; // namespace Core
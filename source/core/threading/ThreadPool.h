@@ -0,0 +1,61 @@
+#pragma once
+#include "Core/Types.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+	A fixed set of worker threads for data parallel work.
+
+	Dispatch runs a job function jobCount times, once per job index, and returns when every job has finished.
+	The calling thread takes jobs as well, a pool without workers simply runs everything on the caller.
+	Only one dispatch runs at a time, dispatching from several threads serializes on the pool.
+*/
+
+namespace Core
+{
+	class ThreadPool
+	{
+	public:
+		typedef std::function<void(uint32 jobIndex)> Job;
+
+		ThreadPool() = default;
+		~ThreadPool();
+
+		/* workerCount threads are started on top of the calling thread, by default one per remaining core */
+		void Init(uint32 workerCount = DefaultWorkerCount());
+		void Destroy();
+
+		void Dispatch(uint32 jobCount, const Job& job);
+
+		uint32 GetWorkerCount() const { return (uint32)m_Workers.size(); }
+		uint32 GetThreadCount() const { return GetWorkerCount() + 1; }
+
+		static uint32 DefaultWorkerCount();
+
+	private:
+		void WorkerLoop();
+		void RunJobs(const Job* job, uint32 jobCount);
+
+		std::vector<std::thread> m_Workers;
+
+		std::mutex m_DispatchLock; // held for a whole dispatch
+		std::mutex m_Lock;
+		std::condition_variable m_WakeUp;
+		std::condition_variable m_Idle;
+
+		/* the current batch, written under m_Lock */
+		const Job* m_Job = nullptr;
+		uint32 m_JobCount = 0;
+		uint64 m_Generation = 0;
+		uint32 m_ActiveWorkers = 0;
+		bool m_Quit = false;
+
+		std::atomic<uint32> m_NextJob{ 0 };
+	};
+
+}; // namespace Core
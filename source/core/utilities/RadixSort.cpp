@@ -0,0 +1,161 @@
+#include "RadixSort.h"
+
+#include "Core/memory/FrameMemory.h"
+#include "Core/threading/ThreadPool.h"
+
+#include <cstring>
+#include <utility>
+
+namespace Core
+{
+	constexpr uint32 s_Passes = 8;
+	constexpr uint32 s_Buckets = 256;
+	constexpr uint32 s_MinPairsPerThread = 16 * 1024; // below this the threads cost more than they save
+
+	static inline uint32 Digit(uint64 key, uint32 pass) { return (uint32)(key >> (pass * 8)) & (s_Buckets - 1); }
+
+	static bool IsUniform(const uint32* histogram, uint32 count)
+	{
+		for(uint32 bucket = 0; bucket < s_Buckets; ++bucket)
+		{
+			if(histogram[bucket] != 0)
+				return histogram[bucket] == count;
+		}
+		return true;
+	}
+
+	static void Scatter(const SortPair* src, SortPair* dst, uint32 begin, uint32 end, uint32 pass, uint32* offsets)
+	{
+		for(uint32 i = begin; i < end; ++i)
+			dst[offsets[Digit(src[i].m_Key, pass)]++] = src[i];
+	}
+
+	static void RadixSortSerial(SortPair* pairs, SortPair* scratch, uint32 count)
+	{
+		// one read gives the histograms of all the passes, the counts do not change with the order
+		uint32 histograms[s_Passes][s_Buckets] = {};
+		for(uint32 i = 0; i < count; ++i)
+		{
+			for(uint32 pass = 0; pass < s_Passes; ++pass)
+				histograms[pass][Digit(pairs[i].m_Key, pass)]++;
+		}
+
+		SortPair* src = pairs;
+		SortPair* dst = scratch;
+		for(uint32 pass = 0; pass < s_Passes; ++pass)
+		{
+			if(IsUniform(histograms[pass], count))
+				continue;
+
+			uint32 offsets[s_Buckets];
+			uint32 sum = 0;
+			for(uint32 bucket = 0; bucket < s_Buckets; ++bucket)
+			{
+				offsets[bucket] = sum;
+				sum += histograms[pass][bucket];
+			}
+
+			Scatter(src, dst, 0, count, pass, offsets);
+			std::swap(src, dst);
+		}
+
+		if(src != pairs)
+			memcpy(pairs, src, sizeof(SortPair) * count);
+	}
+
+	void RadixSort(SortPair* pairs, SortPair* scratch, uint32 count, ThreadPool* pool)
+	{
+		uint32 threadCount = pool ? pool->GetThreadCount() : 1;
+		if(threadCount > count / s_MinPairsPerThread)
+			threadCount = count / s_MinPairsPerThread;
+
+		if(threadCount <= 1)
+		{
+			RadixSortSerial(pairs, scratch, count);
+			return;
+		}
+
+		// every thread owns a contiguous chunk, its histogram and its write offsets per bucket. Chunks are written
+		// in order behind each other within a bucket, which keeps the sort stable.
+		const uint32 chunkSize = (count + threadCount - 1) / threadCount;
+		ScratchScope scope;
+		uint32* histograms = scope.Allocate<uint32>(threadCount * s_Passes * s_Buckets);
+		memset(histograms, 0, sizeof(uint32) * threadCount * s_Passes * s_Buckets);
+
+		auto chunkHistogram = [&](uint32 thread, uint32 pass) -> uint32* {
+			return &histograms[(thread * s_Passes + pass) * s_Buckets];
+		};
+
+		auto chunkRange = [&](uint32 thread, uint32* begin, uint32* end) {
+			*begin = thread * chunkSize;
+			*end = *begin + chunkSize < count ? *begin + chunkSize : count;
+		};
+
+		pool->Dispatch(threadCount, [&](uint32 thread) {
+			uint32 begin, end;
+			chunkRange(thread, &begin, &end);
+			for(uint32 i = begin; i < end; ++i)
+			{
+				for(uint32 pass = 0; pass < s_Passes; ++pass)
+					chunkHistogram(thread, pass)[Digit(pairs[i].m_Key, pass)]++;
+			}
+		});
+
+		uint32 totals[s_Passes][s_Buckets] = {};
+		for(uint32 thread = 0; thread < threadCount; ++thread)
+		{
+			for(uint32 pass = 0; pass < s_Passes; ++pass)
+			{
+				for(uint32 bucket = 0; bucket < s_Buckets; ++bucket)
+					totals[pass][bucket] += chunkHistogram(thread, pass)[bucket];
+			}
+		}
+
+		SortPair* src = pairs;
+		SortPair* dst = scratch;
+		bool firstPass = true;
+		for(uint32 pass = 0; pass < s_Passes; ++pass)
+		{
+			if(IsUniform(totals[pass], count))
+				continue;
+
+			// the chunks hold different pairs after a scatter, only the first pass can use the histograms above
+			if(!firstPass)
+			{
+				pool->Dispatch(threadCount, [&](uint32 thread) {
+					uint32 begin, end;
+					chunkRange(thread, &begin, &end);
+					uint32* histogram = chunkHistogram(thread, pass);
+					memset(histogram, 0, sizeof(uint32) * s_Buckets);
+					for(uint32 i = begin; i < end; ++i)
+						histogram[Digit(src[i].m_Key, pass)]++;
+				});
+			}
+			firstPass = false;
+
+			// turn the counts into write offsets, bucket major and chunk minor
+			uint32 sum = 0;
+			for(uint32 bucket = 0; bucket < s_Buckets; ++bucket)
+			{
+				for(uint32 thread = 0; thread < threadCount; ++thread)
+				{
+					uint32& slot = chunkHistogram(thread, pass)[bucket];
+					const uint32 bucketCount = slot;
+					slot = sum;
+					sum += bucketCount;
+				}
+			}
+
+			pool->Dispatch(threadCount, [&](uint32 thread) {
+				uint32 begin, end;
+				chunkRange(thread, &begin, &end);
+				Scatter(src, dst, begin, end, pass, chunkHistogram(thread, pass));
+			});
+			std::swap(src, dst);
+		}
+
+		if(src != pairs)
+			memcpy(pairs, src, sizeof(SortPair) * count);
+	}
+
+}; // namespace Core
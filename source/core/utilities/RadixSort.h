@@ -0,0 +1,23 @@
+#pragma once
+#include "Core/Types.h"
+
+namespace Core
+{
+	class ThreadPool;
+
+	struct SortPair
+	{
+		uint64 m_Key;
+		uint32 m_Value;
+	};
+
+	/*
+		Stable LSD radix sort on the 64 bit keys, one byte per pass. Passes where every key shares the same byte are
+		skipped, so keys that only use their lower bits cost less.
+
+		scratch must hold count pairs, the sorted result always ends up in pairs. With a pool and enough pairs the
+		histograms and the scatter of every pass are split over the pool's threads.
+	*/
+	void RadixSort(SortPair* pairs, SortPair* scratch, uint32 count, ThreadPool* pool = nullptr);
+
+}; // namespace Core
@@ -1,5 +1,5 @@
 #include "utilities.h"
-#include "Core/hash/Murmur3.h"
+#include "Core/hash/FastHash.h"
 #include <Windows.h>
 namespace Core
 {
@@ -26,16 +26,12 @@ namespace Core
 
 	uint64 Hash(const std::string& str)
 	{
-		uint64 result;
-		MurmurHash3_x86_32(str.c_str(), (int32)str.length(), 0, &result);
-		return result;
+		return Hash64(str.c_str(), str.length());
 	}
 
 	uint64 Hash(const std::string& str, uint32 seed)
 	{
-		uint64 result;
-		MurmurHash3_x86_32(str.c_str(), (int32)str.length(), seed, &result);
-		return result;
+		return Hash64(str.c_str(), str.length(), seed);
 	}
 
 	void DebugPrintLastError()
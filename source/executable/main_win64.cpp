@@ -3,7 +3,12 @@
 #include "graphics/Window.h"
 #include "graphics/GraphicsEngine.h"
 
+#include "core/FixedTimestep.h"
 #include "core/Timer.h"
+#include "core/memory/FrameMemory.h"
+#include "core/memory/MemoryTracker.h"
+#include "core/profiler/Profiler.h"
+#include "core/String/HashString.h"
 #include "input/InputManager.h"
 #include "Logger/Debug.h"
 
@@ -11,6 +16,7 @@
 #include "game/Game.h"
 #include "imgui/imgui.h"
 
+
 #ifdef _WIN32
 #include <Windows.h>
 #include "WindowsMain.h"
@@ -39,9 +45,34 @@ int main(int argc, char* argv[])
 	Input::InputManager& input = Input::InputManager::Get();
 	input.Initialize(main->GetWindow()->GetHandle(), instance);
 
+	// -record <file> writes the session's input, -replay <file> plays one back with its frame times
+#ifdef _WIN32
+	const int argCount = __argc;
+	char** args = __argv;
+#else
+	const int argCount = argc;
+	char** args = argv;
+#endif
+	for(int i = 1; i + 1 < argCount; ++i)
+	{
+		switch(Core::StringHash(args[i]))
+		{
+			case "-record"_hs:
+				input.StartRecording(args[i + 1]);
+				break;
+			case "-replay"_hs:
+				input.StartReplay(args[i + 1]);
+				break;
+		}
+	}
+
 	Core::Timer timer;
 	timer.Init();
 
+	// the game and the scene advance at 60 Hz, frames render at whatever rate they manage
+	Core::FixedTimestep timestep;
+	timestep.Init(1.f / 60.f, 4);
+
 	Game game;
 	StateStack state_stack;
 	state_stack.PushState(&game, StateStack::MAIN);
@@ -51,15 +82,30 @@ int main(int argc, char* argv[])
 		timer.Update();
 		main->Update();
 
-		state_stack.UpdateCurrentState(timer.GetTime());
-		input.Update();
-		graphics_engine.Present(timer.GetTime());
-
+		const float dt = input.Update(timer.GetTime());
+		const uint32 steps = timestep.Advance(dt);
+		for(uint32 i = 0; i < steps; ++i)
+		{
+			state_stack.UpdateCurrentState(timestep.GetStep());
+			graphics_engine.Simulate(timestep.GetStep());
+		}
+		graphics_engine.Present(dt, timestep.GetAlpha());
+
+		// the render thread reports its own frame time, this one only covers the game side
+		PROFILE_COUNTER("Game frame us", timer.GetTime() * 1000000.f);
+		PROFILE_COUNTER("Simulation steps", steps);
+		PROFILE_COUNTER("Frame arena bytes", Core::GetFrameArena().GetUsed());
+		PROFILE_FRAME();
+		Core::MemoryTracker::Get().NewFrame();
+
+		// the packet is filled, nothing the game thread took from the frame arena is used after this
+		Core::GetFrameArena().Reset();
 	} while(true);
 
 	delete main;
 
 	Input::InputManager::Destroy();
+	Core::Profiler::Destroy();
 	Log::Debug::Destroy();
 
 	return 0;
@@ -1,6 +1,8 @@
 #include "StateStack.h"
 #include "State.h"
 
+#include "core/profiler/Profiler.h"
+
 void StateStack::PopCurrentMainState()
 {
 	while( m_GameStates[m_MainIndex].Size() > 0 )
@@ -60,6 +62,7 @@ void StateStack::ResumeCurrentState()
 
 bool StateStack::UpdateCurrentState( float dt )
 {
+	PROFILE_FUNCTION();
 	if( m_GameStates.Size() > 0 )
 	{
 		m_GameStates[m_MainIndex][m_SubIndex]->Update( dt );
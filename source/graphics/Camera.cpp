@@ -20,7 +20,14 @@ namespace Graphics
 
 	void Camera::Update() // called once per frame
 	{
-		m_ViewProjection = m_ProjectionMatrix * Core::FastInverse(m_ViewMatrix);
+		m_ViewMatrixInverse = Core::FastInverse(m_ViewMatrix);
+		m_ViewProjection = m_ProjectionMatrix * m_ViewMatrixInverse;
+	}
+
+	float Camera::GetPixelScale(float screenHeight) const
+	{
+		// the projection scales y by 1 / tan(fov / 2) and normalized device coordinates span two units
+		return fabsf(m_ProjectionMatrix[5]) * screenHeight * 0.5f;
 	}
 
 	Core::Matrix44f* Camera::GetViewProjectionPointer()
@@ -39,6 +39,9 @@ namespace Graphics
 
 		void SetTranslation(const Core::Vector4f& translation);
 
+		/* pixels one unit at a distance of one covers on a screen screenHeight pixels high */
+		float GetPixelScale(float screenHeight) const;
+
 		const Core::Vector4f& GetPosition()
 		{
 			return m_ViewMatrix.GetTranslation();
@@ -1,68 +1,86 @@
 #include "Cube.h"
 
-#include <vulkan/vulkan_core.h>
+#include "OcclusionBuffer.h"
+#include "RenderQueue.h"
 
-#include "VlkDevice.h"
-#include "VlkPhysicalDevice.h"
-
-#include "core/File.h"
+#include "core/MappedFile.h"
 #include "logger/Debug.h"
 
-void Cube::Init(Graphics::VlkDevice* device, Graphics::VlkPhysicalDevice* physicalDevice)
+#include <cfloat>
+
+constexpr float s_MaxPixelError = 1.f;
+constexpr float s_LodHysteresis = 0.25f;
+
+void Cube::Init(Graphics::IGraphicsDevice* device)
 {
-	Core::File loader("cube.mdl", Core::File::READ_FILE);
+	// the vertices are read straight from the mapping, only the positions and the LODs are copied out
+	Core::MappedFile loader("cube.mdl");
+	ASSERT(loader.IsOpen(), "Failed to open cube.mdl!");
+	Init(device, loader.GetData().As<const Vertex>());
+}
 
-	m_Orientation = Core::Matrix44f::Identity();
+void Cube::Init(Graphics::IGraphicsDevice* device, Core::Span<const Vertex> mesh)
+{
 	m_Stride = sizeof(Vertex);
-	m_VertexCount = (loader.GetSize() / sizeof(Vertex));
+	m_VertexCount = (int32)mesh.Size();
 	m_Offset = 0;
 
-	const int32 dataSize = m_Stride * m_VertexCount;
-
-	VkBufferCreateInfo createInfo = {};
-	createInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-	createInfo.size = dataSize;
-	createInfo.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
-	createInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-
-	m_Buffer = device->CreateBuffer(createInfo, &m_Memory, physicalDevice);
-
-	void* data = nullptr;
-	if(vkMapMemory(device->GetDevice(), m_Memory, 0, dataSize, 0, &data) != VK_SUCCESS)
-		ASSERT(false, "Failed to map memory!");
-
-	memcpy(data, loader.GetBuffer(), loader.GetSize());
-	vkUnmapMemory(device->GetDevice(), m_Memory);
+	const Vertex* vertices = mesh.GetData();
+	m_Positions.resize(m_VertexCount);
+	m_BoundsMin = { FLT_MAX, FLT_MAX, FLT_MAX, 1.f };
+	m_BoundsMax = { -FLT_MAX, -FLT_MAX, -FLT_MAX, 1.f };
+	for(int32 i = 0; i < m_VertexCount; ++i)
+	{
+		const Core::Vector4f& position = vertices[i].position;
+		m_Positions[i] = position;
+		m_BoundsMin.x = fminf(m_BoundsMin.x, position.x);
+		m_BoundsMin.y = fminf(m_BoundsMin.y, position.y);
+		m_BoundsMin.z = fminf(m_BoundsMin.z, position.z);
+		m_BoundsMax.x = fmaxf(m_BoundsMax.x, position.x);
+		m_BoundsMax.y = fmaxf(m_BoundsMax.y, position.y);
+		m_BoundsMax.z = fmaxf(m_BoundsMax.z, position.z);
+	}
+
+	std::vector<uint8> lodVertices;
+	Graphics::BuildLods(vertices, m_Stride, m_VertexCount, Graphics::s_MaxLods, &lodVertices, &m_Lods);
+
+	// uploaded through the transfer queue, the buffer is ready for the first frame after the upload is flushed
+	Graphics::BufferDesc desc;
+	desc.m_Size = (uint32)lodVertices.size();
+	desc.m_BindFlags = Graphics::BIND_VERTEX_BUFFER;
+	desc.m_Usage = Graphics::IMMUTABLE_USAGE;
+	desc.m_InitialData = lodVertices.data();
+	m_Buffer = device->CreateBuffer(desc);
 }
 
-void Cube::Draw(VkCommandBuffer commandBuffer, VkPipelineLayout pipelineLayout)
+uint32 Cube::SelectLod(uint32 current, float pixelsPerUnit) const
 {
-	char* data = new char[sizeof(Core::Matrix44f)];
-	memset(data, 0, sizeof(Core::Matrix44f));
-	memcpy(&data[0], &m_Orientation, sizeof(Core::Matrix44f));
-	// memcpy(&data[sizeof(Core::Matrix44f)], &_LightDir, sizeof(Core::Vector4f)); // This is not good at all
-
-	vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(Core::Matrix44f), data);
-	/* This is quite a strange one, this is only gonna be available in non-instanced entities for position */
-
-	VkDeviceSize offset = 0;
-	vkCmdBindVertexBuffers(commandBuffer, 0, 1, &m_Buffer, &offset);
+	// the hysteresis keeps cubes at a threshold from flickering
+	return Graphics::SelectLod(m_Lods.data(), (uint32)m_Lods.size(), current, pixelsPerUnit, s_MaxPixelError,
+							   s_LodHysteresis);
+}
 
-	// This executes secondary commandBuffers inside of the primary commandBuffer
-	// vkCmdExecuteCommands(commandBuffer, 0, nullptr);
+void Cube::Submit(Graphics::RenderQueue* queue, Graphics::HPipeline pipeline, const Core::Matrix44f& world, uint32 lod,
+				  float depth) const
+{
+	const Graphics::MeshLod& range = m_Lods[lod];
 
-	vkCmdDraw(commandBuffer, m_VertexCount, 1, 0, 0);
+	Graphics::DrawCall draw;
+	draw.m_Pipeline = pipeline;
+	draw.m_VertexBuffer = m_Buffer;
+	draw.m_VertexCount = range.m_VertexCount;
+	draw.m_FirstVertex = range.m_FirstVertex;
 
-	delete[] data;
-	data = nullptr;
+	queue->Submit(draw, depth, &world, sizeof(Core::Matrix44f));
 }
 
-void Cube::SetPosition(const Core::Vector4f& position)
+void Cube::AddOccluder(Graphics::OcclusionBuffer* buffer, const Core::Matrix44f& world) const
 {
-	m_Orientation.SetPosition(position);
+	buffer->AddOccluder(world, m_Positions.data(), (uint32)m_Positions.size());
 }
 
-void Cube::Destroy(VkDevice device)
+void Cube::Destroy(Graphics::IGraphicsDevice* device)
 {
-	vkDestroyBuffer(device, m_Buffer, nullptr);
+	device->DestroyBuffer(m_Buffer);
+	m_Buffer = 0;
 }
@@ -2,20 +2,18 @@
 #include "Core/Defines.h"
 #include "Core/Types.h"
 #include "Core/Math/Matrix44.h"
+#include "Core/containers/Span.h"
+#include "GraphicsDevice.h"
+#include "MeshLod.h"
+
+#include <vector>
 
 namespace Graphics
 {
-
-	class VlkDevice;
-	class VlkPhysicalDevice;
+	class RenderQueue;
+	class OcclusionBuffer;
 }; // namespace Graphics
 
-DEFINE_HANDLE(VkBuffer);
-DEFINE_HANDLE(VkDeviceMemory);
-DEFINE_HANDLE(VkDevice);
-DEFINE_HANDLE(VkCommandBuffer);
-DEFINE_HANDLE(VkPipelineLayout);
-
 // Vertex Description
 struct Vertex
 {
@@ -30,16 +28,33 @@ public:
 	Cube() = default;
 	~Cube() = default;
 
-	void Init(Graphics::VlkDevice* device, Graphics::VlkPhysicalDevice* physicalDevice);
-	void Destroy(VkDevice device);
-	void Draw(VkCommandBuffer commandBuffer, VkPipelineLayout pipelineLayout);
-	void SetPosition(const Core::Vector4f& position);
+	/* maps cube.mdl */
+	void Init(Graphics::IGraphicsDevice* device);
+	void Init(Graphics::IGraphicsDevice* device, Core::Span<const Vertex> mesh);
+	void Destroy(Graphics::IGraphicsDevice* device);
+
+	/* an error of less than a pixel is not visible, pixelsPerUnit is Camera::GetPixelScale over the distance */
+	uint32 SelectLod(uint32 current, float pixelsPerUnit) const;
+	/* depth is the distance to the eye divided by the far plane */
+	void Submit(Graphics::RenderQueue* queue, Graphics::HPipeline pipeline, const Core::Matrix44f& world, uint32 lod,
+				float depth) const;
+
+	/* the cube hides whatever is behind it with its own triangles */
+	void AddOccluder(Graphics::OcclusionBuffer* buffer, const Core::Matrix44f& world) const;
+
+	const Core::Vector4f& GetBoundsMin() const { return m_BoundsMin; }
+	const Core::Vector4f& GetBoundsMax() const { return m_BoundsMax; }
 
 private:
-	Core::Matrix44f m_Orientation;
+	// model space, kept on the CPU for the occlusion culling
+	std::vector<Core::Vector4f> m_Positions;
+	Core::Vector4f m_BoundsMin;
+	Core::Vector4f m_BoundsMax;
+
+	// every LOD is a range of the vertex buffer, generated from the full mesh when it is loaded
+	std::vector<Graphics::MeshLod> m_Lods;
 
-	VkBuffer m_Buffer = nullptr;
-	VkDeviceMemory m_Memory = nullptr;
+	Graphics::HBuffer m_Buffer = 0;
 	int32 m_VertexCount = 0;
 	int32 m_Stride = 0;
 	int32 m_Offset = 0;
@@ -32,6 +32,41 @@
 namespace Graphics
 {
 	class ConstantBuffer;
+
+	// slot index and generation, see Core::Pool. 0 is never a valid handle and destroyed handles stay invalid
+	typedef uint32 HBuffer;
+	typedef uint32 HPipeline;
+
+	struct BufferDesc
+	{
+		uint32 m_Size = 0;
+		uint32 m_BindFlags = BIND_VERTEX_BUFFER; // EBindFlag
+		EUsage m_Usage = DEFAULT_USAGE;			 // only DYNAMIC_USAGE and STAGING_USAGE buffers can be updated
+		const void* m_InitialData = nullptr;
+	};
+
+	struct PipelineDesc
+	{
+		const char* m_VertexShader = nullptr;
+		const char* m_FragmentShader = nullptr; // without one the pipeline only writes depth, for the pre-pass
+		ETopology m_Topology = TRIANGLE_LIST;
+		bool m_DepthTest = true;
+		bool m_DepthWrite = true;
+	};
+
+	/* What a buffer is used for on either side of a barrier */
+	enum EResourceState : uint8
+	{
+		EResourceState_Undefined,
+		EResourceState_VertexBuffer,
+		EResourceState_IndexBuffer,
+		EResourceState_ConstantBuffer,
+		EResourceState_ShaderRead,
+		EResourceState_ShaderWrite,
+		EResourceState_CopySource,
+		EResourceState_CopyDest,
+	};
+
 	class IGraphicsDevice
 	{
 		public:
@@ -42,6 +77,27 @@ namespace Graphics
 			virtual void CreateConstantBuffer(ConstantBuffer* constantBuffer) = 0;
 			virtual void DestroyConstantBuffer(ConstantBuffer* constantBuffer) = 0;
 
+			/* Resources, created and destroyed outside of command recording */
+			virtual HBuffer CreateBuffer(const BufferDesc& desc) = 0;
+			virtual void UpdateBuffer(HBuffer buffer, const void* data, uint32 size, uint32 offset) = 0;
+			virtual void DestroyBuffer(HBuffer buffer) = 0;
+
+			virtual HPipeline CreatePipeline(const PipelineDesc& desc) = 0;
+			virtual void DestroyPipeline(HPipeline pipeline) = 0;
+
+			/* Commands, recorded into the frame that is currently being built */
+			virtual void BindPipeline(HPipeline pipeline) = 0;
+			virtual void BindVertexBuffer(HBuffer buffer, uint32 offset) = 0;
+			virtual void BindIndexBuffer(HBuffer buffer, uint32 offset) = 0;
+			virtual void PushConstants(const void* data, uint32 size, uint32 offset) = 0;
+
+			virtual void Draw(uint32 vertexCount, uint32 instanceCount, uint32 firstVertex, uint32 firstInstance) = 0;
+			virtual void DrawIndexed(uint32 indexCount, uint32 instanceCount, uint32 firstIndex, int32 vertexOffset,
+									 uint32 firstInstance) = 0;
+
+			/* Makes writes done in the before state visible to the after state, record outside of render passes */
+			virtual void Barrier(HBuffer buffer, EResourceState before, EResourceState after) = 0;
+
 		private:
 	};
 
@@ -40,15 +40,43 @@ namespace Graphics
 			return false;
 		}
 
+		// double buffered, the game thread builds frame n + 1 while frame n is recorded and submitted
+		m_Packets.Init( 2 );
+		m_RenderThread = std::thread( &GraphicsEngine::RenderLoop, this );
 		return true;
 	}
 
-	void GraphicsEngine::Present( float dt ) { m_Device->DrawFrame( dt ); }
+	void GraphicsEngine::Simulate( float step ) { m_Device->Simulate( step ); }
+
+	void GraphicsEngine::Present( float dt, float alpha )
+	{
+		RenderPacket* packet = m_Packets.BeginWrite();
+		if( !packet )
+			return;
+
+		m_Device->BuildFrame( dt, alpha, packet, m_Packets.GetIndex( packet ) );
+		m_Packets.EndWrite();
+	}
+
+	void GraphicsEngine::RenderLoop()
+	{
+		while( const RenderPacket* packet = m_Packets.BeginRead() )
+		{
+			m_Device->RenderFrame( *packet, m_Packets.GetIndex( packet ) );
+			m_Packets.EndRead();
+		}
+	}
 
 	Camera* GraphicsEngine::GetCamera() { return m_Device->GetCamera(); }
 
 	void GraphicsEngine::BeginFrame() {}
 
-	GraphicsEngine::~GraphicsEngine() {}
+	GraphicsEngine::~GraphicsEngine()
+	{
+		// the frames already handed over are still rendered before the device goes away
+		m_Packets.Close();
+		if( m_RenderThread.joinable() )
+			m_RenderThread.join();
+	}
 
 }; // namespace Graphics
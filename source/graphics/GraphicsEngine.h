@@ -1,7 +1,9 @@
 #pragma once
 
 #include "GraphicsDevice.h"
+#include "RenderPacket.h"
 #include <memory>
+#include <thread>
 
 class Window;
 namespace Graphics
@@ -17,8 +19,15 @@ namespace Graphics
 		static void Create();
 		static GraphicsEngine& Get();
 
+		/* starts the render thread, the device is only used from there afterwards */
 		bool Init( const Window& window );
-		void Present( float dt );
+		/* game thread, advances the scene by one fixed step */
+		void Simulate( float step );
+		/*
+			game thread, builds the next render packet and hands it to the render thread. alpha is how far the frame
+			is between the last two simulated states.
+		*/
+		void Present( float dt, float alpha );
 
 		static vkGraphicsDevice& GetDevice() { return *m_Instance->m_Device; }
 
@@ -28,7 +37,11 @@ namespace Graphics
 		static std::unique_ptr<GraphicsEngine> m_Instance;
 		std::unique_ptr<vkGraphicsDevice> m_Device;
 
+		RenderPacketQueue m_Packets;
+		std::thread m_RenderThread;
+
 		void BeginFrame();
+		void RenderLoop();
 	};
 
 }; // namespace Graphics
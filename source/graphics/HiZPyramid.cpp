@@ -0,0 +1,144 @@
+#include "HiZPyramid.h"
+
+#include "OcclusionBuffer.h"
+#include "logger/Debug.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace Graphics
+{
+	void HiZPyramid::Init(uint32 depthWidth, uint32 depthHeight)
+	{
+		ASSERT(depthWidth > 0, "Hi-Z pyramid needs a depth buffer!");
+		ASSERT(depthHeight > 0, "Hi-Z pyramid needs a depth buffer!");
+
+		m_DepthWidth = depthWidth;
+		m_DepthHeight = depthHeight;
+
+		uint32 width = 1;
+		while(width * 2 <= depthWidth)
+			width *= 2;
+
+		uint32 height = 1;
+		while(height * 2 <= depthHeight)
+			height *= 2;
+
+		m_Levels.clear();
+		m_FirstReadbackLevel = 0;
+
+		uint32 offset = 0;
+		for(;;)
+		{
+			Level level;
+			level.m_Width = width;
+			level.m_Height = height;
+			level.m_Offset = offset;
+			m_Levels.push_back(level);
+			offset += width * height;
+
+			if(width > s_MaxReadbackWidth)
+				m_FirstReadbackLevel = (uint32)m_Levels.size();
+
+			if(width == 1 && height == 1)
+				break;
+
+			width = std::max(1u, width / 2);
+			height = std::max(1u, height / 2);
+		}
+
+		m_Data.assign(offset, 1.f);
+		Invalidate();
+	}
+
+	void HiZPyramid::ReduceLevel(const float* source, uint32 sourceWidth, uint32 sourceHeight, float* destination,
+								 uint32 width, uint32 height)
+	{
+		for(uint32 y = 0; y < height; ++y)
+		{
+			const uint32 beginY = y * sourceHeight / height;
+			const uint32 endY = ((y + 1) * sourceHeight + height - 1) / height;
+			for(uint32 x = 0; x < width; ++x)
+			{
+				const uint32 beginX = x * sourceWidth / width;
+				const uint32 endX = ((x + 1) * sourceWidth + width - 1) / width;
+
+				float farthest = 0.f;
+				for(uint32 sy = beginY; sy < endY; ++sy)
+				{
+					for(uint32 sx = beginX; sx < endX; ++sx)
+						farthest = std::max(farthest, source[sy * sourceWidth + sx]);
+				}
+				destination[y * width + x] = farthest;
+			}
+		}
+	}
+
+	void HiZPyramid::Build(const float* depth, const Core::Matrix44f& viewProjection)
+	{
+		const float* source = depth;
+		uint32 sourceWidth = m_DepthWidth;
+		uint32 sourceHeight = m_DepthHeight;
+		for(const Level& level : m_Levels)
+		{
+			float* destination = &m_Data[level.m_Offset];
+			ReduceLevel(source, sourceWidth, sourceHeight, destination, level.m_Width, level.m_Height);
+
+			source = destination;
+			sourceWidth = level.m_Width;
+			sourceHeight = level.m_Height;
+		}
+
+		m_ViewProjection = viewProjection;
+		m_FirstValidLevel = 0;
+	}
+
+	void HiZPyramid::SetReadback(const float* data, const Core::Matrix44f& viewProjection)
+	{
+		memcpy(&m_Data[m_Levels[m_FirstReadbackLevel].m_Offset], data, GetReadbackSize());
+		m_ViewProjection = viewProjection;
+		m_FirstValidLevel = m_FirstReadbackLevel;
+	}
+
+	uint32 HiZPyramid::GetReadbackSize() const
+	{
+		return ((uint32)m_Data.size() - m_Levels[m_FirstReadbackLevel].m_Offset) * sizeof(float);
+	}
+
+	bool HiZPyramid::IsVisible(const Core::Matrix44f& world, const Core::Vector4f& min,
+							   const Core::Vector4f& max) const
+	{
+		if(m_FirstValidLevel >= GetLevelCount())
+			return true;
+
+		ScreenBounds bounds;
+		if(!ProjectBounds(m_ViewProjection * world, min, max, &bounds))
+			return true;
+
+		if(bounds.IsOffScreen())
+			return false;
+
+		// at this level the bounds are at most one texel wide, so they touch no more than 2x2 texels
+		const float extent = std::max((bounds.m_MaxX - bounds.m_MinX) * (float)m_Levels[0].m_Width,
+									  (bounds.m_MaxY - bounds.m_MinY) * (float)m_Levels[0].m_Height);
+		uint32 index = extent > 1.f ? (uint32)ceilf(log2f(extent)) : 0;
+		index = std::min(std::max(index, m_FirstValidLevel), GetLevelCount() - 1);
+
+		const Level& level = m_Levels[index];
+		const float* depth = GetLevelData(index);
+		const int32 x0 = std::max(0, (int32)floorf(bounds.m_MinX * (float)level.m_Width));
+		const int32 y0 = std::max(0, (int32)floorf(bounds.m_MinY * (float)level.m_Height));
+		const int32 x1 = std::min((int32)level.m_Width - 1, (int32)floorf(bounds.m_MaxX * (float)level.m_Width));
+		const int32 y1 = std::min((int32)level.m_Height - 1, (int32)floorf(bounds.m_MaxY * (float)level.m_Height));
+
+		float farthest = 0.f;
+		for(int32 y = y0; y <= y1; ++y)
+		{
+			for(int32 x = x0; x <= x1; ++x)
+				farthest = std::max(farthest, depth[y * level.m_Width + x]);
+		}
+		return bounds.m_MinZ <= farthest;
+	}
+
+}; // namespace Graphics
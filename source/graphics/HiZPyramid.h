@@ -0,0 +1,71 @@
+#pragma once
+#include "Core/Types.h"
+#include "Core/math/Matrix44.h"
+
+#include <vector>
+
+namespace Graphics
+{
+	/*
+		Hierarchical depth, every texel holds the farthest depth of the area it covers.
+
+		The first level is the largest power of two that fits the depth buffer and every following level halves it
+		down to 1x1. Texel x of a level covers the source pixels [x * source / size, ceil((x + 1) * source / size)),
+		so no pixel underneath a texel is ever missed even when the sizes do not divide. The GPU builds the levels
+		with shaders/hiz.comp, ReduceLevel is the same reduction on the CPU.
+
+		Culling only needs the coarse levels, those are read back after the frame and tested against the screen
+		bounds of an object at the level where the bounds cover at most 2x2 texels. Depth is z / w in [0, 1] with 1
+		as the far plane, the same as in the depth buffer.
+	*/
+	class HiZPyramid
+	{
+	public:
+		struct Level
+		{
+			uint32 m_Width = 0;
+			uint32 m_Height = 0;
+			uint32 m_Offset = 0; // in floats, the levels are stored back to back
+		};
+
+		/* finer levels than this are not read back */
+		static constexpr uint32 s_MaxReadbackWidth = 128;
+
+		HiZPyramid() = default;
+		~HiZPyramid() = default;
+
+		void Init(uint32 depthWidth, uint32 depthHeight);
+
+		static void ReduceLevel(const float* source, uint32 sourceWidth, uint32 sourceHeight, float* destination,
+								uint32 width, uint32 height);
+
+		/* builds every level on the CPU from a full depth buffer rendered with viewProjection */
+		void Build(const float* depth, const Core::Matrix44f& viewProjection);
+
+		/* data holds the levels from GetFirstReadbackLevel on, back to back */
+		void SetReadback(const float* data, const Core::Matrix44f& viewProjection);
+		void Invalidate() { m_FirstValidLevel = GetLevelCount(); }
+
+		/* conservative, everything is visible until there is a pyramid and bounds crossing the near plane always are */
+		bool IsVisible(const Core::Matrix44f& world, const Core::Vector4f& min, const Core::Vector4f& max) const;
+
+		uint32 GetLevelCount() const { return (uint32)m_Levels.size(); }
+		const Level& GetLevel(uint32 level) const { return m_Levels[level]; }
+		const float* GetLevelData(uint32 level) const { return &m_Data[m_Levels[level].m_Offset]; }
+
+		uint32 GetFirstReadbackLevel() const { return m_FirstReadbackLevel; }
+		uint32 GetReadbackSize() const;
+
+	private:
+		uint32 m_DepthWidth = 0;
+		uint32 m_DepthHeight = 0;
+		uint32 m_FirstReadbackLevel = 0;
+		uint32 m_FirstValidLevel = 0;
+
+		Core::Matrix44f m_ViewProjection = Core::Matrix44f::Identity();
+
+		std::vector<Level> m_Levels;
+		std::vector<float> m_Data;
+	};
+
+}; // namespace Graphics
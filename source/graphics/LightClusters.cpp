@@ -0,0 +1,219 @@
+#include "LightClusters.h"
+
+#include "Core/threading/ThreadPool.h"
+#include "Core/profiler/Profiler.h"
+#include "logger/Debug.h"
+
+#include <algorithm>
+#include <cmath>
+#include <emmintrin.h>
+
+namespace Graphics
+{
+	constexpr uint32 s_LightsPerJob = 256;
+
+	void LightClusters::TilePlanes::Init(const Core::Vector4f& axis, const Core::Vector4f& w, uint32 tileCount)
+	{
+		ASSERT(tileCount < s_Capacity, "Too many tiles for the plane arrays!");
+		m_TileCount = tileCount;
+
+		// boundary i is where the normalized device coordinate is -1 + 2i / tileCount, clip = a * w there
+		for(uint32 i = 0; i < s_Capacity; ++i)
+		{
+			const float ndc = -1.f + 2.f * (float)std::min(i, tileCount) / (float)tileCount;
+			const Core::Vector4f plane = axis - w * ndc;
+			const float length = sqrtf(plane.x * plane.x + plane.y * plane.y + plane.z * plane.z);
+			m_X[i] = plane.x / length;
+			m_Y[i] = plane.y / length;
+			m_Z[i] = plane.z / length;
+			m_W[i] = plane.w / length;
+		}
+	}
+
+	bool LightClusters::TilePlanes::FindTiles(const Core::Vector4f& center, float radius, uint8* first,
+											  uint8* last) const
+	{
+		const __m128 x = _mm_set1_ps(center.x);
+		const __m128 y = _mm_set1_ps(center.y);
+		const __m128 z = _mm_set1_ps(center.z);
+		const __m128 r = _mm_set1_ps(radius);
+		const __m128 negativeR = _mm_set1_ps(-radius);
+
+		// bit i of positive is set when the sphere is entirely past boundary i, of notNegative when any of it is
+		uint32 positive = 0;
+		uint32 notNegative = 0;
+		for(uint32 i = 0; i < s_Capacity; i += 4)
+		{
+			__m128 distance = _mm_add_ps(_mm_mul_ps(x, _mm_load_ps(&m_X[i])), _mm_mul_ps(y, _mm_load_ps(&m_Y[i])));
+			distance = _mm_add_ps(distance, _mm_mul_ps(z, _mm_load_ps(&m_Z[i])));
+			distance = _mm_add_ps(distance, _mm_load_ps(&m_W[i]));
+
+			positive |= (uint32)_mm_movemask_ps(_mm_cmpgt_ps(distance, r)) << i;
+			notNegative |= (uint32)_mm_movemask_ps(_mm_cmpgt_ps(distance, negativeR)) << i;
+		}
+
+		// tile t lies between boundary t and t + 1
+		const uint32 touched = notNegative & ~(positive >> 1) & ((1u << m_TileCount) - 1);
+		if(touched == 0)
+			return false;
+
+		uint32 tile = 0;
+		while((touched & (1u << tile)) == 0)
+			++tile;
+		*first = (uint8)tile;
+
+		tile = m_TileCount - 1;
+		while((touched & (1u << tile)) == 0)
+			--tile;
+		*last = (uint8)tile;
+		return true;
+	}
+
+	void LightClusters::Init(const Core::Matrix44f& projection, float nearPlane, float farPlane, uint32 maxIndices)
+	{
+		ASSERT(nearPlane > 0.f, "Depth slices need a near plane in front of the camera!");
+		ASSERT(farPlane > nearPlane, "Far plane must be beyond the near plane!");
+
+		m_Columns.Init(projection.GetColumn(0), projection.GetColumn(3), s_ClustersX);
+		m_Rows.Init(projection.GetColumn(1), projection.GetColumn(3), s_ClustersY);
+
+		m_Near = nearPlane;
+		m_Far = farPlane;
+		m_SliceScale = (float)s_Slices / logf(farPlane / nearPlane);
+		m_SliceBias = -logf(nearPlane) * m_SliceScale;
+		m_MaxIndices = maxIndices;
+
+		m_Clusters.assign(s_ClusterCount, Cluster());
+		m_Indices.clear();
+		m_Dropped = 0;
+		m_Visible = 0;
+	}
+
+	uint32 LightClusters::GetSlice(float viewDepth) const
+	{
+		const float slice = logf(std::max(viewDepth, m_Near)) * m_SliceScale + m_SliceBias;
+		return std::min((uint32)std::max(slice, 0.f), s_Slices - 1);
+	}
+
+	uint32 LightClusters::GetClusterIndex(float screenX, float screenY, float viewDepth) const
+	{
+		const uint32 x = std::min((uint32)std::max(screenX * (float)s_ClustersX, 0.f), s_ClustersX - 1);
+		const uint32 y = std::min((uint32)std::max(screenY * (float)s_ClustersY, 0.f), s_ClustersY - 1);
+		return (GetSlice(viewDepth) * s_ClustersY + y) * s_ClustersX + x;
+	}
+
+	LightClusters::Range LightClusters::FindRange(const Light& light, const Core::Matrix44f& view) const
+	{
+		Range range = {};
+
+		// the smallest sphere around the cone, narrow cones are bounded around their middle instead of their tip
+		Core::Vector4f center = light.m_Position;
+		float radius = light.m_Position.w;
+		const float cosine = light.m_Direction.w;
+		if(cosine > 0.f)
+		{
+			const float distance = cosine < 0.7071f ? cosine * radius : radius / (2.f * cosine);
+			radius = cosine < 0.7071f ? sqrtf(1.f - cosine * cosine) * radius : distance;
+			center += light.m_Direction * distance;
+		}
+		center.w = 1.f;
+		center = center * view;
+
+		if(center.z + radius < m_Near || center.z - radius > m_Far)
+			return range;
+
+		if(!m_Columns.FindTiles(center, radius, &range.m_MinX, &range.m_MaxX))
+			return range;
+
+		if(!m_Rows.FindTiles(center, radius, &range.m_MinY, &range.m_MaxY))
+			return range;
+
+		range.m_MinZ = (uint8)GetSlice(center.z - radius);
+		range.m_MaxZ = (uint8)GetSlice(center.z + radius);
+		range.m_Visible = true;
+		return range;
+	}
+
+	void LightClusters::Build(const Core::Matrix44f& view, const Light* lights, uint32 lightCount,
+							  Core::ThreadPool* pool)
+	{
+		PROFILE_FUNCTION();
+		m_Ranges.resize(lightCount);
+		auto findRanges = [&](uint32 job) {
+			const uint32 begin = job * s_LightsPerJob;
+			const uint32 end = std::min(lightCount, begin + s_LightsPerJob);
+			for(uint32 i = begin; i < end; ++i)
+				m_Ranges[i] = FindRange(lights[i], view);
+		};
+
+		const uint32 jobCount = (lightCount + s_LightsPerJob - 1) / s_LightsPerJob;
+		if(pool)
+		{
+			pool->Dispatch(jobCount, findRanges);
+		}
+		else
+		{
+			for(uint32 job = 0; job < jobCount; ++job)
+				findRanges(job);
+		}
+
+		// count first so every cluster gets its slice of the index list, then fill the slices in light order
+		for(Cluster& cluster : m_Clusters)
+			cluster.m_Count = 0;
+
+		m_Visible = 0;
+		for(const Range& range : m_Ranges)
+		{
+			if(!range.m_Visible)
+				continue;
+
+			m_Visible++;
+			for(uint32 z = range.m_MinZ; z <= range.m_MaxZ; ++z)
+			{
+				for(uint32 y = range.m_MinY; y <= range.m_MaxY; ++y)
+				{
+					Cluster* row = &m_Clusters[(z * s_ClustersY + y) * s_ClustersX];
+					for(uint32 x = range.m_MinX; x <= range.m_MaxX; ++x)
+						row[x].m_Count++;
+				}
+			}
+		}
+
+		// clusters past the end of the index list are cut short, the counts are rebuilt while filling
+		uint32 offset = 0;
+		m_Dropped = 0;
+		for(Cluster& cluster : m_Clusters)
+		{
+			const uint32 count = std::min(cluster.m_Count, m_MaxIndices - offset);
+			m_Dropped += cluster.m_Count - count;
+			cluster.m_Offset = offset;
+			cluster.m_Count = 0;
+			offset += count;
+		}
+		m_Indices.resize(offset);
+
+		for(uint32 i = 0; i < lightCount; ++i)
+		{
+			const Range& range = m_Ranges[i];
+			if(!range.m_Visible)
+				continue;
+
+			for(uint32 z = range.m_MinZ; z <= range.m_MaxZ; ++z)
+			{
+				for(uint32 y = range.m_MinY; y <= range.m_MaxY; ++y)
+				{
+					const uint32 first = (z * s_ClustersY + y) * s_ClustersX;
+					for(uint32 x = range.m_MinX; x <= range.m_MaxX; ++x)
+					{
+						const uint32 index = first + x;
+						Cluster& cluster = m_Clusters[index];
+						const uint32 end = index + 1 < s_ClusterCount ? m_Clusters[index + 1].m_Offset : offset;
+						if(cluster.m_Offset + cluster.m_Count < end)
+							m_Indices[cluster.m_Offset + cluster.m_Count++] = i;
+					}
+				}
+			}
+		}
+	}
+
+}; // namespace Graphics
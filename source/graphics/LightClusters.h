@@ -0,0 +1,124 @@
+#pragma once
+#include "Core/Types.h"
+#include "Core/math/Matrix44.h"
+
+#include <vector>
+
+namespace Core
+{
+	class ThreadPool;
+};
+
+namespace Graphics
+{
+	/* laid out the way the fragment shader reads it, positions and directions are in world space */
+	struct Light
+	{
+		Core::Vector4f m_Position;	// w is the range
+		Core::Vector4f m_Color;		// rgb, w is unused
+		Core::Vector4f m_Direction; // w is the cosine of the spot cone, s_PointLight for point lights
+	};
+
+	/* any cone cosine below -1 lights every direction */
+	constexpr float s_PointLight = -2.f;
+
+	/*
+		Clustered light assignment on the CPU.
+
+		The view frustum is split into s_ClustersX * s_ClustersY tiles on screen and s_Slices depth slices. The
+		slices are spaced exponentially between the near and the far plane, which keeps the clusters close to cubes.
+
+		Every light is bounded by a sphere, a spot light by the sphere around its cone. The sphere is narrowed down to
+		the tile columns, tile rows and slices it touches and the light is added to every cluster in that box. The
+		tile planes come straight from the projection, the distances to them are computed four planes at a time with
+		SSE. The box is conservative, a light can end up in a corner cluster it does not reach but never misses one.
+
+		The result is what the fragment shader reads: the offset and count of every cluster's lights in one flat index
+		list. A pixel finds its cluster from its screen position and view depth, GetClusterIndex does the same.
+	*/
+	class LightClusters
+	{
+	public:
+		static constexpr uint32 s_ClustersX = 16;
+		static constexpr uint32 s_ClustersY = 9;
+		static constexpr uint32 s_Slices = 24;
+		static constexpr uint32 s_ClusterCount = s_ClustersX * s_ClustersY * s_Slices;
+
+		struct Cluster
+		{
+			uint32 m_Offset = 0;
+			uint32 m_Count = 0;
+		};
+
+		LightClusters() = default;
+		~LightClusters() = default;
+
+		/* projection maps view space to clip space, the view depth runs along +z. Lights past maxIndices are dropped */
+		void Init(const Core::Matrix44f& projection, float nearPlane, float farPlane, uint32 maxIndices);
+
+		/* view transforms the lights from world space into the space of the projection */
+		void Build(const Core::Matrix44f& view, const Light* lights, uint32 lightCount,
+				   Core::ThreadPool* pool = nullptr);
+
+		/* screen position in [0, 1] with y pointing down */
+		uint32 GetClusterIndex(float screenX, float screenY, float viewDepth) const;
+
+		const Cluster* GetClusters() const { return m_Clusters.data(); }
+		const uint32* GetIndices() const { return m_Indices.data(); }
+		uint32 GetIndexCount() const { return (uint32)m_Indices.size(); }
+		uint32 GetDroppedCount() const { return m_Dropped; }
+		uint32 GetVisibleCount() const { return m_Visible; }
+
+		/* slice = log(viewDepth) * scale + bias */
+		float GetSliceScale() const { return m_SliceScale; }
+		float GetSliceBias() const { return m_SliceBias; }
+
+	private:
+		/* the clusters a light touches, inclusive */
+		struct Range
+		{
+			uint8 m_MinX;
+			uint8 m_MaxX;
+			uint8 m_MinY;
+			uint8 m_MaxY;
+			uint8 m_MinZ;
+			uint8 m_MaxZ;
+			bool m_Visible;
+		};
+
+		/* the planes between tiles along one axis, stored as four arrays of plane components for SSE */
+		struct TilePlanes
+		{
+			static constexpr uint32 s_Capacity = 20;
+			alignas(16) float m_X[s_Capacity];
+			alignas(16) float m_Y[s_Capacity];
+			alignas(16) float m_Z[s_Capacity];
+			alignas(16) float m_W[s_Capacity];
+			uint32 m_TileCount = 0;
+
+			void Init(const Core::Vector4f& axis, const Core::Vector4f& w, uint32 tileCount);
+
+			/* tiles the sphere touches, false when it is entirely outside of the screen */
+			bool FindTiles(const Core::Vector4f& center, float radius, uint8* first, uint8* last) const;
+		};
+
+		Range FindRange(const Light& light, const Core::Matrix44f& view) const;
+		uint32 GetSlice(float viewDepth) const;
+
+		TilePlanes m_Columns;
+		TilePlanes m_Rows;
+
+		float m_Near = 0.f;
+		float m_Far = 0.f;
+		float m_SliceScale = 0.f;
+		float m_SliceBias = 0.f;
+		uint32 m_MaxIndices = 0;
+		uint32 m_Dropped = 0;
+		uint32 m_Visible = 0;
+
+		std::vector<Range> m_Ranges;
+		std::vector<Cluster> m_Clusters;
+		std::vector<uint32> m_Indices;
+	};
+
+}; // namespace Graphics
@@ -0,0 +1,117 @@
+#include "MemoryView.h"
+#include "VlkPhysicalDevice.h"
+
+#include "Core/memory/MemoryTracker.h"
+
+#include "imgui/imgui.h"
+
+#include <vector>
+
+namespace Graphics
+{
+	static double ToMiB(uint64 bytes)
+	{
+		return (double)bytes / (1024.0 * 1024.0);
+	}
+
+	void DrawMemoryWindow(float width, float height, const MemoryHeapBudget* heaps, uint32 heapCount)
+	{
+		// the snapshot lives across frames until the next one is taken
+		static Core::MemoryTracker::Snapshot snapshot;
+		static bool hasSnapshot = false;
+		static std::vector<Core::MemoryTracker::Allocation> allocations;
+
+		Core::MemoryTracker& tracker = Core::MemoryTracker::Get();
+
+		ImGui::SetNextWindowSize(ImVec2(width, height), ImGuiCond_FirstUseEver);
+		if(!ImGui::Begin("Memory"))
+		{
+			ImGui::End();
+			return;
+		}
+
+		ImGui::Columns(6, "tags");
+		ImGui::Text("Tag");
+		ImGui::NextColumn();
+		ImGui::Text("Live MiB");
+		ImGui::NextColumn();
+		ImGui::Text("Peak MiB");
+		ImGui::NextColumn();
+		ImGui::Text("Budget MiB");
+		ImGui::NextColumn();
+		ImGui::Text("Count");
+		ImGui::NextColumn();
+		ImGui::Text("Frame allocs / KiB");
+		ImGui::NextColumn();
+		ImGui::Separator();
+
+		for(uint32 tag = 0; tag < Core::EMemoryTag_Count; ++tag)
+		{
+			const Core::MemoryTracker::TagStats stats = tracker.GetStats((Core::EMemoryTag)tag);
+			const bool overBudget = stats.m_Budget > 0 && stats.m_LiveBytes > stats.m_Budget;
+
+			if(overBudget)
+				ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(1.f, 0.3f, 0.3f, 1.f));
+			ImGui::Text("%s", Core::MemoryTracker::GetTagName((Core::EMemoryTag)tag));
+			ImGui::NextColumn();
+			ImGui::Text("%.2f", ToMiB(stats.m_LiveBytes));
+			if(overBudget)
+				ImGui::PopStyleColor();
+			ImGui::NextColumn();
+			ImGui::Text("%.2f", ToMiB(stats.m_PeakBytes));
+			ImGui::NextColumn();
+			if(stats.m_Budget > 0)
+				ImGui::Text("%.2f", ToMiB(stats.m_Budget));
+			else
+				ImGui::Text("-");
+			ImGui::NextColumn();
+			ImGui::Text("%llu", (unsigned long long)stats.m_LiveCount);
+			ImGui::NextColumn();
+			ImGui::Text("%llu / %.1f", (unsigned long long)stats.m_FrameCount, (double)stats.m_FrameBytes / 1024.0);
+			ImGui::NextColumn();
+		}
+		ImGui::Columns(1);
+		ImGui::Separator();
+
+		// the driver counts every allocation of the process, the difference to the GPU tags is untracked memory
+		for(uint32 i = 0; i < heapCount; ++i)
+		{
+			const MemoryHeapBudget& heap = heaps[i];
+			ImGui::Text("Heap %u%s: %.1f / %.1f MiB", i, heap.m_DeviceLocal ? " (device local)" : "",
+						ToMiB(heap.m_Usage), ToMiB(heap.m_Budget));
+		}
+		ImGui::Separator();
+
+		if(ImGui::Button("Take snapshot"))
+		{
+			snapshot = tracker.TakeSnapshot();
+			hasSnapshot = true;
+		}
+
+		if(hasSnapshot)
+		{
+			const Core::MemoryTracker::Snapshot diff = Core::MemoryTracker::Diff(snapshot, tracker.TakeSnapshot());
+			for(uint32 tag = 0; tag < Core::EMemoryTag_Count; ++tag)
+			{
+				if(diff.m_LiveCount[tag] == 0 && diff.m_LiveBytes[tag] == 0)
+					continue;
+				ImGui::Text("%s: %+lld allocations %+.1f KiB", Core::MemoryTracker::GetTagName((Core::EMemoryTag)tag),
+							(long long)diff.m_LiveCount[tag], (double)diff.m_LiveBytes[tag] / 1024.0);
+			}
+
+			if(ImGui::CollapsingHeader("Alive since the snapshot"))
+			{
+				tracker.GetAllocationsSince(snapshot, &allocations);
+				for(const Core::MemoryTracker::Allocation& allocation : allocations)
+				{
+					ImGui::Text("#%llu %s %llu bytes at 0x%llx", (unsigned long long)allocation.m_Sequence,
+								Core::MemoryTracker::GetTagName(allocation.m_Tag),
+								(unsigned long long)allocation.m_Size, (unsigned long long)allocation.m_Id);
+				}
+			}
+		}
+
+		ImGui::End();
+	}
+
+}; // namespace Graphics
@@ -0,0 +1,14 @@
+#pragma once
+#include "Core/Types.h"
+
+namespace Graphics
+{
+	struct MemoryHeapBudget;
+
+	/*
+		Core::MemoryTracker by tag next to the driver's heap budgets, with a snapshot to diff against and the live
+		allocations made since it, call between ImGui::NewFrame and ImGui::Render
+	*/
+	void DrawMemoryWindow(float width, float height, const MemoryHeapBudget* heaps, uint32 heapCount);
+
+}; // namespace Graphics
@@ -0,0 +1,375 @@
+#include "MeshLod.h"
+
+#include "Core/profiler/Profiler.h"
+#include "logger/Debug.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <queue>
+
+namespace Graphics
+{
+	// borders are held in place by planes this much heavier than the surface
+	constexpr double s_BorderWeight = 100.0;
+
+	struct Quadric
+	{
+		double m_A2 = 0, m_AB = 0, m_AC = 0, m_AD = 0;
+		double m_B2 = 0, m_BC = 0, m_BD = 0;
+		double m_C2 = 0, m_CD = 0;
+		double m_D2 = 0;
+
+		void AddPlane(double a, double b, double c, double d, double weight)
+		{
+			m_A2 += weight * a * a;
+			m_AB += weight * a * b;
+			m_AC += weight * a * c;
+			m_AD += weight * a * d;
+			m_B2 += weight * b * b;
+			m_BC += weight * b * c;
+			m_BD += weight * b * d;
+			m_C2 += weight * c * c;
+			m_CD += weight * c * d;
+			m_D2 += weight * d * d;
+		}
+
+		void Add(const Quadric& other)
+		{
+			m_A2 += other.m_A2;
+			m_AB += other.m_AB;
+			m_AC += other.m_AC;
+			m_AD += other.m_AD;
+			m_B2 += other.m_B2;
+			m_BC += other.m_BC;
+			m_BD += other.m_BD;
+			m_C2 += other.m_C2;
+			m_CD += other.m_CD;
+			m_D2 += other.m_D2;
+		}
+
+		/* sum of the weighted squared distances from position to the planes */
+		double Evaluate(const Core::Vector4f& position) const
+		{
+			const double x = position.x;
+			const double y = position.y;
+			const double z = position.z;
+			const double error = m_A2 * x * x + 2 * m_AB * x * y + 2 * m_AC * x * z + 2 * m_AD * x + m_B2 * y * y +
+								 2 * m_BC * y * z + 2 * m_BD * y + m_C2 * z * z + 2 * m_CD * z + m_D2;
+			return std::max(error, 0.0);
+		}
+	};
+
+	struct Collapse
+	{
+		double m_Cost;
+		uint32 m_From;
+		uint32 m_To;
+		uint32 m_FromVersion;
+		uint32 m_ToVersion;
+
+		bool operator>(const Collapse& other) const { return m_Cost > other.m_Cost; }
+	};
+
+	static Core::Vector4f Cross3(const Core::Vector4f& a, const Core::Vector4f& b)
+	{
+		return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x, 0.f };
+	}
+
+	static float Dot3(const Core::Vector4f& a, const Core::Vector4f& b)
+	{
+		return a.x * b.x + a.y * b.y + a.z * b.z;
+	}
+
+	static Core::Vector4f TriangleNormal(const Core::Vector4f& a, const Core::Vector4f& b, const Core::Vector4f& c)
+	{
+		return Cross3(b - a, c - a);
+	}
+
+	float SimplifyMesh(const Core::Vector4f* positions, uint32 vertexCount, const uint32* indices, uint32 indexCount,
+					   uint32 targetIndexCount, std::vector<uint32>* result)
+	{
+		PROFILE_FUNCTION();
+		ASSERT((indexCount % 3) == 0, "Simplification needs a triangle list!");
+
+		std::vector<uint32> triangles(indices, indices + indexCount);
+		std::vector<uint8> triangleAlive(indexCount / 3, 1);
+		std::vector<std::vector<uint32>> vertexTriangles(vertexCount);
+		std::vector<Quadric> quadrics(vertexCount);
+
+		for(uint32 t = 0; t < indexCount / 3; ++t)
+		{
+			const uint32* corners = &triangles[t * 3];
+			const Core::Vector4f normal =
+				TriangleNormal(positions[corners[0]], positions[corners[1]], positions[corners[2]]);
+			const float length = sqrtf(Dot3(normal, normal));
+			for(uint32 corner = 0; corner < 3; ++corner)
+				vertexTriangles[corners[corner]].push_back(t);
+
+			if(length <= 0.f)
+				continue;
+
+			const Core::Vector4f unit = normal / length;
+			const double d = -Dot3(unit, positions[corners[0]]);
+			for(uint32 corner = 0; corner < 3; ++corner)
+				quadrics[corners[corner]].AddPlane(unit.x, unit.y, unit.z, d, 1.0);
+		}
+
+		// an edge that only one triangle uses is on the border, it gets a plane standing on it
+		std::vector<std::pair<uint64, uint32>> edges;
+		edges.reserve(indexCount);
+		for(uint32 i = 0; i < indexCount; ++i)
+		{
+			const uint32 a = triangles[i];
+			const uint32 b = triangles[i - i % 3 + (i + 1) % 3];
+			edges.push_back({ ((uint64)std::min(a, b) << 32) | std::max(a, b), i });
+		}
+		std::sort(edges.begin(), edges.end());
+		for(size_t i = 0; i < edges.size(); ++i)
+		{
+			const bool shared = (i > 0 && edges[i - 1].first == edges[i].first) ||
+								(i + 1 < edges.size() && edges[i + 1].first == edges[i].first);
+			if(shared)
+				continue;
+
+			const uint32 corner = edges[i].second;
+			const uint32* corners = &triangles[corner - corner % 3];
+			const uint32 a = triangles[corner];
+			const uint32 b = triangles[corner - corner % 3 + (corner + 1) % 3];
+			const Core::Vector4f edge = positions[b] - positions[a];
+			const Core::Vector4f normal = Cross3(edge, TriangleNormal(positions[corners[0]], positions[corners[1]],
+																		  positions[corners[2]]));
+			const float length = sqrtf(Dot3(normal, normal));
+			if(length <= 0.f)
+				continue;
+
+			const Core::Vector4f unit = normal / length;
+			const double d = -Dot3(unit, positions[a]);
+			quadrics[a].AddPlane(unit.x, unit.y, unit.z, d, s_BorderWeight);
+			quadrics[b].AddPlane(unit.x, unit.y, unit.z, d, s_BorderWeight);
+		}
+
+		std::vector<uint32> versions(vertexCount, 0);
+		std::vector<uint32> remap(vertexCount);
+		for(uint32 i = 0; i < vertexCount; ++i)
+			remap[i] = i;
+
+		std::priority_queue<Collapse, std::vector<Collapse>, std::greater<Collapse>> queue;
+		auto pushCollapse = [&](uint32 from, uint32 to) {
+			Quadric quadric = quadrics[from];
+			quadric.Add(quadrics[to]);
+			queue.push({ quadric.Evaluate(positions[to]), from, to, versions[from], versions[to] });
+		};
+
+		for(uint32 i = 0; i < indexCount; ++i)
+		{
+			const uint32 a = triangles[i];
+			const uint32 b = triangles[i - i % 3 + (i + 1) % 3];
+			pushCollapse(a, b);
+			pushCollapse(b, a);
+		}
+
+		uint32 liveIndices = indexCount;
+		double worstCost = 0.0;
+		while(liveIndices > targetIndexCount && !queue.empty())
+		{
+			const Collapse collapse = queue.top();
+			queue.pop();
+
+			const uint32 from = collapse.m_From;
+			const uint32 to = collapse.m_To;
+			if(remap[from] != from || remap[to] != to)
+				continue;
+
+			if(versions[from] != collapse.m_FromVersion || versions[to] != collapse.m_ToVersion)
+				continue;
+
+			// the triangles that stay must keep facing the same way
+			bool flips = false;
+			for(uint32 t : vertexTriangles[from])
+			{
+				if(!triangleAlive[t])
+					continue;
+
+				uint32* corners = &triangles[t * 3];
+				if(corners[0] == to || corners[1] == to || corners[2] == to)
+					continue;
+
+				Core::Vector4f moved[3];
+				for(uint32 corner = 0; corner < 3; ++corner)
+					moved[corner] = positions[corners[corner] == from ? to : corners[corner]];
+
+				const Core::Vector4f before =
+					TriangleNormal(positions[corners[0]], positions[corners[1]], positions[corners[2]]);
+				if(Dot3(before, TriangleNormal(moved[0], moved[1], moved[2])) <= 0.f)
+				{
+					flips = true;
+					break;
+				}
+			}
+			if(flips)
+				continue;
+
+			remap[from] = to;
+			versions[from]++;
+			versions[to]++;
+			quadrics[to].Add(quadrics[from]);
+			worstCost = std::max(worstCost, collapse.m_Cost);
+
+			for(uint32 t : vertexTriangles[from])
+			{
+				if(!triangleAlive[t])
+					continue;
+
+				uint32* corners = &triangles[t * 3];
+				if(corners[0] == to || corners[1] == to || corners[2] == to)
+				{
+					triangleAlive[t] = 0;
+					liveIndices -= 3;
+					continue;
+				}
+
+				for(uint32 corner = 0; corner < 3; ++corner)
+				{
+					if(corners[corner] == from)
+						corners[corner] = to;
+				}
+				vertexTriangles[to].push_back(t);
+			}
+			vertexTriangles[from].clear();
+
+			// every edge around the kept vertex has a new cost
+			for(uint32 t : vertexTriangles[to])
+			{
+				if(!triangleAlive[t])
+					continue;
+
+				for(uint32 corner = 0; corner < 3; ++corner)
+				{
+					const uint32 neighbour = triangles[t * 3 + corner];
+					if(neighbour == to)
+						continue;
+
+					pushCollapse(neighbour, to);
+					pushCollapse(to, neighbour);
+				}
+			}
+		}
+
+		result->clear();
+		for(uint32 t = 0; t < indexCount / 3; ++t)
+		{
+			if(triangleAlive[t])
+				result->insert(result->end(), &triangles[t * 3], &triangles[t * 3] + 3);
+		}
+
+		// the cost sums squared distances to planes, its root is at least the distance to any one of them
+		return (float)sqrt(worstCost);
+	}
+
+	void BuildLods(const void* vertices, uint32 stride, uint32 vertexCount, uint32 maxLods,
+				   std::vector<uint8>* lodVertices, std::vector<MeshLod>* lods)
+	{
+		PROFILE_FUNCTION();
+		const uint8* source = (const uint8*)vertices;
+		auto position = [=](uint32 vertex) { return *(const Core::Vector4f*)(source + vertex * stride); };
+
+		// weld equal positions, the first vertex at a position is the one every LOD uses there
+		std::vector<uint32> order(vertexCount);
+		for(uint32 i = 0; i < vertexCount; ++i)
+			order[i] = i;
+
+		auto less = [&](uint32 a, uint32 b) {
+			const Core::Vector4f pa = position(a);
+			const Core::Vector4f pb = position(b);
+			if(pa.x != pb.x)
+				return pa.x < pb.x;
+			if(pa.y != pb.y)
+				return pa.y < pb.y;
+			if(pa.z != pb.z)
+				return pa.z < pb.z;
+			return a < b;
+		};
+		std::sort(order.begin(), order.end(), less);
+
+		std::vector<Core::Vector4f> positions;
+		std::vector<uint32> representatives;
+		std::vector<uint32> indices(vertexCount);
+		for(uint32 i = 0; i < vertexCount; ++i)
+		{
+			const uint32 vertex = order[i];
+			const Core::Vector4f p = position(vertex);
+			const bool same = !positions.empty() && positions.back().x == p.x && positions.back().y == p.y &&
+							  positions.back().z == p.z;
+			if(!same)
+			{
+				positions.push_back(p);
+				representatives.push_back(vertex);
+			}
+			indices[vertex] = (uint32)positions.size() - 1;
+		}
+
+		lodVertices->assign(source, source + vertexCount * stride);
+		lods->clear();
+
+		MeshLod full;
+		full.m_VertexCount = vertexCount;
+		lods->push_back(full);
+
+		std::vector<uint32> simplified;
+		uint32 previousCount = vertexCount;
+		while(lods->size() < maxLods)
+		{
+			const uint32 target = (previousCount / 6) * 3;
+			if(target < 3)
+				break;
+
+			const float error = SimplifyMesh(positions.data(), (uint32)positions.size(), indices.data(), vertexCount,
+											 target, &simplified);
+
+			// not worth a LOD when the mesh barely shrinks
+			if(simplified.empty() || simplified.size() * 10 > (size_t)previousCount * 9)
+				break;
+
+			MeshLod lod;
+			lod.m_FirstVertex = (uint32)(lodVertices->size() / stride);
+			lod.m_VertexCount = (uint32)simplified.size();
+			lod.m_Error = std::max(error, lods->back().m_Error);
+			for(uint32 index : simplified)
+			{
+				const uint8* vertex = source + representatives[index] * stride;
+				lodVertices->insert(lodVertices->end(), vertex, vertex + stride);
+			}
+
+			lods->push_back(lod);
+			previousCount = lod.m_VertexCount;
+		}
+	}
+
+	uint32 SelectLod(const MeshLod* lods, uint32 lodCount, uint32 current, float pixelsPerUnit, float maxPixelError,
+					 float hysteresis)
+	{
+		current = std::min(current, lodCount - 1);
+
+		auto coarsest = [=](float limit) {
+			uint32 lod = 0;
+			for(uint32 i = 1; i < lodCount; ++i)
+			{
+				if(lods[i].m_Error * pixelsPerUnit <= limit)
+					lod = i;
+			}
+			return lod;
+		};
+
+		const uint32 coarser = coarsest(maxPixelError * (1.f - hysteresis));
+		if(coarser > current)
+			return coarser;
+
+		if(lods[current].m_Error * pixelsPerUnit > maxPixelError * (1.f + hysteresis))
+			return coarsest(maxPixelError);
+
+		return current;
+	}
+
+}; // namespace Graphics
@@ -0,0 +1,53 @@
+#pragma once
+#include "Core/Types.h"
+#include "Core/math/Vector4.h"
+
+#include <vector>
+
+namespace Graphics
+{
+	/* a range of unindexed vertices in the mesh's vertex buffer */
+	struct MeshLod
+	{
+		uint32 m_FirstVertex = 0;
+		uint32 m_VertexCount = 0;
+		float m_Error = 0.f; // how far the surface moved from the full mesh, in model space units
+	};
+
+	constexpr uint32 s_MaxLods = 5;
+
+	/*
+		Quadric error mesh simplification, after Garland and Heckbert.
+
+		Every vertex carries the sum of the squared distance quadrics of the planes of its triangles. Edges are
+		collapsed cheapest first into one of their two vertices, so no new positions are made up and the kept vertex
+		keeps its attributes. Open borders get an extra plane standing on the border edge, weighted heavily, so they
+		do not erode. Collapses that would flip a triangle are skipped.
+
+		Simplifies until the index count is at or below targetIndexCount or nothing more can be collapsed. The result
+		indexes the same positions, the return value is the largest error of any collapse as a distance.
+	*/
+	float SimplifyMesh(const Core::Vector4f* positions, uint32 vertexCount, const uint32* indices, uint32 indexCount,
+					   uint32 targetIndexCount, std::vector<uint32>* result);
+
+	/*
+		Builds the LOD chain of an unindexed triangle list at import time. Vertices are stride bytes apart and start
+		with their position, positions that are equal are welded before simplifying. LOD 0 is the source as it is,
+		every following LOD aims for half the triangles of the one before, simplified from the source so the errors
+		do not add up. The chain stops early once the mesh no longer shrinks.
+
+		The vertices of every LOD are written back to back, unindexed like the source.
+	*/
+	void BuildLods(const void* vertices, uint32 stride, uint32 vertexCount, uint32 maxLods,
+				   std::vector<uint8>* lodVertices, std::vector<MeshLod>* lods);
+
+	/*
+		Coarsest LOD whose error covers no more than maxPixelError pixels, pixelsPerUnit is how many pixels one model
+		space unit covers at the object's distance. Moving to a coarser LOD needs the error to be hysteresis (a
+		fraction of maxPixelError) below the limit and moving back needs it to be that far above, so objects sitting
+		at a threshold do not flicker between two LODs.
+	*/
+	uint32 SelectLod(const MeshLod* lods, uint32 lodCount, uint32 current, float pixelsPerUnit, float maxPixelError,
+					 float hysteresis);
+
+}; // namespace Graphics
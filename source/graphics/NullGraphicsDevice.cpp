@@ -0,0 +1,155 @@
+#include "NullGraphicsDevice.h"
+
+#include "logger/Debug.h"
+
+#include <cstdint>
+#include <cstring>
+
+namespace Graphics
+{
+	void NullGraphicsDevice::BindConstantBuffer(ConstantBuffer*, uint32 offset)
+	{
+		CmdBindResource* cmd = Record<CmdBindResource>(ECommandType_BindConstantBuffer);
+		cmd->m_Handle = 0;
+		cmd->m_Offset = offset;
+	}
+
+	void NullGraphicsDevice::CreateConstantBuffer(ConstantBuffer*) {}
+
+	void NullGraphicsDevice::DestroyConstantBuffer(ConstantBuffer*) {}
+
+	HBuffer NullGraphicsDevice::CreateBuffer(const BufferDesc& desc)
+	{
+		BufferDesc stored = desc;
+		stored.m_InitialData = nullptr;
+		return m_Buffers.Create(stored);
+	}
+
+	void NullGraphicsDevice::UpdateBuffer(HBuffer buffer, const void*, uint32 size, uint32 offset)
+	{
+		ASSERT(m_Buffers.IsValid(buffer), "Invalid buffer handle!");
+		ASSERT(offset + size <= m_Buffers.Get(buffer)->m_Size, "Update is out of the buffer's range!");
+
+		CmdUpdateBuffer* cmd = Record<CmdUpdateBuffer>(ECommandType_UpdateBuffer);
+		cmd->m_Buffer = buffer;
+		cmd->m_Offset = offset;
+		cmd->m_Size = size;
+	}
+
+	void NullGraphicsDevice::DestroyBuffer(HBuffer buffer)
+	{
+		m_Buffers.Destroy(buffer);
+	}
+
+	HPipeline NullGraphicsDevice::CreatePipeline(const PipelineDesc&)
+	{
+		return m_Pipelines.Create((uint8)0);
+	}
+
+	void NullGraphicsDevice::DestroyPipeline(HPipeline pipeline)
+	{
+		m_Pipelines.Destroy(pipeline);
+	}
+
+	void NullGraphicsDevice::BindPipeline(HPipeline pipeline)
+	{
+		ASSERT(m_Pipelines.IsValid(pipeline), "Invalid pipeline handle!");
+		CmdBindResource* cmd = Record<CmdBindResource>(ECommandType_BindPipeline);
+		cmd->m_Handle = pipeline;
+		cmd->m_Offset = 0;
+	}
+
+	void NullGraphicsDevice::BindVertexBuffer(HBuffer buffer, uint32 offset)
+	{
+		ASSERT(m_Buffers.IsValid(buffer), "Invalid buffer handle!");
+		CmdBindResource* cmd = Record<CmdBindResource>(ECommandType_BindVertexBuffer);
+		cmd->m_Handle = buffer;
+		cmd->m_Offset = offset;
+	}
+
+	void NullGraphicsDevice::BindIndexBuffer(HBuffer buffer, uint32 offset)
+	{
+		ASSERT(m_Buffers.IsValid(buffer), "Invalid buffer handle!");
+		CmdBindResource* cmd = Record<CmdBindResource>(ECommandType_BindIndexBuffer);
+		cmd->m_Handle = buffer;
+		cmd->m_Offset = offset;
+	}
+
+	void NullGraphicsDevice::PushConstants(const void* data, uint32 size, uint32 offset)
+	{
+		// the data is padded so the next header stays 4 byte aligned
+		const uint32 paddedSize = (size + 3) & ~3u;
+		CmdPushConstants* cmd = Record<CmdPushConstants>(ECommandType_PushConstants, paddedSize);
+		cmd->m_Offset = offset;
+		cmd->m_Size = size;
+		memcpy(cmd + 1, data, size);
+	}
+
+	void NullGraphicsDevice::Draw(uint32 vertexCount, uint32 instanceCount, uint32 firstVertex, uint32 firstInstance)
+	{
+		CmdDraw* cmd = Record<CmdDraw>(ECommandType_Draw);
+		cmd->m_Count = vertexCount;
+		cmd->m_InstanceCount = instanceCount;
+		cmd->m_First = firstVertex;
+		cmd->m_VertexOffset = 0;
+		cmd->m_FirstInstance = firstInstance;
+	}
+
+	void NullGraphicsDevice::DrawIndexed(uint32 indexCount, uint32 instanceCount, uint32 firstIndex, int32 vertexOffset,
+										 uint32 firstInstance)
+	{
+		CmdDraw* cmd = Record<CmdDraw>(ECommandType_DrawIndexed);
+		cmd->m_Count = indexCount;
+		cmd->m_InstanceCount = instanceCount;
+		cmd->m_First = firstIndex;
+		cmd->m_VertexOffset = vertexOffset;
+		cmd->m_FirstInstance = firstInstance;
+	}
+
+	void NullGraphicsDevice::Barrier(HBuffer buffer, EResourceState before, EResourceState after)
+	{
+		ASSERT(m_Buffers.IsValid(buffer), "Invalid buffer handle!");
+		CmdBarrier* cmd = Record<CmdBarrier>(ECommandType_Barrier);
+		cmd->m_Buffer = buffer;
+		cmd->m_Before = before;
+		cmd->m_After = after;
+	}
+
+	void NullGraphicsDevice::Reset()
+	{
+		m_Stream.clear();
+		memset(m_CommandCounts, 0, sizeof(m_CommandCounts));
+	}
+
+	bool NullGraphicsDevice::NextCommand(uint32* cursor, Command* command) const
+	{
+		if(*cursor + sizeof(CommandHeader) > m_Stream.size())
+			return false;
+
+		const CommandHeader* header = reinterpret_cast<const CommandHeader*>(&m_Stream[*cursor]);
+		command->m_Type = header->m_Type;
+		command->m_Size = header->m_Size;
+		command->m_Data = header + 1;
+
+		*cursor += sizeof(CommandHeader) + header->m_Size;
+		return true;
+	}
+
+	void* NullGraphicsDevice::RecordRaw(ECommandType type, uint32 size)
+	{
+		ASSERT(size <= UINT16_MAX, "Command is too large for the stream!");
+		ASSERT((size & 3) == 0, "Command arguments must keep the stream 4 byte aligned!");
+
+		const size_t offset = m_Stream.size();
+		m_Stream.resize(offset + sizeof(CommandHeader) + size);
+
+		CommandHeader* header = reinterpret_cast<CommandHeader*>(&m_Stream[offset]);
+		header->m_Type = type;
+		header->m_Padding = 0;
+		header->m_Size = (uint16)size;
+
+		m_CommandCounts[type]++;
+		return header + 1;
+	}
+
+}; // namespace Graphics
@@ -0,0 +1,142 @@
+#pragma once
+#include "GraphicsDevice.h"
+
+#include "Core/memory/Pool.h"
+
+#include <vector>
+
+/*
+	Graphics device without a GPU.
+
+	Resources are only book kept and every command is appended to a compact byte stream, a header followed by the
+	arguments of the command. Everything that drives the device (culling, sorting, batching, recording) can be run,
+	measured and checked in unit tests on a machine without a graphics driver.
+*/
+
+namespace Graphics
+{
+	enum ECommandType : uint8
+	{
+		ECommandType_BindConstantBuffer,
+		ECommandType_UpdateBuffer,
+		ECommandType_BindPipeline,
+		ECommandType_BindVertexBuffer,
+		ECommandType_BindIndexBuffer,
+		ECommandType_PushConstants,
+		ECommandType_Draw,
+		ECommandType_DrawIndexed,
+		ECommandType_Barrier,
+		ECommandType_Count
+	};
+
+	struct CommandHeader
+	{
+		ECommandType m_Type;
+		uint8 m_Padding;
+		uint16 m_Size; // size of the arguments following the header
+	};
+
+	struct CmdBindResource
+	{
+		uint32 m_Handle;
+		uint32 m_Offset;
+	};
+
+	struct CmdUpdateBuffer
+	{
+		HBuffer m_Buffer;
+		uint32 m_Offset;
+		uint32 m_Size;
+	};
+
+	struct CmdPushConstants
+	{
+		uint32 m_Offset;
+		uint32 m_Size; // followed by the data
+	};
+
+	struct CmdDraw
+	{
+		uint32 m_Count; // vertices or indices
+		uint32 m_InstanceCount;
+		uint32 m_First;
+		int32 m_VertexOffset;
+		uint32 m_FirstInstance;
+	};
+
+	struct CmdBarrier
+	{
+		HBuffer m_Buffer;
+		EResourceState m_Before;
+		EResourceState m_After;
+	};
+
+	class NullGraphicsDevice final : public IGraphicsDevice
+	{
+	public:
+		struct Command
+		{
+			ECommandType m_Type;
+			const void* m_Data;
+			uint32 m_Size;
+
+			template <typename T>
+			const T& As() const
+			{
+				return *static_cast<const T*>(m_Data);
+			}
+		};
+
+		NullGraphicsDevice() = default;
+		~NullGraphicsDevice() = default;
+
+		void BindConstantBuffer(ConstantBuffer* constantBuffer, uint32 offset) override;
+		void CreateConstantBuffer(ConstantBuffer* constantBuffer) override;
+		void DestroyConstantBuffer(ConstantBuffer* constantBuffer) override;
+
+		HBuffer CreateBuffer(const BufferDesc& desc) override;
+		void UpdateBuffer(HBuffer buffer, const void* data, uint32 size, uint32 offset) override;
+		void DestroyBuffer(HBuffer buffer) override;
+
+		HPipeline CreatePipeline(const PipelineDesc& desc) override;
+		void DestroyPipeline(HPipeline pipeline) override;
+
+		void BindPipeline(HPipeline pipeline) override;
+		void BindVertexBuffer(HBuffer buffer, uint32 offset) override;
+		void BindIndexBuffer(HBuffer buffer, uint32 offset) override;
+		void PushConstants(const void* data, uint32 size, uint32 offset) override;
+
+		void Draw(uint32 vertexCount, uint32 instanceCount, uint32 firstVertex, uint32 firstInstance) override;
+		void DrawIndexed(uint32 indexCount, uint32 instanceCount, uint32 firstIndex, int32 vertexOffset,
+						 uint32 firstInstance) override;
+
+		void Barrier(HBuffer buffer, EResourceState before, EResourceState after) override;
+
+		/* Drops the recorded commands, resources are kept */
+		void Reset();
+
+		/* Walks the stream, start with cursor at 0. Returns false when there are no more commands */
+		bool NextCommand(uint32* cursor, Command* command) const;
+
+		const std::vector<uint8>& GetStream() const { return m_Stream; }
+		uint32 GetCommandCount(ECommandType type) const { return m_CommandCounts[type]; }
+		uint32 GetBufferCount() const { return m_Buffers.GetCount(); }
+		uint32 GetPipelineCount() const { return m_Pipelines.GetCount(); }
+
+	private:
+		void* RecordRaw(ECommandType type, uint32 size);
+
+		template <typename T>
+		T* Record(ECommandType type, uint32 extraSize = 0)
+		{
+			return static_cast<T*>(RecordRaw(type, sizeof(T) + extraSize));
+		}
+
+		std::vector<uint8> m_Stream;
+		uint32 m_CommandCounts[ECommandType_Count] = {};
+
+		Core::Pool<BufferDesc, HBuffer> m_Buffers;
+		Core::Pool<uint8, HPipeline> m_Pipelines; // pipelines carry no state here, only whether the slot is in use
+	};
+
+}; // namespace Graphics
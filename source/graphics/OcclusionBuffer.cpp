@@ -0,0 +1,329 @@
+#include "OcclusionBuffer.h"
+
+#include "Core/threading/ThreadPool.h"
+#include "Core/profiler/Profiler.h"
+#include "logger/Debug.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <emmintrin.h>
+
+namespace Graphics
+{
+	constexpr float s_MinW = 1e-5f;
+	constexpr float s_MinArea = 1e-6f;
+
+	// occluders rasterized from an occludee's own triangles must not hide it because of rounding
+	constexpr float s_DepthBias = 1e-6f;
+
+	constexpr uint32 s_OccludeesPerJob = 64;
+
+	void OcclusionBuffer::Init(uint32 width, uint32 height)
+	{
+		ASSERT((width % s_TileSize) == 0, "Occlusion buffer width must be a multiple of the tile size!");
+		ASSERT((height % s_TileSize) == 0, "Occlusion buffer height must be a multiple of the tile size!");
+
+		m_Width = width;
+		m_Height = height;
+		m_TilesX = width / s_TileSize;
+		m_TilesY = height / s_TileSize;
+		m_Depth.assign(width * height, 1.f);
+		m_TileDepth.assign(m_TilesX * m_TilesY, 1.f);
+		m_Triangles.clear();
+	}
+
+	void OcclusionBuffer::Clear(const Core::Matrix44f& viewProjection)
+	{
+		m_ViewProjection = viewProjection;
+		m_Triangles.clear();
+		std::fill(m_Depth.begin(), m_Depth.end(), 1.f);
+		std::fill(m_TileDepth.begin(), m_TileDepth.end(), 1.f);
+	}
+
+	bool OcclusionBuffer::ToScreen(const Core::Vector4f& clip, Core::Vector4f* screen) const
+	{
+		if(clip.w < s_MinW)
+			return false;
+
+		// vulkan conventions, y points down in normalized device coordinates
+		const float invW = 1.f / clip.w;
+		screen->x = (clip.x * invW * 0.5f + 0.5f) * (float)m_Width;
+		screen->y = (clip.y * invW * 0.5f + 0.5f) * (float)m_Height;
+		screen->z = clip.z * invW;
+		screen->w = 1.f;
+		return screen->z >= 0.f;
+	}
+
+	void OcclusionBuffer::AddOccluder(const Core::Matrix44f& world, const Core::Vector4f* positions,
+									  uint32 positionCount, const uint32* indices, uint32 indexCount)
+	{
+		// row vectors, the world transform is applied first
+		const Core::Matrix44f modelToClip = m_ViewProjection * world;
+
+		m_Transformed.resize(positionCount);
+		for(uint32 i = 0; i < positionCount; ++i)
+		{
+			const Core::Vector4f position{ positions[i].x, positions[i].y, positions[i].z, 1.f };
+			m_Transformed[i] = position * modelToClip;
+		}
+
+		const uint32 count = indices ? indexCount : positionCount;
+		for(uint32 i = 0; i + 2 < count; i += 3)
+		{
+			const uint32 i0 = indices ? indices[i] : i;
+			const uint32 i1 = indices ? indices[i + 1] : i + 1;
+			const uint32 i2 = indices ? indices[i + 2] : i + 2;
+
+			// triangles crossing the near plane are dropped, an occluder missing only ever means less culling
+			Core::Vector4f v0, v1, v2;
+			if(!ToScreen(m_Transformed[i0], &v0) || !ToScreen(m_Transformed[i1], &v1) ||
+			   !ToScreen(m_Transformed[i2], &v2))
+				continue;
+
+			SetupTriangle(v0, v1, v2);
+		}
+	}
+
+	void OcclusionBuffer::SetupTriangle(const Core::Vector4f& v0, const Core::Vector4f& in1, const Core::Vector4f& in2)
+	{
+		float area = (in1.x - v0.x) * (in2.y - v0.y) - (in1.y - v0.y) * (in2.x - v0.x);
+		if(fabsf(area) < s_MinArea)
+			return;
+
+		// both windings are rasterized, the nearer faces win in the depth test anyway
+		const bool flip = area < 0.f;
+		const Core::Vector4f& v1 = flip ? in2 : in1;
+		const Core::Vector4f& v2 = flip ? in1 : in2;
+		area = fabsf(area);
+
+		Triangle triangle;
+		triangle.m_MinX = std::max(0, (int32)floorf(std::min(v0.x, std::min(v1.x, v2.x))));
+		triangle.m_MinY = std::max(0, (int32)floorf(std::min(v0.y, std::min(v1.y, v2.y))));
+		triangle.m_MaxX = std::min((int32)m_Width - 1, (int32)ceilf(std::max(v0.x, std::max(v1.x, v2.x))));
+		triangle.m_MaxY = std::min((int32)m_Height - 1, (int32)ceilf(std::max(v0.y, std::max(v1.y, v2.y))));
+		if(triangle.m_MinX > triangle.m_MaxX || triangle.m_MinY > triangle.m_MaxY)
+			return;
+
+		if(std::min(v0.z, std::min(v1.z, v2.z)) > 1.f)
+			return;
+
+		const Core::Vector4f* vertices[] = { &v0, &v1, &v2 };
+		for(uint32 edge = 0; edge < 3; ++edge)
+		{
+			const Core::Vector4f& a = *vertices[edge];
+			const Core::Vector4f& b = *vertices[(edge + 1) % 3];
+			triangle.m_A[edge] = a.y - b.y;
+			triangle.m_B[edge] = b.x - a.x;
+			triangle.m_C[edge] = -triangle.m_A[edge] * a.x - triangle.m_B[edge] * a.y;
+		}
+
+		const float dz1 = v1.z - v0.z;
+		const float dz2 = v2.z - v0.z;
+		triangle.m_DzDx = (dz1 * (v2.y - v0.y) - dz2 * (v1.y - v0.y)) / area;
+		triangle.m_DzDy = (dz2 * (v1.x - v0.x) - dz1 * (v2.x - v0.x)) / area;
+		triangle.m_Z0 = v0.z - triangle.m_DzDx * v0.x - triangle.m_DzDy * v0.y;
+
+		m_Triangles.push_back(triangle);
+	}
+
+	void OcclusionBuffer::Rasterize(Core::ThreadPool* pool)
+	{
+		PROFILE_FUNCTION();
+		if(!pool)
+		{
+			RasterizeBand(0, m_TilesY - 1);
+			return;
+		}
+
+		const uint32 bandCount = std::min(m_TilesY, pool->GetThreadCount() * 2);
+		pool->Dispatch(bandCount, [this, bandCount](uint32 band) {
+			const uint32 first = band * m_TilesY / bandCount;
+			const uint32 last = (band + 1) * m_TilesY / bandCount - 1;
+			RasterizeBand(first, last);
+		});
+	}
+
+	void OcclusionBuffer::RasterizeBand(uint32 firstTileRow, uint32 lastTileRow)
+	{
+		const int32 bandMinY = (int32)(firstTileRow * s_TileSize);
+		const int32 bandMaxY = (int32)((lastTileRow + 1) * s_TileSize) - 1;
+
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 laneOffsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+
+		for(const Triangle& triangle : m_Triangles)
+		{
+			const int32 minY = std::max(triangle.m_MinY, bandMinY);
+			const int32 maxY = std::min(triangle.m_MaxY, bandMaxY);
+			if(minY > maxY)
+				continue;
+
+			// the width is a multiple of the tile size, so four pixel blocks starting aligned never leave the row
+			const int32 startX = triangle.m_MinX & ~3;
+			const __m128 px = _mm_add_ps(_mm_set1_ps((float)startX), laneOffsets);
+
+			const __m128 a0 = _mm_set1_ps(triangle.m_A[0]);
+			const __m128 a1 = _mm_set1_ps(triangle.m_A[1]);
+			const __m128 a2 = _mm_set1_ps(triangle.m_A[2]);
+			const __m128 step0 = _mm_set1_ps(triangle.m_A[0] * 4.f);
+			const __m128 step1 = _mm_set1_ps(triangle.m_A[1] * 4.f);
+			const __m128 step2 = _mm_set1_ps(triangle.m_A[2] * 4.f);
+			const __m128 stepZ = _mm_set1_ps(triangle.m_DzDx * 4.f);
+			const __m128 rowZ = _mm_add_ps(_mm_set1_ps(triangle.m_Z0), _mm_mul_ps(px, _mm_set1_ps(triangle.m_DzDx)));
+
+			for(int32 y = minY; y <= maxY; ++y)
+			{
+				const float py = (float)y + 0.5f;
+				__m128 e0 = _mm_add_ps(_mm_mul_ps(a0, px), _mm_set1_ps(triangle.m_B[0] * py + triangle.m_C[0]));
+				__m128 e1 = _mm_add_ps(_mm_mul_ps(a1, px), _mm_set1_ps(triangle.m_B[1] * py + triangle.m_C[1]));
+				__m128 e2 = _mm_add_ps(_mm_mul_ps(a2, px), _mm_set1_ps(triangle.m_B[2] * py + triangle.m_C[2]));
+				__m128 z = _mm_add_ps(rowZ, _mm_set1_ps(triangle.m_DzDy * py));
+
+				float* row = &m_Depth[y * m_Width];
+				for(int32 x = startX; x <= triangle.m_MaxX; x += 4)
+				{
+					const __m128 mask = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(e0, zero), _mm_cmpge_ps(e1, zero)),
+												   _mm_cmpge_ps(e2, zero));
+					if(_mm_movemask_ps(mask))
+					{
+						const __m128 depth = _mm_loadu_ps(row + x);
+						const __m128 nearer = _mm_min_ps(depth, z);
+						_mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(mask, nearer), _mm_andnot_ps(mask, depth)));
+					}
+
+					e0 = _mm_add_ps(e0, step0);
+					e1 = _mm_add_ps(e1, step1);
+					e2 = _mm_add_ps(e2, step2);
+					z = _mm_add_ps(z, stepZ);
+				}
+			}
+		}
+
+		// coarse level, the farthest depth of each tile in the band
+		for(uint32 tileY = firstTileRow; tileY <= lastTileRow; ++tileY)
+		{
+			for(uint32 tileX = 0; tileX < m_TilesX; ++tileX)
+			{
+				__m128 farthest = zero;
+				for(uint32 y = 0; y < s_TileSize; ++y)
+				{
+					const float* row = &m_Depth[(tileY * s_TileSize + y) * m_Width + tileX * s_TileSize];
+					farthest = _mm_max_ps(farthest, _mm_max_ps(_mm_loadu_ps(row), _mm_loadu_ps(row + 4)));
+				}
+				farthest = _mm_max_ps(farthest, _mm_shuffle_ps(farthest, farthest, _MM_SHUFFLE(1, 0, 3, 2)));
+				farthest = _mm_max_ps(farthest, _mm_shuffle_ps(farthest, farthest, _MM_SHUFFLE(2, 3, 0, 1)));
+				m_TileDepth[tileY * m_TilesX + tileX] = _mm_cvtss_f32(farthest);
+			}
+		}
+	}
+
+	bool ProjectBounds(const Core::Matrix44f& modelToClip, const Core::Vector4f& min, const Core::Vector4f& max,
+					   ScreenBounds* bounds)
+	{
+		bounds->m_MinX = bounds->m_MinY = bounds->m_MinZ = FLT_MAX;
+		bounds->m_MaxX = bounds->m_MaxY = -FLT_MAX;
+		for(uint32 i = 0; i < 8; ++i)
+		{
+			const Core::Vector4f corner{ (i & 1) ? max.x : min.x, (i & 2) ? max.y : min.y, (i & 4) ? max.z : min.z,
+										 1.f };
+
+			const Core::Vector4f clip = corner * modelToClip;
+			if(clip.w < s_MinW)
+				return false;
+
+			const float invW = 1.f / clip.w;
+			const float x = clip.x * invW * 0.5f + 0.5f;
+			const float y = clip.y * invW * 0.5f + 0.5f;
+			const float z = clip.z * invW;
+			if(z < 0.f)
+				return false;
+
+			bounds->m_MinX = std::min(bounds->m_MinX, x);
+			bounds->m_MinY = std::min(bounds->m_MinY, y);
+			bounds->m_MinZ = std::min(bounds->m_MinZ, z);
+			bounds->m_MaxX = std::max(bounds->m_MaxX, x);
+			bounds->m_MaxY = std::max(bounds->m_MaxY, y);
+		}
+		return true;
+	}
+
+	bool OcclusionBuffer::IsVisible(const Core::Matrix44f& world, const Core::Vector4f& min,
+									const Core::Vector4f& max) const
+	{
+		ScreenBounds bounds;
+		if(!ProjectBounds(m_ViewProjection * world, min, max, &bounds))
+			return true;
+
+		if(bounds.IsOffScreen())
+			return false;
+
+		const float minX = bounds.m_MinX * (float)m_Width;
+		const float minY = bounds.m_MinY * (float)m_Height;
+		const float maxX = bounds.m_MaxX * (float)m_Width;
+		const float maxY = bounds.m_MaxY * (float)m_Height;
+		const float minZ = bounds.m_MinZ;
+
+		const int32 x0 = std::max(0, (int32)floorf(minX));
+		const int32 y0 = std::max(0, (int32)floorf(minY));
+		const int32 x1 = std::min((int32)m_Width - 1, (int32)floorf(maxX));
+		const int32 y1 = std::min((int32)m_Height - 1, (int32)floorf(maxY));
+
+		const float testZ = minZ - s_DepthBias;
+		const __m128 occludeeZ = _mm_set1_ps(testZ);
+		const __m128i laneIndex = _mm_setr_epi32(0, 1, 2, 3);
+		const __m128i first = _mm_set1_epi32(x0 - 1);
+		const __m128i last = _mm_set1_epi32(x1 + 1);
+
+		for(int32 tileY = y0 / (int32)s_TileSize; tileY <= y1 / (int32)s_TileSize; ++tileY)
+		{
+			for(int32 tileX = x0 / (int32)s_TileSize; tileX <= x1 / (int32)s_TileSize; ++tileX)
+			{
+				if(testZ > m_TileDepth[tileY * m_TilesX + tileX])
+					continue;
+
+				// the tile has something farther than the occludee, look for it inside the rectangle
+				const int32 rowBegin = std::max(y0, tileY * (int32)s_TileSize);
+				const int32 rowEnd = std::min(y1, (tileY + 1) * (int32)s_TileSize - 1);
+				for(int32 y = rowBegin; y <= rowEnd; ++y)
+				{
+					const float* row = &m_Depth[y * m_Width];
+					for(int32 x = tileX * (int32)s_TileSize; x < (tileX + 1) * (int32)s_TileSize; x += 4)
+					{
+						const __m128i lanes = _mm_add_epi32(_mm_set1_epi32(x), laneIndex);
+						const __m128i inside =
+							_mm_and_si128(_mm_cmpgt_epi32(lanes, first), _mm_cmplt_epi32(lanes, last));
+						const __m128 behind = _mm_cmpge_ps(_mm_loadu_ps(row + x), occludeeZ);
+						if(_mm_movemask_ps(_mm_and_ps(behind, _mm_castsi128_ps(inside))))
+							return true;
+					}
+				}
+			}
+		}
+		return false;
+	}
+
+	void OcclusionBuffer::TestVisibility(const Occludee* occludees, uint32 count, uint8* visible,
+										 Core::ThreadPool* pool) const
+	{
+		PROFILE_FUNCTION();
+		auto testRange = [=](uint32 job) {
+			const uint32 begin = job * s_OccludeesPerJob;
+			const uint32 end = std::min(count, begin + s_OccludeesPerJob);
+			for(uint32 i = begin; i < end; ++i)
+				visible[i] = IsVisible(*occludees[i].m_World, occludees[i].m_Min, occludees[i].m_Max) ? 1 : 0;
+		};
+
+		const uint32 jobCount = (count + s_OccludeesPerJob - 1) / s_OccludeesPerJob;
+		if(pool)
+		{
+			pool->Dispatch(jobCount, testRange);
+		}
+		else
+		{
+			for(uint32 job = 0; job < jobCount; ++job)
+				testRange(job);
+		}
+	}
+
+}; // namespace Graphics
@@ -0,0 +1,118 @@
+#pragma once
+#include "Core/Types.h"
+#include "Core/math/Matrix44.h"
+
+#include <vector>
+
+namespace Core
+{
+	class ThreadPool;
+};
+
+namespace Graphics
+{
+	/* screen rectangle of a box in [0, 1] with y pointing down, and the depth of its nearest corner */
+	struct ScreenBounds
+	{
+		float m_MinX;
+		float m_MinY;
+		float m_MaxX;
+		float m_MaxY;
+		float m_MinZ;
+
+		bool IsOffScreen() const
+		{
+			return m_MaxX < 0.f || m_MaxY < 0.f || m_MinX >= 1.f || m_MinY >= 1.f || m_MinZ > 1.f;
+		}
+	};
+
+	/* returns false when the box crosses the near plane, there is no screen rectangle to test then */
+	bool ProjectBounds(const Core::Matrix44f& modelToClip, const Core::Vector4f& min, const Core::Vector4f& max,
+					   ScreenBounds* bounds);
+
+	/*
+		Software occlusion culling on the CPU.
+
+		Occluder triangles are rasterized into a small depth buffer with SSE, four pixels at a time. The three edge
+		functions of a triangle give a coverage mask per four pixels and only the covered lanes take the nearer depth.
+		Every 8x8 tile keeps its farthest depth as the coarse level of the hierarchy.
+
+		Occludees are tested with the screen rectangle and nearest depth of their transformed bounds. Tiles that are
+		nearer than the occludee everywhere reject it right away, only the remaining tiles are checked per pixel.
+
+		Depth is z / w in [0, 1] with 1 as the far plane and y points down like in vulkan. Transforms are
+		Core::Matrix44f with row vectors, the same matrices that are handed to the shaders. Rasterization splits the
+		screen into bands of tile rows, one job per band, so the workers never touch the same pixels.
+	*/
+	class OcclusionBuffer
+	{
+	public:
+		static constexpr uint32 s_TileSize = 8;
+
+		struct Occludee
+		{
+			const Core::Matrix44f* m_World = nullptr;
+			Core::Vector4f m_Min;
+			Core::Vector4f m_Max;
+		};
+
+		OcclusionBuffer() = default;
+		~OcclusionBuffer() = default;
+
+		/* width and height must be multiples of s_TileSize */
+		void Init(uint32 width, uint32 height);
+
+		/* drops the occluders and resets the depth to the far plane */
+		void Clear(const Core::Matrix44f& viewProjection);
+
+		/* positions are in model space, without indices every three positions form a triangle */
+		void AddOccluder(const Core::Matrix44f& world, const Core::Vector4f* positions, uint32 positionCount,
+						 const uint32* indices = nullptr, uint32 indexCount = 0);
+
+		void Rasterize(Core::ThreadPool* pool = nullptr);
+
+		/* conservative, bounds crossing the near plane are always visible */
+		bool IsVisible(const Core::Matrix44f& world, const Core::Vector4f& min, const Core::Vector4f& max) const;
+		void TestVisibility(const Occludee* occludees, uint32 count, uint8* visible,
+							Core::ThreadPool* pool = nullptr) const;
+
+		uint32 GetWidth() const { return m_Width; }
+		uint32 GetHeight() const { return m_Height; }
+		uint32 GetTriangleCount() const { return (uint32)m_Triangles.size(); }
+		const float* GetDepth() const { return m_Depth.data(); }
+		float GetTileDepth(uint32 tileX, uint32 tileY) const { return m_TileDepth[tileY * m_TilesX + tileX]; }
+
+	private:
+		/* a triangle set up for rasterization, inside is where all edge functions are >= 0 */
+		struct Triangle
+		{
+			float m_A[3];
+			float m_B[3];
+			float m_C[3];
+			float m_Z0; // z = m_Z0 + x * m_DzDx + y * m_DzDy
+			float m_DzDx;
+			float m_DzDy;
+			int32 m_MinX;
+			int32 m_MinY;
+			int32 m_MaxX;
+			int32 m_MaxY;
+		};
+
+		void SetupTriangle(const Core::Vector4f& v0, const Core::Vector4f& v1, const Core::Vector4f& v2);
+		void RasterizeBand(uint32 firstTileRow, uint32 lastTileRow);
+		bool ToScreen(const Core::Vector4f& clip, Core::Vector4f* screen) const;
+
+		uint32 m_Width = 0;
+		uint32 m_Height = 0;
+		uint32 m_TilesX = 0;
+		uint32 m_TilesY = 0;
+
+		Core::Matrix44f m_ViewProjection = Core::Matrix44f::Identity();
+
+		std::vector<float> m_Depth;
+		std::vector<float> m_TileDepth; // farthest depth of each tile
+		std::vector<Triangle> m_Triangles;
+		std::vector<Core::Vector4f> m_Transformed;
+	};
+
+}; // namespace Graphics
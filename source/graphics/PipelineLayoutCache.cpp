@@ -0,0 +1,143 @@
+#include "PipelineLayoutCache.h"
+#include "ShaderReflection.h"
+
+#include "logger/Debug.h"
+
+#include <algorithm>
+
+namespace Graphics
+{
+	void PipelineLayoutCache::Init(VkDevice device) { m_Device = device; }
+
+	void PipelineLayoutCache::Destroy()
+	{
+		for(auto& it : m_Layouts)
+			vkDestroyPipelineLayout(m_Device, it.m_Value->m_Layout, nullptr);
+
+		for(auto& it : m_SetLayouts)
+			vkDestroyDescriptorSetLayout(m_Device, it.m_Value, nullptr);
+
+		m_Layouts.Clear();
+		m_SetLayouts.Clear();
+	}
+
+	VkDescriptorSetLayout PipelineLayoutCache::GetSetLayout(const std::vector<VkDescriptorSetLayoutBinding>& bindings)
+	{
+		std::vector<uint32> key;
+		key.reserve(bindings.size() * 4);
+		for(const VkDescriptorSetLayoutBinding& binding : bindings)
+		{
+			key.push_back(binding.binding);
+			key.push_back((uint32)binding.descriptorType);
+			key.push_back(binding.descriptorCount);
+			key.push_back(binding.stageFlags);
+		}
+
+		if(VkDescriptorSetLayout* found = m_SetLayouts.Find(key))
+			return *found;
+
+		VkDescriptorSetLayoutCreateInfo layoutInfo = {};
+		layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+		layoutInfo.bindingCount = (uint32)bindings.size();
+		layoutInfo.pBindings = bindings.data();
+
+		VkDescriptorSetLayout setLayout = nullptr;
+		if(vkCreateDescriptorSetLayout(m_Device, &layoutInfo, nullptr, &setLayout) != VK_SUCCESS)
+			ASSERT(false, "Failed to create Descriptor layout");
+
+		m_SetLayouts.Insert(key, setLayout);
+		return setLayout;
+	}
+
+	const PipelineLayout& PipelineLayoutCache::GetLayout(const ShaderReflection* const* stages, uint32 stageCount)
+	{
+		// merge the stages, a resource used by several stages becomes one binding with the stage flags combined
+		std::vector<ReflectedBinding> bindings;
+		VkPushConstantRange pushRange = {};
+
+		for(uint32 i = 0; i < stageCount; ++i)
+		{
+			for(const ReflectedBinding& binding : stages[i]->m_Bindings)
+			{
+				auto it = std::find_if(bindings.begin(), bindings.end(), [&binding](const ReflectedBinding& other) {
+					return other.m_Set == binding.m_Set && other.m_Binding == binding.m_Binding;
+				});
+
+				if(it == bindings.end())
+				{
+					bindings.push_back(binding);
+					continue;
+				}
+
+				ASSERT(it->m_Type == binding.m_Type, "Shader stages disagree on the type of a descriptor binding!");
+				it->m_Stages |= binding.m_Stages;
+				it->m_Count = std::max(it->m_Count, binding.m_Count);
+			}
+
+			for(const VkPushConstantRange& range : stages[i]->m_PushConstants)
+			{
+				pushRange.stageFlags |= range.stageFlags;
+				pushRange.size = std::max(pushRange.size, range.offset + range.size);
+			}
+		}
+
+		std::sort(bindings.begin(), bindings.end(), [](const ReflectedBinding& a, const ReflectedBinding& b) {
+			return a.m_Set != b.m_Set ? a.m_Set < b.m_Set : a.m_Binding < b.m_Binding;
+		});
+
+		std::vector<uint32> key;
+		key.reserve(bindings.size() * 5 + 2);
+		for(const ReflectedBinding& binding : bindings)
+		{
+			key.push_back(binding.m_Set);
+			key.push_back(binding.m_Binding);
+			key.push_back((uint32)binding.m_Type);
+			key.push_back(binding.m_Count);
+			key.push_back(binding.m_Stages);
+		}
+		key.push_back(pushRange.stageFlags);
+		key.push_back(pushRange.size);
+
+		if(std::unique_ptr<PipelineLayout>* found = m_Layouts.Find(key))
+			return **found;
+
+		std::unique_ptr<PipelineLayout> created = std::make_unique<PipelineLayout>();
+		PipelineLayout& layout = *created;
+		const uint32 setCount = bindings.empty() ? 0 : bindings.back().m_Set + 1;
+		layout.m_SetLayouts.resize(setCount, nullptr);
+
+		std::vector<VkDescriptorSetLayoutBinding> setBindings;
+		for(uint32 set = 0; set < setCount; ++set)
+		{
+			// sets without any bindings still need a (empty) layout to keep the set numbers intact
+			setBindings.clear();
+			for(const ReflectedBinding& binding : bindings)
+			{
+				if(binding.m_Set != set)
+					continue;
+
+				VkDescriptorSetLayoutBinding layoutBinding = {};
+				layoutBinding.binding = binding.m_Binding;
+				layoutBinding.descriptorType = binding.m_Type;
+				layoutBinding.descriptorCount = binding.m_Count;
+				layoutBinding.stageFlags = binding.m_Stages;
+				setBindings.push_back(layoutBinding);
+			}
+			layout.m_SetLayouts[set] = GetSetLayout(setBindings);
+		}
+
+		VkPipelineLayoutCreateInfo pipelineCreateInfo = {};
+		pipelineCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		pipelineCreateInfo.setLayoutCount = setCount;
+		pipelineCreateInfo.pSetLayouts = layout.m_SetLayouts.data();
+		pipelineCreateInfo.pushConstantRangeCount = pushRange.size > 0 ? 1 : 0;
+		pipelineCreateInfo.pPushConstantRanges = &pushRange;
+
+		if(vkCreatePipelineLayout(m_Device, &pipelineCreateInfo, nullptr, &layout.m_Layout) != VK_SUCCESS)
+			ASSERT(false, "Failed to create pipelineLayout");
+
+		m_Layouts.Insert(key, std::move(created));
+		return layout;
+	}
+
+}; // namespace Graphics
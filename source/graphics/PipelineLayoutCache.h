@@ -0,0 +1,62 @@
+#pragma once
+#include "Core/Types.h"
+#include "Core/Defines.h"
+#include "Core/containers/HashMap.h"
+#include "Core/hash/FastHash.h"
+
+#include <memory>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+DEFINE_HANDLE(VkDevice);
+
+namespace Graphics
+{
+	struct ShaderReflection;
+
+	struct PipelineLayout
+	{
+		VkPipelineLayout m_Layout = nullptr;
+		std::vector<VkDescriptorSetLayout> m_SetLayouts; // indexed by set number
+	};
+
+	/* the cache keys are the binding descriptions packed into uint32s */
+	struct LayoutKeyHasher
+	{
+		static uint64 Hash(const std::vector<uint32>& key)
+		{
+			return Core::Hash64(key.data(), key.size() * sizeof(uint32));
+		}
+		static bool Equal(const std::vector<uint32>& a, const std::vector<uint32>& b) { return a == b; }
+	};
+
+	/*
+		Builds pipeline layouts from shader reflection data.
+		Descriptor set layouts and pipeline layouts are deduplicated, pipelines whose shaders declare the same
+		resources end up sharing the same VkPipelineLayout.
+	*/
+	class PipelineLayoutCache
+	{
+	public:
+		PipelineLayoutCache() = default;
+		~PipelineLayoutCache() = default;
+
+		void Init(VkDevice device);
+		void Destroy();
+
+		/* merges the bindings and push constants of every stage */
+		const PipelineLayout& GetLayout(const ShaderReflection* const* stages, uint32 stageCount);
+
+		uint32 GetLayoutCount() const { return m_Layouts.GetCount(); }
+		uint32 GetSetLayoutCount() const { return m_SetLayouts.GetCount(); }
+
+	private:
+		VkDescriptorSetLayout GetSetLayout(const std::vector<VkDescriptorSetLayoutBinding>& bindings);
+
+		VkDevice m_Device = nullptr;
+		Core::HashMap<std::vector<uint32>, VkDescriptorSetLayout, LayoutKeyHasher> m_SetLayouts;
+		// boxed, the map moves its entries around and GetLayout hands out references
+		Core::HashMap<std::vector<uint32>, std::unique_ptr<PipelineLayout>, LayoutKeyHasher> m_Layouts;
+	};
+
+}; // namespace Graphics
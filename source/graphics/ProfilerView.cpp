@@ -0,0 +1,92 @@
+#include "ProfilerView.h"
+
+#include "Core/profiler/Profiler.h"
+
+#include "imgui/imgui.h"
+
+namespace Graphics
+{
+	static ImU32 ColorFromName(const char* name)
+	{
+		uint32 hash = 2166136261u;
+		for(const char* c = name; c && *c; ++c)
+			hash = (hash ^ (uint8)*c) * 16777619u;
+
+		return IM_COL32(90 + (hash & 0x7f), 90 + ((hash >> 8) & 0x7f), 90 + ((hash >> 16) & 0x7f), 255);
+	}
+
+	void DrawProfilerWindow(float width, float height)
+	{
+#ifdef PROFILER_ENABLED
+		Core::Profiler& profiler = Core::Profiler::Get();
+		const Core::Profiler::Frame& frame = profiler.GetLastFrame();
+
+		ImGui::SetNextWindowSize(ImVec2(width, height), ImGuiCond_FirstUseEver);
+		if(!ImGui::Begin("Profiler"))
+		{
+			ImGui::End();
+			return;
+		}
+
+		const double frameMs = (double)(frame.m_End - frame.m_Begin) / 1000000.0;
+		ImGui::Text("Frame: %.3f ms Threads: %u Dropped: %llu", frameMs, profiler.GetThreadCount(),
+					(unsigned long long)profiler.GetDroppedEvents());
+
+		if(!profiler.IsCapturing())
+		{
+			if(ImGui::Button("Start capture"))
+				profiler.StartCapture();
+		}
+		else if(ImGui::Button("Stop capture"))
+		{
+			profiler.StopCapture();
+			profiler.ExportChromeTrace("profile.json");
+		}
+
+		for(const Core::Profiler::CounterSample& counter : frame.m_Counters)
+			ImGui::Text("%s: %lld", counter.m_Name, (long long)counter.m_Value);
+
+		const float rowHeight = ImGui::GetTextLineHeightWithSpacing();
+		const ImVec2 origin = ImGui::GetCursorScreenPos();
+		const float viewWidth = ImGui::GetContentRegionAvail().x;
+		const double frameLength = (double)(frame.m_End - frame.m_Begin);
+
+		uint32 maxRow = 0;
+		ImDrawList* drawList = ImGui::GetWindowDrawList();
+
+		if(frameLength > 0.0)
+		{
+			const double scale = viewWidth / frameLength;
+			for(const Core::Profiler::Scope& scope : frame.m_Scopes)
+			{
+				// one band of rows per thread, deeper scopes further down
+				const uint32 row = scope.m_ThreadIndex * 8 + scope.m_Depth;
+				maxRow = row > maxRow ? row : maxRow;
+
+				const double begin = scope.m_Begin > frame.m_Begin ? (double)(scope.m_Begin - frame.m_Begin) : 0.0;
+				const double end = (double)(scope.m_End - frame.m_Begin);
+
+				const ImVec2 min(origin.x + (float)(begin * scale), origin.y + row * rowHeight);
+				const ImVec2 max(origin.x + (float)(end * scale), min.y + rowHeight - 1.f);
+				if(max.x - min.x < 1.f)
+					continue;
+
+				drawList->AddRectFilled(min, max, ColorFromName(scope.m_Name));
+				drawList->PushClipRect(min, max, true);
+				drawList->AddText(ImVec2(min.x + 2.f, min.y), IM_COL32_BLACK, scope.m_Name);
+				drawList->PopClipRect();
+
+				if(ImGui::IsMouseHoveringRect(min, max))
+					ImGui::SetTooltip("%s %.3f ms", scope.m_Name, (double)(scope.m_End - scope.m_Begin) / 1000000.0);
+			}
+		}
+
+		ImGui::Dummy(ImVec2(viewWidth, (maxRow + 1) * rowHeight));
+		ImGui::End();
+#else
+		(void)width;
+		(void)height;
+#endif
+	}
+
+}; // namespace Graphics
@@ -0,0 +1,8 @@
+#pragma once
+
+namespace Graphics
+{
+	/* Live flame view of the last frame collected by Core::Profiler, call between ImGui::NewFrame and ImGui::Render */
+	void DrawProfilerWindow(float width, float height);
+
+}; // namespace Graphics
@@ -0,0 +1,79 @@
+#include "RenderPacket.h"
+
+#include "Core/profiler/Profiler.h"
+#include "logger/Debug.h"
+
+namespace Graphics
+{
+	void RenderPacketQueue::Init(uint32 packetCount)
+	{
+		ASSERT(packetCount >= 2, "The threads need a packet each!");
+		ASSERT(packetCount <= s_MaxPackets, "Too many render packets!");
+		m_PacketCount = packetCount;
+		m_WriteIndex = 0;
+		m_ReadIndex = 0;
+		m_Written = 0;
+		m_Closed = false;
+	}
+
+	RenderPacket* RenderPacketQueue::BeginWrite()
+	{
+		PROFILE_FUNCTION();
+		std::unique_lock<std::mutex> lock(m_Lock);
+		ASSERT(!m_Writing, "Already writing a packet!");
+		m_PacketRead.wait(lock, [this]() { return m_Closed || m_Written < m_PacketCount; });
+		if(m_Closed)
+			return nullptr;
+
+		m_Writing = true;
+		return &m_Packets[m_WriteIndex];
+	}
+
+	void RenderPacketQueue::EndWrite()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_Lock);
+			ASSERT(m_Writing, "No packet is being written!");
+			m_Writing = false;
+			m_WriteIndex = (m_WriteIndex + 1) % m_PacketCount;
+			m_Written++;
+		}
+		m_PacketWritten.notify_one();
+	}
+
+	const RenderPacket* RenderPacketQueue::BeginRead()
+	{
+		PROFILE_FUNCTION();
+		std::unique_lock<std::mutex> lock(m_Lock);
+		ASSERT(!m_Reading, "Already reading a packet!");
+		m_PacketWritten.wait(lock, [this]() { return m_Closed || m_Written > 0; });
+		if(m_Written == 0)
+			return nullptr;
+
+		m_Reading = true;
+		return &m_Packets[m_ReadIndex];
+	}
+
+	void RenderPacketQueue::EndRead()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_Lock);
+			ASSERT(m_Reading, "No packet is being read!");
+			m_Reading = false;
+			m_ReadIndex = (m_ReadIndex + 1) % m_PacketCount;
+			m_Written--;
+		}
+		m_PacketRead.notify_one();
+	}
+
+	void RenderPacketQueue::Close()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_Lock);
+			m_Closed = true;
+		}
+		m_PacketWritten.notify_all();
+		m_PacketRead.notify_all();
+	}
+
+}; // namespace Graphics
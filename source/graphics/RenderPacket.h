@@ -0,0 +1,91 @@
+#pragma once
+#include "Core/Types.h"
+#include "Core/math/Matrix44.h"
+#include "Core/memory/MemoryTracker.h"
+#include "LightClusters.h"
+
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+class Cube;
+
+namespace Graphics
+{
+	/* a mesh that passed the game thread's culling, with its LOD picked */
+	struct RenderDraw
+	{
+		Core::Matrix44f m_World;
+		const Cube* m_Mesh = nullptr;
+		uint32 m_Lod = 0;
+		float m_Depth = 0.f; // distance to the eye divided by the far plane
+	};
+
+	/*
+		Everything the render thread needs to draw one frame. The game thread fills it, after that it is read only
+		until the render thread hands it back, so the render thread never looks at game state.
+	*/
+	struct RenderPacket
+	{
+		uint64 m_Frame = 0;
+		float m_DeltaTime = 0.f;
+
+		Core::Matrix44f m_View;
+		Core::Matrix44f m_ViewProjection;
+		Core::Vector4f m_LightDir;
+
+		Core::TrackedVector<Light, Core::EMemoryTag_Graphics> m_Lights;
+		Core::TrackedVector<RenderDraw, Core::EMemoryTag_Graphics> m_Draws;
+
+		bool m_DepthPrepass = true;
+		bool m_HiZCulling = true;
+		bool m_BenchmarkRecording = false;
+	};
+
+	/*
+		The packets between the game thread and the render thread, in frame order.
+
+		With two packets the game thread builds frame n + 1 while the render thread records and submits frame n, a
+		third lets the game thread run one more frame ahead. Nothing is dropped, when every packet is taken the game
+		thread waits for the render thread and the other way around.
+	*/
+	class RenderPacketQueue
+	{
+	public:
+		static constexpr uint32 s_MaxPackets = 3;
+
+		RenderPacketQueue() = default;
+		~RenderPacketQueue() = default;
+
+		void Init(uint32 packetCount);
+
+		/* game thread, a packet the render thread is done with or nullptr once closed */
+		RenderPacket* BeginWrite();
+		void EndWrite();
+
+		/* render thread, the oldest written packet or nullptr once closed and every packet was read */
+		const RenderPacket* BeginRead();
+		void EndRead();
+
+		/* wakes both threads up, nothing is handed out after this */
+		void Close();
+
+		uint32 GetIndex(const RenderPacket* packet) const { return (uint32)(packet - m_Packets); }
+		uint32 GetPacketCount() const { return m_PacketCount; }
+
+	private:
+		RenderPacket m_Packets[s_MaxPackets];
+		uint32 m_PacketCount = 0;
+		uint32 m_WriteIndex = 0;
+		uint32 m_ReadIndex = 0;
+		uint32 m_Written = 0; // written and not handed back yet, including the one being read
+		bool m_Writing = false;
+		bool m_Reading = false;
+		bool m_Closed = false;
+
+		std::mutex m_Lock;
+		std::condition_variable m_PacketWritten;
+		std::condition_variable m_PacketRead;
+	};
+
+}; // namespace Graphics
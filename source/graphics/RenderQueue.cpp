@@ -0,0 +1,124 @@
+#include "RenderQueue.h"
+
+#include "Core/Timer.h"
+#include "Core/memory/Pool.h"
+#include "Core/profiler/Profiler.h"
+#include "logger/Debug.h"
+
+#include <cstring>
+
+namespace Graphics
+{
+	uint64 RenderQueue::MakeKey(HPipeline pipeline, uint32 material, HBuffer mesh, float depth)
+	{
+		// only the slots go into the key, no two live handles share one
+		const uint32 pipelineSlot = Core::HandleLayout<HPipeline>::GetIndex(pipeline);
+		const uint32 meshSlot = Core::HandleLayout<HBuffer>::GetIndex(mesh);
+		ASSERT(pipelineSlot < (1u << s_PipelineBits), "Pipeline handle does not fit the sort key!");
+		ASSERT(material < (1u << s_MaterialBits), "Material does not fit the sort key!");
+		ASSERT(meshSlot < (1u << s_MeshBits), "Mesh handle does not fit the sort key!");
+
+		const float clamped = depth < 0.f ? 0.f : (depth > 1.f ? 1.f : depth);
+		const uint64 quantized = (uint64)(clamped * (float)((1u << s_DepthBits) - 1));
+
+		uint64 key = pipelineSlot;
+		key = (key << s_MaterialBits) | material;
+		key = (key << s_MeshBits) | meshSlot;
+		key = (key << s_DepthBits) | quantized;
+		return key;
+	}
+
+	void RenderQueue::Clear()
+	{
+		m_Draws.clear();
+		m_DrawConstants.clear();
+		m_Constants.clear();
+		m_Keys.clear();
+	}
+
+	void RenderQueue::Submit(const DrawCall& draw, float depth, const void* constants, uint32 constantSize)
+	{
+		Constants drawConstants;
+		drawConstants.m_Offset = (uint32)m_Constants.size();
+		drawConstants.m_Size = constantSize;
+		if(constantSize > 0)
+		{
+			m_Constants.resize(m_Constants.size() + constantSize);
+			memcpy(&m_Constants[drawConstants.m_Offset], constants, constantSize);
+		}
+
+		Core::SortPair pair;
+		pair.m_Key = MakeKey(draw.m_Pipeline, draw.m_Material, draw.m_VertexBuffer, depth);
+		pair.m_Value = (uint32)m_Draws.size();
+
+		m_Keys.push_back(pair);
+		m_Draws.push_back(draw);
+		m_DrawConstants.push_back(drawConstants);
+	}
+
+	void RenderQueue::Sort(Core::ThreadPool* pool)
+	{
+		PROFILE_FUNCTION();
+		Core::Timer timer;
+		timer.Init();
+
+		m_Scratch.resize(m_Keys.size());
+		Core::RadixSort(m_Keys.data(), m_Scratch.data(), (uint32)m_Keys.size(), pool);
+
+		timer.Update();
+		m_Stats.m_SortMs = timer.GetTime() * 1000.f;
+	}
+
+	void RenderQueue::Execute(IGraphicsDevice* device, HPipeline pipeline)
+	{
+		PROFILE_FUNCTION();
+		const float sortMs = m_Stats.m_SortMs;
+		m_Stats = Stats();
+		m_Stats.m_SortMs = sortMs;
+		m_Stats.m_Draws = (uint32)m_Keys.size();
+
+		HPipeline boundPipeline = 0;
+		HBuffer boundMesh = 0;
+		uint32 boundMaterial = 0;
+		bool hasMaterial = false;
+
+		for(const Core::SortPair& pair : m_Keys)
+		{
+			const DrawCall& draw = m_Draws[pair.m_Value];
+
+			const HPipeline drawPipeline = pipeline ? pipeline : draw.m_Pipeline;
+			if(drawPipeline != boundPipeline)
+			{
+				device->BindPipeline(drawPipeline);
+				boundPipeline = drawPipeline;
+				m_Stats.m_PipelineChanges++;
+			}
+
+			if(!hasMaterial || draw.m_Material != boundMaterial)
+			{
+				boundMaterial = draw.m_Material;
+				hasMaterial = true;
+				m_Stats.m_MaterialChanges++;
+			}
+
+			if(draw.m_VertexBuffer != boundMesh)
+			{
+				device->BindVertexBuffer(draw.m_VertexBuffer, 0);
+				boundMesh = draw.m_VertexBuffer;
+				m_Stats.m_MeshChanges++;
+			}
+
+			const Constants& constants = m_DrawConstants[pair.m_Value];
+			if(constants.m_Size > 0)
+				device->PushConstants(&m_Constants[constants.m_Offset], constants.m_Size, 0);
+
+			device->Draw(draw.m_VertexCount, draw.m_InstanceCount, draw.m_FirstVertex, 0);
+			m_Stats.m_Triangles += draw.m_VertexCount / 3 * draw.m_InstanceCount;
+		}
+
+		PROFILE_COUNTER("Pipeline changes", m_Stats.m_PipelineChanges);
+		PROFILE_COUNTER("Mesh changes", m_Stats.m_MeshChanges);
+		PROFILE_COUNTER("Triangles", m_Stats.m_Triangles);
+	}
+
+}; // namespace Graphics
@@ -0,0 +1,91 @@
+#pragma once
+#include "GraphicsDevice.h"
+
+#include "Core/utilities/RadixSort.h"
+
+#include <vector>
+
+namespace Core
+{
+	class ThreadPool;
+};
+
+namespace Graphics
+{
+	struct DrawCall
+	{
+		HPipeline m_Pipeline = 0;
+		uint32 m_Material = 0;
+		HBuffer m_VertexBuffer = 0;
+		uint32 m_VertexCount = 0;
+		uint32 m_InstanceCount = 1;
+		uint32 m_FirstVertex = 0;
+	};
+
+	/*
+		Collects the draws of a frame and records them ordered by a 64 bit sort key, so draws that share state end
+		up next to each other and state is only bound when it actually changes.
+
+		Key layout, most significant bits first:
+			pipeline 12 | material 12 | mesh 16 | depth 24
+
+		The pipeline and mesh fields hold the slot of the handle, the generation is left out.
+
+		Depth is the view distance normalized to [0, 1], draws sharing all state are recorded front to back.
+		Materials have no resources that can be bound through IGraphicsDevice yet, they only group the draws.
+	*/
+	class RenderQueue
+	{
+	public:
+		static constexpr uint32 s_PipelineBits = 12;
+		static constexpr uint32 s_MaterialBits = 12;
+		static constexpr uint32 s_MeshBits = 16;
+		static constexpr uint32 s_DepthBits = 24;
+
+		struct Stats
+		{
+			uint32 m_Draws = 0;
+			uint32 m_PipelineChanges = 0;
+			uint32 m_MaterialChanges = 0;
+			uint32 m_MeshChanges = 0;
+			uint32 m_Triangles = 0;
+			float m_SortMs = 0.f;
+		};
+
+		RenderQueue() = default;
+		~RenderQueue() = default;
+
+		static uint64 MakeKey(HPipeline pipeline, uint32 material, HBuffer mesh, float depth);
+
+		void Clear();
+
+		/* constants are copied and pushed at offset 0 right before the draw */
+		void Submit(const DrawCall& draw, float depth, const void* constants = nullptr, uint32 constantSize = 0);
+
+		/* without a call to Sort the draws are recorded in submission order */
+		void Sort(Core::ThreadPool* pool = nullptr);
+		/* a pipeline other than 0 replaces the pipeline of every draw, the depth pre-pass records the same draws */
+		void Execute(IGraphicsDevice* device, HPipeline pipeline = 0);
+
+		uint32 GetDrawCount() const { return (uint32)m_Draws.size(); }
+		uint64 GetKey(uint32 index) const { return m_Keys[index].m_Key; }
+		const Stats& GetStats() const { return m_Stats; }
+
+	private:
+		struct Constants
+		{
+			uint32 m_Offset;
+			uint32 m_Size;
+		};
+
+		std::vector<DrawCall> m_Draws;
+		std::vector<Constants> m_DrawConstants;
+		std::vector<uint8> m_Constants;
+
+		std::vector<Core::SortPair> m_Keys; // value is the index into m_Draws
+		std::vector<Core::SortPair> m_Scratch;
+
+		Stats m_Stats;
+	};
+
+}; // namespace Graphics
@@ -0,0 +1,32 @@
+#pragma once
+#include "Core/Types.h"
+#include "Core/ecs/TransformHierarchy.h"
+#include "Core/math/Matrix44.h"
+
+class Cube;
+
+namespace Graphics
+{
+	/* components of the entities the renderer draws */
+
+	/*
+		m_Previous and m_Current are copied from the node after the last two simulation steps, m_World is the blend
+		of them the frame renders. The render systems read all of it from the chunk.
+	*/
+	struct Transform
+	{
+		Core::Matrix44f m_World;
+		Core::Matrix44f m_Previous;
+		Core::Matrix44f m_Current;
+		Core::TransformId m_Node = Core::s_NoParent;
+	};
+
+	/* the mesh is shared, the LOD and depth are written by the LOD system every frame */
+	struct MeshInstance
+	{
+		const Cube* m_Mesh = nullptr;
+		uint32 m_Lod = 0;
+		float m_Depth = 0.f; // distance to the eye divided by the far plane
+	};
+
+}; // namespace Graphics
@@ -0,0 +1,476 @@
+#include "ShaderReflection.h"
+
+#include "logger/Debug.h"
+
+#include <algorithm>
+
+namespace Graphics
+{
+	namespace
+	{
+		constexpr uint32 SpirvMagic = 0x07230203;
+
+		enum SpirvOp : uint16
+		{
+			OpEntryPoint = 15,
+			OpTypeInt = 21,
+			OpTypeFloat = 22,
+			OpTypeVector = 23,
+			OpTypeMatrix = 24,
+			OpTypeImage = 25,
+			OpTypeSampler = 26,
+			OpTypeSampledImage = 27,
+			OpTypeArray = 28,
+			OpTypeRuntimeArray = 29,
+			OpTypeStruct = 30,
+			OpTypePointer = 32,
+			OpConstant = 43,
+			OpVariable = 59,
+			OpDecorate = 71,
+			OpMemberDecorate = 72,
+		};
+
+		enum SpirvDecoration : uint32
+		{
+			DecorationBlock = 2,
+			DecorationBufferBlock = 3,
+			DecorationArrayStride = 6,
+			DecorationMatrixStride = 7,
+			DecorationBuiltIn = 11,
+			DecorationLocation = 30,
+			DecorationBinding = 33,
+			DecorationDescriptorSet = 34,
+			DecorationOffset = 35,
+		};
+
+		enum SpirvStorageClass : uint32
+		{
+			StorageUniformConstant = 0,
+			StorageInput = 1,
+			StorageUniform = 2,
+			StoragePushConstant = 9,
+			StorageStorageBuffer = 12,
+		};
+
+		struct Id
+		{
+			uint16 m_Op = 0;
+			uint32 m_Type = 0; // element / pointee / component type
+			uint32 m_StorageClass = 0;
+			uint32 m_Width = 0;	 // scalar bit width, vector/matrix component count, array length id
+			uint32 m_Signed = 0; // int signedness, image "sampled" value
+			uint32 m_Dim = 0;	 // image dimension
+			uint64 m_Constant = 0;
+
+			uint32 m_Set = 0;
+			uint32 m_Binding = 0;
+			uint32 m_Location = 0;
+			uint32 m_ArrayStride = 0;
+			bool m_HasLocation = false;
+			bool m_BuiltIn = false;
+			bool m_Block = false;
+			bool m_BufferBlock = false;
+
+			std::vector<uint32> m_Members;
+			std::vector<uint32> m_MemberOffsets;
+			std::vector<uint32> m_MemberMatrixStrides;
+		};
+
+		uint32 TypeSize(const std::vector<Id>& ids, uint32 typeId, uint32 matrixStride = 0)
+		{
+			const Id& type = ids[typeId];
+			switch(type.m_Op)
+			{
+				case OpTypeInt:
+				case OpTypeFloat:
+					return type.m_Width / 8;
+				case OpTypeVector:
+					return TypeSize(ids, type.m_Type) * type.m_Width;
+				case OpTypeMatrix:
+					return (matrixStride ? matrixStride : TypeSize(ids, type.m_Type)) * type.m_Width;
+				case OpTypeArray:
+				{
+					const uint32 length = (uint32)ids[type.m_Width].m_Constant;
+					const uint32 stride = type.m_ArrayStride ? type.m_ArrayStride : TypeSize(ids, type.m_Type);
+					return stride * length;
+				}
+				case OpTypeStruct:
+				{
+					uint32 size = 0;
+					for(size_t i = 0; i < type.m_Members.size(); ++i)
+					{
+						const uint32 end = type.m_MemberOffsets[i] +
+										   TypeSize(ids, type.m_Members[i], type.m_MemberMatrixStrides[i]);
+						size = std::max(size, end);
+					}
+					return size;
+				}
+				default:
+					return 0;
+			}
+		}
+
+		VkFormat VertexFormat(const std::vector<Id>& ids, uint32 typeId)
+		{
+			const Id& type = ids[typeId];
+			const Id& scalar = type.m_Op == OpTypeVector ? ids[type.m_Type] : type;
+			const uint32 count = type.m_Op == OpTypeVector ? type.m_Width : 1;
+
+			if(scalar.m_Width != 32)
+				return VK_FORMAT_UNDEFINED;
+
+			static const VkFormat floats[] = { VK_FORMAT_R32_SFLOAT, VK_FORMAT_R32G32_SFLOAT, VK_FORMAT_R32G32B32_SFLOAT,
+											   VK_FORMAT_R32G32B32A32_SFLOAT };
+			static const VkFormat sints[] = { VK_FORMAT_R32_SINT, VK_FORMAT_R32G32_SINT, VK_FORMAT_R32G32B32_SINT,
+											  VK_FORMAT_R32G32B32A32_SINT };
+			static const VkFormat uints[] = { VK_FORMAT_R32_UINT, VK_FORMAT_R32G32_UINT, VK_FORMAT_R32G32B32_UINT,
+											  VK_FORMAT_R32G32B32A32_UINT };
+
+			if(count < 1 || count > 4)
+				return VK_FORMAT_UNDEFINED;
+
+			if(scalar.m_Op == OpTypeFloat)
+				return floats[count - 1];
+			if(scalar.m_Op == OpTypeInt)
+				return scalar.m_Signed ? sints[count - 1] : uints[count - 1];
+
+			return VK_FORMAT_UNDEFINED;
+		}
+
+		bool DescriptorType(const std::vector<Id>& ids, const Id& variable, uint32 typeId, VkDescriptorType* type)
+		{
+			const Id& resource = ids[typeId];
+			switch(resource.m_Op)
+			{
+				case OpTypeStruct:
+					if(variable.m_StorageClass == StorageStorageBuffer || resource.m_BufferBlock)
+						*type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+					else
+						*type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+					return true;
+				case OpTypeSampler:
+					*type = VK_DESCRIPTOR_TYPE_SAMPLER;
+					return true;
+				case OpTypeSampledImage:
+					*type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+					return true;
+				case OpTypeImage:
+				{
+					constexpr uint32 DimBuffer = 5;
+					constexpr uint32 DimSubpassData = 6;
+					if(resource.m_Dim == DimSubpassData)
+						*type = VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+					else if(resource.m_Dim == DimBuffer)
+						*type = resource.m_Signed == 2 ? VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER
+													   : VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER;
+					else
+						*type = resource.m_Signed == 2 ? VK_DESCRIPTOR_TYPE_STORAGE_IMAGE
+													   : VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+					return true;
+				}
+				default:
+					return false;
+			}
+		}
+
+		/* false when an instruction read below is too short or names an id past the bound of the module */
+		bool ValidateInstruction(const uint32* inst, uint16 op, uint16 count, uint32 bound)
+		{
+			auto id = [inst, count, bound](uint16 operand) { return operand < count && inst[operand] < bound; };
+			switch(op)
+			{
+				case OpEntryPoint:
+					return count >= 2;
+				case OpTypeInt:
+					return count >= 4 && id(1);
+				case OpTypeFloat:
+					return count >= 3 && id(1);
+				case OpTypeVector:
+				case OpTypeMatrix:
+					return count >= 4 && id(1) && id(2);
+				case OpTypeArray:
+					return id(1) && id(2) && id(3);
+				case OpTypeRuntimeArray:
+				case OpTypeSampledImage:
+					return id(1) && id(2);
+				case OpTypeImage:
+					return count >= 9 && id(1) && id(2);
+				case OpTypeSampler:
+					return id(1);
+				case OpTypeStruct:
+					for(uint16 operand = 1; operand < count; ++operand)
+					{
+						if(!id(operand))
+							return false;
+					}
+					return count >= 2;
+				case OpTypePointer:
+					return id(1) && id(3);
+				case OpConstant:
+				case OpVariable:
+					return count >= 4 && id(1) && id(2);
+				case OpDecorate:
+					// Block and BufferBlock are the only decorations read here without a literal
+					return count >= 3 && id(1) &&
+						   (count >= 4 || inst[2] == DecorationBlock || inst[2] == DecorationBufferBlock);
+				case OpMemberDecorate:
+					return count >= 4 && id(1) &&
+						   (count >= 5 || (inst[3] != DecorationOffset && inst[3] != DecorationMatrixStride &&
+										   inst[3] != DecorationBuiltIn));
+				default:
+					return true;
+			}
+		}
+
+	}; // namespace
+
+	bool ReflectShader(const uint32* code, uint32 size, ShaderReflection* reflection)
+	{
+		const size_t wordCount = size / sizeof(uint32);
+		// a bad module is reported to the caller, LoadShader asserts on it
+		if(!code || wordCount < 5 || code[0] != SpirvMagic)
+		{
+			LOG_MESSAGE("Shader is not a SPIR-V module!");
+			return false;
+		}
+
+		const uint32 bound = code[3];
+		std::vector<Id> ids(bound);
+		std::vector<uint32> variables;
+
+		*reflection = ShaderReflection();
+
+		for(size_t word = 5; word < wordCount;)
+		{
+			const uint32* inst = &code[word];
+			const uint16 op = (uint16)(inst[0] & 0xffff);
+			const uint16 count = (uint16)(inst[0] >> 16);
+			if(count == 0 || word + count > wordCount || !ValidateInstruction(inst, op, count, bound))
+			{
+				LOG_MESSAGE("Malformed SPIR-V module, instruction %u at word %u!", (uint32)op, (uint32)word);
+				return false;
+			}
+
+			switch(op)
+			{
+				case OpEntryPoint:
+				{
+					constexpr uint32 ExecutionModelVertex = 0;
+					constexpr uint32 ExecutionModelFragment = 4;
+					constexpr uint32 ExecutionModelCompute = 5;
+					if(inst[1] == ExecutionModelVertex)
+						reflection->m_Stage = VK_SHADER_STAGE_VERTEX_BIT;
+					else if(inst[1] == ExecutionModelFragment)
+						reflection->m_Stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+					else if(inst[1] == ExecutionModelCompute)
+						reflection->m_Stage = VK_SHADER_STAGE_COMPUTE_BIT;
+				}
+				break;
+				case OpTypeInt:
+					ids[inst[1]].m_Op = op;
+					ids[inst[1]].m_Width = inst[2];
+					ids[inst[1]].m_Signed = inst[3];
+					break;
+				case OpTypeFloat:
+					ids[inst[1]].m_Op = op;
+					ids[inst[1]].m_Width = inst[2];
+					break;
+				case OpTypeVector:
+				case OpTypeMatrix:
+				case OpTypeArray:
+					ids[inst[1]].m_Op = op;
+					ids[inst[1]].m_Type = inst[2];
+					ids[inst[1]].m_Width = inst[3];
+					break;
+				case OpTypeRuntimeArray:
+				case OpTypeSampledImage:
+					ids[inst[1]].m_Op = op;
+					ids[inst[1]].m_Type = inst[2];
+					break;
+				case OpTypeImage:
+					ids[inst[1]].m_Op = op;
+					ids[inst[1]].m_Type = inst[2];
+					ids[inst[1]].m_Dim = inst[3];
+					ids[inst[1]].m_Signed = inst[7]; // 1 = sampled, 2 = storage
+					break;
+				case OpTypeSampler:
+					ids[inst[1]].m_Op = op;
+					break;
+				case OpTypeStruct:
+				{
+					Id& type = ids[inst[1]];
+					type.m_Op = op;
+					type.m_Members.assign(inst + 2, inst + count);
+					type.m_MemberOffsets.resize(type.m_Members.size(), 0);
+					type.m_MemberMatrixStrides.resize(type.m_Members.size(), 0);
+				}
+				break;
+				case OpTypePointer:
+					ids[inst[1]].m_Op = op;
+					ids[inst[1]].m_StorageClass = inst[2];
+					ids[inst[1]].m_Type = inst[3];
+					break;
+				case OpConstant:
+					ids[inst[2]].m_Op = op;
+					ids[inst[2]].m_Type = inst[1];
+					ids[inst[2]].m_Constant = inst[3];
+					break;
+				case OpVariable:
+					ids[inst[2]].m_Op = op;
+					ids[inst[2]].m_Type = inst[1];
+					ids[inst[2]].m_StorageClass = inst[3];
+					variables.push_back(inst[2]);
+					break;
+				case OpDecorate:
+				{
+					Id& target = ids[inst[1]];
+					switch(inst[2])
+					{
+						case DecorationBlock:
+							target.m_Block = true;
+							break;
+						case DecorationBufferBlock:
+							target.m_BufferBlock = true;
+							break;
+						case DecorationArrayStride:
+							target.m_ArrayStride = inst[3];
+							break;
+						case DecorationBuiltIn:
+							target.m_BuiltIn = true;
+							break;
+						case DecorationLocation:
+							target.m_Location = inst[3];
+							target.m_HasLocation = true;
+							break;
+						case DecorationBinding:
+							target.m_Binding = inst[3];
+							break;
+						case DecorationDescriptorSet:
+							target.m_Set = inst[3];
+							break;
+						default:
+							break;
+					}
+				}
+				break;
+				default:
+					break;
+			}
+
+			word += count;
+		}
+
+		// Member decorations can appear before the struct is declared, so they are resolved in a second pass
+		for(size_t word = 5; word < wordCount;)
+		{
+			const uint32* inst = &code[word];
+			const uint16 op = (uint16)(inst[0] & 0xffff);
+			const uint16 count = (uint16)(inst[0] >> 16);
+
+			if(op == OpMemberDecorate)
+			{
+				Id& type = ids[inst[1]];
+				const uint32 member = inst[2];
+				if(member < type.m_Members.size())
+				{
+					if(inst[3] == DecorationOffset)
+						type.m_MemberOffsets[member] = inst[4];
+					else if(inst[3] == DecorationMatrixStride)
+						type.m_MemberMatrixStrides[member] = inst[4];
+					else if(inst[3] == DecorationBuiltIn)
+						type.m_BuiltIn = true;
+				}
+			}
+
+			word += count;
+		}
+
+		for(uint32 variableId : variables)
+		{
+			const Id& variable = ids[variableId];
+			const Id& pointer = ids[variable.m_Type];
+			uint32 typeId = pointer.m_Type;
+
+			switch(variable.m_StorageClass)
+			{
+				case StorageInput:
+				{
+					if(reflection->m_Stage != VK_SHADER_STAGE_VERTEX_BIT || variable.m_BuiltIn ||
+					   ids[typeId].m_BuiltIn || !variable.m_HasLocation)
+						break;
+
+					ReflectedVertexInput input;
+					input.m_Location = variable.m_Location;
+					input.m_Format = VertexFormat(ids, typeId);
+					input.m_Size = TypeSize(ids, typeId);
+					ASSERT(input.m_Format != VK_FORMAT_UNDEFINED, "Unsupported vertex input type!");
+					reflection->m_VertexInputs.push_back(input);
+				}
+				break;
+				case StoragePushConstant:
+				{
+					VkPushConstantRange range = {};
+					range.stageFlags = reflection->m_Stage;
+					range.offset = 0;
+					range.size = TypeSize(ids, typeId);
+					reflection->m_PushConstants.push_back(range);
+				}
+				break;
+				case StorageUniform:
+				case StorageUniformConstant:
+				case StorageStorageBuffer:
+				{
+					ReflectedBinding binding;
+					binding.m_Set = variable.m_Set;
+					binding.m_Binding = variable.m_Binding;
+					binding.m_Stages = reflection->m_Stage;
+
+					while(ids[typeId].m_Op == OpTypeArray || ids[typeId].m_Op == OpTypeRuntimeArray)
+					{
+						// runtime arrays are reported with a count of 0, the caller decides how many to allocate
+						const Id& array = ids[typeId];
+						binding.m_Count *= array.m_Op == OpTypeArray ? (uint32)ids[array.m_Width].m_Constant : 0;
+						typeId = array.m_Type;
+					}
+
+					if(DescriptorType(ids, variable, typeId, &binding.m_Type))
+						reflection->m_Bindings.push_back(binding);
+				}
+				break;
+				default:
+					break;
+			}
+		}
+
+		std::sort(reflection->m_Bindings.begin(), reflection->m_Bindings.end(),
+				  [](const ReflectedBinding& a, const ReflectedBinding& b) {
+					  return a.m_Set != b.m_Set ? a.m_Set < b.m_Set : a.m_Binding < b.m_Binding;
+				  });
+		std::sort(reflection->m_VertexInputs.begin(), reflection->m_VertexInputs.end(),
+				  [](const ReflectedVertexInput& a, const ReflectedVertexInput& b) {
+					  return a.m_Location < b.m_Location;
+				  });
+
+		return true;
+	}
+
+	uint32 BuildVertexInputLayout(const ShaderReflection& reflection,
+								  std::vector<VkVertexInputAttributeDescription>* attributes)
+	{
+		uint32 offset = 0;
+		attributes->clear();
+		for(const ReflectedVertexInput& input : reflection.m_VertexInputs)
+		{
+			VkVertexInputAttributeDescription attribute = {};
+			attribute.binding = 0;
+			attribute.location = input.m_Location;
+			attribute.format = input.m_Format;
+			attribute.offset = offset;
+			attributes->push_back(attribute);
+
+			offset += input.m_Size;
+		}
+		return offset;
+	}
+
+}; // namespace Graphics
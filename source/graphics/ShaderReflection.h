@@ -0,0 +1,48 @@
+#pragma once
+#include "Core/Types.h"
+
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+/*
+	Minimal SPIR-V reflection.
+
+	Walks the instruction stream of a shader module and pulls out what the pipeline layout and the vertex input
+	state need: descriptor bindings (set, binding, type, count), push constant blocks and the vertex stage inputs.
+	This removes the need to keep the C++ side in sync with the shader by hand.
+*/
+
+namespace Graphics
+{
+	struct ReflectedBinding
+	{
+		uint32 m_Set = 0;
+		uint32 m_Binding = 0;
+		uint32 m_Count = 1;
+		VkDescriptorType m_Type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+		VkShaderStageFlags m_Stages = 0;
+	};
+
+	struct ReflectedVertexInput
+	{
+		uint32 m_Location = 0;
+		uint32 m_Size = 0;
+		VkFormat m_Format = VK_FORMAT_UNDEFINED;
+	};
+
+	struct ShaderReflection
+	{
+		VkShaderStageFlagBits m_Stage = VK_SHADER_STAGE_VERTEX_BIT;
+		std::vector<ReflectedBinding> m_Bindings;		   // sorted by set, binding
+		std::vector<VkPushConstantRange> m_PushConstants; // offset / size of each push constant block
+		std::vector<ReflectedVertexInput> m_VertexInputs; // sorted by location, only filled for vertex shaders
+	};
+
+	/* code is the raw SPIR-V module, size is in bytes. Returns false if the module is not valid SPIR-V */
+	bool ReflectShader(const uint32* code, uint32 size, ShaderReflection* reflection);
+
+	/* Tightly packed vertex layout in location order on binding 0, returns the stride */
+	uint32 BuildVertexInputLayout(const ShaderReflection& reflection,
+								  std::vector<VkVertexInputAttributeDescription>* attributes);
+
+}; // namespace Graphics
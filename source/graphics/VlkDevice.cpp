@@ -1,6 +1,7 @@
 #include "VlkDevice.h"
 #include "VlkPhysicalDevice.h"
 
+#include "Core/memory/MemoryTracker.h"
 #include "logger/Debug.h"
 
 #include <Windows.h>
@@ -19,6 +20,10 @@ namespace Graphics
 
 	void VlkDevice::Release(IGfxDevice*)
 	{
+		FlushUploads();
+		m_TransferQueue.Destroy();
+		m_ComputeQueue.Destroy();
+		m_GraphicsQueue.Destroy();
 		vkDestroyDevice(m_Device, nullptr);
 	}
 
@@ -45,21 +50,32 @@ namespace Graphics
 		assert(result == VK_SUCCESS && "failed to get swapchainimages");
 	}
 
-	VkDeviceMemory VlkDevice::AllocateMemory(const VkMemoryRequirements& requirements, VlkPhysicalDevice* physDevice)
+	VkDeviceMemory VlkDevice::AllocateMemory(const VkMemoryRequirements& requirements, VlkPhysicalDevice* physDevice,
+											 VkMemoryPropertyFlags properties)
 	{
 		VkDeviceMemory memory;
 		VkMemoryAllocateInfo allocInfo = {};
 		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
 		allocInfo.allocationSize = requirements.size;
-		allocInfo.memoryTypeIndex = physDevice->FindMemoryType(requirements.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+		allocInfo.memoryTypeIndex = physDevice->FindMemoryType(requirements.memoryTypeBits, properties);
 
 		if(vkAllocateMemory(m_Device, &allocInfo, nullptr, &memory) != VK_SUCCESS)
 			ASSERT(false, "Failed to allocate memory on GPU!");
 
+		const Core::EMemoryTag tag = (properties & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT) ? Core::EMemoryTag_GpuDeviceLocal
+																						 : Core::EMemoryTag_GpuHostVisible;
+		Core::MemoryTracker::Get().OnAllocate((uint64)memory, requirements.size, tag);
 		return memory;
 	}
 
-	VkBuffer VlkDevice::CreateBuffer(const VkBufferCreateInfo& createInfo, VkDeviceMemory* memory, VlkPhysicalDevice* physDevice)
+	void VlkDevice::FreeMemory(VkDeviceMemory memory)
+	{
+		Core::MemoryTracker::Get().OnFree((uint64)memory);
+		vkFreeMemory(m_Device, memory, nullptr);
+	}
+
+	VkBuffer VlkDevice::CreateBuffer(const VkBufferCreateInfo& createInfo, VkDeviceMemory* memory, VlkPhysicalDevice* physDevice,
+									 VkMemoryPropertyFlags properties)
 	{
 		VkBuffer buffer = nullptr;
 		if(vkCreateBuffer(m_Device, &createInfo, nullptr, &buffer) != VK_SUCCESS)
@@ -68,7 +84,7 @@ namespace Graphics
 		VkMemoryRequirements memRequirements;
 		vkGetBufferMemoryRequirements(m_Device, buffer, &memRequirements);
 
-		*memory = AllocateMemory(memRequirements, physDevice);
+		*memory = AllocateMemory(memRequirements, physDevice, properties);
 
 		if(vkBindBufferMemory(m_Device, buffer, *memory, 0) != VK_SUCCESS)
 			ASSERT(false, "Failed to bind buffer memory!");
@@ -76,15 +92,89 @@ namespace Graphics
 		return buffer;
 	}
 
+	VkBuffer VlkDevice::CreateDeviceBuffer(const VkBufferCreateInfo& createInfo, const void* data, VkDeviceMemory* memory,
+										   VlkPhysicalDevice* physDevice, VkAccessFlags dstAccess,
+										   VkPipelineStageFlags dstStage)
+	{
+		VkBufferCreateInfo stagingInfo = createInfo;
+		stagingInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+		stagingInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+		VkDeviceMemory stagingMemory = nullptr;
+		VkBuffer staging = CreateBuffer(stagingInfo, &stagingMemory, physDevice);
+
+		void* mapped = nullptr;
+		if(vkMapMemory(m_Device, stagingMemory, 0, createInfo.size, 0, &mapped) != VK_SUCCESS)
+			ASSERT(false, "Failed to map memory!");
+		memcpy(mapped, data, (size_t)createInfo.size);
+		vkUnmapMemory(m_Device, stagingMemory);
+
+		VkBufferCreateInfo deviceInfo = createInfo;
+		deviceInfo.usage |= VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+		VkBuffer buffer = CreateBuffer(deviceInfo, memory, physDevice, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+		if(!m_UploadCommands)
+			m_UploadCommands = m_TransferQueue.BeginCommands();
+
+		VkBufferCopy copyRegion = {};
+		copyRegion.size = createInfo.size;
+		m_Table.vkCmdCopyBuffer(m_UploadCommands, staging, buffer, 1, &copyRegion);
+
+		m_TransferQueue.ReleaseBuffer(m_UploadCommands, buffer, VK_ACCESS_TRANSFER_WRITE_BIT,
+									  VK_PIPELINE_STAGE_TRANSFER_BIT, &m_GraphicsQueue, dstAccess, dstStage);
+
+		m_StagingBuffers.push_back(staging);
+		m_StagingMemory.push_back(stagingMemory);
+		return buffer;
+	}
+
+	void VlkDevice::FlushUploads()
+	{
+		if(!m_UploadCommands)
+			return;
+
+		// the staging buffers are released once the transfer queue is done with them
+		const uint64 ticket = m_TransferQueue.Submit(m_UploadCommands);
+		for(size_t i = 0; i < m_StagingBuffers.size(); ++i)
+			m_TransferQueue.Retire(ticket, m_StagingBuffers[i], m_StagingMemory[i]);
+
+		m_UploadCommands = nullptr;
+		m_StagingBuffers.clear();
+		m_StagingMemory.clear();
+	}
+
 	void VlkDevice::Init(VlkPhysicalDevice* physicalDevice)
 	{
-		// queue create info
-		const float queue_priorities[] = { 1.f };
-		VkDeviceQueueCreateInfo queueCreateInfo = {};
-		queueCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
-		queueCreateInfo.queueFamilyIndex = physicalDevice->GetQueueFamilyIndex();
-		queueCreateInfo.queueCount = 1;
-		queueCreateInfo.pQueuePriorities = queue_priorities;
+		// queue create info, graphics, compute and transfer get a queue each as long as their family has enough
+		const float queue_priorities[] = { 1.f, 1.f, 1.f };
+		const uint32 families[] = { physicalDevice->GetQueueFamilyIndex(), physicalDevice->GetComputeFamilyIndex(),
+									physicalDevice->GetTransferFamilyIndex() };
+		uint32 queueIndices[ARRSIZE(families)] = {};
+
+		std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
+		for(uint32 i = 0; i < ARRSIZE(families); ++i)
+		{
+			VkDeviceQueueCreateInfo* queueCreateInfo = nullptr;
+			for(VkDeviceQueueCreateInfo& info : queueCreateInfos)
+			{
+				if(info.queueFamilyIndex == families[i])
+					queueCreateInfo = &info;
+			}
+
+			if(!queueCreateInfo)
+			{
+				queueCreateInfos.push_back({});
+				queueCreateInfo = &queueCreateInfos.back();
+				queueCreateInfo->sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+				queueCreateInfo->queueFamilyIndex = families[i];
+				queueCreateInfo->pQueuePriorities = queue_priorities;
+			}
+
+			if(queueCreateInfo->queueCount < physicalDevice->GetQueueCount(families[i]))
+				queueCreateInfo->queueCount++;
+
+			queueIndices[i] = queueCreateInfo->queueCount - 1;
+		}
 
 		// Physical device features
 		VkPhysicalDeviceFeatures enabled_features = {};
@@ -93,18 +183,27 @@ namespace Graphics
 		// device create info
 		VkDeviceCreateInfo createInfo = {};
 		createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
-		createInfo.queueCreateInfoCount = 1;
-		createInfo.pQueueCreateInfos = &queueCreateInfo;
+		createInfo.queueCreateInfoCount = (uint32)queueCreateInfos.size();
+		createInfo.pQueueCreateInfos = queueCreateInfos.data();
 #ifdef _DEBUG
 		createInfo.enabledLayerCount = ARRSIZE(debugLayers);
 		createInfo.ppEnabledLayerNames = debugLayers;
 #endif
-		createInfo.enabledExtensionCount = ARRSIZE(deviceExt);
-		createInfo.ppEnabledExtensionNames = deviceExt;
+		// the heap budgets are read when the driver has them
+		std::vector<const char*> extensions(deviceExt, deviceExt + ARRSIZE(deviceExt));
+		m_MemoryBudget = physicalDevice->HasExtension(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+		if(m_MemoryBudget)
+			extensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+		createInfo.enabledExtensionCount = (uint32)extensions.size();
+		createInfo.ppEnabledExtensionNames = extensions.data();
 		createInfo.pEnabledFeatures = &enabled_features;
 
 		m_Device = physicalDevice->CreateDevice(createInfo);
+		m_Table.Load(m_Device);
 
-		vkGetDeviceQueue(m_Device, physicalDevice->GetQueueFamilyIndex(), 0, &m_Queue);
+		m_GraphicsQueue.Init(m_Device, families[0], queueIndices[0]);
+		m_ComputeQueue.Init(m_Device, families[1], queueIndices[1]);
+		m_TransferQueue.Init(m_Device, families[2], queueIndices[2]);
+		m_Queue = m_GraphicsQueue.GetQueue();
 	}
 }; // namespace Graphics
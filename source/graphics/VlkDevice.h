@@ -1,6 +1,8 @@
 #pragma once
 #include <Core/Defines.h>
 #include "IGfxDevice.h"
+#include "VlkDeviceTable.h"
+#include "VlkQueue.h"
 #include <vulkan/vulkan_core.h>
 #include <vector>
 
@@ -32,18 +34,53 @@ namespace Graphics
 			return m_Queue;
 		}
 
+		const VlkDeviceTable& GetTable() const { return m_Table; }
+
+		VlkQueue& GetGraphicsQueue() { return m_GraphicsQueue; }
+		VlkQueue& GetComputeQueue() { return m_ComputeQueue; }
+		VlkQueue& GetTransferQueue() { return m_TransferQueue; }
+
 		VkSwapchainKHR CreateSwapchain(const VkSwapchainCreateInfoKHR& createInfo) const;
 		void DestroySwapchain(VkSwapchainKHR pSwapchain);
 
 		void GetSwapchainImages(VkSwapchainKHR* pSwapchain, std::vector<VkImage>* scImages);
 
-		VkDeviceMemory AllocateMemory(const VkMemoryRequirements& requirements, VlkPhysicalDevice* physDevice);
-		VkBuffer CreateBuffer(const VkBufferCreateInfo& createInfo, VkDeviceMemory* memory, VlkPhysicalDevice* physDevice);
+		/* reported to Core::MemoryTracker as device local or host visible, free it with FreeMemory */
+		VkDeviceMemory AllocateMemory(const VkMemoryRequirements& requirements, VlkPhysicalDevice* physDevice,
+									  VkMemoryPropertyFlags properties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+																		 VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+		void FreeMemory(VkDeviceMemory memory);
+
+		/* VK_EXT_memory_budget is enabled, the physical device reports the heap budgets */
+		bool HasMemoryBudget() const { return m_MemoryBudget; }
+		VkBuffer CreateBuffer(const VkBufferCreateInfo& createInfo, VkDeviceMemory* memory, VlkPhysicalDevice* physDevice,
+							  VkMemoryPropertyFlags properties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+																 VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+		/*
+			Creates a device local buffer and records a copy of data into it on the transfer queue.
+			The buffer is handed over to the graphics queue, it can be used by the first graphics submission after
+			FlushUploads.
+		*/
+		VkBuffer CreateDeviceBuffer(const VkBufferCreateInfo& createInfo, const void* data, VkDeviceMemory* memory,
+									VlkPhysicalDevice* physDevice, VkAccessFlags dstAccess,
+									VkPipelineStageFlags dstStage);
+		void FlushUploads();
 
 	private:
 		void Release(IGfxDevice* device) override;
 		VkDevice m_Device = nullptr;
 		VkQueue m_Queue = nullptr;
+		VlkDeviceTable m_Table;
+		bool m_MemoryBudget = false;
+
+		VlkQueue m_GraphicsQueue;
+		VlkQueue m_ComputeQueue;
+		VlkQueue m_TransferQueue;
+
+		VkCommandBuffer m_UploadCommands = nullptr;
+		std::vector<VkBuffer> m_StagingBuffers;
+		std::vector<VkDeviceMemory> m_StagingMemory;
 	};
 
 }; // namespace Graphics
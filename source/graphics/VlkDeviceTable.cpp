@@ -0,0 +1,17 @@
+#include "VlkDeviceTable.h"
+
+#include "logger/Debug.h"
+
+namespace Graphics
+{
+	void VlkDeviceTable::Load(VkDevice device)
+	{
+#define VLK_LOAD_FUNCTION(function)                                    \
+	function = (PFN_##function)vkGetDeviceProcAddr(device, #function); \
+	ASSERT(function != nullptr, "Failed to load " #function "!");
+
+		VLK_DEVICE_FUNCTIONS(VLK_LOAD_FUNCTION)
+#undef VLK_LOAD_FUNCTION
+	}
+
+}; // namespace Graphics
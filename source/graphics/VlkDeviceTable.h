@@ -0,0 +1,48 @@
+#pragma once
+#include "Core/Defines.h"
+
+#include <vulkan/vulkan_core.h>
+
+DEFINE_HANDLE(VkDevice);
+
+/*
+	Device level entry points resolved once through vkGetDeviceProcAddr.
+
+	Calls made through the exported vk* symbols go through the loader trampoline, which looks up the dispatch table of
+	the handle on every call. The functions in this table point straight into the driver for the device they were
+	loaded from, use it for everything that is called per draw.
+*/
+
+// clang-format off
+#define VLK_DEVICE_FUNCTIONS(X)		\
+	X(vkBeginCommandBuffer)			\
+	X(vkEndCommandBuffer)			\
+	X(vkCmdBeginRenderPass)			\
+	X(vkCmdEndRenderPass)			\
+	X(vkCmdBindPipeline)			\
+	X(vkCmdBindDescriptorSets)		\
+	X(vkCmdBindVertexBuffers)		\
+	X(vkCmdBindIndexBuffer)			\
+	X(vkCmdPushConstants)			\
+	X(vkCmdDraw)					\
+	X(vkCmdDrawIndexed)				\
+	X(vkCmdDispatch)				\
+	X(vkCmdPipelineBarrier)			\
+	X(vkCmdCopyBuffer)				\
+	X(vkCmdCopyImageToBuffer)		\
+	X(vkCmdExecuteCommands)			\
+	X(vkQueueSubmit)
+// clang-format on
+
+namespace Graphics
+{
+	struct VlkDeviceTable
+	{
+#define VLK_DECLARE_FUNCTION(function) PFN_##function function = nullptr;
+		VLK_DEVICE_FUNCTIONS(VLK_DECLARE_FUNCTION)
+#undef VLK_DECLARE_FUNCTION
+
+		void Load(VkDevice device);
+	};
+
+}; // namespace Graphics
@@ -5,6 +5,7 @@
 
 #include "logger/Debug.h"
 
+#include <cstring>
 #include <vector>
 
 namespace Graphics
@@ -36,6 +37,28 @@ namespace Graphics
 		}
 
 		ASSERT(m_PhysicalDevice, "Physical Device is null!");
+
+		// Families without graphics map to the copy / async compute engines, they run alongside the graphics queue.
+		// Fall back to a family shared with compute and last to the graphics family itself.
+		int32 transfer = FindDedicatedFamily(VK_QUEUE_TRANSFER_BIT, VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT);
+		if(transfer < 0)
+			transfer = FindDedicatedFamily(VK_QUEUE_TRANSFER_BIT, VK_QUEUE_GRAPHICS_BIT);
+		m_TransferFamilyIndex = transfer < 0 ? m_QueueFamilyIndex : (uint32)transfer;
+
+		const int32 compute = FindDedicatedFamily(VK_QUEUE_COMPUTE_BIT, VK_QUEUE_GRAPHICS_BIT);
+		m_ComputeFamilyIndex = compute < 0 ? m_QueueFamilyIndex : (uint32)compute;
+	}
+
+	int32 VlkPhysicalDevice::FindDedicatedFamily(VkQueueFlags required, VkQueueFlags excluded) const
+	{
+		for(uint32 i = 0; i < m_QueueProperties.Size(); ++i)
+		{
+			const VkQueueFamilyProperties& property = m_QueueProperties[i];
+			if(property.queueCount > 0 && (property.queueFlags & required) == required &&
+			   (property.queueFlags & excluded) == 0)
+				return (int32)i;
+		}
+		return -1;
 	}
 
 	VkDevice VlkPhysicalDevice::CreateDevice(const VkDeviceCreateInfo& createInfo) const
@@ -120,6 +143,42 @@ namespace Graphics
 		return 0;
 	}
 
+	bool VlkPhysicalDevice::HasExtension(const char* extension) const
+	{
+		uint32 count = 0;
+		vkEnumerateDeviceExtensionProperties(m_PhysicalDevice, nullptr, &count, nullptr);
+		std::vector<VkExtensionProperties> extensions(count);
+		vkEnumerateDeviceExtensionProperties(m_PhysicalDevice, nullptr, &count, extensions.data());
+
+		for(const VkExtensionProperties& properties : extensions)
+		{
+			if(strcmp(properties.extensionName, extension) == 0)
+				return true;
+		}
+		return false;
+	}
+
+	uint32 VlkPhysicalDevice::GetMemoryBudget(bool budgetExtension, MemoryHeapBudget* heaps, uint32 maxHeaps) const
+	{
+		VkPhysicalDeviceMemoryBudgetPropertiesEXT budget = {};
+		budget.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+
+		VkPhysicalDeviceMemoryProperties2 properties = {};
+		properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+		properties.pNext = budgetExtension ? &budget : nullptr;
+		vkGetPhysicalDeviceMemoryProperties2(m_PhysicalDevice, &properties);
+
+		const VkPhysicalDeviceMemoryProperties& memory = properties.memoryProperties;
+		const uint32 heapCount = memory.memoryHeapCount < maxHeaps ? memory.memoryHeapCount : maxHeaps;
+		for(uint32 i = 0; i < heapCount; ++i)
+		{
+			heaps[i].m_Budget = budgetExtension ? budget.heapBudget[i] : memory.memoryHeaps[i].size;
+			heaps[i].m_Usage = budgetExtension ? budget.heapUsage[i] : 0;
+			heaps[i].m_DeviceLocal = (memory.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) != 0;
+		}
+		return heapCount;
+	}
+
 	VkFormat VlkPhysicalDevice::FindSupportedFormat(const Core::GrowingArray<VkFormat>& formats,
 													VkImageTiling tilingOption, VkFormatFeatureFlags features)
 	{
@@ -22,6 +22,13 @@ namespace Graphics
 		int32 familyIndex = -1;
 	};
 
+	struct MemoryHeapBudget
+	{
+		uint64 m_Budget = 0; // what the process can use of the heap
+		uint64 m_Usage = 0;	 // what the process uses of it, all of its allocations and not only the tracked ones
+		bool m_DeviceLocal = false;
+	};
+
 	class VlkPhysicalDevice
 	{
 	public:
@@ -31,6 +38,9 @@ namespace Graphics
 		void Init(VlkInstance* instance);
 
 		uint32 GetQueueFamilyIndex() const { return m_QueueFamilyIndex; }
+		uint32 GetTransferFamilyIndex() const { return m_TransferFamilyIndex; }
+		uint32 GetComputeFamilyIndex() const { return m_ComputeFamilyIndex; }
+		uint32 GetQueueCount(uint32 familyIndex) const { return m_QueueProperties[familyIndex].queueCount; }
 
 		VkDevice CreateDevice(const VkDeviceCreateInfo& createInfo) const;
 
@@ -42,12 +52,22 @@ namespace Graphics
 
 		uint32 FindMemoryType(uint32 typeFilter, VkMemoryPropertyFlags flags);
 
+		bool HasExtension(const char* extension) const;
+
+		/*
+			Fills one entry per memory heap and returns the heap count. With VK_EXT_memory_budget enabled on the
+			device the budget and usage come from the driver, without it the budget is the heap size and the usage
+			is unknown.
+		*/
+		uint32 GetMemoryBudget(bool budgetExtension, MemoryHeapBudget* heaps, uint32 maxHeaps) const;
+
 		VkFormat FindSupportedFormat(const Core::GrowingArray<VkFormat>& formats, VkImageTiling tilingOption,
 									 VkFormatFeatureFlags features);
 
 		VkFormat FindDepthFormat();
 
 	private:
+		int32 FindDedicatedFamily(VkQueueFlags required, VkQueueFlags excluded) const;
 		bool SurfaceCanPresent(VkSurfaceKHR pSurface) const;
 		uint32 GetSurfacePresentModeCount(VkSurfaceKHR pSurface) const;
 		void GetSurfacePresentModes(VkSurfaceKHR pSurface, uint32 presentModeCount,
@@ -58,6 +78,8 @@ namespace Graphics
 
 		VkPhysicalDevice m_PhysicalDevice = nullptr;
 		uint32 m_QueueFamilyIndex = 0;
+		uint32 m_TransferFamilyIndex = 0;
+		uint32 m_ComputeFamilyIndex = 0;
 		uint32 m_PresentFamily = 0;
 
 		Core::GrowingArray<VkQueueFamilyProperties> m_QueueProperties;
@@ -0,0 +1,304 @@
+#include "VlkQueue.h"
+
+#include "Core/memory/MemoryTracker.h"
+#include "logger/Debug.h"
+
+namespace Graphics
+{
+	void VlkQueue::Init(VkDevice device, uint32 familyIndex, uint32 queueIndex)
+	{
+		m_Device = device;
+		m_FamilyIndex = familyIndex;
+		vkGetDeviceQueue(m_Device, familyIndex, queueIndex, &m_Queue);
+
+		VkCommandPoolCreateInfo poolCreateInfo = {};
+		poolCreateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		poolCreateInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+		poolCreateInfo.queueFamilyIndex = familyIndex;
+
+		if(vkCreateCommandPool(m_Device, &poolCreateInfo, nullptr, &m_Pool) != VK_SUCCESS)
+			ASSERT(false, "failed to create VkCommandPool!");
+	}
+
+	void VlkQueue::Destroy()
+	{
+		if(!m_Device)
+			return;
+
+		for(Submission& submission : m_Submissions)
+			vkWaitForFences(m_Device, 1, &submission.m_Fence, VK_TRUE, UINT64_MAX);
+		Collect();
+
+		for(Acquire& acquire : m_Acquires)
+			vkDestroySemaphore(m_Device, acquire.m_Semaphore, nullptr);
+
+		for(VkFence fence : m_FreeFences)
+			vkDestroyFence(m_Device, fence, nullptr);
+
+		vkDestroyCommandPool(m_Device, m_Pool, nullptr);
+
+		m_Acquires.clear();
+		m_Handovers.clear();
+		m_FreeFences.clear();
+		m_Pool = nullptr;
+		m_Device = nullptr;
+	}
+
+	VkCommandBuffer VlkQueue::BeginCommands()
+	{
+		VkCommandBufferAllocateInfo allocInfo = {};
+		allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		allocInfo.commandPool = m_Pool;
+		allocInfo.commandBufferCount = 1;
+		allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+
+		VkCommandBuffer commandBuffer = nullptr;
+		if(vkAllocateCommandBuffers(m_Device, &allocInfo, &commandBuffer) != VK_SUCCESS)
+			ASSERT(false, "Failed to create VkCommandBuffer!");
+
+		VkCommandBufferBeginInfo beginInfo = {};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+		VERIFY(vkBeginCommandBuffer(commandBuffer, &beginInfo) == VK_SUCCESS, "vkBeginCommandBuffer failed!");
+		return commandBuffer;
+	}
+
+	uint64 VlkQueue::Submit(VkCommandBuffer commandBuffer)
+	{
+		VERIFY(vkEndCommandBuffer(commandBuffer) == VK_SUCCESS, "vkEndCommandBuffer failed!");
+
+		Collect();
+		SubmitAcquires();
+
+		// every receiving queue gets its own semaphore, a binary semaphore can only be waited on once
+		std::vector<VkSemaphore> signals;
+		std::vector<VlkQueue*> destinations;
+		for(const Handover& handover : m_Handovers)
+		{
+			size_t index = 0;
+			while(index < destinations.size() && destinations[index] != handover.m_Destination)
+				++index;
+
+			if(index == destinations.size())
+			{
+				destinations.push_back(handover.m_Destination);
+				signals.push_back(CreateVkSemaphore());
+
+				Acquire acquire = {};
+				acquire.m_Semaphore = signals.back();
+				handover.m_Destination->m_Acquires.push_back(acquire);
+			}
+
+			Acquire& acquire = handover.m_Destination->m_Acquires.back();
+			acquire.m_Stage |= handover.m_Stage;
+			if(handover.m_Barrier.srcQueueFamilyIndex != handover.m_Barrier.dstQueueFamilyIndex)
+				acquire.m_Barriers.push_back(handover.m_Barrier);
+		}
+		m_Handovers.clear();
+
+		VkSubmitInfo submitInfo = {};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers = &commandBuffer;
+		submitInfo.signalSemaphoreCount = (uint32)signals.size();
+		submitInfo.pSignalSemaphores = signals.data();
+
+		return SubmitTracked(commandBuffer, submitInfo);
+	}
+
+	void VlkQueue::Submit(const VkSubmitInfo& submitInfo, VkFence fence)
+	{
+		Collect();
+		SubmitAcquires();
+
+		if(vkQueueSubmit(m_Queue, 1, &submitInfo, fence) != VK_SUCCESS)
+			ASSERT(false, "Failed to submit the queue!");
+	}
+
+	uint64 VlkQueue::SubmitTracked(VkCommandBuffer commandBuffer, const VkSubmitInfo& submitInfo)
+	{
+		Submission submission;
+		submission.m_Ticket = m_NextTicket++;
+		submission.m_Fence = GetFence();
+		submission.m_CommandBuffers.push_back(commandBuffer);
+
+		if(vkQueueSubmit(m_Queue, 1, &submitInfo, submission.m_Fence) != VK_SUCCESS)
+			ASSERT(false, "Failed to submit the queue!");
+
+		m_Submissions.push_back(submission);
+		return submission.m_Ticket;
+	}
+
+	uint64 VlkQueue::SubmitAcquires()
+	{
+		if(m_Acquires.empty())
+			return 0;
+
+		VkCommandBuffer commandBuffer = BeginCommands();
+
+		std::vector<VkSemaphore> waits;
+		std::vector<VkPipelineStageFlags> waitStages;
+		for(Acquire& acquire : m_Acquires)
+		{
+			waits.push_back(acquire.m_Semaphore);
+			waitStages.push_back(acquire.m_Stage);
+
+			if(!acquire.m_Barriers.empty())
+				vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, acquire.m_Stage, 0, 0, nullptr,
+									 (uint32)acquire.m_Barriers.size(), acquire.m_Barriers.data(), 0, nullptr);
+		}
+
+		VERIFY(vkEndCommandBuffer(commandBuffer) == VK_SUCCESS, "vkEndCommandBuffer failed!");
+
+		VkSubmitInfo submitInfo = {};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers = &commandBuffer;
+		submitInfo.waitSemaphoreCount = (uint32)waits.size();
+		submitInfo.pWaitSemaphores = waits.data();
+		submitInfo.pWaitDstStageMask = waitStages.data();
+
+		const uint64 ticket = SubmitTracked(commandBuffer, submitInfo);
+		m_Submissions.back().m_Semaphores = waits;
+		m_Acquires.clear();
+		return ticket;
+	}
+
+	void VlkQueue::ReleaseBuffer(VkCommandBuffer commandBuffer, VkBuffer buffer, VkAccessFlags srcAccess,
+								 VkPipelineStageFlags srcStage, VlkQueue* destination, VkAccessFlags dstAccess,
+								 VkPipelineStageFlags dstStage)
+	{
+		Handover handover = {};
+		handover.m_Destination = destination;
+		handover.m_Stage = dstStage;
+
+		VkBufferMemoryBarrier& barrier = handover.m_Barrier;
+		barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+		barrier.srcQueueFamilyIndex = m_FamilyIndex;
+		barrier.dstQueueFamilyIndex = destination->GetFamilyIndex();
+		barrier.buffer = buffer;
+		barrier.offset = 0;
+		barrier.size = VK_WHOLE_SIZE;
+
+		if(barrier.srcQueueFamilyIndex != barrier.dstQueueFamilyIndex)
+		{
+			// release half, the access masks of the destination are ignored here
+			barrier.srcAccessMask = srcAccess;
+			vkCmdPipelineBarrier(commandBuffer, srcStage, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 1,
+								 &barrier, 0, nullptr);
+		}
+
+		// acquire half, recorded on the destination queue
+		barrier.srcAccessMask = 0;
+		barrier.dstAccessMask = dstAccess;
+		m_Handovers.push_back(handover);
+	}
+
+	void VlkQueue::Retire(uint64 ticket, VkBuffer buffer, VkDeviceMemory memory)
+	{
+		for(Submission& submission : m_Submissions)
+		{
+			if(submission.m_Ticket != ticket)
+				continue;
+
+			submission.m_Buffers.push_back(buffer);
+			submission.m_Memory.push_back(memory);
+			return;
+		}
+
+		// already finished
+		vkDestroyBuffer(m_Device, buffer, nullptr);
+		Core::MemoryTracker::Get().OnFree((uint64)memory);
+		vkFreeMemory(m_Device, memory, nullptr);
+	}
+
+	bool VlkQueue::IsDone(uint64 ticket)
+	{
+		Collect();
+		for(const Submission& submission : m_Submissions)
+		{
+			if(submission.m_Ticket == ticket)
+				return false;
+		}
+		return true;
+	}
+
+	void VlkQueue::Wait(uint64 ticket)
+	{
+		for(Submission& submission : m_Submissions)
+		{
+			if(submission.m_Ticket == ticket)
+			{
+				vkWaitForFences(m_Device, 1, &submission.m_Fence, VK_TRUE, UINT64_MAX);
+				break;
+			}
+		}
+		Collect();
+	}
+
+	void VlkQueue::Collect()
+	{
+		size_t keep = 0;
+		for(size_t i = 0; i < m_Submissions.size(); ++i)
+		{
+			Submission& submission = m_Submissions[i];
+			if(vkGetFenceStatus(m_Device, submission.m_Fence) != VK_SUCCESS)
+			{
+				if(keep != i)
+					m_Submissions[keep] = std::move(submission);
+				++keep;
+				continue;
+			}
+
+			vkFreeCommandBuffers(m_Device, m_Pool, (uint32)submission.m_CommandBuffers.size(),
+								 submission.m_CommandBuffers.data());
+
+			for(VkSemaphore semaphore : submission.m_Semaphores)
+				vkDestroySemaphore(m_Device, semaphore, nullptr);
+
+			for(VkBuffer buffer : submission.m_Buffers)
+				vkDestroyBuffer(m_Device, buffer, nullptr);
+
+			for(VkDeviceMemory memory : submission.m_Memory)
+			{
+				Core::MemoryTracker::Get().OnFree((uint64)memory);
+				vkFreeMemory(m_Device, memory, nullptr);
+			}
+
+			vkResetFences(m_Device, 1, &submission.m_Fence);
+			m_FreeFences.push_back(submission.m_Fence);
+		}
+		m_Submissions.resize(keep);
+	}
+
+	VkFence VlkQueue::GetFence()
+	{
+		if(!m_FreeFences.empty())
+		{
+			VkFence fence = m_FreeFences.back();
+			m_FreeFences.pop_back();
+			return fence;
+		}
+
+		VkFenceCreateInfo fenceCreateInfo = {};
+		fenceCreateInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+		VkFence fence = nullptr;
+		if(vkCreateFence(m_Device, &fenceCreateInfo, nullptr, &fence) != VK_SUCCESS)
+			ASSERT(false, "Failed to create fence!");
+		return fence;
+	}
+
+	VkSemaphore VlkQueue::CreateVkSemaphore()
+	{
+		VkSemaphore semaphore = nullptr;
+		VkSemaphoreCreateInfo semaphoreCreateInfo = {};
+		semaphoreCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+		if(vkCreateSemaphore(m_Device, &semaphoreCreateInfo, nullptr, &semaphore) != VK_SUCCESS)
+			ASSERT(false, "Failed to create VkSemaphore");
+
+		return semaphore;
+	}
+
+}; // namespace Graphics
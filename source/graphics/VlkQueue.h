@@ -0,0 +1,95 @@
+#pragma once
+#include "Core/Types.h"
+#include "Core/Defines.h"
+
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+DEFINE_HANDLE(VkDevice);
+DEFINE_HANDLE(VkQueue);
+
+namespace Graphics
+{
+	/*
+		A device queue together with the command pool that records for it.
+
+		Submissions are tracked with fences and identified by a ticket, command buffers and retired resources are
+		recycled once the fence of their submission has signaled, instead of draining the queue with vkQueueWaitIdle.
+
+		Buffers moving to another queue are released with ReleaseBuffer, the matching acquire barrier and the semaphore
+		wait are injected in front of the next submission on the receiving queue. When both queues share a family no
+		ownership transfer is needed and only the semaphore is kept to order the two queues.
+	*/
+	class VlkQueue
+	{
+	public:
+		VlkQueue() = default;
+		~VlkQueue() = default;
+
+		void Init(VkDevice device, uint32 familyIndex, uint32 queueIndex);
+		void Destroy();
+
+		VkQueue GetQueue() const { return m_Queue; }
+		uint32 GetFamilyIndex() const { return m_FamilyIndex; }
+
+		/* one time command buffer allocated from this queue's pool, hand it back with Submit */
+		VkCommandBuffer BeginCommands();
+		uint64 Submit(VkCommandBuffer commandBuffer);
+
+		/* submits externally owned command buffers, pending acquires from other queues are submitted first */
+		void Submit(const VkSubmitInfo& submitInfo, VkFence fence);
+
+		void ReleaseBuffer(VkCommandBuffer commandBuffer, VkBuffer buffer, VkAccessFlags srcAccess,
+						   VkPipelineStageFlags srcStage, VlkQueue* destination, VkAccessFlags dstAccess,
+						   VkPipelineStageFlags dstStage);
+
+		/* the buffer and memory are destroyed once the submission with the ticket has finished */
+		void Retire(uint64 ticket, VkBuffer buffer, VkDeviceMemory memory);
+
+		bool IsDone(uint64 ticket);
+		void Wait(uint64 ticket);
+		void Collect();
+
+	private:
+		struct Submission
+		{
+			uint64 m_Ticket = 0;
+			VkFence m_Fence = nullptr;
+			std::vector<VkCommandBuffer> m_CommandBuffers;
+			std::vector<VkSemaphore> m_Semaphores;
+			std::vector<VkBuffer> m_Buffers;
+			std::vector<VkDeviceMemory> m_Memory;
+		};
+
+		struct Handover
+		{
+			VkBufferMemoryBarrier m_Barrier;
+			VkPipelineStageFlags m_Stage;
+			VlkQueue* m_Destination;
+		};
+
+		struct Acquire
+		{
+			VkSemaphore m_Semaphore;
+			VkPipelineStageFlags m_Stage;
+			std::vector<VkBufferMemoryBarrier> m_Barriers;
+		};
+
+		uint64 SubmitTracked(VkCommandBuffer commandBuffer, const VkSubmitInfo& submitInfo);
+		uint64 SubmitAcquires();
+		VkFence GetFence();
+		VkSemaphore CreateVkSemaphore();
+
+		VkDevice m_Device = nullptr;
+		VkQueue m_Queue = nullptr;
+		VkCommandPool m_Pool = nullptr;
+		uint32 m_FamilyIndex = 0;
+		uint64 m_NextTicket = 1;
+
+		std::vector<Submission> m_Submissions;
+		std::vector<VkFence> m_FreeFences;
+		std::vector<Handover> m_Handovers;
+		std::vector<Acquire> m_Acquires;
+	};
+
+}; // namespace Graphics
@@ -11,9 +11,16 @@
 #include "Utilities.h"
 #include "Window.h"
 
-#include "Core/File.h"
+#include "Core/MappedFile.h"
+#include "Core/Timer.h"
+#include "Core/ecs/World.h"
 #include "Core/math/Matrix44.h"
+#include "Core/memory/FrameMemory.h"
+#include "Core/memory/MemoryTracker.h"
+#include "Core/memory/Pool.h"
 #include "Core/utilities/Randomizer.h"
+#include "Core/profiler/Profiler.h"
+#include "Core/threading/ThreadPool.h"
 #include "Input/InputManager.h"
 #include "input/InputDeviceMouse_Win32.h"
 #include "input/InputDeviceKeyboard_Win32.h"
@@ -21,7 +28,19 @@
 #include "logger/Debug.h"
 
 #include "Cube.h"
-
+#include "HiZPyramid.h"
+#include "LightClusters.h"
+#include "MemoryView.h"
+#include "OcclusionBuffer.h"
+#include "PipelineLayoutCache.h"
+#include "ProfilerView.h"
+#include "RenderPacket.h"
+#include "RenderQueue.h"
+#include "SceneComponents.h"
+#include "ShaderReflection.h"
+
+#include <cfloat>
+#include <mutex>
 #include <windows.h>
 #include <vulkan/vulkan.h>
 #include <vulkan/vulkan_win32.h>
@@ -46,16 +65,59 @@ VkImage _depthImage = nullptr;
 VkImageView _depthView = nullptr;
 VkDeviceMemory _depthImageMemory = nullptr;
 
+// depth pre-pass and the hierarchical depth built from the depth of the frame
+VkRenderPass _depthRenderPass = nullptr;
+VkFramebuffer _depthFramebuffer = nullptr;
+
+constexpr uint32 _MaxHiZLevels = 16;
+VkImage _HiZImage = nullptr;
+VkDeviceMemory _HiZMemory = nullptr;
+std::vector<VkImageView> _HiZViews; // one per level
+VkPipeline _HiZPipeline = nullptr;
+VkPipelineLayout _HiZLayout = nullptr; // owned by _LayoutCache
+VkDescriptorPool _HiZDescriptorPool = nullptr;
+std::vector<VkDescriptorSet> _HiZSets; // level i reads level i - 1, the first level reads the depth buffer
+VkBuffer _HiZReadback = nullptr;
+VkDeviceMemory _HiZReadbackMemory = nullptr;
+
 Graphics::Camera _Camera;
+constexpr float _NearPlane = 0.1f;
+constexpr float _FarPlane = 1000.f;
 
 Window::Size _size;
 
 Core::Vector4f _LightDir;
 Core::Matrix44f _LightObject = Core::Matrix44f::Identity();
 
+// the simulation runs at a fixed rate, frames blend the last two steps. The camera only turns per frame, the mouse
+// delta belongs to the frame, but it moves per step.
+Core::Vector4f _PreviousLightDir;
+Core::Vector4f _CameraPosition;
+Core::Vector4f _PreviousCameraPosition;
+bool _TransformsMoving = false; // the last step moved something, the previous and current worlds differ
+bool _TransformsStale = true;	// the blended worlds have to be written again
+
+// the render thread's copy of the frame it records, the constant buffer is filled from these
+Core::Matrix44f _FrameViewProjection = Core::Matrix44f::Identity();
+Core::Matrix44f _FrameView = Core::Matrix44f::Identity();
+Core::Vector4f _FrameLightDir;
+
+// clustered forward lighting, the lights are binned on the CPU every frame and read by frag.hlsl
+constexpr uint32 _LightCount = 1024;
+constexpr uint32 _MaxLightIndices = 1 << 18;
+Graphics::LightClusters _LightClusters;
+std::vector<Graphics::Light> _Lights;
+std::vector<Graphics::Light> _PreviousLights;
+std::vector<float> _LightPhases;
+float _LightTime = 0.f;
+Core::Vector4f _ClusterParams; // clusters per pixel in x and y, depth slice scale and bias
+uint32 _ClusterSize[4] = { Graphics::LightClusters::s_ClustersX, Graphics::LightClusters::s_ClustersY,
+						   Graphics::LightClusters::s_Slices, 0 };
+
 struct Shader
 {
 	VkShaderModule m_Module = nullptr;
+	Graphics::ShaderReflection m_Reflection;
 	void Create(VkShaderModule module) { m_Module = module; }
 	VkShaderModule GetModule() { return m_Module; }
 };
@@ -63,7 +125,78 @@ struct Shader
 Shader _vertexShader;
 Shader _fragmentShader;
 
-std::vector<Cube> _Cubes;
+Graphics::PipelineLayoutCache _LayoutCache;
+
+// resources handed out through the IGraphicsDevice interface
+struct BufferSlot
+{
+	VkBuffer m_Buffer = nullptr;
+	VkDeviceMemory m_Memory = nullptr;
+	uint32 m_Size = 0;
+	bool m_HostVisible = false;
+};
+
+struct PipelineSlot
+{
+	VkPipeline m_Pipeline = nullptr;
+	VkPipelineLayout m_Layout = nullptr; // owned by _LayoutCache
+	VkShaderStageFlags m_PushStages = 0;
+};
+
+Core::Pool<BufferSlot> _Buffers;
+Core::Pool<PipelineSlot> _Pipelines;
+
+// every cube entity shares the one mesh
+Cube _CubeMesh;
+Core::World _World;
+Core::Query* _Renderables = nullptr;
+Core::TransformHierarchy _Transforms;
+Graphics::HPipeline _CubePipeline = 0;
+Graphics::RenderQueue _RenderQueue;
+Core::ThreadPool _Workers;
+
+Graphics::OcclusionBuffer _Occlusion;
+uint32 _CulledCubes = 0;
+uint32 _OccludeeCount = 0; // the entities _Renderables matched in the last cull
+
+Graphics::HPipeline _DepthPipeline = 0;
+Graphics::HiZPyramid _HiZ;
+bool _DepthPrepass = true;
+bool _HiZCulling = true;
+bool _HiZRecorded = false; // the frame in flight copies its pyramid into _HiZReadback
+uint32 _HiZCulledCubes = 0;
+Core::Matrix44f _HiZViewProjection = Core::Matrix44f::Identity(); // of the frame the pyramid was built from
+
+Graphics::HBuffer _LightBuffer = 0;
+Graphics::HBuffer _ClusterBuffer = 0;
+Graphics::HBuffer _LightIndexBuffer = 0;
+
+float _RecordTrampolineMs = 0.f;
+float _RecordTableMs = 0.f;
+
+// ImGui is built on the game thread, its draw lists are cloned per packet for the render thread to record
+struct ImGuiFrame
+{
+	ImDrawData m_DrawData;
+	std::vector<ImDrawList*> m_Lists;
+};
+ImGuiFrame _ImGuiFrames[Graphics::RenderPacketQueue::s_MaxPackets];
+
+// written by the render thread at the end of a frame, shown by the game thread
+struct RenderStats
+{
+	Graphics::RenderQueue::Stats m_Queue;
+	uint32 m_HiZCulled = 0;
+	uint32 m_VisibleLights = 0;
+	uint32 m_LightIndices = 0;
+	uint32 m_DroppedLights = 0;
+	float m_RecordTrampolineMs = 0.f;
+	float m_RecordTableMs = 0.f;
+};
+std::mutex _RenderStatsLock;
+RenderStats _RenderStats;
+Core::Timer _RenderTimer;
+uint64 _GameFrame = 0;
 
 namespace Graphics
 {
@@ -77,6 +210,102 @@ namespace Graphics
 		int32 m_Offset = 0;
 	};
 
+	VkShaderStageFlags GetPushConstantStages(const ShaderReflection* const* stages, uint32 stageCount)
+	{
+		VkShaderStageFlags flags = 0;
+		for(uint32 i = 0; i < stageCount; ++i)
+		{
+			for(const VkPushConstantRange& range : stages[i]->m_PushConstants)
+				flags |= range.stageFlags;
+		}
+		return flags;
+	}
+
+	VkBufferUsageFlags ConvertBindFlags(uint32 bindFlags)
+	{
+		VkBufferUsageFlags usage = 0;
+		if(bindFlags & BIND_VERTEX_BUFFER)
+			usage |= VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
+		if(bindFlags & BIND_INDEX_BUFFER)
+			usage |= VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
+		if(bindFlags & BIND_CONSTANT_BUFFER)
+			usage |= VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
+		if(bindFlags & (BIND_SHADER_RESOURCE | BIND_UNORDERED_ACCESS))
+			usage |= VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+		return usage;
+	}
+
+	VkPrimitiveTopology ConvertTopology(ETopology topology)
+	{
+		switch(topology)
+		{
+			case POINT_LIST:
+				return VK_PRIMITIVE_TOPOLOGY_POINT_LIST;
+			case LINE_LIST:
+				return VK_PRIMITIVE_TOPOLOGY_LINE_LIST;
+			case _4_CONTROL_POINT_PATCHLIST:
+				return VK_PRIMITIVE_TOPOLOGY_PATCH_LIST;
+			default:
+				return VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+		}
+	}
+
+	// access and pipeline stages a buffer is touched by in each EResourceState
+	struct ResourceAccess
+	{
+		VkAccessFlags m_Access;
+		VkPipelineStageFlags m_Stages;
+	};
+
+	constexpr VkPipelineStageFlags _ShaderStages =
+		VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+
+	const ResourceAccess _ResourceAccess[] = {
+		{ 0, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT },									 // EResourceState_Undefined
+		{ VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT }, // EResourceState_VertexBuffer
+		{ VK_ACCESS_INDEX_READ_BIT, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT },			 // EResourceState_IndexBuffer
+		{ VK_ACCESS_UNIFORM_READ_BIT, _ShaderStages },								 // EResourceState_ConstantBuffer
+		{ VK_ACCESS_SHADER_READ_BIT, _ShaderStages },								 // EResourceState_ShaderRead
+		{ VK_ACCESS_SHADER_WRITE_BIT, _ShaderStages },								 // EResourceState_ShaderWrite
+		{ VK_ACCESS_TRANSFER_READ_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT },			 // EResourceState_CopySource
+		{ VK_ACCESS_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT },			 // EResourceState_CopyDest
+	};
+
+	// what the first use of a freshly uploaded buffer has to wait for
+	ResourceAccess GetBindAccess(uint32 bindFlags)
+	{
+		ResourceAccess access = { 0, 0 };
+		const EResourceState states[] = { EResourceState_VertexBuffer, EResourceState_IndexBuffer,
+										  EResourceState_ConstantBuffer, EResourceState_ShaderRead };
+		const uint32 flags[] = { BIND_VERTEX_BUFFER, BIND_INDEX_BUFFER, BIND_CONSTANT_BUFFER,
+								 BIND_SHADER_RESOURCE | BIND_UNORDERED_ACCESS };
+
+		for(uint32 i = 0; i < ARRSIZE(states); ++i)
+		{
+			if(bindFlags & flags[i])
+			{
+				access.m_Access |= _ResourceAccess[states[i]].m_Access;
+				access.m_Stages |= _ResourceAccess[states[i]].m_Stages;
+			}
+		}
+
+		if(access.m_Stages == 0)
+			access = { VK_ACCESS_MEMORY_READ_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT };
+		return access;
+	}
+
+	Core::Vector4f Blend(const Core::Vector4f& previous, const Core::Vector4f& current, float alpha)
+	{
+		return previous + (current - previous) * alpha;
+	}
+
+	// a step only moves things a little, blending element wise stays close enough to a rotation
+	void Blend(const Core::Matrix44f& previous, const Core::Matrix44f& current, float alpha, Core::Matrix44f* out)
+	{
+		for(uint32 i = 0; i < 16; ++i)
+			(*out)[i] = previous[i] + (current[i] - previous[i]) * alpha;
+	}
+
 	vkGraphicsDevice::vkGraphicsDevice() = default;
 
 	vkGraphicsDevice::~vkGraphicsDevice()
@@ -85,14 +314,34 @@ namespace Graphics
 		auto device = m_LogicalDevice->GetDevice();
 		DestroyConstantBuffer(&_ViewProjection);
 
-		for(Cube& cube : _Cubes)
-			cube.Destroy(m_LogicalDevice->GetDevice());
-
-		DestroyShader(&_vertexShader);
-		DestroyShader(&_fragmentShader);
-
-		vkDestroyPipelineLayout(device, _pipelineLayout, nullptr);
-		vkDestroyPipeline(device, _pipeline, nullptr);
+		_CubeMesh.Destroy(this);
+
+		_Buffers.ForEach([this, device](HBuffer, BufferSlot& slot) {
+			vkDestroyBuffer(device, slot.m_Buffer, nullptr);
+			m_LogicalDevice->FreeMemory(slot.m_Memory);
+		});
+		_Buffers.Clear();
+
+		_Pipelines.ForEach(
+			[device](HPipeline, PipelineSlot& slot) { vkDestroyPipeline(device, slot.m_Pipeline, nullptr); });
+		_Pipelines.Clear();
+
+		vkDestroyPipeline(device, _HiZPipeline, nullptr);
+		for(VkImageView view : _HiZViews)
+			vkDestroyImageView(device, view, nullptr);
+		vkDestroyImage(device, _HiZImage, nullptr);
+		m_LogicalDevice->FreeMemory(_HiZMemory);
+		vkDestroyBuffer(device, _HiZReadback, nullptr);
+		m_LogicalDevice->FreeMemory(_HiZReadbackMemory);
+		vkDestroyImageView(device, _depthView, nullptr);
+		vkDestroyImage(device, _depthImage, nullptr);
+		m_LogicalDevice->FreeMemory(_depthImageMemory);
+		vkDestroyDescriptorPool(device, _HiZDescriptorPool, nullptr);
+		vkDestroyFramebuffer(device, _depthFramebuffer, nullptr);
+		vkDestroyRenderPass(device, _depthRenderPass, nullptr);
+
+		_LayoutCache.Destroy();
+		_Workers.Destroy();
 
 		vkDestroySemaphore(device, m_DrawDone, nullptr);
 		vkDestroySemaphore(device, m_AcquireNextImageSemaphore, nullptr);
@@ -101,6 +350,12 @@ namespace Graphics
 		for(VkFramebuffer buffer : m_FrameBuffers)
 			vkDestroyFramebuffer(device, buffer, nullptr);
 
+		for(ImGuiFrame& frame : _ImGuiFrames)
+		{
+			for(ImDrawList* list : frame.m_Lists)
+				IM_DELETE(list);
+		}
+
 		ImGui_ImplVulkan_DestroyFontUploadObjects();
 		ImGui::DestroyContext();
 		ImGui_ImplWin32_Shutdown();
@@ -115,8 +370,12 @@ namespace Graphics
 	bool vkGraphicsDevice::Init(const Window& window)
 	{
 		_size = window.GetInnerSize();
-		_Camera.InitPerspectiveProjection(_size.m_Width, _size.m_Height, 0.1f, 1000.f, 90.f);
+		_Camera.InitPerspectiveProjection(_size.m_Width, _size.m_Height, _NearPlane, _FarPlane, 90.f);
 		_Camera.SetTranslation({ 0.f, 0.f, -25.f, 1.f });
+		_CameraPosition = _Camera.GetPosition();
+		_PreviousCameraPosition = _CameraPosition;
+		_LightDir = _LightObject.GetForward();
+		_PreviousLightDir = _LightDir;
 
 		m_Instance = new VlkInstance();
 		m_Instance->Init();
@@ -132,8 +391,11 @@ namespace Graphics
 
 		//_ViewProjection.RegVar(_Camera.GetView());
 		//_ViewProjection.RegVar(_Camera.GetProjection());
-		_ViewProjection.RegVar(_Camera.GetViewProjectionPointer());
-		_ViewProjection.RegVar(&_LightDir);
+		_ViewProjection.RegVar(&_FrameViewProjection);
+		_ViewProjection.RegVar(&_FrameLightDir);
+		_ViewProjection.RegVar(&_FrameView);
+		_ViewProjection.RegVar(&_ClusterParams);
+		_ViewProjection.RegVar(&_ClusterSize);
 
 		CreateConstantBuffer(&_ViewProjection);
 		CreateCommandPool();
@@ -146,6 +408,8 @@ namespace Graphics
 
 		CreateDepthResources();
 		_renderPass = CreateRenderPass();
+		_depthRenderPass = CreateDepthRenderPass();
+		_depthFramebuffer = CreateFramebuffer(_depthRenderPass, &_depthView, 1, window);
 
 		m_FrameBuffers.resize(m_Swapchain->GetNofImages());
 		auto& list = m_Swapchain->GetImageList();
@@ -155,7 +419,7 @@ namespace Graphics
 			viewList[i] = CreateImageView(m_Swapchain->GetFormat().format, list[i], VK_IMAGE_ASPECT_COLOR_BIT);
 
 			VkImageView views[] = { viewList[i], _depthView };
-			m_FrameBuffers[i] = CreateFramebuffer(views, ARRSIZE(views), window);
+			m_FrameBuffers[i] = CreateFramebuffer(_renderPass, views, ARRSIZE(views), window);
 		}
 
 		LoadShader(&_vertexShader, "Data/Shaders/vertex.vert");
@@ -164,29 +428,73 @@ namespace Graphics
 		CreateViewport(0.f, 0.f, _size.m_Width, _size.m_Height, 0.f, 1.f, &_Viewport);
 		SetupScissorArea((uint32)_size.m_Width, (uint32)_size.m_Height, 0, 0, &_Scissor);
 
-		VkDescriptorSetLayoutBinding uboLayoutBinding = {};
-		uboLayoutBinding.binding = 0;
-		uboLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-		uboLayoutBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
-		uboLayoutBinding.descriptorCount = 1;
+		// descriptor bindings and push constants are taken from the shaders themselves
+		_LayoutCache.Init(m_LogicalDevice->GetDevice());
+		const ShaderReflection* stages[] = { &_vertexShader.m_Reflection, &_fragmentShader.m_Reflection };
+		const PipelineLayout& layout = _LayoutCache.GetLayout(stages, ARRSIZE(stages));
+		ASSERT(!layout.m_SetLayouts.empty(), "Shaders do not declare the view projection constant buffer!");
 
-		VkDescriptorSetLayoutBinding bindings[] = {
-			uboLayoutBinding,
-		};
+		_descriptorLayout = layout.m_SetLayouts[0];
+		_pipelineLayout = layout.m_Layout;
 
-		_descriptorLayout = CreateDescriptorLayout(bindings, ARRSIZE(bindings));
+		std::vector<VkVertexInputAttributeDescription> attributes;
+		ASSERT(BuildVertexInputLayout(_vertexShader.m_Reflection, &attributes) == sizeof(Vertex),
+			   "Vertex shader inputs do not match the Vertex layout!");
 
-		VkDescriptorSetLayout descriptorLayouts[] = {
-			_descriptorLayout,
-		};
+		CreateDescriptorPool();
+		CreateDescriptorSet();
+		CreateLightResources();
 
-		VkPushConstantRange pushRangeList[] = {
-			{ VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(Core::Matrix44f) + sizeof(Core::Vector4f) },
-		};
+		VkDescriptorBufferInfo bInfo2 = {};
+		bInfo2.buffer = static_cast<VkBuffer>(_ViewProjection.GetBuffer());
+		bInfo2.offset = 0;
+		bInfo2.range = _ViewProjection.GetSize();
+
+		// lights, clusters and light indices follow the constant buffer
+		const HBuffer lightBuffers[] = { _LightBuffer, _ClusterBuffer, _LightIndexBuffer };
+		VkDescriptorBufferInfo lightInfos[ARRSIZE(lightBuffers)] = {};
+		VkWriteDescriptorSet descWrites[1 + ARRSIZE(lightBuffers)] = {};
+
+		descWrites[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		descWrites[0].dstSet = _descriptorSet;
+		descWrites[0].dstBinding = 0;
+		descWrites[0].dstArrayElement = 0;
+		descWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+		descWrites[0].descriptorCount = 1;
+		descWrites[0].pBufferInfo = &bInfo2;
+
+		for(uint32 i = 0; i < ARRSIZE(lightBuffers); ++i)
+		{
+			lightInfos[i].buffer = _Buffers.Get(lightBuffers[i])->m_Buffer;
+			lightInfos[i].offset = 0;
+			lightInfos[i].range = VK_WHOLE_SIZE;
+
+			descWrites[i + 1] = descWrites[0];
+			descWrites[i + 1].dstBinding = i + 1;
+			descWrites[i + 1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+			descWrites[i + 1].pBufferInfo = &lightInfos[i];
+		}
 
-		_pipelineLayout =
-			CreatePipelineLayout(descriptorLayouts, ARRSIZE(descriptorLayouts), pushRangeList, ARRSIZE(pushRangeList));
-		_pipeline = CreateGraphicsPipeline();
+		vkUpdateDescriptorSets(m_LogicalDevice->GetDevice(), ARRSIZE(descWrites), descWrites, 0, nullptr);
+
+		_pipeline = CreateGraphicsPipeline(&_vertexShader, &_fragmentShader, _pipelineLayout, PipelineDesc());
+
+		// the cubes are drawn through the render queue, which binds pipelines by handle
+		PipelineSlot cubePipeline;
+		cubePipeline.m_Pipeline = _pipeline;
+		cubePipeline.m_Layout = _pipelineLayout;
+		cubePipeline.m_PushStages = GetPushConstantStages(stages, ARRSIZE(stages));
+		_CubePipeline = _Pipelines.Create(cubePipeline);
+
+		// the same vertex shader without a fragment stage, it only lays down the depth in the pre-pass
+		PipelineSlot depthPipeline = cubePipeline;
+		depthPipeline.m_Pipeline = CreateGraphicsPipeline(&_vertexShader, nullptr, _pipelineLayout, PipelineDesc());
+		_DepthPipeline = _Pipelines.Create(depthPipeline);
+
+		DestroyShader(&_vertexShader);
+		DestroyShader(&_fragmentShader);
+
+		CreateHiZResources();
 
 		m_AcquireNextImageSemaphore = CreateVkSemaphore(m_LogicalDevice->GetDevice());
 		m_DrawDone = CreateVkSemaphore(m_LogicalDevice->GetDevice());
@@ -196,12 +504,22 @@ namespace Graphics
 		const float zValue = 0.f;
 		Core::Vector4f position{ xValue, yValue, zValue, 1.f };
 
+		// a low resolution is plenty to find what is hidden
+		_Occlusion.Init(256, 144);
+
+		_CubeMesh.Init(this);
+		_Renderables = _World.CreateQuery<Graphics::Transform, Graphics::MeshInstance>();
+		const Core::TransformId grid = _Transforms.Create();
 		for(int i = 0; i < 128; i++)
 		{
-			_Cubes.push_back(Cube());
-			Cube& last = _Cubes.back();
-			last.Init(m_LogicalDevice, m_PhysicalDevice);
-			last.SetPosition(position);
+			Graphics::Transform transform;
+			transform.m_World = Core::Matrix44f::Identity();
+			transform.m_Node = _Transforms.Create(grid);
+			_Transforms.SetPosition(transform.m_Node, position);
+
+			Graphics::MeshInstance instance;
+			instance.m_Mesh = &_CubeMesh;
+			_World.CreateEntity(transform, instance);
 
 			position.x += 5.f;
 			if(i % 10 == 0 && i != 0)
@@ -210,14 +528,28 @@ namespace Graphics
 				position.x = xValue;
 			}
 		}
+		m_LogicalDevice->FlushUploads();
+
+		_Workers.Init();
 
+		// the first step blends from where the cubes already are
+		_Transforms.Update(&_Workers);
+		_World.ForEach<Graphics::Transform>(_Renderables, [](Graphics::Transform& transform) {
+			transform.m_Current = _Transforms.GetWorld(transform.m_Node);
+			transform.m_Previous = transform.m_Current;
+			transform.m_World = transform.m_Current;
+		});
+
+		// signaled, the first frame has nothing to wait for
 		VkFenceCreateInfo fenceCreateInfo = {};
 		fenceCreateInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+		fenceCreateInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
 
 		if(vkCreateFence(m_LogicalDevice->GetDevice(), &fenceCreateInfo, nullptr, &m_CommandFence) != VK_SUCCESS)
 			ASSERT(false, "Failed to create fence!");
 
 		SetupImGui();
+		_RenderTimer.Init();
 
 		return true;
 	}
@@ -234,8 +566,52 @@ namespace Graphics
 
 	//_____________________________________________
 
-	void vkGraphicsDevice::DrawFrame(float dt)
+	void vkGraphicsDevice::Simulate(float step)
 	{
+		PROFILE_FUNCTION();
+
+		_PreviousLightDir = _LightDir;
+		_LightObject = _LightObject * Core::Matrix44f::CreateRotateAroundX(Core::DegreeToRad(45.f) * step);
+		_LightDir = _LightObject.GetForward();
+
+		Input::IInputDevice* keyboard = nullptr;
+		Input::InputManager::Get().GetDevice(Input::EDeviceType_Keyboard, &keyboard);
+		const float speed = 10.f;
+
+		// the last frame left the camera at a blended position, the step carries on from the simulated one
+		_Camera.SetTranslation(_CameraPosition);
+		if(keyboard->IsDown(DIK_W))
+			_Camera.Forward(speed * step);
+		if(keyboard->IsDown(DIK_S))
+			_Camera.Forward(-speed * step);
+
+		if(keyboard->IsDown(DIK_D))
+			_Camera.Right(speed * step);
+		if(keyboard->IsDown(DIK_A))
+			_Camera.Right(-speed * step);
+
+		if(keyboard->IsDown(DIK_R))
+			_Camera.Up(speed * step);
+		if(keyboard->IsDown(DIK_F))
+			_Camera.Up(-speed * step);
+
+		_PreviousCameraPosition = _CameraPosition;
+		_CameraPosition = _Camera.GetPosition();
+
+		_PreviousLights = _Lights;
+		UpdateLights(step);
+		UpdateTransforms();
+	}
+
+	void vkGraphicsDevice::BuildFrame(float dt, float alpha, RenderPacket* packet, uint32 packetIndex)
+	{
+		PROFILE_FUNCTION();
+
+		RenderStats stats;
+		{
+			std::lock_guard<std::mutex> lock(_RenderStatsLock);
+			stats = _RenderStats;
+		}
 
 		ImGui_ImplVulkan_NewFrame();
 		ImGui_ImplWin32_NewFrame();
@@ -244,56 +620,124 @@ namespace Graphics
 		// static bool show_demo_window = true;
 		// ImGui::ShowDemoWindow(&show_demo_window);
 
+		packet->m_BenchmarkRecording = false;
 		ImGui::SetNextWindowSize(ImVec2(_size.m_Width * 0.15f, _size.m_Height * 0.25f));
 		if(ImGui::Begin("blank", 0, ImGuiWindowFlags_NoCollapse | ImGuiWindowFlags_NoResize))
 		{
 			ImGui::Text("LightDir: X: %.3f Y: %.3f Z: %.3f", _LightDir.x, _LightDir.y, _LightDir.z);
+			if(ImGui::Button("Benchmark recording"))
+				packet->m_BenchmarkRecording = true;
+			ImGui::Text("Loader: %.3f ms Table: %.3f ms", stats.m_RecordTrampolineMs, stats.m_RecordTableMs);
+
+			const RenderQueue::Stats& queueStats = stats.m_Queue;
+			ImGui::Text("Draws: %u Sort: %.3f ms", queueStats.m_Draws, queueStats.m_SortMs);
+			ImGui::Text("Triangles: %u", queueStats.m_Triangles);
+			ImGui::Text("Changes pipeline: %u mesh: %u", queueStats.m_PipelineChanges, queueStats.m_MeshChanges);
+			ImGui::Text("Occlusion culled: %u / %u", _CulledCubes, _OccludeeCount);
+			ImGui::Checkbox("Depth pre-pass", &_DepthPrepass);
+			ImGui::Checkbox("Hi-Z culling", &_HiZCulling);
+			ImGui::Text("Hi-Z culled: %u", stats.m_HiZCulled);
+			ImGui::Text("Lights: %u / %u indices: %u dropped: %u", stats.m_VisibleLights, (uint32)_Lights.size(),
+						stats.m_LightIndices, stats.m_DroppedLights);
 			ImGui::End();
 		}
 
+		DrawProfilerWindow(_size.m_Width * 0.5f, _size.m_Height * 0.3f);
+
+		// the driver's heap budgets are the budgets of the GPU tags
+		MemoryHeapBudget heaps[VK_MAX_MEMORY_HEAPS];
+		const uint32 heapCount =
+			m_PhysicalDevice->GetMemoryBudget(m_LogicalDevice->HasMemoryBudget(), heaps, VK_MAX_MEMORY_HEAPS);
+		uint64 deviceLocalBudget = 0;
+		uint64 hostVisibleBudget = 0;
+		for(uint32 i = 0; i < heapCount; ++i)
+			(heaps[i].m_DeviceLocal ? deviceLocalBudget : hostVisibleBudget) += heaps[i].m_Budget;
+		Core::MemoryTracker::Get().SetBudget(Core::EMemoryTag_GpuDeviceLocal, deviceLocalBudget);
+		Core::MemoryTracker::Get().SetBudget(Core::EMemoryTag_GpuHostVisible, hostVisibleBudget);
+		DrawMemoryWindow(_size.m_Width * 0.4f, _size.m_Height * 0.3f, heaps, heapCount);
+
 		ImGui::Render();
 
-		_LightObject = _LightObject * Core::Matrix44f::CreateRotateAroundX(Core::DegreeToRad(45.f) * dt);
-		_LightDir = _LightObject.GetForward();
+		// the render thread is done with this packet and its draw lists
+		ImGuiFrame& imguiFrame = _ImGuiFrames[packetIndex];
+		for(ImDrawList* list : imguiFrame.m_Lists)
+			IM_DELETE(list);
+		imguiFrame.m_Lists.clear();
 
-		if(vkAcquireNextImageKHR(m_LogicalDevice->GetDevice(), m_Swapchain->GetSwapchain(), UINT64_MAX,
-								 m_AcquireNextImageSemaphore, VK_NULL_HANDLE /*fence*/, &m_Index) != VK_SUCCESS)
-			ASSERT(false, "Failed to acquire next image!");
+		const ImDrawData* drawData = ImGui::GetDrawData();
+		for(int i = 0; i < drawData->CmdListsCount; ++i)
+			imguiFrame.m_Lists.push_back(drawData->CmdLists[i]->CloneOutput());
+		imguiFrame.m_DrawData = *drawData;
+		imguiFrame.m_DrawData.CmdLists = imguiFrame.m_Lists.data();
 
-		Input::InputManager& input = Input::InputManager::Get();
+		Input::IInputDevice* mouse = nullptr;
+		Input::InputManager::Get().GetDevice(Input::EDeviceType_Mouse, &mouse);
+		if(mouse->IsDown(1))
+		{
+			const Input::Cursor& cursor = mouse->GetCursor();
+			_Camera.OrientCamera({ cursor.dx, cursor.dy });
+		}
 
-		Input::HInputDeviceMouse* mouse = nullptr;
-		input.GetDevice(Input::EDeviceType_Mouse, &mouse);
+		_Camera.SetTranslation(Blend(_PreviousCameraPosition, _CameraPosition, alpha));
+		_Camera.Update();
 
-		const Input::Cursor& cursor = mouse->GetCursor();
+		Core::Vector4f lightDir = Blend(_PreviousLightDir, _LightDir, alpha);
+		Core::Normalize(lightDir);
+
+		packet->m_Frame = ++_GameFrame;
+		packet->m_DeltaTime = dt;
+		packet->m_View = *_Camera.GetView();
+		packet->m_ViewProjection = *_Camera.GetViewProjectionPointer();
+		packet->m_LightDir = lightDir;
+		packet->m_Lights.assign(_Lights.begin(), _Lights.end());
+		for(uint32 i = 0; i < (uint32)_Lights.size(); ++i)
+			packet->m_Lights[i].m_Position = Blend(_PreviousLights[i].m_Position, _Lights[i].m_Position, alpha);
+		packet->m_DepthPrepass = _DepthPrepass;
+		packet->m_HiZCulling = _HiZCulling;
+		CullScene(alpha, packet);
+	}
 
-		Input::HInputDeviceKeyboard* keyboard = nullptr;
-		input.GetDevice(Input::EDeviceType_Keyboard, &keyboard);
-		const float speed = 10.f;
+	void vkGraphicsDevice::RenderFrame(const RenderPacket& packet, uint32 packetIndex)
+	{
+		PROFILE_FUNCTION();
 
-		if(keyboard->IsDown(DIK_W))
-			_Camera.Forward(speed * dt);
-		if(keyboard->IsDown(DIK_S))
-			_Camera.Forward(-speed * dt);
+		// the constant buffer, the light buffers and the Hi-Z readback are shared by every frame, and so is the
+		// acquire semaphore: the last submit has to be done waiting on it before it is signaled again
+		VkDevice device = m_LogicalDevice->GetDevice();
+		vkWaitForFences(device, 1, &m_CommandFence, VK_TRUE, UINT64_MAX);
+		vkResetFences(device, 1, &m_CommandFence);
 
-		if(keyboard->IsDown(DIK_D))
-			_Camera.Right(speed * dt);
-		if(keyboard->IsDown(DIK_A))
-			_Camera.Right(-speed * dt);
+		if(vkAcquireNextImageKHR(device, m_Swapchain->GetSwapchain(), UINT64_MAX, m_AcquireNextImageSemaphore,
+								 VK_NULL_HANDLE /*fence*/, &m_Index) != VK_SUCCESS)
+			ASSERT(false, "Failed to acquire next image!");
 
-		if(keyboard->IsDown(DIK_R))
-			_Camera.Up(speed * dt);
-		if(keyboard->IsDown(DIK_F))
-			_Camera.Up(-speed * dt);
+		// the frame that just finished copied its pyramid back
+		if(_HiZRecorded)
+		{
+			void* mapped = nullptr;
+			if(vkMapMemory(device, _HiZReadbackMemory, 0, _HiZ.GetReadbackSize(), 0, &mapped) != VK_SUCCESS)
+				ASSERT(false, "Failed to map memory!");
 
-		if(mouse->IsDown(1))
+			_HiZ.SetReadback((const float*)mapped, _HiZViewProjection);
+			vkUnmapMemory(device, _HiZReadbackMemory);
+		}
+		else
 		{
-			_Camera.OrientCamera({ cursor.dx, cursor.dy });
+			_HiZ.Invalidate();
 		}
 
-		_Camera.Update();
+		if(packet.m_BenchmarkRecording)
+			BenchmarkCommandRecording(100000);
+
+		_FrameViewProjection = packet.m_ViewProjection;
+		_FrameView = packet.m_View;
+		_FrameLightDir = packet.m_LightDir;
+		BinLights(packet);
 		BindConstantBuffer(&_ViewProjection, 0);
 
+		VkCommandBuffer commandBuffer = m_CmdBuffers[packet.m_Frame % m_CmdBuffers.size()];
+		SetupRenderCommands(commandBuffer, m_FrameBuffers[m_Index], packet, &_ImGuiFrames[packetIndex].m_DrawData);
+
 		const VkPipelineStageFlags waitDstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT; // associated with
 																									 // having
 																									 // semaphores
@@ -302,7 +746,7 @@ namespace Graphics
 		submitInfo.pWaitDstStageMask = &waitDstStageMask;
 
 		submitInfo.commandBufferCount = 1;
-		submitInfo.pCommandBuffers = &m_CmdBuffers[m_Index];
+		submitInfo.pCommandBuffers = &commandBuffer;
 
 		submitInfo.pSignalSemaphores = &m_DrawDone;
 		submitInfo.signalSemaphoreCount = 1;
@@ -310,9 +754,11 @@ namespace Graphics
 		submitInfo.pWaitSemaphores = &m_AcquireNextImageSemaphore;
 		submitInfo.waitSemaphoreCount = 1;
 
+		// buffers created since the last frame are uploaded ahead of the graphics submit that uses them
+		m_LogicalDevice->FlushUploads();
+
 		// This line fails when running with renderdoc, suspecting empty queue would be the issue
-		if(vkQueueSubmit(m_LogicalDevice->GetQueue(), 1, &submitInfo, m_CommandFence) != VK_SUCCESS)
-			ASSERT(false, "Failed to submit the queue!");
+		m_LogicalDevice->GetGraphicsQueue().Submit(submitInfo, m_CommandFence);
 
 		VkSwapchainKHR swapchain = m_Swapchain->GetSwapchain();
 
@@ -327,12 +773,19 @@ namespace Graphics
 		if(vkQueuePresentKHR(m_LogicalDevice->GetQueue(), &presentInfo) != VK_SUCCESS)
 			ASSERT(false, "Failed to present!");
 
-		/*for(Cube& cube : _Cubes)
 		{
-			cube.update(dt);
-		}*/
+			std::lock_guard<std::mutex> lock(_RenderStatsLock);
+			_RenderStats.m_Queue = _RenderQueue.GetStats();
+			_RenderStats.m_HiZCulled = _HiZCulledCubes;
+			_RenderStats.m_VisibleLights = _LightClusters.GetVisibleCount();
+			_RenderStats.m_LightIndices = _LightClusters.GetIndexCount();
+			_RenderStats.m_DroppedLights = _LightClusters.GetDroppedCount();
+			_RenderStats.m_RecordTrampolineMs = _RecordTrampolineMs;
+			_RenderStats.m_RecordTableMs = _RecordTableMs;
+		}
 
-		SetupRenderCommands(m_Index ^ 1);
+		_RenderTimer.Update();
+		PROFILE_COUNTER("Render frame us", _RenderTimer.GetTime() * 1000000.f);
 	}
 
 	//_____________________________________________
@@ -356,15 +809,16 @@ namespace Graphics
 		attRef.attachment = 0;
 		attRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
 
+		// the depth pass clears the depth and lays it down when the pre-pass is on, the Hi-Z build reads it after
 		VkAttachmentDescription depthAttachment = {};
 		depthAttachment.format = m_PhysicalDevice->FindDepthFormat();
 		depthAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
-		depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-		depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+		depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
 		depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
 		depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-		depthAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-		depthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+		depthAttachment.initialLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+		depthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
 
 		VkAttachmentReference depthAttachmentRef = {};
 		depthAttachmentRef.attachment = 1;
@@ -376,19 +830,84 @@ namespace Graphics
 		subpassDesc.pColorAttachments = &attRef;
 		subpassDesc.pDepthStencilAttachment = &depthAttachmentRef;
 
+		VkSubpassDependency dependencies[3] = {};
+		dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
+		dependencies[0].dstSubpass = 0;
+		dependencies[0].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+		dependencies[0].srcAccessMask = 0;
+		dependencies[0].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+		dependencies[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+
+		// depth written by the depth pass
+		dependencies[1].srcSubpass = VK_SUBPASS_EXTERNAL;
+		dependencies[1].dstSubpass = 0;
+		dependencies[1].srcStageMask = VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+		dependencies[1].srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+		dependencies[1].dstStageMask = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+		dependencies[1].dstAccessMask =
+			VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+
+		// depth read by the Hi-Z build
+		dependencies[2].srcSubpass = 0;
+		dependencies[2].dstSubpass = VK_SUBPASS_EXTERNAL;
+		dependencies[2].srcStageMask = VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+		dependencies[2].srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+		dependencies[2].dstStageMask = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+		dependencies[2].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+		VkAttachmentDescription attachments[] = { attDesc, depthAttachment };
+		VkRenderPassCreateInfo rpInfo = {};
+		rpInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+		rpInfo.attachmentCount = ARRSIZE(attachments);
+		rpInfo.pAttachments = attachments;
+		rpInfo.subpassCount = 1;
+		rpInfo.pSubpasses = &subpassDesc;
+		rpInfo.dependencyCount = ARRSIZE(dependencies);
+		rpInfo.pDependencies = dependencies;
+
+		VkRenderPass renderpass = nullptr;
+		if(vkCreateRenderPass(m_LogicalDevice->GetDevice(), &rpInfo, nullptr, &renderpass) != VK_SUCCESS)
+			ASSERT(false, "Failed to create renderpass");
+
+		return renderpass;
+	}
+
+	VkRenderPass vkGraphicsDevice::CreateDepthRenderPass()
+	{
+		VkAttachmentDescription depthAttachment = {};
+		depthAttachment.format = m_PhysicalDevice->FindDepthFormat();
+		depthAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+		depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+		depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+		depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+		depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		depthAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		depthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+		VkAttachmentReference depthAttachmentRef = {};
+		depthAttachmentRef.attachment = 0;
+		depthAttachmentRef.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+		VkSubpassDescription subpassDesc = {};
+		subpassDesc.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+		subpassDesc.colorAttachmentCount = 0;
+		subpassDesc.pDepthStencilAttachment = &depthAttachmentRef;
+
+		// the Hi-Z build of the previous frame has to be done reading the depth before it is cleared
 		VkSubpassDependency dependency = {};
 		dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
 		dependency.dstSubpass = 0;
-		dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+		dependency.srcStageMask = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
 		dependency.srcAccessMask = 0;
-		dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-		dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+		dependency.dstStageMask =
+			VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+		dependency.dstAccessMask =
+			VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
 
-		VkAttachmentDescription attachments[] = { attDesc, depthAttachment };
 		VkRenderPassCreateInfo rpInfo = {};
 		rpInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
-		rpInfo.attachmentCount = ARRSIZE(attachments);
-		rpInfo.pAttachments = attachments;
+		rpInfo.attachmentCount = 1;
+		rpInfo.pAttachments = &depthAttachment;
 		rpInfo.subpassCount = 1;
 		rpInfo.pSubpasses = &subpassDesc;
 		rpInfo.dependencyCount = 1;
@@ -396,7 +915,7 @@ namespace Graphics
 
 		VkRenderPass renderpass = nullptr;
 		if(vkCreateRenderPass(m_LogicalDevice->GetDevice(), &rpInfo, nullptr, &renderpass) != VK_SUCCESS)
-			ASSERT(false, "Failed to create renderpass");
+			ASSERT(false, "Failed to create depth renderpass");
 
 		return renderpass;
 	}
@@ -433,7 +952,8 @@ namespace Graphics
 	}
 	//_____________________________________________
 
-	VkPipeline vkGraphicsDevice::CreateGraphicsPipeline()
+	VkPipeline vkGraphicsDevice::CreateGraphicsPipeline(HShader* vertexShader, HShader* fragmentShader,
+														VkPipelineLayout layout, const PipelineDesc& desc)
 	{
 		// viewport
 		VkPipelineViewportStateCreateInfo vpCreateInfo = {};
@@ -446,9 +966,10 @@ namespace Graphics
 		// depth
 		VkPipelineDepthStencilStateCreateInfo pipelineDepthStencilStateCreateInfo = {};
 		pipelineDepthStencilStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
-		pipelineDepthStencilStateCreateInfo.depthTestEnable = VK_TRUE;
-		pipelineDepthStencilStateCreateInfo.depthWriteEnable = VK_TRUE;
-		pipelineDepthStencilStateCreateInfo.depthCompareOp = VK_COMPARE_OP_LESS;
+		pipelineDepthStencilStateCreateInfo.depthTestEnable = desc.m_DepthTest ? VK_TRUE : VK_FALSE;
+		pipelineDepthStencilStateCreateInfo.depthWriteEnable = desc.m_DepthWrite ? VK_TRUE : VK_FALSE;
+		// equal passes where the depth pre-pass already laid down the same surface
+		pipelineDepthStencilStateCreateInfo.depthCompareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
 		pipelineDepthStencilStateCreateInfo.depthBoundsTestEnable = VK_FALSE;
 		pipelineDepthStencilStateCreateInfo.minDepthBounds = 0.f;
 		pipelineDepthStencilStateCreateInfo.maxDepthBounds = 1.f;
@@ -480,68 +1001,51 @@ namespace Graphics
 		blendAttachState.colorWriteMask = 0xF;
 		blendAttachState.blendEnable = VK_FALSE;
 
+		const bool depthOnly = fragmentShader == nullptr;
+
 		VkPipelineColorBlendStateCreateInfo blendCreateInfo = {};
 		blendCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
 		blendCreateInfo.logicOpEnable = VK_FALSE;
-		blendCreateInfo.attachmentCount = 1;
+		blendCreateInfo.attachmentCount = depthOnly ? 0 : 1;
 		blendCreateInfo.pAttachments = &blendAttachState;
 
-		// Input Assembler
-		auto bindDesc = CreateBindDesc();	 // Define the size of the input assembler
-		auto attrDesc = CreateAttrDesc(0, 0); // Define each attribute of the input assembler
-		auto attrDesc2 = CreateAttrDesc(1, 16);
-		auto attrDesc3 = CreateAttrDesc(2, 32);
-		// This is 100% based on the vertex and not something that should be manually setup.
-		// Vertex Description should be on the model
+		// Input Assembler, the attributes are read from the inputs of the vertex shader
+		std::vector<VkVertexInputAttributeDescription> descriptions;
+		const uint32 stride = BuildVertexInputLayout(vertexShader->m_Reflection, &descriptions);
 
-		VkVertexInputBindingDescription bindDescArr[] = { bindDesc };
-		VkVertexInputAttributeDescription descriptions[] = { attrDesc, attrDesc2, attrDesc3 };
+		VkVertexInputBindingDescription bindDesc = {};
+		bindDesc.binding = 0;
+		bindDesc.stride = stride;
+		bindDesc.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
 
 		VkPipelineVertexInputStateCreateInfo vertexInputInfo = {};
 		vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
 
-		vertexInputInfo.vertexBindingDescriptionCount = ARRSIZE(bindDescArr);
-		vertexInputInfo.vertexAttributeDescriptionCount = ARRSIZE(descriptions);
-
-		vertexInputInfo.pVertexBindingDescriptions = bindDescArr;
-		vertexInputInfo.pVertexAttributeDescriptions = descriptions;
-
-		CreateDescriptorPool();
-		CreateDescriptorSet();
-
-		VkDescriptorBufferInfo bInfo2 = {};
-		bInfo2.buffer = static_cast<VkBuffer>(_ViewProjection.GetBuffer());
-		bInfo2.offset = 0;
-		bInfo2.range = _ViewProjection.GetSize();
-
-		VkWriteDescriptorSet descWrite = {};
-		descWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-		descWrite.dstSet = _descriptorSet;
-		descWrite.dstBinding = 0;
-		descWrite.dstArrayElement = 0;
-		descWrite.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-		descWrite.descriptorCount = 1;
-		descWrite.pBufferInfo = &bInfo2;
+		vertexInputInfo.vertexBindingDescriptionCount = stride > 0 ? 1 : 0;
+		vertexInputInfo.vertexAttributeDescriptionCount = (uint32)descriptions.size();
 
-		vkUpdateDescriptorSets(m_LogicalDevice->GetDevice(), 1, &descWrite, 0, nullptr);
+		vertexInputInfo.pVertexBindingDescriptions = &bindDesc;
+		vertexInputInfo.pVertexAttributeDescriptions = descriptions.data();
 
 		VkPipelineInputAssemblyStateCreateInfo pipelineIACreateInfo = {};
 		pipelineIACreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
-		pipelineIACreateInfo.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+		pipelineIACreateInfo.topology = ConvertTopology(desc.m_Topology);
 		pipelineIACreateInfo.primitiveRestartEnable = VK_FALSE;
 
 		// the entry point of shader cannot be defined like this.
-		VkPipelineShaderStageCreateInfo ssci[] = {
-			CreateShaderStageInfo(VK_SHADER_STAGE_VERTEX_BIT, _vertexShader.GetModule(), "main"),
-			CreateShaderStageInfo(VK_SHADER_STAGE_FRAGMENT_BIT, _fragmentShader.GetModule(), "main")
-		};
+		VkPipelineShaderStageCreateInfo ssci[2];
+		uint32 stageCount = 0;
+		ssci[stageCount++] = CreateShaderStageInfo(VK_SHADER_STAGE_VERTEX_BIT, vertexShader->GetModule(), "main");
+		if(!depthOnly)
+			ssci[stageCount++] =
+				CreateShaderStageInfo(VK_SHADER_STAGE_FRAGMENT_BIT, fragmentShader->GetModule(), "main");
 
 		VkGraphicsPipelineCreateInfo pipelineInfo = {};
 		pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-		pipelineInfo.layout = _pipelineLayout;
+		pipelineInfo.layout = layout;
 		pipelineInfo.pVertexInputState = &vertexInputInfo;
 		pipelineInfo.pInputAssemblyState = &pipelineIACreateInfo;
-		pipelineInfo.renderPass = _renderPass;
+		pipelineInfo.renderPass = depthOnly ? _depthRenderPass : _renderPass;
 		pipelineInfo.pViewportState = &vpCreateInfo;
 		pipelineInfo.pColorBlendState = &blendCreateInfo;
 		pipelineInfo.pRasterizationState = &rastCreateInfo;
@@ -549,44 +1053,43 @@ namespace Graphics
 		pipelineInfo.pMultisampleState = &pipelineMSCreateInfo;
 
 		pipelineInfo.pStages = ssci;
-		pipelineInfo.stageCount = ARRSIZE(ssci);
+		pipelineInfo.stageCount = stageCount;
 
 		VkPipeline pipeline;
 		if(vkCreateGraphicsPipelines(m_LogicalDevice->GetDevice(), VK_NULL_HANDLE, 1, &pipelineInfo, nullptr,
 									 &pipeline) != VK_SUCCESS)
 			ASSERT(false, "Failed to create pipeline!");
 
-		DestroyShader(&_vertexShader);
-		DestroyShader(&_fragmentShader);
-
 		return pipeline;
 	}
 
-	VkDescriptorSetLayout vkGraphicsDevice::CreateDescriptorLayout(VkDescriptorSetLayoutBinding* descriptorBindings,
-																   int32 bindingCount)
+	VkPipeline vkGraphicsDevice::CreateComputePipeline(HShader* computeShader, VkPipelineLayout layout)
 	{
-		VkDescriptorSetLayoutCreateInfo layoutInfo = {};
-		layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-		layoutInfo.bindingCount = bindingCount;
-		layoutInfo.pBindings = descriptorBindings;
-		VkDescriptorSetLayout descriptorLayout;
-		if(vkCreateDescriptorSetLayout(m_LogicalDevice->GetDevice(), &layoutInfo, nullptr, &descriptorLayout) !=
-		   VK_SUCCESS)
-			ASSERT(false, "Failed to create Descriptor layout");
+		VkComputePipelineCreateInfo pipelineInfo = {};
+		pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+		pipelineInfo.stage = CreateShaderStageInfo(VK_SHADER_STAGE_COMPUTE_BIT, computeShader->GetModule(), "main");
+		pipelineInfo.layout = layout;
+
+		VkPipeline pipeline = nullptr;
+		if(vkCreateComputePipelines(m_LogicalDevice->GetDevice(), VK_NULL_HANDLE, 1, &pipelineInfo, nullptr,
+									&pipeline) != VK_SUCCESS)
+			ASSERT(false, "Failed to create compute pipeline!");
 
-		return descriptorLayout;
+		return pipeline;
 	}
 
 	void vkGraphicsDevice::CreateDescriptorPool()
 	{
-		VkDescriptorPoolSize poolSize = {};
-		poolSize.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-		poolSize.descriptorCount = 1; // (uint32_t)m_Swapchain->GetNofImages();
+		VkDescriptorPoolSize poolSizes[2] = {};
+		poolSizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+		poolSizes[0].descriptorCount = 1; // (uint32_t)m_Swapchain->GetNofImages();
+		poolSizes[1].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		poolSizes[1].descriptorCount = 3; // lights, clusters and light indices
 
 		VkDescriptorPoolCreateInfo createInfo = {};
 		createInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-		createInfo.poolSizeCount = 1;
-		createInfo.pPoolSizes = &poolSize;
+		createInfo.poolSizeCount = ARRSIZE(poolSizes);
+		createInfo.pPoolSizes = poolSizes;
 		createInfo.maxSets = (uint32_t)m_Swapchain->GetNofImages();
 
 		if(vkCreateDescriptorPool(m_LogicalDevice->GetDevice(), &createInfo, nullptr, &_descriptorPool) != VK_SUCCESS)
@@ -612,28 +1115,8 @@ namespace Graphics
 
 	//_____________________________________________
 
-	VkPipelineLayout vkGraphicsDevice::CreatePipelineLayout(VkDescriptorSetLayout* descriptorLayouts,
-															int32 descriptorLayoutCount,
-															VkPushConstantRange* pushConstantRange,
-															int32 pushConstantRangeCount)
-	{
-		VkPipelineLayoutCreateInfo pipelineCreateInfo = {};
-		pipelineCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-
-		pipelineCreateInfo.setLayoutCount = descriptorLayoutCount;
-		pipelineCreateInfo.pSetLayouts = descriptorLayouts;
-
-		pipelineCreateInfo.pushConstantRangeCount = pushConstantRangeCount;
-		pipelineCreateInfo.pPushConstantRanges = pushConstantRange;
-
-		VkPipelineLayout pipeline;
-		if(vkCreatePipelineLayout(m_LogicalDevice->GetDevice(), &pipelineCreateInfo, nullptr, &pipeline) != VK_SUCCESS)
-			ASSERT(false, "Failed to create pipelineLayout");
-		return pipeline;
-	}
-	//_____________________________________________
-
-	VkImageView vkGraphicsDevice::CreateImageView(VkFormat format, VkImage image, VkImageAspectFlags aspectFlag)
+	VkImageView vkGraphicsDevice::CreateImageView(VkFormat format, VkImage image, VkImageAspectFlags aspectFlag,
+												  uint32 mipLevel)
 	{
 		// This is a logic device operation
 
@@ -646,7 +1129,7 @@ namespace Graphics
 							  VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY };
 		VkImageSubresourceRange& srr = vcInfo.subresourceRange;
 		srr.aspectMask = aspectFlag;
-		srr.baseMipLevel = 0;
+		srr.baseMipLevel = mipLevel;
 		srr.levelCount = 1;
 		srr.baseArrayLayer = 0;
 		srr.layerCount = 1;
@@ -658,12 +1141,13 @@ namespace Graphics
 	}
 
 	// This is wrong, this is not how a frame buffer should be created. It should take a width & height not a window
-	VkFramebuffer vkGraphicsDevice::CreateFramebuffer(VkImageView* view, int32 attachmentCount, const Window& window)
+	VkFramebuffer vkGraphicsDevice::CreateFramebuffer(VkRenderPass renderPass, VkImageView* view, int32 attachmentCount,
+													  const Window& window)
 	{
 		// This is a logic device operation
 		VkFramebufferCreateInfo ci = {};
 		ci.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
-		ci.renderPass = _renderPass;
+		ci.renderPass = renderPass;
 		ci.attachmentCount = attachmentCount;
 		ci.pAttachments = view;
 		ci.width = (uint32)window.GetInnerSize().m_Width;
@@ -676,25 +1160,6 @@ namespace Graphics
 		return framebuffer;
 	}
 
-	VkVertexInputBindingDescription vkGraphicsDevice::CreateBindDesc()
-	{
-		VkVertexInputBindingDescription bindingDescription = {};
-		bindingDescription.binding = 0;
-		bindingDescription.stride = sizeof(Vertex);
-		bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
-		return bindingDescription;
-	}
-
-	VkVertexInputAttributeDescription vkGraphicsDevice::CreateAttrDesc(int location, int offset)
-	{
-		VkVertexInputAttributeDescription attrDesc = {};
-		attrDesc.binding = 0;
-		attrDesc.location = location;
-		attrDesc.format = VK_FORMAT_R32G32B32A32_SFLOAT;
-		attrDesc.offset = offset;
-		return attrDesc;
-	}
-
 	VkSemaphore vkGraphicsDevice::CreateVkSemaphore(VkDevice pDevice)
 	{
 		VkSemaphore semaphore = nullptr;
@@ -707,13 +1172,24 @@ namespace Graphics
 	}
 	//_____________________________________________
 
-	VkShaderModule vkGraphicsDevice::LoadShader(const char* filepath, VkDevice pDevice)
+	VkShaderModule vkGraphicsDevice::LoadShader(const char* filepath, VkDevice pDevice, ShaderReflection* reflection)
 	{
-		Core::File shader(filepath, Core::File::READ_FILE);
+		// the mapping stays open until the module is created, the driver copies the code
+		Core::MappedFile shader(filepath);
+		ASSERT(shader.IsOpen(), "Failed to open shader!");
+		return LoadShader(shader.GetData().As<const uint32>(), pDevice, reflection);
+	}
+
+	VkShaderModule vkGraphicsDevice::LoadShader(Core::Span<const uint32> code, VkDevice pDevice,
+												ShaderReflection* reflection)
+	{
+		if(!ReflectShader(code.GetData(), (uint32)code.SizeInBytes(), reflection))
+			ASSERT(false, "Failed to reflect shader!");
+
 		VkShaderModuleCreateInfo createInfo = {};
 		createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-		createInfo.codeSize = shader.GetSize();
-		createInfo.pCode = (const uint32_t*)shader.GetBuffer();
+		createInfo.codeSize = code.SizeInBytes();
+		createInfo.pCode = code.GetData();
 
 		VkShaderModule shaderModule = nullptr;
 		if(vkCreateShaderModule(pDevice, &createInfo, nullptr, &shaderModule) != VK_SUCCESS)
@@ -724,7 +1200,7 @@ namespace Graphics
 
 	void vkGraphicsDevice::LoadShader(HShader* shader, const char* filepath)
 	{
-		shader->Create(LoadShader(filepath, m_LogicalDevice->GetDevice()));
+		shader->Create(LoadShader(filepath, m_LogicalDevice->GetDevice(), &shader->m_Reflection));
 	}
 
 	void vkGraphicsDevice::BindConstantBuffer(ConstantBuffer* constantBuffer, uint32 offset)
@@ -749,6 +1225,7 @@ namespace Graphics
 	void vkGraphicsDevice::DestroyConstantBuffer(ConstantBuffer* constantBuffer)
 	{
 		vkDestroyBuffer(m_LogicalDevice->GetDevice(), static_cast<VkBuffer>(constantBuffer->GetBuffer()), nullptr);
+		m_LogicalDevice->FreeMemory(static_cast<VkDeviceMemory>(constantBuffer->GetDeviceMemory()));
 	}
 
 	//_____________________________________________
@@ -780,49 +1257,677 @@ namespace Graphics
 		constantBuffer->SetDeviceMemory(deviceMem);
 	}
 
-	void vkGraphicsDevice::SetupRenderCommands(int index)
+	HBuffer vkGraphicsDevice::CreateBuffer(const BufferDesc& desc)
+	{
+		VkBufferCreateInfo createInfo = {};
+		createInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+		createInfo.size = desc.m_Size;
+		createInfo.usage = ConvertBindFlags(desc.m_BindFlags);
+		createInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+		BufferSlot slot;
+		slot.m_Size = desc.m_Size;
+		slot.m_HostVisible = (desc.m_Usage & (DYNAMIC_USAGE | STAGING_USAGE)) != 0;
+
+		if(slot.m_HostVisible)
+		{
+			if(desc.m_Usage & STAGING_USAGE)
+				createInfo.usage |= VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+			slot.m_Buffer = m_LogicalDevice->CreateBuffer(createInfo, &slot.m_Memory, m_PhysicalDevice);
+		}
+		else if(desc.m_InitialData)
+		{
+			// copied on the transfer queue, the upload is flushed with the next frame
+			const ResourceAccess access = GetBindAccess(desc.m_BindFlags);
+			slot.m_Buffer = m_LogicalDevice->CreateDeviceBuffer(createInfo, desc.m_InitialData, &slot.m_Memory,
+																m_PhysicalDevice, access.m_Access, access.m_Stages);
+		}
+		else
+		{
+			createInfo.usage |= VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+			slot.m_Buffer = m_LogicalDevice->CreateBuffer(createInfo, &slot.m_Memory, m_PhysicalDevice,
+														  VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+		}
+
+		const HBuffer buffer = _Buffers.Create(slot);
+		if(slot.m_HostVisible && desc.m_InitialData)
+			UpdateBuffer(buffer, desc.m_InitialData, desc.m_Size, 0);
+
+		return buffer;
+	}
+
+	void vkGraphicsDevice::UpdateBuffer(HBuffer buffer, const void* data, uint32 size, uint32 offset)
 	{
-		vkWaitForFences(m_LogicalDevice->GetDevice(), 1, &m_CommandFence, VK_TRUE, UINT64_MAX);
-		vkResetFences(m_LogicalDevice->GetDevice(), 1, &m_CommandFence);
+		ASSERT(_Buffers.IsValid(buffer), "Invalid buffer handle!");
+		const BufferSlot& slot = *_Buffers.Get(buffer);
+		ASSERT(slot.m_HostVisible, "Only dynamic and staging buffers can be updated!");
+		ASSERT(offset + size <= slot.m_Size, "Update is out of the buffer's range!");
+
+		void* mapped = nullptr;
+		if(vkMapMemory(m_LogicalDevice->GetDevice(), slot.m_Memory, offset, size, 0, &mapped) != VK_SUCCESS)
+			ASSERT(false, "Failed to map memory!");
 
+		memcpy(mapped, data, size);
+		vkUnmapMemory(m_LogicalDevice->GetDevice(), slot.m_Memory);
+	}
+
+	void vkGraphicsDevice::DestroyBuffer(HBuffer buffer)
+	{
+		// the buffer must not be used by a frame that is still in flight
+		if(!_Buffers.IsValid(buffer))
+			return;
+
+		const BufferSlot& slot = *_Buffers.Get(buffer);
+		vkDestroyBuffer(m_LogicalDevice->GetDevice(), slot.m_Buffer, nullptr);
+		m_LogicalDevice->FreeMemory(slot.m_Memory);
+		_Buffers.Destroy(buffer);
+	}
+
+	HPipeline vkGraphicsDevice::CreatePipeline(const PipelineDesc& desc)
+	{
+		const bool depthOnly = desc.m_FragmentShader == nullptr;
+
+		HShader vertexShader;
+		HShader fragmentShader;
+		LoadShader(&vertexShader, desc.m_VertexShader);
+		if(!depthOnly)
+			LoadShader(&fragmentShader, desc.m_FragmentShader);
+
+		const ShaderReflection* stages[] = { &vertexShader.m_Reflection, &fragmentShader.m_Reflection };
+		const uint32 stageCount = depthOnly ? 1 : ARRSIZE(stages);
+
+		PipelineSlot slot;
+		slot.m_Layout = _LayoutCache.GetLayout(stages, stageCount).m_Layout;
+		slot.m_Pipeline =
+			CreateGraphicsPipeline(&vertexShader, depthOnly ? nullptr : &fragmentShader, slot.m_Layout, desc);
+		slot.m_PushStages = GetPushConstantStages(stages, stageCount);
+
+		DestroyShader(&vertexShader);
+		if(!depthOnly)
+			DestroyShader(&fragmentShader);
+
+		return _Pipelines.Create(slot);
+	}
+
+	void vkGraphicsDevice::DestroyPipeline(HPipeline pipeline)
+	{
+		if(!_Pipelines.IsValid(pipeline))
+			return;
+
+		vkDestroyPipeline(m_LogicalDevice->GetDevice(), _Pipelines.Get(pipeline)->m_Pipeline, nullptr);
+		_Pipelines.Destroy(pipeline);
+	}
+
+	void vkGraphicsDevice::BindPipeline(HPipeline pipeline)
+	{
+		ASSERT(m_RecordingBuffer != nullptr, "No frame is being recorded!");
+		ASSERT(_Pipelines.IsValid(pipeline), "Invalid pipeline handle!");
+
+		// the view projection set is shared by every pipeline
+		const PipelineSlot& slot = *_Pipelines.Get(pipeline);
+		const VlkDeviceTable& table = m_LogicalDevice->GetTable();
+		table.vkCmdBindPipeline(m_RecordingBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, slot.m_Pipeline);
+		table.vkCmdBindDescriptorSets(m_RecordingBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, slot.m_Layout, 0, 1,
+									  &_descriptorSet, 0, nullptr);
+		m_BoundPipeline = pipeline;
+	}
+
+	void vkGraphicsDevice::BindVertexBuffer(HBuffer buffer, uint32 offset)
+	{
+		ASSERT(m_RecordingBuffer != nullptr, "No frame is being recorded!");
+		ASSERT(_Buffers.IsValid(buffer), "Invalid buffer handle!");
+
+		const VkDeviceSize deviceOffset = offset;
+		m_LogicalDevice->GetTable().vkCmdBindVertexBuffers(m_RecordingBuffer, 0, 1, &_Buffers.Get(buffer)->m_Buffer,
+															&deviceOffset);
+	}
+
+	void vkGraphicsDevice::BindIndexBuffer(HBuffer buffer, uint32 offset)
+	{
+		ASSERT(m_RecordingBuffer != nullptr, "No frame is being recorded!");
+		ASSERT(_Buffers.IsValid(buffer), "Invalid buffer handle!");
+
+		m_LogicalDevice->GetTable().vkCmdBindIndexBuffer(m_RecordingBuffer, _Buffers.Get(buffer)->m_Buffer, offset,
+														  VK_INDEX_TYPE_UINT32);
+	}
+
+	void vkGraphicsDevice::PushConstants(const void* data, uint32 size, uint32 offset)
+	{
+		ASSERT(m_RecordingBuffer != nullptr, "No frame is being recorded!");
+		ASSERT(m_BoundPipeline != 0, "Push constants need a bound pipeline!");
+
+		const PipelineSlot& slot = *_Pipelines.Get(m_BoundPipeline);
+		m_LogicalDevice->GetTable().vkCmdPushConstants(m_RecordingBuffer, slot.m_Layout, slot.m_PushStages, offset,
+														size, data);
+	}
+
+	void vkGraphicsDevice::Draw(uint32 vertexCount, uint32 instanceCount, uint32 firstVertex, uint32 firstInstance)
+	{
+		ASSERT(m_RecordingBuffer != nullptr, "No frame is being recorded!");
+		m_LogicalDevice->GetTable().vkCmdDraw(m_RecordingBuffer, vertexCount, instanceCount, firstVertex,
+											   firstInstance);
+	}
+
+	void vkGraphicsDevice::DrawIndexed(uint32 indexCount, uint32 instanceCount, uint32 firstIndex, int32 vertexOffset,
+									   uint32 firstInstance)
+	{
+		ASSERT(m_RecordingBuffer != nullptr, "No frame is being recorded!");
+		m_LogicalDevice->GetTable().vkCmdDrawIndexed(m_RecordingBuffer, indexCount, instanceCount, firstIndex,
+													  vertexOffset, firstInstance);
+	}
+
+	void vkGraphicsDevice::Barrier(HBuffer buffer, EResourceState before, EResourceState after)
+	{
+		ASSERT(m_RecordingBuffer != nullptr, "No frame is being recorded!");
+		ASSERT(_Buffers.IsValid(buffer), "Invalid buffer handle!");
+
+		const ResourceAccess& src = _ResourceAccess[before];
+		const ResourceAccess& dst = _ResourceAccess[after];
+
+		VkBufferMemoryBarrier barrier = {};
+		barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+		barrier.srcAccessMask = src.m_Access;
+		barrier.dstAccessMask = dst.m_Access;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.buffer = _Buffers.Get(buffer)->m_Buffer;
+		barrier.offset = 0;
+		barrier.size = VK_WHOLE_SIZE;
+
+		m_LogicalDevice->GetTable().vkCmdPipelineBarrier(m_RecordingBuffer, src.m_Stages, dst.m_Stages, 0, 0, nullptr,
+														  1, &barrier, 0, nullptr);
+	}
+
+	void vkGraphicsDevice::UpdateTransforms()
+	{
+		PROFILE_FUNCTION();
+
+		// only the subtrees that moved are recomputed. The chunks are refreshed when anything did, and once more on
+		// the step after, so the previous worlds catch up and the blend comes to rest.
+		const bool moved = _Transforms.Update(&_Workers) > 0;
+		if(moved || _TransformsMoving)
+		{
+			_World.ParallelForEach<Graphics::Transform>(_Renderables, &_Workers, [](Graphics::Transform& transform) {
+				transform.m_Previous = transform.m_Current;
+				transform.m_Current = _Transforms.GetWorld(transform.m_Node);
+			});
+			_TransformsStale = true;
+		}
+		_TransformsMoving = moved;
+	}
+
+	void vkGraphicsDevice::CullScene(float alpha, RenderPacket* packet)
+	{
+		PROFILE_FUNCTION();
+
+		// a scene at rest is not blended again every frame
+		if(_TransformsMoving || _TransformsStale)
+		{
+			_World.ParallelForEach<Graphics::Transform>(
+				_Renderables, &_Workers, [alpha](Graphics::Transform& transform) {
+					Blend(transform.m_Previous, transform.m_Current, alpha, &transform.m_World);
+				});
+			_TransformsStale = false;
+		}
+
+		// LOD and sort depth of every mesh, one job per chunk
+		const Core::Vector4f eye = _Camera.GetPosition();
+		const float pixelScale = _Camera.GetPixelScale((float)_size.m_Height);
+		_World.ParallelForEach<Graphics::Transform, Graphics::MeshInstance>(
+			_Renderables, &_Workers, [&](Graphics::Transform& transform, Graphics::MeshInstance& instance) {
+				const float distance = (transform.m_World.GetTranslation() - eye).Length();
+				instance.m_Depth = distance / _FarPlane;
+				instance.m_Lod = instance.m_Mesh->SelectLod(instance.m_Lod, pixelScale / fmaxf(distance, 1e-3f));
+			});
+
+		// every cube occludes the others, only the ones that are not hidden behind them are drawn. The occludees point
+		// into the chunks, nothing may add or remove entities until the packet is filled. Both arrays only live
+		// for this frame.
+		_Occlusion.Clear(*_Camera.GetViewProjectionPointer());
+		const uint32 occludeeCount = _World.GetEntityCount(_Renderables);
+		Core::LinearArena& frameArena = Core::GetFrameArena();
+		Graphics::OcclusionBuffer::Occludee* occludees =
+			frameArena.New<Graphics::OcclusionBuffer::Occludee>(occludeeCount);
+		uint8* cubeVisible = frameArena.Allocate<uint8>(occludeeCount);
+		uint32 first = 0;
+		_World.ForEachChunk<Graphics::Transform, Graphics::MeshInstance>(
+			_Renderables, [&](uint32 count, const Core::Entity*, const Graphics::Transform* transforms,
+							  const Graphics::MeshInstance* instances) {
+				for(uint32 i = 0; i < count; ++i)
+				{
+					const Cube* mesh = instances[i].m_Mesh;
+					mesh->AddOccluder(&_Occlusion, transforms[i].m_World);
+					occludees[first + i].m_World = &transforms[i].m_World;
+					occludees[first + i].m_Min = mesh->GetBoundsMin();
+					occludees[first + i].m_Max = mesh->GetBoundsMax();
+				}
+				first += count;
+			});
+		_Occlusion.Rasterize(&_Workers);
+		_Occlusion.TestVisibility(occludees, occludeeCount, cubeVisible, &_Workers);
+		_OccludeeCount = occludeeCount;
+
+		packet->m_Draws.clear();
+		_CulledCubes = 0;
+		first = 0;
+		_World.ForEachChunk<Graphics::Transform, Graphics::MeshInstance>(
+			_Renderables, [&](uint32 count, const Core::Entity*, const Graphics::Transform* transforms,
+							  const Graphics::MeshInstance* instances) {
+				for(uint32 i = 0; i < count; ++i)
+				{
+					if(!cubeVisible[first + i])
+					{
+						_CulledCubes++;
+						continue;
+					}
+
+					RenderDraw draw;
+					draw.m_World = transforms[i].m_World;
+					draw.m_Mesh = instances[i].m_Mesh;
+					draw.m_Lod = instances[i].m_Lod;
+					draw.m_Depth = instances[i].m_Depth;
+					packet->m_Draws.push_back(draw);
+				}
+				first += count;
+			});
+	}
+
+	void vkGraphicsDevice::SetupRenderCommands(VkCommandBuffer commandBuffer, VkFramebuffer frameBuffer,
+											   const RenderPacket& packet, ImDrawData* imguiDrawData)
+	{
+		PROFILE_FUNCTION();
 		VkCommandBufferBeginInfo cmdInfo = {};
 		cmdInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
 		cmdInfo.flags = VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT;
 
-		VkFramebuffer& frameBuffer = m_FrameBuffers[index];
-		VkCommandBuffer& commandBuffer = m_CmdBuffers[index];
+		const VlkDeviceTable& table = m_LogicalDevice->GetTable();
 
-		if(vkBeginCommandBuffer(commandBuffer, &cmdInfo) != VK_SUCCESS)
+		if(table.vkBeginCommandBuffer(commandBuffer, &cmdInfo) != VK_SUCCESS)
 			ASSERT(false, "Failed to begin CommandBuffer!");
 
+		// sorted so draws sharing a pipeline and mesh are recorded back to back, front to back within them
+		_RenderQueue.Clear();
+		_HiZCulledCubes = 0;
+		for(const RenderDraw& draw : packet.m_Draws)
+		{
+			// hidden last frame, cubes that come out from behind something show up one frame late
+			const Cube* mesh = draw.m_Mesh;
+			if(packet.m_HiZCulling && !_HiZ.IsVisible(draw.m_World, mesh->GetBoundsMin(), mesh->GetBoundsMax()))
+			{
+				_HiZCulledCubes++;
+				continue;
+			}
+			mesh->Submit(&_RenderQueue, _CubePipeline, draw.m_World, draw.m_Lod, draw.m_Depth);
+		}
+		_RenderQueue.Sort(&_Workers);
+
+		m_RecordingBuffer = commandBuffer;
+
+		// the depth pass always runs, without the pre-pass it only clears the depth for the main pass
+		VkClearValue depthClear = {};
+		depthClear.depthStencil = { 1.f, 0 };
+
+		VkRenderPassBeginInfo depthPassInfo = {};
+		depthPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+		depthPassInfo.renderPass = _depthRenderPass;
+		depthPassInfo.framebuffer = _depthFramebuffer;
+		depthPassInfo.renderArea.offset = { 0, 0 };
+		depthPassInfo.renderArea.extent = { (uint32)_size.m_Width, (uint32)_size.m_Height };
+		depthPassInfo.clearValueCount = 1;
+		depthPassInfo.pClearValues = &depthClear;
+
+		table.vkCmdBeginRenderPass(commandBuffer, &depthPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+		if(packet.m_DepthPrepass)
+		{
+			m_BoundPipeline = 0;
+			_RenderQueue.Execute(this, _DepthPipeline);
+		}
+		table.vkCmdEndRenderPass(commandBuffer);
+
 		VkRenderPassBeginInfo pass_info = {};
 		PrepareRenderPass(&pass_info, frameBuffer, _size.m_Width, _size.m_Height);
 
-		vkCmdBeginRenderPass(commandBuffer, &pass_info, VK_SUBPASS_CONTENTS_INLINE);
-		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, _pipeline);
-		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, _pipelineLayout, 0, 1, &_descriptorSet,
-								0, nullptr);
+		table.vkCmdBeginRenderPass(commandBuffer, &pass_info, VK_SUBPASS_CONTENTS_INLINE);
 
 		/* This thing right here is what I'm looking for */
 
-		for(Cube& cube : _Cubes)
-		{
-			cube.Draw(commandBuffer, _pipelineLayout);
-		}
+		m_BoundPipeline = 0;
+		_RenderQueue.Execute(this);
+
+		m_RecordingBuffer = nullptr;
 
 		/* This is what draws the cubes */
 
-		ImGui_ImplVulkan_RenderDrawData(ImGui::GetDrawData(), commandBuffer);
+		ImGui_ImplVulkan_RenderDrawData(imguiDrawData, commandBuffer);
+
+		table.vkCmdEndRenderPass(commandBuffer);
 
-		vkCmdEndRenderPass(commandBuffer);
+		_HiZRecorded = packet.m_HiZCulling;
+		if(_HiZRecorded)
+		{
+			_HiZViewProjection = packet.m_ViewProjection;
+			RecordHiZ(commandBuffer);
+		}
 
-		if(vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+		if(table.vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
 			ASSERT(false, "Failed to end CommandBuffer!");
 	}
 
+	void vkGraphicsDevice::CreateLightResources()
+	{
+		_LightClusters.Init(*_Camera.GetProjection(), _NearPlane, _FarPlane, _MaxLightIndices);
+
+		// scattered in front of the wall of cubes, every fourth one is a spot light shining at it
+		_Lights.resize(_LightCount);
+		_LightPhases.resize(_LightCount);
+		for(uint32 i = 0; i < _LightCount; ++i)
+		{
+			Light& light = _Lights[i];
+			light.m_Position = { Core::Rand(-26.f, 32.f), Core::Rand(-16.f, 52.f), Core::Rand(-6.f, -1.f),
+								 Core::Rand(3.f, 8.f) };
+			light.m_Color = { Core::Rand(0.2f, 1.f), Core::Rand(0.2f, 1.f), Core::Rand(0.2f, 1.f), 1.f };
+			light.m_Direction = { 0.f, 0.f, 1.f, (i % 4) == 0 ? 0.85f : s_PointLight };
+			_LightPhases[i] = Core::Rand(0.f, 6.28f);
+		}
+		_PreviousLights = _Lights;
+
+		BufferDesc desc;
+		desc.m_BindFlags = BIND_SHADER_RESOURCE;
+		desc.m_Usage = DYNAMIC_USAGE;
+
+		desc.m_Size = _LightCount * sizeof(Light);
+		_LightBuffer = CreateBuffer(desc);
+
+		desc.m_Size = LightClusters::s_ClusterCount * sizeof(LightClusters::Cluster);
+		_ClusterBuffer = CreateBuffer(desc);
+
+		desc.m_Size = _MaxLightIndices * sizeof(uint32);
+		_LightIndexBuffer = CreateBuffer(desc);
+	}
+
+	void vkGraphicsDevice::UpdateLights(float step)
+	{
+		PROFILE_FUNCTION();
+		_LightTime += step;
+		for(uint32 i = 0; i < _LightCount; ++i)
+			_Lights[i].m_Position.y += cosf(_LightTime + _LightPhases[i]) * step;
+	}
+
+	void vkGraphicsDevice::BinLights(const RenderPacket& packet)
+	{
+		PROFILE_FUNCTION();
+		const uint32 lightCount = (uint32)packet.m_Lights.size();
+		_LightClusters.Build(packet.m_View, packet.m_Lights.data(), lightCount, &_Workers);
+
+		_ClusterParams.x = (float)LightClusters::s_ClustersX / _size.m_Width;
+		_ClusterParams.y = (float)LightClusters::s_ClustersY / _size.m_Height;
+		_ClusterParams.z = _LightClusters.GetSliceScale();
+		_ClusterParams.w = _LightClusters.GetSliceBias();
+
+		// the previous frame has finished with the buffers, RenderFrame waited for it
+		UpdateBuffer(_LightBuffer, packet.m_Lights.data(), lightCount * sizeof(Light), 0);
+		UpdateBuffer(_ClusterBuffer, _LightClusters.GetClusters(),
+					 LightClusters::s_ClusterCount * sizeof(LightClusters::Cluster), 0);
+		if(_LightClusters.GetIndexCount() > 0)
+			UpdateBuffer(_LightIndexBuffer, _LightClusters.GetIndices(),
+						 _LightClusters.GetIndexCount() * sizeof(uint32), 0);
+	}
+
+	void vkGraphicsDevice::CreateHiZResources()
+	{
+		VkDevice device = m_LogicalDevice->GetDevice();
+		const VkExtent2D extent = m_Swapchain->GetExtent();
+		_HiZ.Init(extent.width, extent.height);
+
+		const uint32 levelCount = _HiZ.GetLevelCount();
+		ASSERT(levelCount <= _MaxHiZLevels, "Depth buffer is too large for the Hi-Z pyramid!");
+
+		HShader shader;
+		LoadShader(&shader, "Data/Shaders/hiz.comp");
+		const ShaderReflection* stages[] = { &shader.m_Reflection };
+		const PipelineLayout& layout = _LayoutCache.GetLayout(stages, ARRSIZE(stages));
+		ASSERT(!layout.m_SetLayouts.empty(), "Hi-Z shader does not declare its images!");
+
+		_HiZLayout = layout.m_Layout;
+		_HiZPipeline = CreateComputePipeline(&shader, _HiZLayout);
+		DestroyShader(&shader);
+
+		const HiZPyramid::Level& first = _HiZ.GetLevel(0);
+		CreateImage(first.m_Width, first.m_Height, VK_FORMAT_R32_SFLOAT, VK_IMAGE_TILING_OPTIMAL,
+					VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+					VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, _HiZImage, _HiZMemory, levelCount);
+
+		_HiZViews.resize(levelCount);
+		for(uint32 i = 0; i < levelCount; ++i)
+			_HiZViews[i] = CreateImageView(VK_FORMAT_R32_SFLOAT, _HiZImage, VK_IMAGE_ASPECT_COLOR_BIT, i);
+
+		VkDescriptorPoolSize poolSizes[2] = {};
+		poolSizes[0].type = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+		poolSizes[0].descriptorCount = levelCount;
+		poolSizes[1].type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+		poolSizes[1].descriptorCount = levelCount;
+
+		VkDescriptorPoolCreateInfo poolInfo = {};
+		poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+		poolInfo.poolSizeCount = ARRSIZE(poolSizes);
+		poolInfo.pPoolSizes = poolSizes;
+		poolInfo.maxSets = levelCount;
+
+		if(vkCreateDescriptorPool(device, &poolInfo, nullptr, &_HiZDescriptorPool) != VK_SUCCESS)
+			ASSERT(false, "Failed to create descriptorPool");
+
+		std::vector<VkDescriptorSetLayout> setLayouts(levelCount, layout.m_SetLayouts[0]);
+		VkDescriptorSetAllocateInfo allocInfo = {};
+		allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		allocInfo.descriptorPool = _HiZDescriptorPool;
+		allocInfo.descriptorSetCount = levelCount;
+		allocInfo.pSetLayouts = setLayouts.data();
+
+		_HiZSets.resize(levelCount);
+		if(vkAllocateDescriptorSets(device, &allocInfo, _HiZSets.data()) != VK_SUCCESS)
+			ASSERT(false, "failed to allocate descriptor sets!");
+
+		for(uint32 i = 0; i < levelCount; ++i)
+		{
+			VkDescriptorImageInfo source = {};
+			source.imageView = i == 0 ? _depthView : _HiZViews[i - 1];
+			source.imageLayout = i == 0 ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_GENERAL;
+
+			VkDescriptorImageInfo destination = {};
+			destination.imageView = _HiZViews[i];
+			destination.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+			VkWriteDescriptorSet writes[2] = {};
+			writes[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			writes[0].dstSet = _HiZSets[i];
+			writes[0].dstBinding = 0;
+			writes[0].descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+			writes[0].descriptorCount = 1;
+			writes[0].pImageInfo = &source;
+
+			writes[1] = writes[0];
+			writes[1].dstBinding = 1;
+			writes[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+			writes[1].pImageInfo = &destination;
+
+			vkUpdateDescriptorSets(device, ARRSIZE(writes), writes, 0, nullptr);
+		}
+
+		VkBufferCreateInfo readbackInfo = {};
+		readbackInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+		readbackInfo.size = _HiZ.GetReadbackSize();
+		readbackInfo.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+		readbackInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		_HiZReadback = m_LogicalDevice->CreateBuffer(readbackInfo, &_HiZReadbackMemory, m_PhysicalDevice);
+	}
+
+	void vkGraphicsDevice::RecordHiZ(VkCommandBuffer commandBuffer)
+	{
+		PROFILE_FUNCTION();
+		const VlkDeviceTable& table = m_LogicalDevice->GetTable();
+		const uint32 levelCount = _HiZ.GetLevelCount();
+
+		VkImageMemoryBarrier barrier = {};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = _HiZImage;
+		barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		barrier.subresourceRange.baseMipLevel = 0;
+		barrier.subresourceRange.levelCount = levelCount;
+		barrier.subresourceRange.baseArrayLayer = 0;
+		barrier.subresourceRange.layerCount = 1;
+
+		// rebuilt every frame, the old levels are thrown away once the previous copy is done with them
+		barrier.srcAccessMask = 0;
+		barrier.dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+		barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+		table.vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+								   0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+		table.vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, _HiZPipeline);
+
+		// every level waits for the one it reads, the last barrier also covers the copy below
+		barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_TRANSFER_READ_BIT;
+		barrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+		barrier.subresourceRange.levelCount = 1;
+
+		VkExtent2D source = m_Swapchain->GetExtent();
+		for(uint32 i = 0; i < levelCount; ++i)
+		{
+			const HiZPyramid::Level& level = _HiZ.GetLevel(i);
+			const uint32 constants[] = { source.width, source.height, level.m_Width, level.m_Height };
+
+			table.vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, _HiZLayout, 0, 1,
+										  &_HiZSets[i], 0, nullptr);
+			table.vkCmdPushConstants(commandBuffer, _HiZLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(constants),
+									 constants);
+			table.vkCmdDispatch(commandBuffer, (level.m_Width + 7) / 8, (level.m_Height + 7) / 8, 1);
+
+			barrier.subresourceRange.baseMipLevel = i;
+			table.vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+									   VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0,
+									   nullptr, 0, nullptr, 1, &barrier);
+
+			source = { level.m_Width, level.m_Height };
+		}
+
+		// only the coarse levels go back, laid out the way HiZPyramid::SetReadback expects them
+		VkBufferImageCopy regions[_MaxHiZLevels] = {};
+		const uint32 firstLevel = _HiZ.GetFirstReadbackLevel();
+		const uint32 firstOffset = _HiZ.GetLevel(firstLevel).m_Offset;
+		for(uint32 i = firstLevel; i < levelCount; ++i)
+		{
+			const HiZPyramid::Level& level = _HiZ.GetLevel(i);
+			VkBufferImageCopy& region = regions[i - firstLevel];
+			region.bufferOffset = (level.m_Offset - firstOffset) * sizeof(float);
+			region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			region.imageSubresource.mipLevel = i;
+			region.imageSubresource.baseArrayLayer = 0;
+			region.imageSubresource.layerCount = 1;
+			region.imageExtent = { level.m_Width, level.m_Height, 1 };
+		}
+		table.vkCmdCopyImageToBuffer(commandBuffer, _HiZImage, VK_IMAGE_LAYOUT_GENERAL, _HiZReadback,
+									 levelCount - firstLevel, regions);
+
+		VkBufferMemoryBarrier hostBarrier = {};
+		hostBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+		hostBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		hostBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+		hostBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		hostBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		hostBarrier.buffer = _HiZReadback;
+		hostBarrier.offset = 0;
+		hostBarrier.size = VK_WHOLE_SIZE;
+		table.vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 0,
+								   nullptr, 1, &hostBarrier, 0, nullptr);
+	}
+
+	void vkGraphicsDevice::BenchmarkCommandRecording(uint32 drawCount)
+	{
+		// Records the same draws into a secondary command buffer through the loader trampolines and through the
+		// device table. Only the recording is timed, nothing is submitted. One untimed pass of each warms the caches
+		// and grows the driver's command memory, then the two alternate which goes first and the fastest run counts.
+		constexpr uint32 s_Iterations = 8;
+		VkDevice device = m_LogicalDevice->GetDevice();
+		const VlkDeviceTable& table = m_LogicalDevice->GetTable();
+		const Core::Matrix44f world = Core::Matrix44f::Identity();
+
+		VkCommandBufferInheritanceInfo inheritanceInfo = {};
+		inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+		inheritanceInfo.renderPass = _renderPass;
+		inheritanceInfo.subpass = 0;
+
+		VkCommandBufferBeginInfo beginInfo = {};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT | VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+		beginInfo.pInheritanceInfo = &inheritanceInfo;
+
+		VkCommandBuffer commandBuffer = CreateCommandBuffer(device, m_CmdPool, VK_COMMAND_BUFFER_LEVEL_SECONDARY);
+		Core::Timer timer;
+
+		auto recordTrampolines = [&]() {
+			vkResetCommandBuffer(commandBuffer, 0);
+			vkBeginCommandBuffer(commandBuffer, &beginInfo);
+			timer.Init();
+			vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, _pipeline);
+			for(uint32 i = 0; i < drawCount; ++i)
+			{
+				vkCmdPushConstants(commandBuffer, _pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(world), &world);
+				vkCmdDraw(commandBuffer, 36, 1, 0, 0);
+			}
+			timer.Update();
+			vkEndCommandBuffer(commandBuffer);
+			return timer.GetTime() * 1000.f;
+		};
+
+		auto recordTable = [&]() {
+			vkResetCommandBuffer(commandBuffer, 0);
+			table.vkBeginCommandBuffer(commandBuffer, &beginInfo);
+			timer.Init();
+			table.vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, _pipeline);
+			for(uint32 i = 0; i < drawCount; ++i)
+			{
+				table.vkCmdPushConstants(commandBuffer, _pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(world),
+										 &world);
+				table.vkCmdDraw(commandBuffer, 36, 1, 0, 0);
+			}
+			timer.Update();
+			table.vkEndCommandBuffer(commandBuffer);
+			return timer.GetTime() * 1000.f;
+		};
+
+		recordTrampolines();
+		recordTable();
+
+		_RecordTrampolineMs = FLT_MAX;
+		_RecordTableMs = FLT_MAX;
+		for(uint32 i = 0; i < s_Iterations; ++i)
+		{
+			if(i % 2 == 0)
+			{
+				_RecordTrampolineMs = fminf(_RecordTrampolineMs, recordTrampolines());
+				_RecordTableMs = fminf(_RecordTableMs, recordTable());
+			}
+			else
+			{
+				_RecordTableMs = fminf(_RecordTableMs, recordTable());
+				_RecordTrampolineMs = fminf(_RecordTrampolineMs, recordTrampolines());
+			}
+		}
+
+		vkFreeCommandBuffers(device, m_CmdPool, 1, &commandBuffer);
+
+		LOG_MESSAGE("Recorded %u draws, fastest of %u runs, loader: %.3f ms, device table: %.3f ms", drawCount,
+					s_Iterations, _RecordTrampolineMs, _RecordTableMs);
+	}
+
 	void vkGraphicsDevice::DestroyShader(HShader* pShader)
 	{
 		vkDestroyShaderModule(m_LogicalDevice->GetDevice(), pShader->GetModule(), nullptr);
+		pShader->m_Module = nullptr;
 	}
 
 	Camera* vkGraphicsDevice::GetCamera() { return &_Camera; }
@@ -837,8 +1942,8 @@ namespace Graphics
 		VkFormat depthFormat = m_PhysicalDevice->FindDepthFormat();
 		const VkExtent2D extent = m_Swapchain->GetExtent();
 		CreateImage(extent.width, extent.height, depthFormat, VK_IMAGE_TILING_OPTIMAL,
-					VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, _depthImage,
-					_depthImageMemory);
+					VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+					VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, _depthImage, _depthImageMemory);
 		_depthView = CreateImageView(depthFormat, _depthImage, VK_IMAGE_ASPECT_DEPTH_BIT);
 
 		transitionImageLayout(_depthImage, depthFormat, VK_IMAGE_LAYOUT_UNDEFINED,
@@ -847,7 +1952,7 @@ namespace Graphics
 
 	void vkGraphicsDevice::CreateImage(uint32 width, uint32 height, VkFormat format, VkImageTiling imageTiling,
 									   VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage& image,
-									   VkDeviceMemory& imageMemory)
+									   VkDeviceMemory& imageMemory, uint32 mipLevels)
 	{
 		VkDevice device = m_LogicalDevice->GetDevice();
 
@@ -857,7 +1962,7 @@ namespace Graphics
 		imageInfo.extent.width = width;
 		imageInfo.extent.height = height;
 		imageInfo.extent.depth = 1;
-		imageInfo.mipLevels = 1;
+		imageInfo.mipLevels = mipLevels;
 		imageInfo.arrayLayers = 1;
 		imageInfo.format = format;
 		imageInfo.tiling = imageTiling;
@@ -871,14 +1976,7 @@ namespace Graphics
 
 		VkMemoryRequirements memRequirements;
 		vkGetImageMemoryRequirements(device, image, &memRequirements);
-
-		VkMemoryAllocateInfo allocInfo = {};
-		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-		allocInfo.allocationSize = memRequirements.size;
-		allocInfo.memoryTypeIndex = m_PhysicalDevice->FindMemoryType(memRequirements.memoryTypeBits, properties);
-
-		if(vkAllocateMemory(device, &allocInfo, nullptr, &imageMemory) != VK_SUCCESS)
-			throw std::runtime_error("failed to allocate image memory!");
+		imageMemory = m_LogicalDevice->AllocateMemory(memRequirements, m_PhysicalDevice, properties);
 
 		vkBindImageMemory(device, image, imageMemory, 0);
 	}
@@ -957,48 +2055,33 @@ namespace Graphics
 		endSingleTimeCommands(commandBuffer);
 	}
 
-	// Util Function
+	// Util Function, the copy runs on the transfer queue and is handed over to the next graphics submission
 	void vkGraphicsDevice::copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size)
 	{
-		VkCommandBuffer commandBuffer = beginSingleTimeCommands();
+		VlkQueue& transfer = m_LogicalDevice->GetTransferQueue();
+		VkCommandBuffer commandBuffer = transfer.BeginCommands();
 
 		VkBufferCopy copyRegion = {};
 		copyRegion.size = size;
 		vkCmdCopyBuffer(commandBuffer, srcBuffer, dstBuffer, 1, &copyRegion);
 
-		endSingleTimeCommands(commandBuffer);
+		transfer.ReleaseBuffer(commandBuffer, dstBuffer, VK_ACCESS_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+							   &m_LogicalDevice->GetGraphicsQueue(), VK_ACCESS_MEMORY_READ_BIT,
+							   VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+		transfer.Submit(commandBuffer);
 	}
 
 	// Extends a commandbuffer
 	VkCommandBuffer vkGraphicsDevice::beginSingleTimeCommands()
 	{
-		VkDevice device = m_LogicalDevice->GetDevice();
-
-		VkCommandBuffer buffer;
-		buffer = CreateCommandBuffer(device, m_CmdPool, VK_COMMAND_BUFFER_LEVEL_PRIMARY);
-
-		VkCommandBufferBeginInfo beginInfo = {};
-		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
-
-		VERIFY(vkBeginCommandBuffer(buffer, &beginInfo) == VK_SUCCESS, "vkBeginCommandBuffer failed!");
-
-		return buffer;
+		return m_LogicalDevice->GetGraphicsQueue().BeginCommands();
 	}
 
 	void vkGraphicsDevice::endSingleTimeCommands(VkCommandBuffer commandBuffer)
 	{
-		vkEndCommandBuffer(commandBuffer);
-
-		VkSubmitInfo submitInfo = {};
-		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-		submitInfo.commandBufferCount = 1;
-		submitInfo.pCommandBuffers = &commandBuffer;
-
-		vkQueueSubmit(m_LogicalDevice->GetQueue(), 1, &submitInfo, VK_NULL_HANDLE);
-		vkQueueWaitIdle(m_LogicalDevice->GetQueue());
-
-		vkFreeCommandBuffers(m_LogicalDevice->GetDevice(), m_CmdPool, 1, &commandBuffer);
+		// waits on the fence of this submission only, the rest of the queue keeps running
+		VlkQueue& graphics = m_LogicalDevice->GetGraphicsQueue();
+		graphics.Wait(graphics.Submit(commandBuffer));
 	}
 	// end of command buffer
 
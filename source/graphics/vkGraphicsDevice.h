@@ -3,6 +3,7 @@
 #include "GraphicsDevice.h"
 
 #include "Core/utilities/utilities.h"
+#include "Core/containers/Span.h"
 #include "Core/Defines.h"
 
 #include <memory>
@@ -10,6 +11,7 @@
 #include <vulkan/vulkan_core.h>
 
 class Window;
+struct ImDrawData;
 typedef struct Shader HShader;
 namespace Graphics
 {
@@ -19,6 +21,8 @@ namespace Graphics
 	class VlkPhysicalDevice;
 	class VlkDevice;
 	class VlkSwapchain;
+	struct ShaderReflection;
+	struct RenderPacket;
 
 	class vkGraphicsDevice final : public IGraphicsDevice
 	{
@@ -29,7 +33,15 @@ namespace Graphics
 		class Camera* GetCamera();
 		bool Init(const Window& window);
 
-		void DrawFrame(float dt);
+		/* game thread, one fixed step of everything that moves: the camera, the lights and the transforms */
+		void Simulate(float step);
+		/*
+			game thread, runs the UI and fills the packet with what is visible, blending the last two simulated
+			states by alpha
+		*/
+		void BuildFrame(float dt, float alpha, RenderPacket* packet, uint32 packetIndex);
+		/* render thread, records, submits and presents the frame of the packet */
+		void RenderFrame(const RenderPacket& packet, uint32 packetIndex);
 
 		VlkInstance& GetVlkInstance() { return *m_Instance; }
 		VlkDevice& GetVlkDevice() { return *m_LogicalDevice; }
@@ -38,6 +50,25 @@ namespace Graphics
 		virtual void CreateConstantBuffer(ConstantBuffer* constantBuffer) override;
 		virtual void DestroyConstantBuffer(ConstantBuffer* constantBuffer) override;
 
+		HBuffer CreateBuffer(const BufferDesc& desc) override;
+		void UpdateBuffer(HBuffer buffer, const void* data, uint32 size, uint32 offset) override;
+		void DestroyBuffer(HBuffer buffer) override;
+
+		HPipeline CreatePipeline(const PipelineDesc& desc) override;
+		void DestroyPipeline(HPipeline pipeline) override;
+
+		// commands go into the command buffer of the frame being set up in SetupRenderCommands
+		void BindPipeline(HPipeline pipeline) override;
+		void BindVertexBuffer(HBuffer buffer, uint32 offset) override;
+		void BindIndexBuffer(HBuffer buffer, uint32 offset) override;
+		void PushConstants(const void* data, uint32 size, uint32 offset) override;
+
+		void Draw(uint32 vertexCount, uint32 instanceCount, uint32 firstVertex, uint32 firstInstance) override;
+		void DrawIndexed(uint32 indexCount, uint32 instanceCount, uint32 firstIndex, int32 vertexOffset,
+						 uint32 firstInstance) override;
+
+		void Barrier(HBuffer buffer, EResourceState before, EResourceState after) override;
+
 		void LoadShader(HShader* shader, const char* filepath);
 		void DestroyShader(HShader* pShader);
 
@@ -58,32 +89,48 @@ namespace Graphics
 		uint32 m_Index = 0;
 		std::vector<VkFramebuffer> m_FrameBuffers;
 
+		VkCommandBuffer m_RecordingBuffer = nullptr;
+		HPipeline m_BoundPipeline = 0;
+
 		VkRenderPass CreateRenderPass();
+		VkRenderPass CreateDepthRenderPass();
 		void CreateCommandPool();
 		VkCommandBuffer CreateCommandBuffer(VkDevice device, VkCommandPool pool, VkCommandBufferLevel bufferLevel);
-		VkPipeline CreateGraphicsPipeline();
+		/* without a fragment shader the pipeline only writes depth and is created for the depth pre-pass */
+		VkPipeline CreateGraphicsPipeline(HShader* vertexShader, HShader* fragmentShader, VkPipelineLayout layout,
+										  const PipelineDesc& desc);
+		VkPipeline CreateComputePipeline(HShader* computeShader, VkPipelineLayout layout);
 
-		VkDescriptorSetLayout CreateDescriptorLayout(VkDescriptorSetLayoutBinding* descriptorBindings,
-													 int32 bindingCount);
 		void CreateDescriptorPool();
 		void CreateDescriptorSet();
 
-		VkPipelineLayout CreatePipelineLayout(VkDescriptorSetLayout* descriptorLayouts, int32 descriptorLayoutCount,
-											  VkPushConstantRange* pushConstantRange, int32 pushConstantRangeCount);
-		VkImageView CreateImageView(VkFormat format, VkImage image, VkImageAspectFlags aspectFlag);
-		VkFramebuffer CreateFramebuffer(VkImageView* view, int32 attachmentCount, const Window& window);
+		VkImageView CreateImageView(VkFormat format, VkImage image, VkImageAspectFlags aspectFlag,
+									uint32 mipLevel = 0);
+		VkFramebuffer CreateFramebuffer(VkRenderPass renderPass, VkImageView* view, int32 attachmentCount,
+										const Window& window);
 
 		void CreateImage(uint32 width, uint32 height, VkFormat format, VkImageTiling imageTiling,
 						 VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage& image,
-						 VkDeviceMemory& imageMemory);
-
-		VkVertexInputBindingDescription CreateBindDesc();
-		VkVertexInputAttributeDescription CreateAttrDesc(int location, int offset);
+						 VkDeviceMemory& imageMemory, uint32 mipLevels = 1);
 
 		void CreateDepthResources();
+		void CreateLightResources();
+		/* game thread, moves the lights by one step */
+		void UpdateLights(float step);
+		/* render thread, bins the lights of the packet into clusters and uploads what frag.hlsl reads */
+		void BinLights(const RenderPacket& packet);
+		/* game thread, updates the transforms */
+		void UpdateTransforms();
+		/* game thread, blends the transforms, picks the LODs and keeps what the occlusion buffer does not hide */
+		void CullScene(float alpha, RenderPacket* packet);
+		void CreateHiZResources();
+		/* builds the Hi-Z pyramid from the depth of the frame and copies the coarse levels back */
+		void RecordHiZ(VkCommandBuffer commandBuffer);
 
 		VkSemaphore CreateVkSemaphore(VkDevice pDevice);
-		VkShaderModule LoadShader(const char* filepath, VkDevice pDevice);
+		VkShaderModule LoadShader(const char* filepath, VkDevice pDevice, ShaderReflection* reflection);
+		/* code is SPIR-V words, for example a span of a MappedFile */
+		VkShaderModule LoadShader(Core::Span<const uint32> code, VkDevice pDevice, ShaderReflection* reflection);
 
 		// rewrite
 		VkCommandBuffer beginSingleTimeCommands();
@@ -104,7 +151,9 @@ namespace Graphics
 
 		void SetupImGui();
 
-		void SetupRenderCommands(int index);
+		void SetupRenderCommands(VkCommandBuffer commandBuffer, VkFramebuffer frameBuffer, const RenderPacket& packet,
+								 ImDrawData* imguiDrawData);
+		void BenchmarkCommandRecording(uint32 drawCount);
 		void PrepareRenderPass(VkRenderPassBeginInfo* pass_info, VkFramebuffer framebuffer, uint32 width,
 							   uint32 height);
 	};
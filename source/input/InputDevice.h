@@ -41,6 +41,17 @@ namespace Input
 		float z, dz;
 	};
 
+	/* what a device reports for one frame, input is recorded and replayed in these */
+	struct DeviceState
+	{
+		uint32 m_Buttons[8] = {}; // one bit per key or button
+		Cursor m_Cursor = {};
+
+		bool IsDown( uint8 button ) const { return ( ( m_Buttons[button >> 5] >> ( button & 31 ) ) & 1 ) != 0; }
+		void SetDown( uint8 button ) { m_Buttons[button >> 5] |= 1u << ( button & 31 ); }
+		void SetUp( uint8 button ) { m_Buttons[button >> 5] &= ~( 1u << ( button & 31 ) ); }
+	};
+
 	class IInputDevice
 	{
 	public:
@@ -56,14 +67,18 @@ namespace Input
 		virtual bool OnRelease(uint8 vkey) const = 0;
 		virtual bool IsDown(uint8 vkey) const = 0;
 
-
-
+		/* the state of this frame, what gets recorded */
+		virtual void GetState( DeviceState* stateOut ) const = 0;
 
 		const EDeviceType GetType() const { return m_DeviceType; }
 
+		/* only pointing devices move it */
+		const Cursor& GetCursor() const { return m_Cursor; }
+
 	protected:
 		virtual void Release() = 0;
 		EDeviceType m_DeviceType{ EDeviceType_Unknown };
+		Cursor m_Cursor{};
 	};
 
 }; // namespace Input
\ No newline at end of file
@@ -0,0 +1,76 @@
+#include "InputDeviceEvents.h"
+
+#include <cstring>
+
+namespace Input
+{
+	InputDeviceEvents::InputDeviceEvents( EDeviceType device_type ) { m_DeviceType = device_type; }
+
+	bool InputDeviceEvents::OnDown() const { return false; }
+
+	bool InputDeviceEvents::OnRelease() const { return false; }
+
+	bool InputDeviceEvents::IsDown() const { return false; }
+
+	bool InputDeviceEvents::OnDown( uint8 vkey ) const { return m_Pressed.IsDown( vkey ); }
+
+	bool InputDeviceEvents::OnRelease( uint8 vkey ) const { return m_Released.IsDown( vkey ); }
+
+	bool InputDeviceEvents::IsDown( uint8 vkey ) const { return m_Held.IsDown( vkey ); }
+
+	void InputDeviceEvents::Update()
+	{
+		memset( m_DownTimes, 0, sizeof( m_DownTimes ) );
+		memset( m_ReleaseTimes, 0, sizeof( m_ReleaseTimes ) );
+		m_Pressed = DeviceState();
+		m_Released = DeviceState();
+		m_Cursor.dx = 0.f;
+		m_Cursor.dy = 0.f;
+		m_Cursor.dz = 0.f;
+	}
+
+	void InputDeviceEvents::GetState( DeviceState* state_out ) const
+	{
+		// a tap inside the frame is recorded as held for the frame, so a replay still sees it
+		*state_out = m_Held;
+		for( uint32 i = 0; i < ARRSIZE( m_Pressed.m_Buttons ); ++i )
+			state_out->m_Buttons[i] |= m_Pressed.m_Buttons[i];
+		state_out->m_Cursor = m_Cursor;
+	}
+
+	void InputDeviceEvents::OnEvent( const InputEvent& event )
+	{
+		const uint8 button = event.m_Button;
+		switch( event.m_Type )
+		{
+			case EInputEventType_ButtonDown:
+				if( m_Held.IsDown( button ) )
+					break;
+
+				m_Held.SetDown( button );
+				if( !m_Pressed.IsDown( button ) )
+				{
+					m_Pressed.SetDown( button );
+					m_DownTimes[button] = event.m_Time;
+				}
+				break;
+			case EInputEventType_ButtonUp:
+				if( !m_Held.IsDown( button ) )
+					break;
+
+				m_Held.SetUp( button );
+				m_Released.SetDown( button );
+				m_ReleaseTimes[button] = event.m_Time;
+				break;
+			case EInputEventType_Move:
+				m_Cursor.x += event.m_X;
+				m_Cursor.y += event.m_Y;
+				m_Cursor.z += event.m_Z;
+				m_Cursor.dx += event.m_X;
+				m_Cursor.dy += event.m_Y;
+				m_Cursor.dz += event.m_Z;
+				break;
+		}
+	}
+
+}; // namespace Input
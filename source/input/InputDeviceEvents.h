@@ -0,0 +1,49 @@
+#pragma once
+
+#include "InputEvent.h"
+
+namespace Input
+{
+	/*
+		A keyboard or mouse built from events instead of polled state.
+
+		Update starts a new frame, the events of the frame are handed in after it. OnDown and OnRelease are true for
+		every press and release that happened during the frame, also for a tap that went down and up between two
+		frames, which IsDown never sees. GetDownTime and GetReleaseTime tell when in the frame that was.
+	*/
+	class InputDeviceEvents final : public IInputDevice
+	{
+	public:
+		InputDeviceEvents( EDeviceType device_type );
+		~InputDeviceEvents() override = default;
+
+		bool OnDown() const override;
+		bool OnRelease() const override;
+		bool IsDown() const override;
+
+		bool OnDown( uint8 vkey ) const override;
+		bool OnRelease( uint8 vkey ) const override;
+		bool IsDown( uint8 vkey ) const override;
+
+		void Update() override;
+		void GetState( DeviceState* stateOut ) const override;
+
+		/* game thread, in the order the events happened */
+		void OnEvent( const InputEvent& event );
+
+		/* GetInputTime of the first press or last release this frame, 0 when there was none */
+		uint64 GetDownTime( uint8 vkey ) const { return m_DownTimes[vkey]; }
+		uint64 GetReleaseTime( uint8 vkey ) const { return m_ReleaseTimes[vkey]; }
+
+	private:
+		void Release() override {}
+
+		// only the buttons are used
+		DeviceState m_Held;
+		DeviceState m_Pressed;
+		DeviceState m_Released;
+		uint64 m_DownTimes[256] = {};
+		uint64 m_ReleaseTimes[256] = {};
+	};
+
+}; // namespace Input
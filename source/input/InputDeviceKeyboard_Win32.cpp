@@ -77,4 +77,14 @@ namespace Input
 		}
 	}
 
+	void InputDeviceKeyboard_Win32::GetState( DeviceState* state_out ) const
+	{
+		*state_out = DeviceState();
+		for( uint32 key = 0; key < ARRSIZE( m_State ); ++key )
+		{
+			if( m_State[key] & 0x80 )
+				state_out->SetDown( (uint8)key );
+		}
+	}
+
 }; // namespace Input
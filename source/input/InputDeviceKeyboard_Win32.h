@@ -19,6 +19,7 @@ namespace Input
 		bool IsDown( uint8 vkey ) const override;
 
 		void Update() override;
+		void GetState( DeviceState* stateOut ) const override;
 
 	private:
 		void Release() override;
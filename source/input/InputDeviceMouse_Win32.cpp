@@ -88,4 +88,16 @@ namespace Input
 		m_Cursor.dy = (float)m_PrevState.lY;
 	}
 
+	void InputDeviceMouse_Win32::GetState( DeviceState* state_out ) const
+	{
+		// Update only reads the buttons of DIMOUSESTATE
+		*state_out = DeviceState();
+		for( uint32 button = 0; button < sizeof( DIMOUSESTATE::rgbButtons ); ++button )
+		{
+			if( m_State.rgbButtons[button] & 0x80 )
+				state_out->SetDown( (uint8)button );
+		}
+		state_out->m_Cursor = m_Cursor;
+	}
+
 }; // namespace Input
@@ -21,12 +21,10 @@ namespace Input
 		bool IsDown( uint8 vkey ) const override;
 
 		void Update() override;
-
-		const Cursor& GetCursor() const { return m_Cursor; }
+		void GetState( DeviceState* stateOut ) const override;
 
 	private:
 		void Release() override;
-		Cursor m_Cursor;
 		DIMOUSESTATE2 m_State;
 		DIMOUSESTATE2 m_PrevState;
 		IDirectInput8* m_Input = nullptr;
@@ -0,0 +1,31 @@
+#include "InputDeviceReplay.h"
+
+namespace Input
+{
+	InputDeviceReplay::InputDeviceReplay( EDeviceType device_type ) { m_DeviceType = device_type; }
+
+	bool InputDeviceReplay::OnDown() const { return false; }
+
+	bool InputDeviceReplay::OnRelease() const { return false; }
+
+	bool InputDeviceReplay::IsDown() const { return false; }
+
+	bool InputDeviceReplay::OnDown( uint8 vkey ) const { return m_State.IsDown( vkey ) && !m_PrevState.IsDown( vkey ); }
+
+	bool InputDeviceReplay::OnRelease( uint8 vkey ) const
+	{
+		return !m_State.IsDown( vkey ) && m_PrevState.IsDown( vkey );
+	}
+
+	bool InputDeviceReplay::IsDown( uint8 vkey ) const { return m_State.IsDown( vkey ); }
+
+	void InputDeviceReplay::GetState( DeviceState* state_out ) const { *state_out = m_State; }
+
+	void InputDeviceReplay::SetState( const DeviceState& state )
+	{
+		m_PrevState = m_State;
+		m_State = state;
+		m_Cursor = state.m_Cursor;
+	}
+
+}; // namespace Input
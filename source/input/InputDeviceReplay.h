@@ -0,0 +1,35 @@
+#pragma once
+
+#include "InputDevice.h"
+
+namespace Input
+{
+	/* stands in for a real device while a recording plays back, it reports whatever state it was handed last */
+	class InputDeviceReplay final : public IInputDevice
+	{
+	public:
+		InputDeviceReplay( EDeviceType device_type );
+		~InputDeviceReplay() override = default;
+
+		bool OnDown() const override;
+		bool OnRelease() const override;
+		bool IsDown() const override;
+
+		bool OnDown( uint8 vkey ) const override;
+		bool OnRelease( uint8 vkey ) const override;
+		bool IsDown( uint8 vkey ) const override;
+
+		/* the state is set by the replay, there is nothing to poll */
+		void Update() override {}
+		void GetState( DeviceState* stateOut ) const override;
+
+		/* the next frame of the recording */
+		void SetState( const DeviceState& state );
+
+	private:
+		void Release() override {}
+		DeviceState m_State;
+		DeviceState m_PrevState;
+	};
+
+}; // namespace Input
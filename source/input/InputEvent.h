@@ -0,0 +1,41 @@
+#pragma once
+
+#include "InputDevice.h"
+
+#include <vector>
+
+namespace Input
+{
+	enum EInputEventType : uint8
+	{
+		EInputEventType_ButtonDown,
+		EInputEventType_ButtonUp,
+		EInputEventType_Move
+	};
+
+	/* one change of one device, stamped with the time the source saw it */
+	struct InputEvent
+	{
+		uint64 m_Time = 0; // GetInputTime microseconds
+		EDeviceType m_Device = EDeviceType_Unknown;
+		EInputEventType m_Type = EInputEventType_ButtonDown;
+		uint8 m_Button = 0; // a DIK_ scan code for keys, the button index for the mouse
+		float m_X = 0.f;	// relative motion of a move, z is the wheel
+		float m_Y = 0.f;
+		float m_Z = 0.f;
+	};
+
+	/* microseconds on the steady clock, the clock event times are measured on */
+	uint64 GetInputTime();
+
+	/* where events come from, polled on the input thread */
+	class IInputEventSource
+	{
+	public:
+		virtual ~IInputEventSource() {}
+
+		/* appends the events that happened since the last poll, oldest first */
+		virtual void Poll( std::vector<InputEvent>* events_out ) = 0;
+	};
+
+}; // namespace Input
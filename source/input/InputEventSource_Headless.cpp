@@ -0,0 +1,22 @@
+#include "InputEventSource_Headless.h"
+
+namespace Input
+{
+	void InputEventSource_Headless::Inject( const InputEvent& event )
+	{
+		InputEvent stamped = event;
+		if( stamped.m_Time == 0 )
+			stamped.m_Time = GetInputTime();
+
+		std::lock_guard<std::mutex> lock( m_Lock );
+		m_Events.push_back( stamped );
+	}
+
+	void InputEventSource_Headless::Poll( std::vector<InputEvent>* events_out )
+	{
+		std::lock_guard<std::mutex> lock( m_Lock );
+		events_out->insert( events_out->end(), m_Events.begin(), m_Events.end() );
+		m_Events.clear();
+	}
+
+}; // namespace Input
@@ -0,0 +1,26 @@
+#pragma once
+
+#include "InputEvent.h"
+
+#include <mutex>
+
+namespace Input
+{
+	/* events handed in by code instead of a device, for tests and runs without a window */
+	class InputEventSource_Headless final : public IInputEventSource
+	{
+	public:
+		InputEventSource_Headless() = default;
+		~InputEventSource_Headless() override = default;
+
+		/* any thread, an event without a time is stamped now */
+		void Inject( const InputEvent& event );
+
+		void Poll( std::vector<InputEvent>* events_out ) override;
+
+	private:
+		std::mutex m_Lock;
+		std::vector<InputEvent> m_Events;
+	};
+
+}; // namespace Input
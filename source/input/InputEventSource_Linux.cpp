@@ -0,0 +1,185 @@
+#include "InputEventSource_Linux.h"
+
+#ifdef __linux__
+#include <cerrno>
+#include <cstdio>
+#include <ctime>
+#include <fcntl.h>
+#include <linux/input.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+namespace Input
+{
+	constexpr uint32 s_MaxEventNodes = 64;
+
+	// the keys past KEY_F12 that have a DIK_ code, as { evdev code, DIK_ code }
+	constexpr uint16 s_ExtendedKeys[][2] = {
+		{ KEY_KPENTER, 0x9c },	 { KEY_RIGHTCTRL, 0x9d }, { KEY_KPSLASH, 0xb5 },	{ KEY_SYSRQ, 0xb7 },
+		{ KEY_RIGHTALT, 0xb8 },	 { KEY_HOME, 0xc7 },	  { KEY_UP, 0xc8 },			{ KEY_PAGEUP, 0xc9 },
+		{ KEY_LEFT, 0xcb },		 { KEY_RIGHT, 0xcd },	  { KEY_END, 0xcf },		{ KEY_DOWN, 0xd0 },
+		{ KEY_PAGEDOWN, 0xd1 },	 { KEY_INSERT, 0xd2 },	  { KEY_DELETE, 0xd3 },		{ KEY_LEFTMETA, 0xdb },
+		{ KEY_RIGHTMETA, 0xdc }, { KEY_COMPOSE, 0xdd },
+	};
+
+	static bool TranslateKey( uint16 code, uint8* dik_out )
+	{
+		// up to F12 the evdev codes are the set 1 scan codes DIK_ uses as well
+		if( code >= KEY_ESC && code <= KEY_F12 )
+		{
+			*dik_out = (uint8)code;
+			return true;
+		}
+
+		for( const uint16* key : s_ExtendedKeys )
+		{
+			if( key[0] == code )
+			{
+				*dik_out = (uint8)key[1];
+				return true;
+			}
+		}
+		return false;
+	}
+
+	static uint64 GetEventTime( const input_event& raw )
+	{
+#ifdef input_event_sec
+		return (uint64)raw.input_event_sec * 1000000 + raw.input_event_usec;
+#else
+		return (uint64)raw.time.tv_sec * 1000000 + raw.time.tv_usec;
+#endif
+	}
+
+	static bool HasBit( const unsigned long* bits, uint32 bit )
+	{
+		constexpr uint32 bitsPerLong = sizeof( unsigned long ) * 8;
+		return ( bits[bit / bitsPerLong] >> ( bit % bitsPerLong ) ) & 1;
+	}
+
+	InputEventSource_Linux::~InputEventSource_Linux() { Close(); }
+
+	uint32 InputEventSource_Linux::OpenAll()
+	{
+		uint32 opened = 0;
+		for( uint32 i = 0; i < s_MaxEventNodes; ++i )
+		{
+			char path[32];
+			snprintf( path, sizeof( path ), "/dev/input/event%u", i );
+			const int fd = open( path, O_RDONLY | O_NONBLOCK | O_CLOEXEC );
+			if( fd < 0 )
+				continue;
+
+			unsigned long types[1] = {};
+			if( ioctl( fd, EVIOCGBIT( 0, sizeof( types ) ), types ) < 0 ||
+				( !HasBit( types, EV_KEY ) && !HasBit( types, EV_REL ) ) )
+			{
+				close( fd );
+				continue;
+			}
+
+			AddDevice( fd );
+			opened++;
+		}
+		return opened;
+	}
+
+	void InputEventSource_Linux::AddDevice( int fd )
+	{
+		fcntl( fd, F_SETFL, fcntl( fd, F_GETFL ) | O_NONBLOCK );
+
+		Device device;
+		device.m_Fd = fd;
+		int clock = CLOCK_MONOTONIC;
+		device.m_KernelTime = ioctl( fd, EVIOCSCLOCKID, &clock ) == 0;
+		m_Devices.push_back( device );
+	}
+
+	void InputEventSource_Linux::Close()
+	{
+		for( Device& device : m_Devices )
+		{
+			if( device.m_Fd >= 0 )
+				close( device.m_Fd );
+		}
+		m_Devices.clear();
+	}
+
+	void InputEventSource_Linux::Poll( std::vector<InputEvent>* events_out )
+	{
+		input_event buffer[64];
+		for( Device& device : m_Devices )
+		{
+			if( device.m_Fd < 0 )
+				continue;
+
+			const uint64 now = GetInputTime();
+			ssize_t bytes = 0;
+			while( ( bytes = read( device.m_Fd, buffer, sizeof( buffer ) ) ) > 0 )
+			{
+				const uint32 count = (uint32)( bytes / sizeof( input_event ) );
+				for( uint32 i = 0; i < count; ++i )
+				{
+					const input_event& raw = buffer[i];
+					InputEvent event;
+					event.m_Time = device.m_KernelTime ? GetEventTime( raw ) : now;
+
+					if( raw.type == EV_KEY )
+					{
+						// 2 is the key repeating, the press was already sent
+						if( raw.value == 2 )
+							continue;
+
+						event.m_Type = raw.value ? EInputEventType_ButtonDown : EInputEventType_ButtonUp;
+						if( raw.code >= BTN_LEFT && raw.code <= BTN_TASK )
+						{
+							event.m_Device = EDeviceType_Mouse;
+							event.m_Button = (uint8)( raw.code - BTN_LEFT );
+						}
+						else if( TranslateKey( raw.code, &event.m_Button ) )
+						{
+							event.m_Device = EDeviceType_Keyboard;
+						}
+						else
+						{
+							continue;
+						}
+						events_out->push_back( event );
+					}
+					else if( raw.type == EV_REL )
+					{
+						if( raw.code == REL_X )
+							device.m_MoveX += (float)raw.value;
+						else if( raw.code == REL_Y )
+							device.m_MoveY += (float)raw.value;
+						else if( raw.code == REL_WHEEL )
+							device.m_MoveZ += (float)raw.value;
+						else
+							continue;
+						device.m_Moved = true;
+					}
+					else if( raw.type == EV_SYN && raw.code == SYN_REPORT && device.m_Moved )
+					{
+						event.m_Device = EDeviceType_Mouse;
+						event.m_Type = EInputEventType_Move;
+						event.m_X = device.m_MoveX;
+						event.m_Y = device.m_MoveY;
+						event.m_Z = device.m_MoveZ;
+						events_out->push_back( event );
+						device.m_MoveX = device.m_MoveY = device.m_MoveZ = 0.f;
+						device.m_Moved = false;
+					}
+				}
+			}
+
+			// unplugged, the node is gone for good
+			if( bytes < 0 && errno == ENODEV )
+			{
+				close( device.m_Fd );
+				device.m_Fd = -1;
+			}
+		}
+	}
+
+}; // namespace Input
+#endif
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "InputEvent.h"
+
+namespace Input
+{
+	/*
+		Keyboards and mice read through evdev, /dev/input/event*. The devices are read without blocking and the
+		events keep the kernel's time stamps, on the same clock as GetInputTime.
+
+		Key codes are translated to the DIK_ scan codes the rest of the input uses, the common keys share their
+		values and the extended ones are mapped. Mouse buttons become button indices, relative motion is collected
+		until the kernel ends the report and sent as one move.
+	*/
+	class InputEventSource_Linux final : public IInputEventSource
+	{
+	public:
+		InputEventSource_Linux() = default;
+		~InputEventSource_Linux() override;
+
+		/* every /dev/input/event* that has keys or relative axes, returns how many were opened */
+		uint32 OpenAll();
+		/* takes ownership of fd, anything that reads like an evdev node works */
+		void AddDevice( int fd );
+		void Close();
+
+		void Poll( std::vector<InputEvent>* events_out ) override;
+
+	private:
+		struct Device
+		{
+			int m_Fd = -1;
+			bool m_KernelTime = false; // the kernel stamps on the monotonic clock, otherwise stamped when read
+			float m_MoveX = 0.f;
+			float m_MoveY = 0.f;
+			float m_MoveZ = 0.f;
+			bool m_Moved = false;
+		};
+
+		std::vector<Device> m_Devices;
+	};
+
+}; // namespace Input
@@ -0,0 +1,128 @@
+#include "InputEventSource_Win32.h"
+#include <cassert>
+#include <dinput.h>
+
+namespace Input
+{
+	// events a device keeps between two polls, at 1 kHz this is plenty
+	constexpr DWORD s_BufferSize = 256;
+
+	static IDirectInputDevice8* CreateBufferedDevice( IDirectInput8* input, REFGUID guid, LPCDIDATAFORMAT format,
+													  HWindow window_handle )
+	{
+		IDirectInputDevice8* device = nullptr;
+		if( input->CreateDevice( guid, &device, nullptr ) != S_OK )
+		{
+			assert( !"Failed to create input device!" );
+			return nullptr;
+		}
+
+		DIPROPDWORD buffer_size = {};
+		buffer_size.diph.dwSize = sizeof( DIPROPDWORD );
+		buffer_size.diph.dwHeaderSize = sizeof( DIPROPHEADER );
+		buffer_size.diph.dwObj = 0;
+		buffer_size.diph.dwHow = DIPH_DEVICE;
+		buffer_size.dwData = s_BufferSize;
+
+		if( device->SetDataFormat( format ) != S_OK ||
+			device->SetCooperativeLevel( window_handle, DISCL_BACKGROUND | DISCL_NONEXCLUSIVE ) != S_OK ||
+			device->SetProperty( DIPROP_BUFFERSIZE, &buffer_size.diph ) != S_OK )
+		{
+			assert( !"Failed to set up buffered input device!" );
+			device->Release();
+			return nullptr;
+		}
+
+		device->Acquire();
+		return device;
+	}
+
+	InputEventSource_Win32::InputEventSource_Win32( HWindow window_handle, HInstance instance_handle )
+	{
+		HRESULT hr =
+			DirectInput8Create( instance_handle, DIRECTINPUT_VERSION, IID_IDirectInput8, (void**)&m_Input, nullptr );
+		assert( hr == S_OK && "Failed to create dinput8" );
+		if( hr != S_OK )
+			return;
+
+		m_Keyboard = CreateBufferedDevice( m_Input, GUID_SysKeyboard, &c_dfDIKeyboard, window_handle );
+		m_Mouse = CreateBufferedDevice( m_Input, GUID_SysMouse, &c_dfDIMouse2, window_handle );
+	}
+
+	InputEventSource_Win32::~InputEventSource_Win32()
+	{
+		IDirectInputDevice8* devices[] = { m_Keyboard, m_Mouse };
+		for( IDirectInputDevice8* device : devices )
+		{
+			if( device )
+			{
+				device->Unacquire();
+				device->Release();
+			}
+		}
+
+		if( m_Input )
+			m_Input->Release();
+	}
+
+	void InputEventSource_Win32::Poll( std::vector<InputEvent>* events_out )
+	{
+		if( m_Keyboard )
+			PollDevice( m_Keyboard, EDeviceType_Keyboard, events_out );
+		if( m_Mouse )
+			PollDevice( m_Mouse, EDeviceType_Mouse, events_out );
+	}
+
+	void InputEventSource_Win32::PollDevice( IDirectInputDevice8* device, EDeviceType device_type,
+											 std::vector<InputEvent>* events_out )
+	{
+		DIDEVICEOBJECTDATA data[s_BufferSize];
+		DWORD count = s_BufferSize;
+		const HRESULT hr = device->GetDeviceData( sizeof( DIDEVICEOBJECTDATA ), data, &count, 0 );
+		if( hr == DIERR_INPUTLOST || hr == DIERR_NOTACQUIRED )
+		{
+			// lost focus or the device was reset, what happened in between is gone
+			device->Acquire();
+			return;
+		}
+
+		// DI_BUFFEROVERFLOW still succeeds, only the oldest events were lost
+		if( FAILED( hr ) )
+			return;
+
+		const uint64 now = GetInputTime();
+		for( DWORD i = 0; i < count; ++i )
+		{
+			const DWORD offset = data[i].dwOfs;
+			const bool down = ( data[i].dwData & 0x80 ) != 0;
+
+			InputEvent event;
+			event.m_Time = now;
+			event.m_Device = device_type;
+			event.m_Type = down ? EInputEventType_ButtonDown : EInputEventType_ButtonUp;
+			if( device_type == EDeviceType_Keyboard )
+			{
+				event.m_Button = (uint8)offset;
+			}
+			else if( offset == DIMOFS_X || offset == DIMOFS_Y || offset == DIMOFS_Z )
+			{
+				// the axes hold a relative LONG
+				const float delta = (float)(LONG)data[i].dwData;
+				event.m_Type = EInputEventType_Move;
+				event.m_X = offset == DIMOFS_X ? delta : 0.f;
+				event.m_Y = offset == DIMOFS_Y ? delta : 0.f;
+				event.m_Z = offset == DIMOFS_Z ? delta : 0.f;
+			}
+			else if( offset >= DIMOFS_BUTTON0 && offset <= DIMOFS_BUTTON7 )
+			{
+				event.m_Button = (uint8)( offset - DIMOFS_BUTTON0 );
+			}
+			else
+			{
+				continue;
+			}
+			events_out->push_back( event );
+		}
+	}
+
+}; // namespace Input
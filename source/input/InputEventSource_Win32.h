@@ -0,0 +1,30 @@
+#pragma once
+
+#include "InputEvent.h"
+
+namespace Input
+{
+	/*
+		Keyboard and mouse through DirectInput's buffered mode. The device queues every change with its sequence
+		number, so a poll gets all of them in order instead of just the state at that moment.
+
+		DirectInput's own time stamps are GetTickCount milliseconds, the events are stamped when they are read
+		instead, which at the input thread's rate is finer than that.
+	*/
+	class InputEventSource_Win32 final : public IInputEventSource
+	{
+	public:
+		InputEventSource_Win32( HWindow window_handle, HInstance instance_handle );
+		~InputEventSource_Win32() override;
+
+		void Poll( std::vector<InputEvent>* events_out ) override;
+
+	private:
+		void PollDevice( IDirectInputDevice8* device, EDeviceType device_type, std::vector<InputEvent>* events_out );
+
+		IDirectInput8* m_Input = nullptr;
+		IDirectInputDevice8* m_Keyboard = nullptr;
+		IDirectInputDevice8* m_Mouse = nullptr;
+	};
+
+}; // namespace Input
@@ -0,0 +1,68 @@
+#include "InputEventThread.h"
+
+#include <chrono>
+
+namespace Input
+{
+	constexpr uint32 s_QueueCapacity = 1024;
+	constexpr uint32 s_MaxPendingEvents = 4 * s_QueueCapacity;
+
+	uint64 GetInputTime()
+	{
+		const auto now = std::chrono::steady_clock::now().time_since_epoch();
+		return (uint64)std::chrono::duration_cast<std::chrono::microseconds>( now ).count();
+	}
+
+	InputEventThread::~InputEventThread() { Stop(); }
+
+	void InputEventThread::Start( IInputEventSource* const* sources, uint32 source_count, uint32 rate_hz )
+	{
+		Stop();
+		m_Sources.assign( sources, sources + source_count );
+		m_Pending.clear();
+		m_Queue.Init( s_QueueCapacity );
+		m_Dropped = 0;
+		m_IntervalUs = 1000000 / ( rate_hz > 0 ? rate_hz : 1 );
+		m_Running = true;
+		m_Thread = std::thread( &InputEventThread::Run, this );
+	}
+
+	void InputEventThread::Stop()
+	{
+		m_Running = false;
+		if( m_Thread.joinable() )
+			m_Thread.join();
+	}
+
+	void InputEventThread::Run()
+	{
+		auto next = std::chrono::steady_clock::now();
+		while( m_Running.load( std::memory_order_relaxed ) )
+		{
+			for( IInputEventSource* source : m_Sources )
+				source->Poll( &m_Pending );
+
+			// what doesn't fit stays pending for the next poll, the order is kept
+			size_t pushed = 0;
+			while( pushed < m_Pending.size() && m_Queue.Push( m_Pending[pushed] ) )
+				pushed++;
+			m_Pending.erase( m_Pending.begin(), m_Pending.begin() + pushed );
+
+			if( m_Pending.size() > s_MaxPendingEvents )
+			{
+				const size_t dropped = m_Pending.size() - s_MaxPendingEvents;
+				m_Pending.erase( m_Pending.begin(), m_Pending.begin() + dropped );
+				m_Dropped += (uint32)dropped;
+			}
+
+			// a late poll already caught everything, the missed ones are not made up for
+			next += std::chrono::microseconds( m_IntervalUs );
+			const auto now = std::chrono::steady_clock::now();
+			if( next < now )
+				next = now;
+			else
+				std::this_thread::sleep_until( next );
+		}
+	}
+
+}; // namespace Input
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "InputEvent.h"
+#include "Core/threading/SpscQueue.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace Input
+{
+	/*
+		Polls the event sources on a thread of its own, many times a frame, and hands the events to the game thread
+		through a lock free queue. A press and release that both fall inside one frame arrive as two events instead
+		of being missed between two polls of the device state.
+
+		The queue only has this thread as producer and the game thread as consumer. Events that don't fit wait on
+		this thread until the game thread made room, they are only dropped when that backlog grows too large too.
+	*/
+	class InputEventThread
+	{
+	public:
+		InputEventThread() = default;
+		~InputEventThread();
+
+		/* the sources are polled rate_hz times a second until Stop, they must outlive it */
+		void Start( IInputEventSource* const* sources, uint32 source_count, uint32 rate_hz = 1000 );
+		void Stop();
+		bool IsRunning() const { return m_Thread.joinable(); }
+
+		/* game thread, the next event in the order they happened */
+		bool Pop( InputEvent* event_out ) { return m_Queue.Pop( event_out ); }
+
+		uint32 GetDroppedCount() const { return m_Dropped.load( std::memory_order_relaxed ); }
+
+	private:
+		void Run();
+
+		std::vector<IInputEventSource*> m_Sources;
+		std::vector<InputEvent> m_Pending;
+		Core::SpscQueue<InputEvent> m_Queue;
+		std::thread m_Thread;
+		std::atomic<bool> m_Running{ false };
+		std::atomic<uint32> m_Dropped{ 0 };
+		uint32 m_IntervalUs = 1000;
+	};
+
+}; // namespace Input
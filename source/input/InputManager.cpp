@@ -1,7 +1,16 @@
 #include "InputManager.h"
 
+#include "InputDeviceEvents.h"
+#include "InputDeviceReplay.h"
+#ifdef _WIN32
 #include "InputDeviceKeyboard_Win32.h"
 #include "InputDeviceMouse_Win32.h"
+#include "InputEventSource_Win32.h"
+#elif defined( __linux__ )
+#include "InputEventSource_Linux.h"
+#endif
+
+#include "Core/profiler/Profiler.h"
 
 #include <cassert>
 
@@ -9,18 +18,126 @@ namespace Input
 {
 	InputManager* InputManager::m_Instance = nullptr;
 
-	void InputManager::Initialize( HWindow window_handle, HInstance window_instance )
+	InputManager::~InputManager()
+	{
+		StopRecording();
+		StopReplay();
+		m_EventThread.Stop();
+		delete m_PlatformSource;
+
+		// the event devices are ours, the thread that fed them is gone
+		for( InputDeviceEvents*& device : m_EventDevices )
+		{
+			delete device;
+			device = nullptr;
+		}
+	}
+
+	void InputManager::Initialize( HWindow window_handle, HInstance window_instance, EBackend backend )
 	{
+		if( backend == EBackend_Events )
+		{
+#ifdef _WIN32
+			m_PlatformSource = new InputEventSource_Win32( window_handle, window_instance );
+#elif defined( __linux__ )
+			InputEventSource_Linux* source = new InputEventSource_Linux;
+			source->OpenAll();
+			m_PlatformSource = source;
+#endif
+			if( m_PlatformSource )
+				InitializeEvents( &m_PlatformSource, 1 );
+			return;
+		}
+
+#ifdef _WIN32
 		m_Devices.push_back( new HInputDeviceKeyboard( window_handle, window_instance ) );
 		m_Devices.push_back( new HInputDeviceMouse( window_handle, window_instance ) );
+#endif
 	}
 
-	void InputManager::Update()
+	void InputManager::InitializeEvents( IInputEventSource* const* sources, uint32 source_count )
 	{
+		const EDeviceType types[] = { EDeviceType_Keyboard, EDeviceType_Mouse };
+		for( EDeviceType type : types )
+		{
+			m_EventDevices[type] = new InputDeviceEvents( type );
+			m_Devices.push_back( m_EventDevices[type] );
+		}
+		m_EventThread.Start( sources, source_count );
+	}
+
+	float InputManager::Update( float dt )
+	{
+		PROFILE_FUNCTION();
 		for( const auto& device : m_Devices )
 		{
 			device->Update();
 		}
+
+		// everything the input thread collected since the last frame
+		InputEvent event;
+		while( m_EventThread.Pop( &event ) )
+		{
+			if( event.m_Device < ARRSIZE( m_EventDevices ) && m_EventDevices[event.m_Device] )
+				m_EventDevices[event.m_Device]->OnEvent( event );
+		}
+
+		if( IsReplaying() )
+		{
+			float recorded_dt = 0.f;
+			if( m_Replay.ReadFrame( &recorded_dt, m_ReplayStates.data() ) )
+			{
+				for( size_t i = 0; i < m_ReplayDevices.size(); ++i )
+					static_cast<InputDeviceReplay*>( m_ReplayDevices[i] )->SetState( m_ReplayStates[i] );
+				dt = recorded_dt;
+			}
+			else
+			{
+				StopReplay();
+			}
+		}
+
+		// a replay can be recorded again, what the game saw is what gets written
+		if( m_Recorder.IsOpen() )
+			m_Recorder.WriteFrame( dt );
+
+		return dt;
+	}
+
+	bool InputManager::StartRecording( const char* filepath )
+	{
+		m_RecordingReplay = IsReplaying();
+		const std::vector<IInputDevice*>& devices = m_RecordingReplay ? m_ReplayDevices : m_Devices;
+		return m_Recorder.Open( filepath, devices.data(), (uint32)devices.size() );
+	}
+
+	void InputManager::StopRecording()
+	{
+		m_Recorder.Close();
+		m_RecordingReplay = false;
+	}
+
+	bool InputManager::StartReplay( const char* filepath )
+	{
+		StopReplay();
+		if( !m_Replay.Open( filepath ) )
+			return false;
+
+		for( uint32 i = 0; i < m_Replay.GetDeviceCount(); ++i )
+			m_ReplayDevices.push_back( new InputDeviceReplay( m_Replay.GetDeviceType( i ) ) );
+		m_ReplayStates.resize( m_ReplayDevices.size() );
+		return true;
+	}
+
+	void InputManager::StopReplay()
+	{
+		// a recording of the replay ends with it, the recorder reads the devices deleted here
+		if( m_RecordingReplay )
+			StopRecording();
+
+		for( IInputDevice* device : m_ReplayDevices )
+			delete device;
+		m_ReplayDevices.clear();
 	}
 
 	void InputManager::AddDevice( IInputDevice* input_device ) { m_Devices.push_back( input_device ); }
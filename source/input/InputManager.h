@@ -1,6 +1,9 @@
 #pragma once
 #include "InputDevice.h"
+#include "InputEventThread.h"
+#include "InputRecording.h"
 #include <Core/Defines.h>
+#include <cassert>
 #include <vector>
 
 namespace Input
@@ -9,12 +12,31 @@ namespace Input
 	{
 	public:
 		InputManager() = default;
-		~InputManager() = default;
+		~InputManager();
 
-		void Initialize( HWindow windowHandle, HInstance windowInstance );
+		enum EBackend
+		{
+			EBackend_Polling, // the device state is read once a frame
+			EBackend_Events	  // a thread collects the platform's events, presses inside a frame are not lost
+		};
+
+		void Initialize( HWindow windowHandle, HInstance windowInstance, EBackend backend = EBackend_Events );
+
+		/* the event backend on sources of your own, like InputEventSource_Headless. They must outlive the manager */
+		void InitializeEvents( IInputEventSource* const* sources, uint32 sourceCount );
+
+		/* update the inputs, returns the frame time to use: dt, or the recorded one while replaying */
+		float Update( float dt );
 
-		/* update the inputs */
-		void Update();
+		/* every frame's input and frame time are written to filepath until StopRecording or the recorded replay ends */
+		bool StartRecording( const char* filepath );
+		void StopRecording();
+		bool IsRecording() const { return m_Recorder.IsOpen(); }
+
+		/* the devices are replaced by ones playing back filepath, the real devices come back when it ends */
+		bool StartReplay( const char* filepath );
+		void StopReplay();
+		bool IsReplaying() const { return !m_ReplayDevices.empty(); }
 
 		/* add a device to the device list */
 		void AddDevice( IInputDevice* inputDevice );
@@ -29,6 +51,16 @@ namespace Input
 	private:
 		static InputManager* m_Instance;
 		std::vector<IInputDevice*> m_Devices{};
+
+		InputEventThread m_EventThread;
+		IInputEventSource* m_PlatformSource = nullptr;
+		class InputDeviceEvents* m_EventDevices[EDeviceType_Gamepad + 1] = {}; // by device type
+
+		InputRecorder m_Recorder;
+		bool m_RecordingReplay = false; // the recorder holds m_ReplayDevices
+		InputReplay m_Replay;
+		std::vector<IInputDevice*> m_ReplayDevices; // InputDeviceReplay, one per recorded device
+		std::vector<DeviceState> m_ReplayStates;
 	};
 
 	template <typename T>
@@ -39,9 +71,11 @@ namespace Input
 
 		if( deviceType != EDeviceType_Gamepad )
 		{
-			for( size_t i = 0; i < m_Devices.size(); ++i )
+			// the replay devices stand in for the real ones while a recording plays
+			const std::vector<IInputDevice*>& devices = IsReplaying() ? m_ReplayDevices : m_Devices;
+			for( size_t i = 0; i < devices.size(); ++i )
 			{
-				Input::IInputDevice* device = m_Devices[i];
+				Input::IInputDevice* device = devices[i];
 				if( device->GetType() == deviceType )
 				{
 					*deviceOut = static_cast<T*>( device );
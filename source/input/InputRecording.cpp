@@ -0,0 +1,133 @@
+#include "InputRecording.h"
+
+#include "Core/File.h"
+
+#include <cassert>
+#include <cstring>
+
+namespace Input
+{
+	constexpr uint32 s_RecordingMagic = 0x52504e49; // "INPR"
+	constexpr uint32 s_RecordingVersion = 1;
+
+	InputRecorder::~InputRecorder() { Close(); }
+
+	bool InputRecorder::Open( const char* filepath, IInputDevice* const* devices, uint32 device_count )
+	{
+		assert( device_count <= s_MaxRecordedDevices && "Too many input devices to record!" );
+		Close();
+
+		m_File = fopen( filepath, "wb" );
+		if( !m_File )
+			return false;
+
+		m_Devices.assign( devices, devices + device_count );
+		m_States.assign( device_count, DeviceState() );
+		m_FrameCount = 0;
+
+		const uint32 header[] = { s_RecordingMagic, s_RecordingVersion, device_count };
+		fwrite( header, sizeof( header ), 1, m_File );
+		for( IInputDevice* device : m_Devices )
+		{
+			const uint32 type = device->GetType();
+			fwrite( &type, sizeof( type ), 1, m_File );
+		}
+		return true;
+	}
+
+	void InputRecorder::Close()
+	{
+		if( m_File )
+			fclose( m_File );
+
+		m_File = nullptr;
+		m_Devices.clear();
+		m_States.clear();
+	}
+
+	void InputRecorder::WriteFrame( float dt )
+	{
+		if( !m_File )
+			return;
+
+		uint8 changed = 0;
+		DeviceState states[s_MaxRecordedDevices];
+		for( uint32 i = 0; i < (uint32)m_Devices.size(); ++i )
+		{
+			m_Devices[i]->GetState( &states[i] );
+			if( memcmp( &states[i], &m_States[i], sizeof( DeviceState ) ) != 0 )
+			{
+				changed |= 1 << i;
+				m_States[i] = states[i];
+			}
+		}
+
+		fwrite( &dt, sizeof( dt ), 1, m_File );
+		fwrite( &changed, sizeof( changed ), 1, m_File );
+		for( uint32 i = 0; i < (uint32)m_Devices.size(); ++i )
+		{
+			if( changed & ( 1 << i ) )
+				fwrite( &states[i], sizeof( DeviceState ), 1, m_File );
+		}
+		m_FrameCount++;
+	}
+
+	bool InputReplay::Open( const char* filepath )
+	{
+		m_Data.clear();
+		m_DeviceTypes.clear();
+		m_Position = 0;
+
+		Core::File file( filepath, Core::File::READ_FILE );
+		const uint8* buffer = (const uint8*)file.GetBuffer();
+		m_Data.assign( buffer, buffer + file.GetSize() );
+
+		uint32 header[3] = {};
+		if( !Read( header, sizeof( header ) ) )
+			return false;
+
+		if( header[0] != s_RecordingMagic || header[1] != s_RecordingVersion || header[2] > s_MaxRecordedDevices )
+			return false;
+
+		for( uint32 i = 0; i < header[2]; ++i )
+		{
+			uint32 type = 0;
+			if( !Read( &type, sizeof( type ) ) )
+				return false;
+
+			m_DeviceTypes.push_back( (EDeviceType)type );
+		}
+		m_States.assign( m_DeviceTypes.size(), DeviceState() );
+		return true;
+	}
+
+	bool InputReplay::ReadFrame( float* dt_out, DeviceState* states_out )
+	{
+		float dt = 0.f;
+		uint8 changed = 0;
+		if( !Read( &dt, sizeof( dt ) ) || !Read( &changed, sizeof( changed ) ) )
+			return false;
+
+		for( uint32 i = 0; i < (uint32)m_States.size(); ++i )
+		{
+			// a frame cut off at the end of the file is not played
+			if( ( changed & ( 1 << i ) ) && !Read( &m_States[i], sizeof( DeviceState ) ) )
+				return false;
+
+			states_out[i] = m_States[i];
+		}
+		*dt_out = dt;
+		return true;
+	}
+
+	bool InputReplay::Read( void* data, uint32 size )
+	{
+		if( m_Position + size > (uint32)m_Data.size() )
+			return false;
+
+		memcpy( data, &m_Data[m_Position], size );
+		m_Position += size;
+		return true;
+	}
+
+}; // namespace Input
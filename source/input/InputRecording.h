@@ -0,0 +1,67 @@
+#pragma once
+
+#include "InputDevice.h"
+
+#include <cstdio>
+#include <vector>
+
+/*
+	Input written to and read back from a binary file, so the same session can be played again on any machine.
+
+	The file starts with the types of the recorded devices. Every frame after that is the frame time, one byte with
+	a bit for each device whose state changed since the frame before, and the new state of those devices. A device
+	that is not touched costs nothing, an idle frame is five bytes.
+*/
+
+namespace Input
+{
+	constexpr uint32 s_MaxRecordedDevices = 8;
+
+	class InputRecorder
+	{
+	public:
+		InputRecorder() = default;
+		~InputRecorder();
+
+		/* the devices are recorded in this order until Close */
+		bool Open( const char* filepath, IInputDevice* const* devices, uint32 device_count );
+		void Close();
+
+		/* the state the devices have right now */
+		void WriteFrame( float dt );
+
+		bool IsOpen() const { return m_File != nullptr; }
+		uint32 GetFrameCount() const { return m_FrameCount; }
+
+	private:
+		// written as it goes, a session that crashes keeps what was recorded so far
+		FILE* m_File = nullptr;
+		std::vector<IInputDevice*> m_Devices;
+		std::vector<DeviceState> m_States;
+		uint32 m_FrameCount = 0;
+	};
+
+	class InputReplay
+	{
+	public:
+		InputReplay() = default;
+		~InputReplay() = default;
+
+		bool Open( const char* filepath );
+
+		uint32 GetDeviceCount() const { return (uint32)m_DeviceTypes.size(); }
+		EDeviceType GetDeviceType( uint32 device ) const { return m_DeviceTypes[device]; }
+
+		/* the next frame, one state per device. Returns false at the end of the recording. */
+		bool ReadFrame( float* dt_out, DeviceState* states_out );
+
+	private:
+		std::vector<uint8> m_Data;
+		std::vector<EDeviceType> m_DeviceTypes;
+		std::vector<DeviceState> m_States;
+		uint32 m_Position = 0;
+
+		bool Read( void* data, uint32 size );
+	};
+
+}; // namespace Input
@@ -65,6 +65,9 @@ end
     includedirs { ".\\" }
     warnings "Extra"
 
+    -- CPU profiler scopes, remove to compile all PROFILE_* macros out
+    defines { "PROFILER_ENABLED" }
+
     objdir "%{wks.location}/obj/%{cfg.buildcfg}/%{prj.name}"
     staticruntime "on"
     filter "system:Windows"
@@ -6,12 +6,57 @@ struct VSOutput
     float4 color : COLOR;
     float4 normal : NORMAL;
     float4 lightDir : LIGHT;
+    float4 worldPosition : WORLD;
+    float viewDepth : VIEWDEPTH;
 };
 
+cbuffer viewProjection : register (b0)
+{
+    row_major float4x4 viewProj;
+    float4 lightDir; 
+    row_major float4x4 view;
+    float4 clusterParams; // clusters per pixel in x and y, depth slice scale and bias
+    uint4 clusterSize;
+};
+
+// Graphics::Light, point lights have a cone cosine below -1
+struct Light
+{
+    float4 position; // w is the range
+    float4 color;
+    float4 direction; // w is the cosine of the spot cone
+};
+
+[[vk::binding(1)]] StructuredBuffer<Light> lights;
+[[vk::binding(2)]] StructuredBuffer<uint2> clusters; // offset and count into lightIndices, built by LightClusters
+[[vk::binding(3)]] StructuredBuffer<uint> lightIndices;
+
+float3 ClusterLighting(float3 position, float3 normal, float2 pixel, float viewDepth)
+{
+    uint3 cluster;
+    cluster.xy = min(uint2(pixel * clusterParams.xy), clusterSize.xy - 1);
+    cluster.z = min(uint(max(log(viewDepth) * clusterParams.z + clusterParams.w, 0)), clusterSize.z - 1);
+    const uint2 range = clusters[(cluster.z * clusterSize.y + cluster.y) * clusterSize.x + cluster.x];
+
+    float3 result = 0;
+    for (uint i = 0; i < range.y; ++i)
+    {
+        const Light light = lights[lightIndices[range.x + i]];
+        const float3 toLight = light.position.xyz - position;
+        const float distance = length(toLight);
+        const float3 direction = toLight / max(distance, 0.0001);
+
+        const float falloff = saturate(1 - distance / light.position.w);
+        const float cone = smoothstep(light.direction.w - 0.05, light.direction.w, dot(-direction, light.direction.xyz));
+        result += light.color.rgb * saturate(dot(normal, direction)) * falloff * falloff * cone;
+    }
+    return result;
+}
 
 float4 main(VSOutput input) : SV_Target 
 {
     float3 normal = normalize(input.normal.xyz);
     float3 output = dot(normal, -input.lightDir.xyz);
-    return saturate(input.color * float4(1,1,0,1) * float4(output, 1)) + 1 * 0.42;
-}
\ No newline at end of file
+    float3 lit = ClusterLighting(input.worldPosition.xyz, normal, input.position.xy, input.viewDepth);
+    return saturate(input.color * float4(1,1,0,1) * float4(output, 1)) + 1 * 0.42 + float4(lit * input.color.rgb, 0);
+}
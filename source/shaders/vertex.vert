@@ -11,6 +11,9 @@ cbuffer viewProjection : register (b0)
 {
     row_major float4x4 viewProj;
     float4 lightDir; 
+    row_major float4x4 view;
+    float4 clusterParams; // clusters per pixel in x and y, depth slice scale and bias
+    uint4 clusterSize;
 };
 
 struct VSInput 
@@ -26,18 +29,20 @@ struct VSOutput
     float4 color : COLOR;
     float4 normal : NORMAL;
     float4 lightDir : LIGHT;
+    float4 worldPosition : WORLD;
+    float viewDepth : VIEWDEPTH;
 };
 
 VSOutput main(VSInput input, uint vertex_id : SV_VertexID) 
 {
     VSOutput output = (VSOutput)0;
 
-    output.position = mul(input.position, pc.world);
-    output.position = mul(output.position, viewProj);
+    output.worldPosition = mul(input.position, pc.world);
+    output.position = mul(output.worldPosition, viewProj);
+    output.viewDepth = mul(output.worldPosition, view).z;
     output.lightDir = lightDir;
 
-    // output.normal = mul(input.normal, pc.world);
-    output.normal = input.normal;
+    output.normal = mul(float4(input.normal.xyz, 0), pc.world);
     output.color = input.color; //float4(1,1,1,1);
     return output;
 }
\ No newline at end of file
@@ -5,6 +5,57 @@
 #include "Core/math/Vector3.h"
 #include "Core/math/Vector2.h"
 #include "Core/containers/GrowingArray.h"
+#include "Core/containers/HashMap.h"
+#include "Core/hash/FastHash.h"
+#include "Core/hash/Murmur3.h"
+#include "Core/profiler/Profiler.h"
+#include "Core/String/HashStringTable.h"
+#include "Core/File.h"
+#include "Core/FixedTimestep.h"
+#include "Core/IoService.h"
+#include "Core/MappedFile.h"
+#include "Core/Timer.h"
+#include "Core/ecs/EntityCommandBuffer.h"
+#include "Core/ecs/TransformHierarchy.h"
+#include "Core/ecs/World.h"
+#include "Core/memory/ArenaAllocator.h"
+#include "Core/memory/FrameMemory.h"
+#include "Core/memory/MemoryTracker.h"
+#include "Core/memory/Pool.h"
+#include "Core/threading/SpscQueue.h"
+#include "Core/threading/ThreadPool.h"
+#include "Core/utilities/RadixSort.h"
+#include "graphics/HiZPyramid.h"
+#include "graphics/LightClusters.h"
+#include "graphics/MeshLod.h"
+#include "graphics/NullGraphicsDevice.h"
+#include "graphics/OcclusionBuffer.h"
+#include "graphics/RenderPacket.h"
+#include "graphics/RenderQueue.h"
+#include "graphics/ShaderReflection.h"
+#include "input/InputDeviceEvents.h"
+#include "input/InputDeviceReplay.h"
+#include "input/InputEventSource_Headless.h"
+#include "input/InputEventSource_Linux.h"
+#include "input/InputManager.h"
+#include "input/InputRecording.h"
+
+#include <algorithm>
+#include <atomic>
+#include <bitset>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <mutex>
+#include <new>
+#include <random>
+#include <thread>
+#include <unordered_map>
+
+#ifdef __linux__
+#include <linux/input.h>
+#include <unistd.h>
+#endif
 
 /*
 	different macros for unit tests
@@ -22,6 +73,38 @@
 	ASSERT_FALSE //fatal
 */
 
+// every heap allocation of the test binary is counted, for the tests that check a path does not allocate
+static std::atomic<uint64> s_HeapAllocations{ 0 };
+
+void* operator new(size_t size)
+{
+	s_HeapAllocations.fetch_add(1, std::memory_order_relaxed);
+	if(void* memory = malloc(size ? size : 1))
+		return memory;
+	throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept
+{
+	free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept
+{
+	free(memory);
+}
+
+// the milliseconds function takes, for the benchmarks
+template <typename Function>
+static float MeasureMs(Function&& function)
+{
+	Core::Timer timer;
+	timer.Init();
+	function();
+	timer.Update();
+	return timer.GetTime() * 1000.f;
+}
+
 TEST(Vector4, Length)
 {
 	constexpr float a = 193.f, b = 284.f, c = 321.f, d = 461.f;
@@ -113,6 +196,2501 @@ TEST(GrowingArray, Grow)
 	array.Add(11);
 }
 
+TEST(GrowingArray, NonTrivialAndMove)
+{
+	static int32 alive = 0;
+	struct Tracked
+	{
+		Tracked(const std::string& name)
+			: m_Name(name)
+		{
+			alive++;
+		}
+		Tracked(const Tracked& other)
+			: m_Name(other.m_Name)
+		{
+			alive++;
+		}
+		Tracked(Tracked&& other)
+			: m_Name(std::move(other.m_Name))
+		{
+			alive++;
+		}
+		Tracked& operator=(Tracked&& other) = default;
+		~Tracked() { alive--; }
+		std::string m_Name;
+	};
+
+	{
+		// nothing is constructed up front and growing moves the elements over
+		Core::GrowingArray<Tracked> array(2);
+		EXPECT_EQ(alive, 0);
+		for(uint32 i = 0; i < 20; ++i)
+			EXPECT_EQ(array.Emplace(std::to_string(i)).m_Name, std::to_string(i));
+		EXPECT_EQ(alive, 20);
+
+		// the reference is still good while the array grows under it
+		array.Add(array[3]);
+		EXPECT_EQ(array.GetLast().m_Name, "3");
+
+		array.RemoveCyclicAtIndex(0);
+		EXPECT_EQ(array[0].m_Name, "3");
+		EXPECT_EQ(array.Size(), 20u);
+		EXPECT_EQ(alive, 20);
+
+		Core::GrowingArray<Tracked> copy(array);
+		EXPECT_EQ(alive, 40);
+		const Tracked* data = array.GetData();
+		Core::GrowingArray<Tracked> moved(std::move(array));
+		EXPECT_EQ(moved.GetData(), data);
+		EXPECT_EQ(array.Size(), 0u);
+		EXPECT_EQ(alive, 40);
+
+		// assigning over an array destroys what it held
+		copy = std::move(moved);
+		EXPECT_EQ(alive, 20);
+		EXPECT_EQ(copy[19].m_Name, "19");
+	}
+	EXPECT_EQ(alive, 0);
+
+	// the state stack keeps arrays of arrays
+	Core::GrowingArray<Core::GrowingArray<int32>> nested;
+	for(int32 i = 0; i < 50; ++i)
+	{
+		nested.Add(Core::GrowingArray<int32>(4));
+		nested.GetLast().Add(i);
+	}
+	nested.RemoveCyclicAtIndex(0);
+	EXPECT_EQ(nested[0][0], 49);
+	EXPECT_EQ(nested[1][0], 1);
+}
+
+TEST(GrowingArray, InlineAndAllocator)
+{
+	Core::MemoryTracker& tracker = Core::MemoryTracker::Get();
+	const Core::MemoryTracker::Snapshot before = tracker.TakeSnapshot();
+	{
+		// nothing goes to the heap until the inline elements run out
+		Core::GrowingArray<uint32, 8> array;
+		for(uint32 i = 0; i < 8; ++i)
+			array.Add(i);
+		EXPECT_EQ(array.Capacity(), 8u);
+		EXPECT_EQ(Core::MemoryTracker::Diff(before, tracker.TakeSnapshot()).m_Sequence, 0u);
+
+		array.Add(8);
+		EXPECT_EQ(array.Capacity(), 16u);
+		EXPECT_EQ(Core::MemoryTracker::Diff(before, tracker.TakeSnapshot()).m_LiveCount[Core::EMemoryTag_Core], 1);
+
+		array.RemoveLast();
+		array.ShrinkToFit();
+		EXPECT_EQ(array.Capacity(), 8u);
+		EXPECT_EQ(Core::MemoryTracker::Diff(before, tracker.TakeSnapshot()).m_LiveCount[Core::EMemoryTag_Core], 0);
+
+		// inline elements are moved one by one, the source stays usable
+		Core::GrowingArray<uint32, 8> moved(std::move(array));
+		EXPECT_EQ(moved.Size(), 8u);
+		EXPECT_EQ(moved[7], 7u);
+		EXPECT_EQ(array.Size(), 0u);
+		array.Add(1);
+		EXPECT_EQ(array[0], 1u);
+	}
+
+	{
+		Core::LinearArena arena;
+		const Core::ArenaAllocator<uint32> allocator(&arena);
+		Core::GrowingArray<uint32, 0, Core::ArenaAllocator<uint32>> array(allocator);
+		for(uint32 i = 0; i < 100; ++i)
+			array.Add(i);
+		EXPECT_EQ(array[99], 99u);
+		EXPECT_GE(arena.GetUsed(), 100 * sizeof(uint32));
+	}
+	EXPECT_EQ(Core::MemoryTracker::Diff(before, tracker.TakeSnapshot()).m_LiveCount[Core::EMemoryTag_Core], 0);
+}
+
+TEST(GrowingArray, Benchmark)
+{
+	constexpr uint32 count = 1000000;
+	Core::Timer timer;
+	uint64 sum = 0;
+
+	timer.Init();
+	{
+		std::vector<uint32> vector;
+		for(uint32 i = 0; i < count; ++i)
+			vector.push_back(i);
+		for(uint32 value : vector)
+			sum += value;
+	}
+	timer.Update();
+	const float vectorMs = timer.GetTime() * 1000.f;
+
+	timer.Init();
+	{
+		Core::GrowingArray<uint32> array;
+		for(uint32 i = 0; i < count; ++i)
+			array.Add(i);
+		for(uint32 value : array)
+			sum += value;
+	}
+	timer.Update();
+	const float arrayMs = timer.GetTime() * 1000.f;
+	EXPECT_EQ(sum, (uint64)count * (count - 1));
+
+	// lots of short lists, where the inline elements save the allocation
+	constexpr uint32 listCount = 100000;
+	uint64 listSum = 0;
+	timer.Init();
+	for(uint32 list = 0; list < listCount; ++list)
+	{
+		std::vector<std::string> names;
+		for(uint32 i = 0; i < 4; ++i)
+			names.emplace_back(1, (char)('a' + i));
+		listSum += names.size();
+	}
+	timer.Update();
+	const float vectorListMs = timer.GetTime() * 1000.f;
+
+	timer.Init();
+	for(uint32 list = 0; list < listCount; ++list)
+	{
+		Core::GrowingArray<std::string, 4> names(0);
+		for(uint32 i = 0; i < 4; ++i)
+			names.Emplace(1, (char)('a' + i));
+		listSum += names.Size();
+	}
+	timer.Update();
+	const float arrayListMs = timer.GetTime() * 1000.f;
+	EXPECT_EQ(listSum, (uint64)listCount * 8);
+
+	printf("%u adds: std::vector %.2f ms GrowingArray %.2f ms\n", count, vectorMs, arrayMs);
+	printf("%u lists of 4 strings: std::vector %.2f ms GrowingArray<4> %.2f ms\n", listCount, vectorListMs,
+		   arrayListMs);
+}
+
+TEST(HashMap, MatchesUnorderedMap)
+{
+	// random inserts and erases on a small key range, so runs get long and erases shift them back
+	Core::HashMap<uint32, uint32> map;
+	std::unordered_map<uint32, uint32> reference;
+	std::mt19937 random(7);
+	for(uint32 i = 0; i < 100000; ++i)
+	{
+		const uint32 key = random() % 4096;
+		if(random() % 3 == 0)
+		{
+			EXPECT_EQ(map.Erase(key), reference.erase(key) == 1);
+		}
+		else
+		{
+			const bool inserted = reference.emplace(key, i).second;
+			EXPECT_EQ(map.Insert(key, i), inserted);
+		}
+	}
+	ASSERT_EQ(map.GetCount(), (uint32)reference.size());
+	for(const auto& entry : reference)
+	{
+		const uint32* value = map.Find(entry.first);
+		ASSERT_TRUE(value != nullptr);
+		EXPECT_EQ(*value, entry.second);
+	}
+	uint32 iterated = 0;
+	for(const auto& entry : map)
+	{
+		EXPECT_EQ(reference[entry.m_Key], entry.m_Value);
+		iterated++;
+	}
+	EXPECT_EQ(iterated, map.GetCount());
+	EXPECT_TRUE(map.Find(5000u) == nullptr);
+
+	// move only values, and the table can be moved
+	Core::HashMap<uint64, std::unique_ptr<uint32>> owners;
+	for(uint32 i = 0; i < 100; ++i)
+		owners.Insert(i * 0x100000000ull, std::unique_ptr<uint32>(new uint32(i)));
+	Core::HashMap<uint64, std::unique_ptr<uint32>> moved(std::move(owners));
+	EXPECT_EQ(owners.GetCount(), 0u);
+	EXPECT_EQ(**moved.Find(42 * 0x100000000ull), 42u);
+	moved[7] = std::unique_ptr<uint32>(new uint32(7));
+	EXPECT_EQ(moved.GetCount(), 101u);
+}
+
+TEST(HashMap, LookupKeysAndAllocators)
+{
+	// strings are found by const char* without building a std::string
+	Core::HashMap<std::string, uint32> names;
+	names.Insert("vertex", 1);
+	names["fragment"] = 2;
+	EXPECT_EQ(*names.Find("fragment"), 2u);
+	EXPECT_TRUE(names.Contains("vertex"));
+	EXPECT_FALSE(names.Contains("compute"));
+
+	// a HashString key is found by its hash, which can be hashed once up front
+	Core::HashMap<Core::HashString, uint32> ids;
+	const Core::HashString albedo("albedo");
+	ids.Insert(albedo, 3);
+	ids.Insert(Core::HashString("normal"), 4);
+	const uint64 hash = decltype(ids)::GetHash(albedo);
+	EXPECT_EQ(*ids.Find(albedo.GetHash(), hash), 3u);
+	EXPECT_EQ(*ids.Find(Core::HashString("normal").GetHash()), 4u);
+	EXPECT_TRUE(ids.Erase(albedo));
+	EXPECT_TRUE(ids.Find(albedo) == nullptr);
+
+	Core::LinearArena arena;
+	{
+		const Core::ArenaAllocator<uint8> allocator(&arena);
+		Core::HashSet<uint32, Core::Hasher<uint32>, Core::ArenaAllocator<uint8>> set(allocator);
+		set.Reserve(1000);
+		const size_t used = arena.GetUsed();
+		for(uint32 i = 0; i < 1000; ++i)
+			EXPECT_TRUE(set.Insert(i * 3));
+		EXPECT_FALSE(set.Insert(3));
+		EXPECT_EQ(arena.GetUsed(), used);
+		EXPECT_TRUE(set.Contains(2997u));
+		EXPECT_FALSE(set.Contains(2998u));
+		EXPECT_EQ(set.GetCapacity(), 2048u);
+	}
+}
+
+TEST(HashMap, Benchmark)
+{
+	constexpr uint32 count = 1000000;
+	std::vector<uint64> keys(count);
+	std::mt19937_64 random(1);
+	for(uint64& key : keys)
+		key = random();
+
+	uint64 sum = 0;
+	std::unordered_map<uint64, uint64> reference;
+	const float stdInsert = MeasureMs([&]() {
+		for(uint32 i = 0; i < count; ++i)
+			reference.emplace(keys[i], i);
+	});
+	const float stdFind = MeasureMs([&]() {
+		for(uint32 i = 0; i < count; ++i)
+			sum += reference.find(keys[(i * 7919) % count])->second;
+	});
+	const float stdIterate = MeasureMs([&]() {
+		for(const auto& entry : reference)
+			sum += entry.second;
+	});
+
+	Core::HashMap<uint64, uint64> map;
+	const float mapInsert = MeasureMs([&]() {
+		for(uint32 i = 0; i < count; ++i)
+			map.Insert(keys[i], i);
+	});
+	const float mapFind = MeasureMs([&]() {
+		for(uint32 i = 0; i < count; ++i)
+			sum -= *map.Find(keys[(i * 7919) % count]);
+	});
+	const float mapIterate = MeasureMs([&]() {
+		for(const auto& entry : map)
+			sum -= entry.m_Value;
+	});
+	EXPECT_EQ(sum, 0u);
+
+	printf("%u uint64 keys, std::unordered_map / HashMap\n", count);
+	printf("insert %.1f / %.1f ms find %.1f / %.1f ms iterate %.1f / %.1f ms\n", stdInsert, mapInsert, stdFind,
+		   mapFind, stdIterate, mapIterate);
+}
+
+TEST(HashString, CompileTime)
+{
+	// folded at compile time and the same as hashing at run time
+	constexpr uint64 albedo = "albedo"_hs;
+	static_assert(albedo == Core::HashString("albedo").GetHash(), "The literal and the class have to agree!");
+	static_assert(""_hs == Core::s_StringHashBasis, "The empty string hashes to the basis!");
+
+	std::string runtime = "alb";
+	runtime += "edo";
+	EXPECT_EQ(Core::HashString(runtime.c_str()), albedo);
+	EXPECT_EQ(Core::StringHash(runtime.c_str(), runtime.length()), albedo);
+	EXPECT_NE(Core::HashString("albedo"), Core::HashString("Albedo"));
+
+	// the known FNV-1a 64 value for "a"
+	EXPECT_EQ("a"_hs, 0xaf63dc4c8601ec8cull);
+
+	uint32 matched = 0;
+	for(const char* name : { "albedo", "normal", "roughness" })
+	{
+		switch(Core::StringHash(name))
+		{
+			case "albedo"_hs:
+				matched |= 1;
+				break;
+			case "normal"_hs:
+				matched |= 2;
+				break;
+			default:
+				matched |= 4;
+		}
+	}
+	EXPECT_EQ(matched, 7u);
+
+	// a map keyed by HashString is looked up by a literal without hashing a string
+	Core::HashMap<Core::HashString, uint32> slots;
+	slots.Insert(Core::HashString("normal"), 1);
+	EXPECT_EQ(*slots.Find("normal"_hs), 1u);
+}
+
+TEST(HashString, InternTable)
+{
+	Core::HashStringTable& table = Core::HashStringTable::Get();
+
+	// the table keeps its own copy
+	char name[] = "diffuse_texture";
+	const Core::HashString interned = Core::HashString::Intern(name);
+	name[0] = 'x';
+	EXPECT_STREQ(interned.GetString(), "diffuse_texture");
+	EXPECT_STREQ(Core::HashString("diffuse_texture").GetString(), "diffuse_texture");
+	EXPECT_EQ(table.Find("specular_texture"_hs), nullptr);
+
+	// interning again is a lookup
+	const uint32 count = table.GetCount();
+	const char* first = table.Add("diffuse_texture"_hs, "diffuse_texture");
+	EXPECT_EQ(first, interned.GetString());
+	EXPECT_EQ(table.GetCount(), count);
+
+	// a different string on a taken hash is a collision, the first string keeps the hash
+	const uint32 collisions = table.GetCollisionCount();
+	EXPECT_STREQ(table.Add("diffuse_texture"_hs, "not_diffuse"), "diffuse_texture");
+	EXPECT_EQ(table.GetCollisionCount(), collisions + 1);
+
+	// interning from many threads at once
+	std::vector<std::thread> threads;
+	for(uint32 thread = 0; thread < 4; ++thread)
+	{
+		threads.emplace_back([]() {
+			for(uint32 i = 0; i < 1000; ++i)
+				Core::HashString::Intern(("name_" + std::to_string(i)).c_str());
+		});
+	}
+	for(std::thread& thread : threads)
+		thread.join();
+	EXPECT_EQ(table.GetCount(), count + 1000);
+	EXPECT_STREQ(Core::HashString("name_999"_hs).GetString(), "name_999");
+	EXPECT_EQ(table.GetCollisionCount(), collisions + 1);
+}
+
+TEST(HashData, StreamingAndPaths)
+{
+	std::vector<uint8> data(1 << 20);
+	std::mt19937 random(3);
+	for(uint8& byte : data)
+		byte = (uint8)random();
+
+	auto check = [&](size_t size) {
+		const uint64 hash = Core::Hash64(data.data(), size, 17);
+		EXPECT_EQ(hash, Core::Hash64Reference(data.data(), size, 17)) << size;
+		EXPECT_NE(hash, Core::Hash64(data.data(), size, 18)) << size;
+
+		// fed in random pieces, including empty ones
+		Core::HashStream stream(17);
+		for(size_t offset = 0; offset < size;)
+		{
+			const size_t piece = std::min<size_t>(size - offset, random() % 200);
+			stream.Update(data.data() + offset, piece);
+			offset += piece;
+		}
+		EXPECT_EQ(stream.Finish(), hash) << size;
+		EXPECT_EQ(stream.Finish128(), Core::Hash128Bit(data.data(), size, 17)) << size;
+	};
+
+	for(size_t size = 0; size <= 2100; ++size)
+		check(size);
+	check(data.size());
+
+	Core::HashStream stream;
+	stream.Update(data.data(), 100);
+	EXPECT_EQ(stream.Finish(), Core::Hash64(data.data(), 100));
+	stream.Update(data.data() + 100, 5000);
+	EXPECT_EQ(stream.Finish(), Core::Hash64(data.data(), 5100));
+	EXPECT_EQ(stream.GetSize(), 5100u);
+
+	struct Key
+	{
+		uint32 m_A;
+		float m_B;
+	};
+	EXPECT_EQ(Core::HashPod(Key{ 1, 2.f }), Core::HashPod(Key{ 1, 2.f }));
+	EXPECT_NE(Core::HashPod(Key{ 1, 2.f }), Core::HashPod(Key{ 2, 1.f }));
+	EXPECT_NE(Core::HashCombine(Core::HashPod(1), Core::HashPod(2)),
+			  Core::HashCombine(Core::HashPod(2), Core::HashPod(1)));
+}
+
+TEST(HashData, Quality)
+{
+	// flipping any input bit flips about half of the output bits
+	std::mt19937_64 random(5);
+	for(size_t size : { 3, 8, 16, 17, 64, 128, 129, 500, 1500 })
+	{
+		std::vector<uint8> data(size);
+		uint64 flipped = 0;
+		uint32 trials = 0;
+		for(uint32 round = 0; round < 40; ++round)
+		{
+			for(uint8& byte : data)
+				byte = (uint8)random();
+			const uint64 hash = Core::Hash64(data.data(), size);
+			for(uint32 bit = 0; bit < size * 8; bit += (uint32)(size / 16) + 1)
+			{
+				data[bit / 8] ^= 1 << (bit % 8);
+				flipped += std::bitset<64>(hash ^ Core::Hash64(data.data(), size)).count();
+				data[bit / 8] ^= 1 << (bit % 8);
+				trials++;
+			}
+		}
+		const double ratio = (double)flipped / (trials * 64.0);
+		EXPECT_NEAR(ratio, 0.5, 0.01) << size;
+	}
+
+	// sequential keys, the worst case for weak hashes
+	constexpr uint32 count = 1000000;
+	std::vector<uint64> hashes(count);
+	for(uint64 i = 0; i < count; ++i)
+		hashes[i] = Core::Hash64(&i, sizeof(i));
+	std::sort(hashes.begin(), hashes.end());
+	EXPECT_EQ(std::adjacent_find(hashes.begin(), hashes.end()), hashes.end());
+}
+
+TEST(HashData, Benchmark)
+{
+	std::vector<uint8> data(1 << 20);
+	std::mt19937 random(7);
+	for(uint8& byte : data)
+		byte = (uint8)random();
+
+	printf("size, Hash64 / MurmurHash3_x64_128 GB/s\n");
+	uint64 sum = 0;
+	for(size_t size : { 16, 1024, 1 << 20 })
+	{
+		// the same number of bytes for every size
+		const size_t rounds = (256ull << 20) / size;
+		const size_t span = data.size() - size + 1;
+		const float fast = MeasureMs([&]() {
+			for(size_t i = 0; i < rounds; ++i)
+				sum += Core::Hash64(data.data() + (i * 64) % span, size);
+		});
+		const float murmur = MeasureMs([&]() {
+			for(size_t i = 0; i < rounds; ++i)
+			{
+				uint64 out[2];
+				MurmurHash3_x64_128(data.data() + (i * 64) % span, (int)size, 0, out);
+				sum += out[0];
+			}
+		});
+		const double gigabytes = (double)rounds * size / (1 << 30);
+		printf("%zu, %.2f / %.2f\n", size, gigabytes * 1000.0 / fast, gigabytes * 1000.0 / murmur);
+	}
+	EXPECT_NE(sum, 0u);
+}
+
+TEST(MappedFile, ReadAndViews)
+{
+	const char* filepath = "mapped_file.bin";
+	std::vector<uint32> words(100000);
+	for(uint32 i = 0; i < words.size(); ++i)
+		words[i] = i * 2654435761u;
+
+	FILE* file = fopen(filepath, "wb");
+	ASSERT_NE(file, nullptr);
+	fwrite(words.data(), sizeof(uint32), words.size(), file);
+	fclose(file);
+
+	{
+		Core::MappedFile mapped(filepath, Core::EFileAccess_Random);
+		ASSERT_TRUE(mapped.IsOpen());
+		EXPECT_EQ(mapped.GetSize(), words.size() * sizeof(uint32));
+
+		Core::Span<const uint32> mappedWords = mapped.GetData().As<const uint32>();
+		ASSERT_EQ(mappedWords.Size(), words.size());
+		EXPECT_TRUE(std::equal(mappedWords.begin(), mappedWords.end(), words.begin()));
+
+		// views are clamped to the end of the file
+		mapped.WillNeed(4000, 400);
+		Core::Span<const uint8> view = mapped.GetView(4000, 400);
+		EXPECT_EQ(view.Size(), 400u);
+		EXPECT_EQ(view.As<const uint32>()[0], words[1000]);
+		EXPECT_EQ(mapped.GetView(mapped.GetSize() - 8, 100).Size(), 8u);
+		EXPECT_TRUE(mapped.GetView(mapped.GetSize(), 100).IsEmpty());
+		EXPECT_EQ(mappedWords.SubSpan(10, 5)[4], words[14]);
+
+		// the same bytes the copying reader returns
+		Core::File copied(filepath, Core::File::READ_FILE);
+		ASSERT_EQ(copied.GetSize(), mapped.GetSize());
+		EXPECT_EQ(memcmp(copied.GetBuffer(), mapped.GetData().GetData(), copied.GetSize()), 0);
+
+		Core::MappedFile moved(std::move(mapped));
+		EXPECT_FALSE(mapped.IsOpen());
+		EXPECT_TRUE(moved.IsOpen());
+		EXPECT_EQ(moved.GetData().As<const uint32>()[7], words[7]);
+	}
+	remove(filepath);
+
+	file = fopen(filepath, "wb");
+	fclose(file);
+	Core::MappedFile empty(filepath);
+	EXPECT_TRUE(empty.IsOpen());
+	EXPECT_TRUE(empty.GetData().IsEmpty());
+	empty.Close();
+	remove(filepath);
+
+	Core::MappedFile missing;
+	EXPECT_FALSE(missing.Open("does_not_exist.bin"));
+	EXPECT_FALSE(missing.IsOpen());
+}
+
+TEST(MappedFile, Benchmark)
+{
+	const char* filepath = "mapped_file_benchmark.bin";
+	constexpr uint32 size = 256 << 20;
+	{
+		std::vector<uint8> data(size);
+		std::mt19937 random(11);
+		for(size_t i = 0; i < data.size(); i += 4096)
+			data[i] = (uint8)random();
+		FILE* file = fopen(filepath, "wb");
+		ASSERT_NE(file, nullptr);
+		fwrite(data.data(), 1, data.size(), file);
+		fclose(file);
+	}
+
+	// open, read every byte and close, the file is in the OS cache for both
+	uint64 copiedHash = 0;
+	uint64 mappedHash = 0;
+	const float copiedTime = MeasureMs([&]() {
+		Core::File file(filepath, Core::File::READ_FILE);
+		copiedHash = Core::Hash64(file.GetBuffer(), file.GetSize());
+	});
+	const float mappedTime = MeasureMs([&]() {
+		Core::MappedFile file(filepath);
+		mappedHash = Core::Hash64(file.GetData().GetData(), file.GetData().Size());
+	});
+	EXPECT_EQ(copiedHash, mappedHash);
+	remove(filepath);
+
+	printf("%u MB file, File / MappedFile: %.1f / %.1f ms\n", size >> 20, copiedTime, mappedTime);
+}
+
+static void WriteIoTestFile(const char* filepath, std::vector<uint32>* words)
+{
+	for(uint32 i = 0; i < words->size(); ++i)
+		(*words)[i] = i * 2246822519u;
+	FILE* file = fopen(filepath, "wb");
+	ASSERT_NE(file, nullptr);
+	fwrite(words->data(), sizeof(uint32), words->size(), file);
+	fclose(file);
+}
+
+TEST(IoService, BatchedReads)
+{
+	const char* filepath = "io_service.bin";
+	std::vector<uint32> words(2 << 20);
+	WriteIoTestFile(filepath, &words);
+	const uint32 fileSize = (uint32)(words.size() * sizeof(uint32));
+
+	for(bool useIoUring : { true, false })
+	{
+		Core::IoService service;
+		service.Init(32, 4, useIoUring);
+		Core::IoFile file = Core::IoService::OpenFile(filepath);
+		ASSERT_TRUE(file.IsValid());
+		EXPECT_EQ(Core::IoService::GetFileSize(file), fileSize);
+
+		// 256 chunks spread over the priorities and one more that runs past the end of the file
+		constexpr uint32 chunkSize = 32 * 1024;
+		std::vector<uint8> data(fileSize + chunkSize);
+		std::vector<Core::IoRequest> requests;
+		std::atomic<uint32> callbacks{ 0 };
+		std::atomic<int64> bytesRead{ 0 };
+		for(uint32 offset = 0; offset <= fileSize; offset += chunkSize)
+		{
+			Core::IoRequest request;
+			request.m_File = file;
+			request.m_Offset = offset < fileSize ? offset : fileSize - chunkSize / 2;
+			request.m_Buffer = &data[request.m_Offset];
+			request.m_Size = chunkSize;
+			request.m_Priority = (Core::EIoPriority)(requests.size() % Core::EIoPriority_Count);
+			request.m_Callback = [&](const Core::IoRequest&, int64 result) {
+				callbacks++;
+				bytesRead += result;
+			};
+			requests.push_back(request);
+		}
+
+		Core::IoBatch batch;
+		service.Submit(requests.data(), (uint32)requests.size() / 2, &batch);
+		service.Submit(requests.data() + requests.size() / 2, (uint32)(requests.size() - requests.size() / 2), &batch);
+		service.Wait(batch);
+		EXPECT_TRUE(batch.IsDone());
+		EXPECT_EQ(batch.GetFailedCount(), 0u);
+		EXPECT_EQ(callbacks.load(), requests.size());
+		EXPECT_EQ(bytesRead.load(), (int64)fileSize + chunkSize / 2);
+		EXPECT_EQ(memcmp(data.data(), words.data(), fileSize), 0) << useIoUring;
+
+		// a closed file fails without taking the service down
+		Core::IoBatch failed;
+		Core::IoRequest bad = requests[0];
+		bad.m_File = Core::IoFile();
+		bad.m_Callback = nullptr;
+		service.Submit(&bad, 1, &failed);
+		service.Wait(failed);
+		EXPECT_EQ(failed.GetFailedCount(), 1u);
+		Core::IoService::CloseFile(file);
+
+		// buffers, offsets and sizes aligned for reads around the OS cache, not every file system can do them
+		Core::IoFile direct = Core::IoService::OpenFile(filepath, Core::EIoOpen_Unbuffered);
+		if(direct.IsValid())
+		{
+			constexpr uint32 alignment = Core::IoService::s_UnbufferedAlignment;
+			std::vector<uint8> memory(4 * alignment);
+			uint8* aligned = (uint8*)(((uintptr_t)memory.data() + alignment - 1) & ~(uintptr_t)(alignment - 1));
+
+			Core::IoRequest request;
+			request.m_File = direct;
+			request.m_Offset = 5 * alignment;
+			request.m_Buffer = aligned;
+			request.m_Size = 2 * alignment;
+			Core::IoBatch directBatch;
+			service.Submit(&request, 1, &directBatch);
+			service.Wait(directBatch);
+			EXPECT_EQ(directBatch.GetFailedCount(), 0u);
+			EXPECT_EQ(memcmp(aligned, (const uint8*)words.data() + request.m_Offset, request.m_Size), 0);
+			Core::IoService::CloseFile(direct);
+		}
+		service.Destroy();
+	}
+	remove(filepath);
+}
+
+TEST(IoService, Priorities)
+{
+	const char* filepath = "io_priorities.bin";
+	std::vector<uint32> words(1024);
+	WriteIoTestFile(filepath, &words);
+
+	for(bool useIoUring : { true, false })
+	{
+		Core::IoService service;
+		service.Init(1, 1, useIoUring);
+		Core::IoFile file = Core::IoService::OpenFile(filepath);
+
+		// the first read holds the only slot until everything else is queued
+		std::mutex lock;
+		std::condition_variable released;
+		bool release = false;
+		std::vector<Core::EIoPriority> order;
+		uint32 buffer[16];
+
+		Core::IoRequest blocker;
+		blocker.m_File = file;
+		blocker.m_Buffer = buffer;
+		blocker.m_Size = sizeof(buffer);
+		blocker.m_Callback = [&](const Core::IoRequest&, int64) {
+			std::unique_lock<std::mutex> guard(lock);
+			released.wait(guard, [&]() { return release; });
+		};
+		Core::IoBatch batch;
+		service.Submit(&blocker, 1, &batch);
+
+		std::vector<Core::IoRequest> requests;
+		for(uint32 i = 0; i < 12; ++i)
+		{
+			Core::IoRequest request = blocker;
+			request.m_Priority = (Core::EIoPriority)(Core::EIoPriority_Low - i % Core::EIoPriority_Count);
+			request.m_Callback = [&](const Core::IoRequest& done, int64) { order.push_back(done.m_Priority); };
+			requests.push_back(request);
+		}
+		service.Submit(requests.data(), (uint32)requests.size(), &batch);
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			release = true;
+		}
+		released.notify_all();
+		service.Wait(batch);
+
+		ASSERT_EQ(order.size(), requests.size());
+		EXPECT_TRUE(std::is_sorted(order.begin(), order.end())) << useIoUring;
+		Core::IoService::CloseFile(file);
+	}
+	remove(filepath);
+}
+
+TEST(IoService, Benchmark)
+{
+	const char* filepath = "io_benchmark.bin";
+	std::vector<uint32> words(64 << 18);
+	WriteIoTestFile(filepath, &words);
+	const uint32 fileSize = (uint32)(words.size() * sizeof(uint32));
+	constexpr uint32 chunkSize = 64 * 1024;
+	std::vector<uint8> data(fileSize);
+
+	// the same chunks read one after the other with stdio
+	const float blocking = MeasureMs([&]() {
+		FILE* file = fopen(filepath, "rb");
+		for(uint32 offset = 0; offset < fileSize; offset += chunkSize)
+		{
+			fseek(file, offset, SEEK_SET);
+			fread(&data[offset], 1, chunkSize, file);
+		}
+		fclose(file);
+	});
+
+	float queued[2];
+	for(bool useIoUring : { true, false })
+	{
+		Core::IoService service;
+		service.Init(64, 4, useIoUring);
+		Core::IoFile file = Core::IoService::OpenFile(filepath);
+		std::vector<Core::IoRequest> requests;
+		for(uint32 offset = 0; offset < fileSize; offset += chunkSize)
+		{
+			Core::IoRequest request;
+			request.m_File = file;
+			request.m_Offset = offset;
+			request.m_Buffer = &data[offset];
+			request.m_Size = chunkSize;
+			requests.push_back(request);
+		}
+
+		memset(data.data(), 0, data.size());
+		queued[useIoUring ? 0 : 1] = MeasureMs([&]() {
+			Core::IoBatch batch;
+			service.Submit(requests.data(), (uint32)requests.size(), &batch);
+			service.Wait(batch);
+		});
+		EXPECT_EQ(memcmp(data.data(), words.data(), fileSize), 0);
+		Core::IoService::CloseFile(file);
+	}
+	remove(filepath);
+
+	printf("%u MB in %u KB reads, stdio / io_uring / threads: %.1f / %.1f / %.1f ms\n", fileSize >> 20,
+		   chunkSize >> 10, blocking, queued[0], queued[1]);
+}
+
+TEST(Profiler, NestedScopes)
+{
+	Core::Profiler& profiler = Core::Profiler::Get();
+	profiler.NewFrame();
+	{
+		Core::ScopedProfileEvent outer("outer");
+		{
+			Core::ScopedProfileEvent inner("inner");
+		}
+		Core::Profiler::Counter("draws", 128);
+	}
+	profiler.NewFrame();
+
+	const Core::Profiler::Frame& frame = profiler.GetLastFrame();
+	ASSERT_EQ(frame.m_Scopes.size(), 2u);
+	EXPECT_STREQ(frame.m_Scopes[0].m_Name, "inner");
+	EXPECT_EQ(frame.m_Scopes[0].m_Depth, 1u);
+	EXPECT_STREQ(frame.m_Scopes[1].m_Name, "outer");
+	EXPECT_EQ(frame.m_Scopes[1].m_Depth, 0u);
+	EXPECT_LE(frame.m_Scopes[1].m_Begin, frame.m_Scopes[0].m_Begin);
+	EXPECT_GE(frame.m_Scopes[1].m_End, frame.m_Scopes[0].m_End);
+	ASSERT_EQ(frame.m_Counters.size(), 1u);
+	EXPECT_EQ(frame.m_Counters[0].m_Value, 128);
+}
+
+TEST(Profiler, ThreadBuffers)
+{
+	Core::Profiler& profiler = Core::Profiler::Get();
+	profiler.NewFrame();
+
+	// every thread records into a buffer of its own, whichever registered first
+	{
+		Core::ScopedProfileEvent scope("main");
+	}
+	std::thread worker([]() {
+		for(int i = 0; i < 100; i++)
+		{
+			Core::ScopedProfileEvent scope("worker");
+		}
+	});
+	worker.join();
+
+	profiler.NewFrame();
+	uint32 mainIndex = UINT32_MAX;
+	uint32 workerIndex = UINT32_MAX;
+	uint32 workerScopes = 0;
+	for(const Core::Profiler::Scope& scope : profiler.GetLastFrame().m_Scopes)
+	{
+		if(strcmp(scope.m_Name, "main") == 0)
+			mainIndex = scope.m_ThreadIndex;
+		else if(strcmp(scope.m_Name, "worker") == 0)
+		{
+			if(workerScopes++ == 0)
+				workerIndex = scope.m_ThreadIndex;
+			EXPECT_EQ(scope.m_ThreadIndex, workerIndex);
+		}
+	}
+
+	EXPECT_EQ(workerScopes, 100u);
+	EXPECT_NE(mainIndex, UINT32_MAX);
+	EXPECT_NE(workerIndex, mainIndex);
+	EXPECT_GE(profiler.GetThreadCount(), 2u);
+}
+
+TEST(Profiler, DestroyAndRecreate)
+{
+	// a thread that profiled before a Destroy records into the next profiler
+	{
+		Core::ScopedProfileEvent scope("before");
+	}
+	Core::Profiler::Destroy();
+
+	Core::Profiler& profiler = Core::Profiler::Get();
+	profiler.NewFrame();
+	{
+		Core::ScopedProfileEvent scope("after");
+	}
+	profiler.NewFrame();
+
+	uint32 afterScopes = 0;
+	for(const Core::Profiler::Scope& scope : profiler.GetLastFrame().m_Scopes)
+		afterScopes += strcmp(scope.m_Name, "after") == 0 ? 1 : 0;
+	EXPECT_EQ(afterScopes, 1u);
+	EXPECT_GE(profiler.GetThreadCount(), 1u);
+}
+
+TEST(NullGraphicsDevice, RecordsCommands)
+{
+	Graphics::NullGraphicsDevice device;
+
+	Graphics::BufferDesc desc;
+	desc.m_Size = 1024;
+	const Graphics::HBuffer buffer = device.CreateBuffer(desc);
+	const Graphics::HPipeline pipeline = device.CreatePipeline(Graphics::PipelineDesc());
+
+	const float world[16] = { 1.f, 0.f, 0.f, 0.f, 0.f, 1.f, 0.f, 0.f, 0.f, 0.f, 1.f, 0.f, 5.f, 6.f, 7.f, 1.f };
+	device.BindPipeline(pipeline);
+	device.BindVertexBuffer(buffer, 0);
+	device.PushConstants(world, sizeof(world), 0);
+	device.Draw(36, 1, 0, 0);
+
+	EXPECT_EQ(device.GetCommandCount(Graphics::ECommandType_Draw), 1u);
+
+	const Graphics::ECommandType expected[] = { Graphics::ECommandType_BindPipeline,
+												Graphics::ECommandType_BindVertexBuffer,
+												Graphics::ECommandType_PushConstants, Graphics::ECommandType_Draw };
+	uint32 cursor = 0;
+	uint32 index = 0;
+	Graphics::NullGraphicsDevice::Command command;
+	while(device.NextCommand(&cursor, &command))
+	{
+		ASSERT_LT(index, 4u);
+		EXPECT_EQ(command.m_Type, expected[index++]);
+
+		if(command.m_Type == Graphics::ECommandType_BindPipeline)
+		{
+			EXPECT_EQ(command.As<Graphics::CmdBindResource>().m_Handle, pipeline);
+		}
+
+		if(command.m_Type == Graphics::ECommandType_PushConstants)
+		{
+			ASSERT_EQ(command.As<Graphics::CmdPushConstants>().m_Size, sizeof(world));
+			EXPECT_EQ(memcmp(&command.As<Graphics::CmdPushConstants>() + 1, world, sizeof(world)), 0);
+		}
+
+		if(command.m_Type == Graphics::ECommandType_Draw)
+		{
+			EXPECT_EQ(command.As<Graphics::CmdDraw>().m_Count, 36u);
+		}
+	}
+	EXPECT_EQ(index, 4u);
+	EXPECT_EQ(cursor, device.GetStream().size());
+
+	device.Reset();
+	cursor = 0;
+	EXPECT_FALSE(device.NextCommand(&cursor, &command));
+}
+
+TEST(NullGraphicsDevice, Handles)
+{
+	Graphics::NullGraphicsDevice device;
+
+	Graphics::BufferDesc desc;
+	desc.m_Size = 64;
+	const Graphics::HBuffer first = device.CreateBuffer(desc);
+	const Graphics::HBuffer second = device.CreateBuffer(desc);
+	EXPECT_NE(first, 0u);
+	EXPECT_NE(first, second);
+	EXPECT_EQ(device.GetBufferCount(), 2u);
+
+	device.DestroyBuffer(first);
+	EXPECT_EQ(device.GetBufferCount(), 1u);
+
+	// the slot is reused with the next generation, the old handle stays dead
+	typedef Core::HandleLayout<Graphics::HBuffer> Layout;
+	const Graphics::HBuffer reused = device.CreateBuffer(desc);
+	EXPECT_NE(reused, first);
+	EXPECT_EQ(Layout::GetIndex(reused), Layout::GetIndex(first));
+	device.DestroyBuffer(first);
+	EXPECT_EQ(device.GetBufferCount(), 2u);
+
+	// destroying twice must not put the slot on the free list again
+	device.DestroyBuffer(second);
+	device.DestroyBuffer(second);
+	EXPECT_NE(device.CreateBuffer(desc), device.CreateBuffer(desc));
+}
+
+TEST(NullGraphicsDevice, RecordBenchmark)
+{
+	constexpr uint32 drawCount = 100000;
+	Graphics::NullGraphicsDevice device;
+
+	Graphics::BufferDesc desc;
+	desc.m_Size = 36 * 32;
+	const Graphics::HBuffer buffer = device.CreateBuffer(desc);
+	const Graphics::HPipeline pipeline = device.CreatePipeline(Graphics::PipelineDesc());
+	const float world[16] = { 1.f, 0.f, 0.f, 0.f, 0.f, 1.f, 0.f, 0.f, 0.f, 0.f, 1.f, 0.f, 0.f, 0.f, 0.f, 1.f };
+
+	Core::Timer timer;
+	timer.Init();
+	device.BindPipeline(pipeline);
+	device.BindVertexBuffer(buffer, 0);
+	for(uint32 i = 0; i < drawCount; ++i)
+	{
+		device.PushConstants(world, sizeof(world), 0);
+		device.Draw(36, 1, 0, 0);
+	}
+	timer.Update();
+
+	EXPECT_EQ(device.GetCommandCount(Graphics::ECommandType_Draw), drawCount);
+	EXPECT_EQ(device.GetCommandCount(Graphics::ECommandType_PushConstants), drawCount);
+	printf("Recorded %u draws in %.3f ms, %zu bytes\n", drawCount, timer.GetTime() * 1000.f, device.GetStream().size());
+}
+
+TEST(ThreadPool, Dispatch)
+{
+	Core::ThreadPool pool;
+	pool.Init(3);
+
+	std::vector<uint32> hits(1000, 0);
+	std::atomic<uint32> total{ 0 };
+	for(int round = 0; round < 10; round++)
+	{
+		pool.Dispatch((uint32)hits.size(), [&](uint32 index) {
+			hits[index]++;
+			total++;
+		});
+	}
+
+	EXPECT_EQ(total.load(), 10000u);
+	EXPECT_TRUE(std::all_of(hits.begin(), hits.end(), [](uint32 count) { return count == 10; }));
+}
+
+TEST(RadixSort, MatchesStableSort)
+{
+	std::mt19937_64 random(1234);
+	std::vector<Core::SortPair> pairs(200000);
+	for(uint32 i = 0; i < pairs.size(); ++i)
+	{
+		// few distinct high bits, plenty of duplicates to check stability
+		pairs[i].m_Key = (random() & 0xFF000000FFFFull) | ((uint64)(i % 7) << 52);
+		pairs[i].m_Value = i;
+	}
+
+	std::vector<Core::SortPair> expected = pairs;
+	std::stable_sort(expected.begin(), expected.end(),
+					 [](const Core::SortPair& a, const Core::SortPair& b) { return a.m_Key < b.m_Key; });
+
+	Core::ThreadPool pool;
+	pool.Init(3);
+
+	for(Core::ThreadPool* sortPool : { (Core::ThreadPool*)nullptr, &pool })
+	{
+		std::vector<Core::SortPair> sorted = pairs;
+		std::vector<Core::SortPair> scratch(sorted.size());
+		Core::RadixSort(sorted.data(), scratch.data(), (uint32)sorted.size(), sortPool);
+
+		for(uint32 i = 0; i < sorted.size(); ++i)
+		{
+			ASSERT_EQ(sorted[i].m_Key, expected[i].m_Key);
+			ASSERT_EQ(sorted[i].m_Value, expected[i].m_Value);
+		}
+	}
+}
+
+TEST(RenderQueue, SortedStateChanges)
+{
+	constexpr uint32 drawCount = 100000;
+	Graphics::NullGraphicsDevice device;
+
+	Graphics::HPipeline pipelines[8];
+	for(Graphics::HPipeline& pipeline : pipelines)
+		pipeline = device.CreatePipeline(Graphics::PipelineDesc());
+
+	Graphics::BufferDesc desc;
+	desc.m_Size = 36 * 48;
+	Graphics::HBuffer meshes[64];
+	for(Graphics::HBuffer& mesh : meshes)
+		mesh = device.CreateBuffer(desc);
+
+	std::mt19937 random(42);
+	Graphics::RenderQueue queue;
+	for(uint32 i = 0; i < drawCount; ++i)
+	{
+		Graphics::DrawCall draw;
+		draw.m_Pipeline = pipelines[random() % ARRSIZE(pipelines)];
+		draw.m_Material = random() % 16;
+		draw.m_VertexBuffer = meshes[random() % ARRSIZE(meshes)];
+		draw.m_VertexCount = 36;
+		queue.Submit(draw, (float)(random() % 1000) / 1000.f, &i, sizeof(i));
+	}
+
+	queue.Execute(&device);
+	const Graphics::RenderQueue::Stats unsorted = queue.GetStats();
+
+	Core::ThreadPool pool;
+	pool.Init();
+	device.Reset();
+	queue.Sort(&pool);
+	queue.Execute(&device);
+	const Graphics::RenderQueue::Stats sorted = queue.GetStats();
+
+	for(uint32 i = 1; i < queue.GetDrawCount(); ++i)
+		ASSERT_LE(queue.GetKey(i - 1), queue.GetKey(i));
+
+	EXPECT_EQ(sorted.m_PipelineChanges, ARRSIZE(pipelines));
+	EXPECT_LE(sorted.m_MaterialChanges, ARRSIZE(pipelines) * 16);
+	EXPECT_LE(sorted.m_MeshChanges, ARRSIZE(pipelines) * 16 * ARRSIZE(meshes));
+	EXPECT_EQ(device.GetCommandCount(Graphics::ECommandType_BindPipeline), sorted.m_PipelineChanges);
+	EXPECT_EQ(device.GetCommandCount(Graphics::ECommandType_BindVertexBuffer), sorted.m_MeshChanges);
+	EXPECT_EQ(device.GetCommandCount(Graphics::ECommandType_Draw), drawCount);
+
+	// the depth pre-pass records the same draws with a single pipeline
+	device.Reset();
+	queue.Execute(&device, pipelines[0]);
+	EXPECT_EQ(device.GetCommandCount(Graphics::ECommandType_BindPipeline), 1u);
+	EXPECT_EQ(device.GetCommandCount(Graphics::ECommandType_Draw), drawCount);
+
+	printf("%u draws, pipeline/material/mesh changes unsorted: %u/%u/%u sorted: %u/%u/%u, sort %.3f ms on %u threads\n",
+		   drawCount, unsorted.m_PipelineChanges, unsorted.m_MaterialChanges, unsorted.m_MeshChanges,
+		   sorted.m_PipelineChanges, sorted.m_MaterialChanges, sorted.m_MeshChanges, sorted.m_SortMs,
+		   pool.GetThreadCount());
+}
+
+TEST(ShaderReflection, CompiledVertexShader)
+{
+	// compile_shaders.bat writes the modules to bin/Data/Shaders and the tests run from bin
+	Core::MappedFile shader("Data/Shaders/vertex.vert");
+	if(!shader.IsOpen())
+		GTEST_SKIP() << "Data/Shaders/vertex.vert is missing, compile the shaders first";
+
+	Graphics::ShaderReflection reflection;
+	Core::Span<const uint32> code = shader.GetData().As<const uint32>();
+	ASSERT_TRUE(Graphics::ReflectShader(code.GetData(), (uint32)code.SizeInBytes(), &reflection));
+	EXPECT_EQ(reflection.m_Stage, VK_SHADER_STAGE_VERTEX_BIT);
+
+	// cbuffer viewProjection : register(b0)
+	ASSERT_EQ(reflection.m_Bindings.size(), 1u);
+	EXPECT_EQ(reflection.m_Bindings[0].m_Set, 0u);
+	EXPECT_EQ(reflection.m_Bindings[0].m_Binding, 0u);
+	EXPECT_EQ(reflection.m_Bindings[0].m_Count, 1u);
+	EXPECT_EQ(reflection.m_Bindings[0].m_Type, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER);
+
+	// the world matrix
+	ASSERT_EQ(reflection.m_PushConstants.size(), 1u);
+	EXPECT_EQ(reflection.m_PushConstants[0].size, 64u);
+	EXPECT_EQ(reflection.m_PushConstants[0].stageFlags, (VkShaderStageFlags)VK_SHADER_STAGE_VERTEX_BIT);
+
+	// POSITION, COLOR and NORMAL, SV_VertexID is a builtin and not a vertex input
+	ASSERT_EQ(reflection.m_VertexInputs.size(), 3u);
+	for(uint32 i = 0; i < 3; ++i)
+	{
+		EXPECT_EQ(reflection.m_VertexInputs[i].m_Location, i);
+		EXPECT_EQ(reflection.m_VertexInputs[i].m_Format, VK_FORMAT_R32G32B32A32_SFLOAT);
+		EXPECT_EQ(reflection.m_VertexInputs[i].m_Size, 16u);
+	}
+
+	// the stride of the Vertex in Cube.h
+	std::vector<VkVertexInputAttributeDescription> attributes;
+	EXPECT_EQ(Graphics::BuildVertexInputLayout(reflection, &attributes), 48u);
+	EXPECT_EQ(attributes.size(), 3u);
+}
+
+TEST(ShaderReflection, RejectsMalformedModules)
+{
+	auto reflect = [](std::vector<uint32> module, std::initializer_list<uint32> instruction) {
+		module.insert(module.end(), instruction);
+		Graphics::ShaderReflection reflection;
+		return Graphics::ReflectShader(module.data(), (uint32)(module.size() * sizeof(uint32)), &reflection);
+	};
+
+	// magic, version, generator, id bound and schema, then OpTypeFloat %1 32
+	const std::vector<uint32> module = { 0x07230203, 0x00010000, 0, 4, 0, (3u << 16) | 22, 1, 32 };
+	const uint32 typeImage = 25;
+	const uint32 typeStruct = 30;
+	const uint32 decorate = 71;
+	EXPECT_TRUE(reflect(module, {}));
+
+	// ids at or past the bound
+	EXPECT_FALSE(reflect(module, { (4u << 16) | decorate, 4, 34, 0 }));
+	EXPECT_FALSE(reflect(module, { (4u << 16) | typeStruct, 2, 1, 9 }));
+	// operands missing, or an instruction running past the end
+	EXPECT_FALSE(reflect(module, { (3u << 16) | typeImage, 2, 1 }));
+	EXPECT_FALSE(reflect(module, { (3u << 16) | decorate, 1, 33 }));
+	EXPECT_FALSE(reflect(module, { (6u << 16) | typeImage, 2, 1 }));
+
+	Graphics::ShaderReflection reflection;
+	EXPECT_FALSE(Graphics::ReflectShader(module.data(), 3 * sizeof(uint32), &reflection));
+}
+
+static Core::Matrix44f MakeTranslation(float x, float y, float z)
+{
+	Core::Matrix44f world = Core::Matrix44f::Identity();
+	world.SetTranslation(x, y, z, 1.f);
+	return world;
+}
+
+TEST(OcclusionBuffer, HiddenBehindWall)
+{
+	// the camera sits at the origin looking down +z, the wall covers the center of the screen
+	const Core::Matrix44f viewProjection = Core::VKCreatePerspectiveMatrix(0.1f, 100.f, 16.f / 9.f, 90.f);
+	const Core::Vector4f wall[] = {
+		{ -4.f, -4.f, 10.f }, { 4.f, -4.f, 10.f }, { 4.f, 4.f, 10.f }, { -4.f, 4.f, 10.f },
+	};
+	const uint32 indices[] = { 0, 1, 2, 0, 2, 3 };
+
+	Graphics::OcclusionBuffer buffer;
+	buffer.Init(256, 144);
+	buffer.Clear(viewProjection);
+	buffer.AddOccluder(Core::Matrix44f::Identity(), wall, ARRSIZE(wall), indices, ARRSIZE(indices));
+	buffer.Rasterize();
+	ASSERT_EQ(buffer.GetTriangleCount(), 2u);
+
+	const Core::Vector4f min(-1.f, -1.f, -1.f);
+	const Core::Vector4f max(1.f, 1.f, 1.f);
+	EXPECT_FALSE(buffer.IsVisible(MakeTranslation(0.f, 0.f, 20.f), min, max));
+	EXPECT_FALSE(buffer.IsVisible(MakeTranslation(2.f, -2.f, 50.f), min, max));
+	EXPECT_TRUE(buffer.IsVisible(MakeTranslation(0.f, 0.f, 5.f), min, max));
+	EXPECT_TRUE(buffer.IsVisible(MakeTranslation(15.f, 0.f, 20.f), min, max));
+	EXPECT_TRUE(buffer.IsVisible(MakeTranslation(0.f, 7.5f, 20.f), min, max));
+
+	// the wall itself is not hidden by its own depth
+	EXPECT_TRUE(buffer.IsVisible(Core::Matrix44f::Identity(), { -4.f, -4.f, 10.f }, { 4.f, 4.f, 10.f }));
+
+	// off screen is never visible
+	EXPECT_FALSE(buffer.IsVisible(MakeTranslation(200.f, 0.f, 20.f), min, max));
+}
+
+TEST(OcclusionBuffer, ThreadedMatchesSerial)
+{
+	constexpr uint32 triangleCount = 20000;
+	constexpr uint32 occludeeCount = 20000;
+	const Core::Matrix44f viewProjection = Core::VKCreatePerspectiveMatrix(0.1f, 100.f, 16.f / 9.f, 90.f);
+
+	std::mt19937 random(7);
+	std::uniform_real_distribution<float> spread(-40.f, 40.f);
+	std::uniform_real_distribution<float> distance(5.f, 90.f);
+	std::uniform_real_distribution<float> offset(-2.f, 2.f);
+
+	std::vector<Core::Vector4f> positions;
+	for(uint32 i = 0; i < triangleCount; ++i)
+	{
+		const Core::Vector4f center(spread(random), spread(random), distance(random));
+		for(uint32 corner = 0; corner < 3; ++corner)
+			positions.push_back({ center.x + offset(random), center.y + offset(random), center.z + offset(random) });
+	}
+
+	std::vector<Core::Matrix44f> worlds;
+	std::vector<Graphics::OcclusionBuffer::Occludee> occludees(occludeeCount);
+	for(uint32 i = 0; i < occludeeCount; ++i)
+		worlds.push_back(MakeTranslation(spread(random), spread(random), distance(random)));
+	for(uint32 i = 0; i < occludeeCount; ++i)
+	{
+		occludees[i].m_World = &worlds[i];
+		occludees[i].m_Min = { -0.5f, -0.5f, -0.5f };
+		occludees[i].m_Max = { 0.5f, 0.5f, 0.5f };
+	}
+
+	Graphics::OcclusionBuffer serial;
+	serial.Init(256, 144);
+	serial.Clear(viewProjection);
+	serial.AddOccluder(Core::Matrix44f::Identity(), positions.data(), (uint32)positions.size());
+	serial.Rasterize();
+
+	std::vector<uint8> serialVisible(occludeeCount);
+	serial.TestVisibility(occludees.data(), occludeeCount, serialVisible.data());
+
+	Core::ThreadPool pool;
+	pool.Init(3);
+
+	Graphics::OcclusionBuffer threaded;
+	threaded.Init(256, 144);
+
+	Core::Timer timer;
+	timer.Init();
+	threaded.Clear(viewProjection);
+	threaded.AddOccluder(Core::Matrix44f::Identity(), positions.data(), (uint32)positions.size());
+	threaded.Rasterize(&pool);
+	timer.Update();
+	const float rasterizeMs = timer.GetTime() * 1000.f;
+
+	std::vector<uint8> threadedVisible(occludeeCount);
+	threaded.TestVisibility(occludees.data(), occludeeCount, threadedVisible.data(), &pool);
+	timer.Update();
+	const float testMs = timer.GetTime() * 1000.f;
+
+	const uint32 pixelCount = serial.GetWidth() * serial.GetHeight();
+	EXPECT_TRUE(std::equal(serial.GetDepth(), serial.GetDepth() + pixelCount, threaded.GetDepth()));
+	EXPECT_EQ(serialVisible, threadedVisible);
+
+	const uint32 visibleCount = (uint32)std::count(threadedVisible.begin(), threadedVisible.end(), 1);
+	EXPECT_GT(visibleCount, 0u);
+	EXPECT_LT(visibleCount, occludeeCount);
+
+	printf("%u triangles rasterized in %.3f ms, %u of %u occludees visible, tested in %.3f ms on %u threads\n",
+		   threaded.GetTriangleCount(), rasterizeMs, visibleCount, occludeeCount, testMs, pool.GetThreadCount());
+}
+
+TEST(HiZPyramid, Conservative)
+{
+	constexpr uint32 width = 300;
+	constexpr uint32 height = 170;
+
+	std::mt19937 random(11);
+	std::uniform_real_distribution<float> distribution(0.f, 1.f);
+	std::vector<float> depth(width * height);
+	for(float& value : depth)
+		value = distribution(random);
+
+	Graphics::HiZPyramid pyramid;
+	pyramid.Init(width, height);
+	pyramid.Build(depth.data(), Core::Matrix44f::Identity());
+
+	ASSERT_EQ(pyramid.GetLevel(0).m_Width, 256u);
+	ASSERT_EQ(pyramid.GetLevel(0).m_Height, 128u);
+	ASSERT_EQ(pyramid.GetLevel(pyramid.GetLevelCount() - 1).m_Width, 1u);
+	ASSERT_EQ(pyramid.GetLevel(pyramid.GetLevelCount() - 1).m_Height, 1u);
+	EXPECT_EQ(pyramid.GetLevel(pyramid.GetFirstReadbackLevel()).m_Width, Graphics::HiZPyramid::s_MaxReadbackWidth);
+
+	// every pixel is covered by a texel at least as far away
+	for(uint32 level = 0; level < pyramid.GetLevelCount(); ++level)
+	{
+		const Graphics::HiZPyramid::Level& size = pyramid.GetLevel(level);
+		const float* texels = pyramid.GetLevelData(level);
+		for(uint32 y = 0; y < height; ++y)
+		{
+			for(uint32 x = 0; x < width; ++x)
+			{
+				const uint32 texelX = x * size.m_Width / width;
+				const uint32 texelY = y * size.m_Height / height;
+				ASSERT_GE(texels[texelY * size.m_Width + texelX], depth[y * width + x]);
+			}
+		}
+	}
+
+	EXPECT_EQ(*pyramid.GetLevelData(pyramid.GetLevelCount() - 1), *std::max_element(depth.begin(), depth.end()));
+}
+
+TEST(HiZPyramid, CullsAgainstReadback)
+{
+	// the same wall as the occlusion buffer test, its depth is the source of the pyramid
+	const Core::Matrix44f viewProjection = Core::VKCreatePerspectiveMatrix(0.1f, 100.f, 16.f / 9.f, 90.f);
+	const Core::Vector4f wall[] = {
+		{ -4.f, -4.f, 10.f }, { 4.f, -4.f, 10.f }, { 4.f, 4.f, 10.f }, { -4.f, 4.f, 10.f },
+	};
+	const uint32 indices[] = { 0, 1, 2, 0, 2, 3 };
+
+	Graphics::OcclusionBuffer depth;
+	depth.Init(512, 288);
+	depth.Clear(viewProjection);
+	depth.AddOccluder(Core::Matrix44f::Identity(), wall, ARRSIZE(wall), indices, ARRSIZE(indices));
+	depth.Rasterize();
+
+	Graphics::HiZPyramid pyramid;
+	pyramid.Init(depth.GetWidth(), depth.GetHeight());
+
+	const Core::Vector4f min(-1.f, -1.f, -1.f);
+	const Core::Vector4f max(1.f, 1.f, 1.f);
+	EXPECT_TRUE(pyramid.IsVisible(MakeTranslation(0.f, 0.f, 20.f), min, max));
+
+	pyramid.Build(depth.GetDepth(), viewProjection);
+
+	// only the coarse levels come back from the GPU
+	Graphics::HiZPyramid readback;
+	readback.Init(depth.GetWidth(), depth.GetHeight());
+	readback.SetReadback(pyramid.GetLevelData(pyramid.GetFirstReadbackLevel()), viewProjection);
+
+	for(const Graphics::HiZPyramid* test : { &pyramid, &readback })
+	{
+		EXPECT_FALSE(test->IsVisible(MakeTranslation(0.f, 0.f, 20.f), min, max));
+		EXPECT_FALSE(test->IsVisible(MakeTranslation(1.f, -1.f, 60.f), min, max));
+		EXPECT_TRUE(test->IsVisible(MakeTranslation(0.f, 0.f, 5.f), min, max));
+		EXPECT_TRUE(test->IsVisible(MakeTranslation(15.f, 0.f, 20.f), min, max));
+		EXPECT_FALSE(test->IsVisible(MakeTranslation(200.f, 0.f, 20.f), min, max));
+	}
+}
+
+static std::vector<Graphics::Light> MakeLights(uint32 count, std::mt19937* random)
+{
+	std::uniform_real_distribution<float> spread(-40.f, 40.f);
+	std::uniform_real_distribution<float> depth(-5.f, 90.f);
+	std::uniform_real_distribution<float> range(0.5f, 6.f);
+	std::uniform_real_distribution<float> unit(-1.f, 1.f);
+
+	std::vector<Graphics::Light> lights(count);
+	for(uint32 i = 0; i < count; ++i)
+	{
+		Graphics::Light& light = lights[i];
+		light.m_Position = { spread(*random), spread(*random) * 0.6f, depth(*random), range(*random) };
+		light.m_Color = { 1.f, 1.f, 1.f, 1.f };
+		light.m_Direction = { unit(*random), unit(*random), unit(*random), 0.f };
+		light.m_Direction = light.m_Direction / light.m_Direction.Length();
+
+		// every other light is a spot, half of those wider than 90 degrees
+		light.m_Direction.w = (i % 2) == 0 ? Graphics::s_PointLight : (i % 4) == 1 ? 0.9f : 0.3f;
+	}
+	return lights;
+}
+
+TEST(LightClusters, ContainsLitPoints)
+{
+	const Core::Matrix44f projection = Core::VKCreatePerspectiveMatrix(0.1f, 100.f, 16.f / 9.f, 90.f);
+	std::mt19937 random(7);
+	const std::vector<Graphics::Light> lights = MakeLights(512, &random);
+
+	Graphics::LightClusters clusters;
+	clusters.Init(projection, 0.1f, 100.f, 1 << 20);
+	clusters.Build(Core::Matrix44f::Identity(), lights.data(), (uint32)lights.size());
+	EXPECT_EQ(clusters.GetDroppedCount(), 0u);
+	EXPECT_GT(clusters.GetVisibleCount(), 0u);
+	EXPECT_LT(clusters.GetVisibleCount(), (uint32)lights.size());
+
+	// any point a light reaches has to find the light in its cluster
+	std::uniform_real_distribution<float> unit(-1.f, 1.f);
+	uint32 tested = 0;
+	for(uint32 i = 0; i < lights.size(); ++i)
+	{
+		const Graphics::Light& light = lights[i];
+		for(uint32 sample = 0; sample < 64; ++sample)
+		{
+			Core::Vector4f offset(unit(random), unit(random), unit(random), 0.f);
+			const float length = offset.Length();
+			if(length > 1.f || length < 0.01f)
+				continue;
+
+			// inside the cone, point lights have a cone cosine below any dot product
+			if(Core::Dot(offset / length, light.m_Direction) < light.m_Direction.w)
+				continue;
+
+			offset *= light.m_Position.w;
+
+			Core::Vector4f point = light.m_Position + offset;
+			point.w = 1.f;
+			const Core::Vector4f clip = point * projection;
+			if(point.z < 0.1f || point.z > 100.f || clip.w <= 0.f)
+				continue;
+
+			const float screenX = clip.x / clip.w * 0.5f + 0.5f;
+			const float screenY = clip.y / clip.w * 0.5f + 0.5f;
+			if(screenX < 0.f || screenX >= 1.f || screenY < 0.f || screenY >= 1.f)
+				continue;
+
+			const Graphics::LightClusters::Cluster& cluster =
+				clusters.GetClusters()[clusters.GetClusterIndex(screenX, screenY, point.z)];
+			const uint32* first = clusters.GetIndices() + cluster.m_Offset;
+			EXPECT_NE(std::find(first, first + cluster.m_Count, i), first + cluster.m_Count);
+			tested++;
+		}
+	}
+	EXPECT_GT(tested, 1000u);
+}
+
+TEST(LightClusters, BinBenchmark)
+{
+	constexpr uint32 lightCount = 4096;
+	const Core::Matrix44f projection = Core::VKCreatePerspectiveMatrix(0.1f, 100.f, 16.f / 9.f, 90.f);
+	std::mt19937 random(11);
+	const std::vector<Graphics::Light> lights = MakeLights(lightCount, &random);
+
+	Graphics::LightClusters serial;
+	serial.Init(projection, 0.1f, 100.f, 1 << 20);
+	Graphics::LightClusters threaded;
+	threaded.Init(projection, 0.1f, 100.f, 1 << 20);
+
+	Core::ThreadPool pool;
+	pool.Init();
+
+	Core::Timer timer;
+	timer.Init();
+	serial.Build(Core::Matrix44f::Identity(), lights.data(), lightCount);
+	timer.Update();
+	const float serialMs = timer.GetTime() * 1000.f;
+	threaded.Build(Core::Matrix44f::Identity(), lights.data(), lightCount, &pool);
+	timer.Update();
+
+	ASSERT_EQ(serial.GetIndexCount(), threaded.GetIndexCount());
+	EXPECT_TRUE(std::equal(serial.GetIndices(), serial.GetIndices() + serial.GetIndexCount(), threaded.GetIndices()));
+	printf("Binned %u lights into %u indices in %.3f ms, %.3f ms on %u threads\n", serial.GetVisibleCount(),
+		   serial.GetIndexCount(), serialMs, timer.GetTime() * 1000.f, pool.GetThreadCount());
+
+	// a short index list drops what does not fit instead of overrunning it
+	Graphics::LightClusters small;
+	small.Init(projection, 0.1f, 100.f, 1000);
+	small.Build(Core::Matrix44f::Identity(), lights.data(), lightCount);
+	EXPECT_EQ(small.GetIndexCount(), 1000u);
+	EXPECT_EQ(small.GetDroppedCount(), serial.GetIndexCount() - 1000u);
+}
+
+static void MakeSphere(uint32 rings, uint32 segments, std::vector<Core::Vector4f>* positions,
+					   std::vector<uint32>* indices)
+{
+	for(uint32 ring = 0; ring <= rings; ++ring)
+	{
+		const float theta = 3.1415926f * (float)ring / (float)rings;
+		for(uint32 segment = 0; segment <= segments; ++segment)
+		{
+			const float phi = 2.f * 3.1415926f * (float)(segment % segments) / (float)segments;
+			positions->push_back({ sinf(theta) * cosf(phi), cosf(theta), sinf(theta) * sinf(phi), 1.f });
+		}
+	}
+
+	// the seam and the poles are separate vertices at equal positions, the LOD import welds them
+	for(uint32 ring = 0; ring < rings; ++ring)
+	{
+		for(uint32 segment = 0; segment < segments; ++segment)
+		{
+			const uint32 a = ring * (segments + 1) + segment;
+			const uint32 b = a + segments + 1;
+			const uint32 quad[] = { a, a + 1, b, a + 1, b + 1, b };
+			indices->insert(indices->end(), quad, quad + ARRSIZE(quad));
+		}
+	}
+}
+
+TEST(MeshLod, SimplifyKeepsSurface)
+{
+	// a flat grid can lose almost every triangle without moving its surface or its border
+	constexpr uint32 size = 16;
+	std::vector<Core::Vector4f> positions;
+	std::vector<uint32> indices;
+	for(uint32 y = 0; y <= size; ++y)
+	{
+		for(uint32 x = 0; x <= size; ++x)
+			positions.push_back({ (float)x, (float)y, 2.f, 1.f });
+	}
+	for(uint32 y = 0; y < size; ++y)
+	{
+		for(uint32 x = 0; x < size; ++x)
+		{
+			const uint32 a = y * (size + 1) + x;
+			const uint32 quad[] = { a, a + 1, a + size + 1, a + 1, a + size + 2, a + size + 1 };
+			indices.insert(indices.end(), quad, quad + ARRSIZE(quad));
+		}
+	}
+
+	std::vector<uint32> result;
+	const float error = Graphics::SimplifyMesh(positions.data(), (uint32)positions.size(), indices.data(),
+											   (uint32)indices.size(), (uint32)indices.size() / 8, &result);
+	EXPECT_LE(result.size(), indices.size() / 8);
+	EXPECT_LT(error, 1e-3f);
+
+	float area = 0.f;
+	for(size_t i = 0; i < result.size(); i += 3)
+	{
+		const Core::Vector4f& a = positions[result[i]];
+		const Core::Vector4f& b = positions[result[i + 1]];
+		const Core::Vector4f& c = positions[result[i + 2]];
+		const float z = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+		EXPECT_GT(z, 0.f);
+		area += z * 0.5f;
+	}
+	EXPECT_NEAR(area, (float)(size * size), 1e-3f);
+
+	// a curved surface has to move, but not by much at half the triangles
+	positions.clear();
+	indices.clear();
+	MakeSphere(16, 24, &positions, &indices);
+	const float sphereError = Graphics::SimplifyMesh(positions.data(), (uint32)positions.size(), indices.data(),
+													 (uint32)indices.size(), (uint32)indices.size() / 2, &result);
+	EXPECT_LE(result.size(), indices.size() / 2);
+	EXPECT_GT(sphereError, 0.f);
+	EXPECT_LT(sphereError, 0.25f);
+}
+
+TEST(MeshLod, SelectionHysteresis)
+{
+	struct TestVertex
+	{
+		Core::Vector4f m_Position;
+		Core::Vector4f m_Normal;
+	};
+
+	std::vector<Core::Vector4f> positions;
+	std::vector<uint32> indices;
+	MakeSphere(24, 32, &positions, &indices);
+	std::vector<TestVertex> vertices;
+	for(uint32 index : indices)
+		vertices.push_back({ positions[index], positions[index] });
+
+	std::vector<uint8> lodVertices;
+	std::vector<Graphics::MeshLod> lods;
+	Graphics::BuildLods(vertices.data(), sizeof(TestVertex), (uint32)vertices.size(), Graphics::s_MaxLods,
+						&lodVertices, &lods);
+	ASSERT_GE(lods.size(), 3u);
+	ASSERT_LE(lods.size(), Graphics::s_MaxLods);
+	EXPECT_EQ(lods[0].m_VertexCount, (uint32)vertices.size());
+	EXPECT_EQ(memcmp(lodVertices.data(), vertices.data(), vertices.size() * sizeof(TestVertex)), 0);
+	for(size_t i = 1; i < lods.size(); ++i)
+	{
+		EXPECT_LT(lods[i].m_VertexCount, lods[i - 1].m_VertexCount);
+		EXPECT_GE(lods[i].m_Error, lods[i - 1].m_Error);
+		EXPECT_EQ(lods[i].m_FirstVertex, lods[i - 1].m_FirstVertex + lods[i - 1].m_VertexCount);
+	}
+	EXPECT_EQ(lodVertices.size(), (lods.back().m_FirstVertex + lods.back().m_VertexCount) * sizeof(TestVertex));
+
+	const uint32 last = (uint32)lods.size() - 1;
+	constexpr float maxPixelError = 1.f;
+	constexpr float hysteresis = 0.25f;
+	EXPECT_EQ(Graphics::SelectLod(lods.data(), (uint32)lods.size(), 0, 1e6f, maxPixelError, hysteresis), 0u);
+	EXPECT_EQ(Graphics::SelectLod(lods.data(), (uint32)lods.size(), 0, 1e-6f, maxPixelError, hysteresis), last);
+
+	// walking away only ever coarsens, walking back only ever refines
+	uint32 lod = 0;
+	for(float pixelsPerUnit = 1e4f; pixelsPerUnit > 1e-2f; pixelsPerUnit *= 0.9f)
+	{
+		const uint32 next = Graphics::SelectLod(lods.data(), (uint32)lods.size(), lod, pixelsPerUnit, maxPixelError,
+												hysteresis);
+		EXPECT_GE(next, lod);
+		lod = next;
+	}
+	EXPECT_EQ(lod, last);
+
+	// right at the threshold of LOD 1 small changes in distance do not switch back and forth
+	const float threshold = maxPixelError / lods[1].m_Error;
+	lod = Graphics::SelectLod(lods.data(), (uint32)lods.size(), 0, threshold, maxPixelError, hysteresis);
+	EXPECT_EQ(lod, 0u);
+	lod = Graphics::SelectLod(lods.data(), (uint32)lods.size(), 1, threshold, maxPixelError, hysteresis);
+	EXPECT_EQ(lod, 1u);
+	for(uint32 i = 0; i < 10; ++i)
+	{
+		const float wobble = (i % 2) == 0 ? 1.1f : 0.9f;
+		EXPECT_EQ(Graphics::SelectLod(lods.data(), (uint32)lods.size(), 1, threshold * wobble, maxPixelError,
+									  hysteresis),
+				  1u);
+	}
+}
+
+struct TestPosition
+{
+	float x, y, z;
+};
+
+struct TestVelocity
+{
+	float x, y, z;
+};
+
+struct TestTag
+{
+	uint32 m_Value;
+};
+
+TEST(ECS, StructuralChanges)
+{
+	Core::World world;
+	std::vector<Core::Entity> entities;
+	constexpr uint32 entityCount = 2000; // several chunks
+	for(uint32 i = 0; i < entityCount; ++i)
+		entities.push_back(world.CreateEntity(TestPosition{ (float)i, 0.f, 0.f }));
+	EXPECT_EQ(world.GetEntityCount(), entityCount);
+
+	// every third entity moves to another archetype and back for some, the values follow the entity
+	for(uint32 i = 0; i < entityCount; i += 3)
+		world.AddComponent(entities[i], TestVelocity{ 0.f, (float)i, 0.f });
+	for(uint32 i = 0; i < entityCount; i += 6)
+		world.RemoveComponent<TestVelocity>(entities[i]);
+	for(uint32 i = 0; i < entityCount; ++i)
+	{
+		ASSERT_TRUE(world.IsAlive(entities[i]));
+		EXPECT_EQ(world.GetComponent<TestPosition>(entities[i])->x, (float)i);
+		const bool hasVelocity = i % 3 == 0 && i % 6 != 0;
+		EXPECT_EQ(world.HasComponent<TestVelocity>(entities[i]), hasVelocity);
+		if(hasVelocity)
+		{
+			EXPECT_EQ(world.GetComponent<TestVelocity>(entities[i])->y, (float)i);
+		}
+	}
+
+	// destroyed handles stay dead when their slot is reused
+	for(uint32 i = 0; i < entityCount; i += 2)
+		world.DestroyEntity(entities[i]);
+	EXPECT_EQ(world.GetEntityCount(), entityCount / 2);
+	const Core::Entity reused = world.CreateEntity(TestTag{ 7 });
+	EXPECT_FALSE(world.IsAlive(entities[entityCount - 2]));
+	EXPECT_EQ(reused.m_Index, entities[entityCount - 2].m_Index);
+	EXPECT_NE(reused, entities[entityCount - 2]);
+	EXPECT_EQ(world.GetComponent<TestPosition>(entities[entityCount - 2]), nullptr);
+	EXPECT_EQ(world.GetComponent<TestTag>(reused)->m_Value, 7u);
+	EXPECT_FALSE(world.IsAlive(Core::Entity()));
+
+	for(uint32 i = 1; i < entityCount; i += 2)
+		EXPECT_EQ(world.GetComponent<TestPosition>(entities[i])->x, (float)i);
+}
+
+TEST(ECS, QueriesAndParallel)
+{
+	Core::World world;
+	Core::Query* moving = world.CreateQuery<TestPosition, TestVelocity>();
+	Core::Query* still = world.CreateQuery<TestPosition>(Core::ComponentRegistry::GetMask<TestVelocity>());
+	EXPECT_EQ((world.CreateQuery<TestPosition, TestVelocity>()), moving);
+
+	// archetypes made after the queries are picked up by them
+	constexpr uint32 entityCount = 5000;
+	for(uint32 i = 0; i < entityCount; ++i)
+	{
+		if(i % 4 == 0)
+			world.CreateEntity(TestPosition{ 0.f, 0.f, 0.f });
+		else if(i % 4 == 1)
+			world.CreateEntity(TestPosition{ 0.f, 0.f, 0.f }, TestVelocity{ (float)i, 1.f, 0.f });
+		else
+			world.CreateEntity(TestPosition{ 0.f, 0.f, 0.f }, TestVelocity{ (float)i, 1.f, 0.f }, TestTag{ i });
+	}
+	EXPECT_EQ(moving->m_Archetypes.size(), 2u);
+	EXPECT_EQ(still->m_Archetypes.size(), 1u);
+	EXPECT_EQ(world.GetEntityCount(moving), entityCount - entityCount / 4);
+	EXPECT_EQ(world.GetEntityCount(still), entityCount / 4);
+
+	uint32 stillCount = 0;
+	world.ForEach<TestPosition>(still, [&](TestPosition&) { stillCount++; });
+	EXPECT_EQ(stillCount, entityCount / 4);
+
+	Core::ThreadPool pool;
+	pool.Init(3);
+	std::atomic<uint32> moved{ 0 };
+	world.ParallelForEach<TestPosition, TestVelocity>(moving, &pool, [&](TestPosition& position,
+																		  TestVelocity& velocity) {
+		position.x += velocity.x;
+		position.y += velocity.y;
+		moved++;
+	});
+	EXPECT_EQ(moved.load(), entityCount - entityCount / 4);
+
+	// the command buffer is filled from the workers and applied once the iteration is over
+	Core::Query* tagged = world.CreateQuery<TestTag>();
+	Core::EntityCommandBuffer commands;
+	world.ParallelForEach<TestTag>(tagged, &pool, [&](TestTag& tag) {
+		if(tag.m_Value % 2 == 0)
+			commands.Create(TestTag{ tag.m_Value + 1 });
+	});
+	world.ForEachChunk<TestTag>(tagged, [&](uint32 count, const Core::Entity* entities, TestTag* tags) {
+		for(uint32 i = 0; i < count; ++i)
+		{
+			if(tags[i].m_Value % 2 == 0)
+				commands.Remove<TestVelocity>(entities[i]);
+		}
+	});
+	commands.Playback(&world);
+	EXPECT_TRUE(commands.IsEmpty());
+
+	uint32 serialCount = 0;
+	world.ForEach<TestPosition, TestVelocity>(moving, [&](TestPosition& position, TestVelocity& velocity) {
+		EXPECT_EQ(position.x, velocity.x);
+		EXPECT_EQ(position.y, 1.f);
+		serialCount++;
+	});
+	EXPECT_EQ(serialCount, entityCount / 2);
+	EXPECT_EQ(world.GetEntityCount(), entityCount + entityCount / 4);
+}
+
+/* the world matrix the slow way, parent by parent */
+static Core::Matrix44f ReferenceWorld(const Core::TransformHierarchy& hierarchy, Core::TransformId id,
+									  const std::vector<float>& angles, const std::vector<float>& scales)
+{
+	Core::Matrix44f local = Core::Matrix44f::CreateRotateAroundY(angles[id]);
+	local = local * Core::Matrix44f::CreateScaleMatrix(scales[id], scales[id], scales[id], 1.f);
+	local.SetPosition(hierarchy.GetPosition(id));
+
+	const Core::TransformId parent = hierarchy.GetParent(id);
+	if(parent == Core::s_NoParent)
+		return local;
+	return ReferenceWorld(hierarchy, parent, angles, scales) * local;
+}
+
+static Core::Vector4f YRotation(float angle)
+{
+	return { 0.f, sinf(angle * 0.5f), 0.f, cosf(angle * 0.5f) };
+}
+
+TEST(TransformHierarchy, MatchesReference)
+{
+	// parents are picked at random, so children of one parent are created far apart
+	constexpr uint32 nodeCount = 5000;
+	std::mt19937 random(5);
+	std::uniform_real_distribution<float> unit(0.f, 1.f);
+	Core::TransformHierarchy hierarchy;
+	std::vector<float> angles;
+	std::vector<float> scales;
+	for(uint32 i = 0; i < nodeCount; ++i)
+	{
+		const Core::TransformId parent = i < 3 ? Core::s_NoParent : (Core::TransformId)(random() % i);
+		const Core::TransformId id = hierarchy.Create(parent);
+		angles.push_back(unit(random) * 6.28f);
+		scales.push_back(0.9f + unit(random) * 0.2f);
+		hierarchy.SetLocal(id, { unit(random), unit(random), unit(random), 1.f }, YRotation(angles[id]),
+						   { scales[id], scales[id], scales[id], 1.f });
+	}
+
+	Core::ThreadPool pool;
+	pool.Init(3);
+	EXPECT_EQ(hierarchy.Update(&pool), nodeCount);
+	EXPECT_EQ(hierarchy.Update(&pool), 0u);
+
+	// moving a node updates exactly its subtree
+	hierarchy.SetPosition(1, { 2.f, 0.f, 0.f, 1.f });
+	angles[7] += 1.f;
+	hierarchy.SetRotation(7, YRotation(angles[7]));
+	const uint32 updated = hierarchy.Update(&pool);
+	EXPECT_GT(updated, 1u);
+	EXPECT_LT(updated, nodeCount);
+
+	for(Core::TransformId id = 0; id < nodeCount; ++id)
+	{
+		const Core::Matrix44f expected = ReferenceWorld(hierarchy, id, angles, scales);
+		const Core::Matrix44f& world = hierarchy.GetWorld(id);
+		for(int i = 0; i < 16; ++i)
+			ASSERT_NEAR(world[i], expected[i], 1e-3f) << "node " << id;
+	}
+}
+
+TEST(TransformHierarchy, SparseUpdateBenchmark)
+{
+	// 1000 roots with two levels of 10 children each, 100k nodes
+	constexpr uint32 rootCount = 1000;
+	Core::TransformHierarchy hierarchy;
+	std::vector<Core::TransformId> leaves;
+	for(uint32 root = 0; root < rootCount; ++root)
+	{
+		const Core::TransformId rootId = hierarchy.Create();
+		for(uint32 child = 0; child < 9; ++child)
+		{
+			const Core::TransformId childId = hierarchy.Create(rootId);
+			for(uint32 leaf = 0; leaf < 10; ++leaf)
+				leaves.push_back(hierarchy.Create(childId));
+		}
+	}
+	ASSERT_EQ(hierarchy.GetCount(), 100000u);
+
+	Core::ThreadPool pool;
+	pool.Init();
+	hierarchy.Update(&pool);
+
+	// 1% of the nodes move, every 90th leaf. The first round warms up the dirty lists.
+	auto moveLeaves = [&](float y) {
+		for(size_t i = 0; i < leaves.size(); i += 90)
+			hierarchy.SetPosition(leaves[i], { 1.f, y, 3.f, 1.f });
+	};
+	moveLeaves(1.f);
+	hierarchy.Update(&pool);
+
+	Core::Timer timer;
+	timer.Init();
+	moveLeaves(2.f);
+	const uint32 updated = hierarchy.Update(&pool);
+	timer.Update();
+	EXPECT_EQ(updated, (uint32)(leaves.size() + 89) / 90);
+	EXPECT_EQ(hierarchy.GetWorld(leaves[90]).GetTranslation().y, 2.f);
+
+	// a root moving takes its whole subtree along
+	hierarchy.SetPosition(0, { 0.f, 10.f, 0.f, 1.f });
+	EXPECT_EQ(hierarchy.Update(&pool), 100u);
+	EXPECT_EQ(hierarchy.GetWorld(leaves[0]).GetTranslation().y, 12.f);
+	printf("Updated %u of %u transforms in %.1f us\n", updated, hierarchy.GetCount(), timer.GetTime() * 1e6f);
+}
+
+TEST(RenderPacketQueue, FrameOrder)
+{
+	// the reader sees every frame once, in order, with the draws the writer put in
+	for(uint32 packetCount = 2; packetCount <= Graphics::RenderPacketQueue::s_MaxPackets; ++packetCount)
+	{
+		Graphics::RenderPacketQueue queue;
+		queue.Init(packetCount);
+
+		constexpr uint64 frameCount = 1000;
+		std::thread writer([&queue]() {
+			for(uint64 frame = 1; frame <= frameCount; ++frame)
+			{
+				Graphics::RenderPacket* packet = queue.BeginWrite();
+				packet->m_Frame = frame;
+				packet->m_Draws.resize(frame % 7 + 1);
+				for(Graphics::RenderDraw& draw : packet->m_Draws)
+					draw.m_Depth = (float)frame;
+				queue.EndWrite();
+			}
+			queue.Close();
+		});
+
+		uint64 expected = 1;
+		uint32 mismatches = 0;
+		while(const Graphics::RenderPacket* packet = queue.BeginRead())
+		{
+			EXPECT_EQ(packet->m_Frame, expected);
+			EXPECT_EQ(packet->m_Draws.size(), expected % 7 + 1);
+			for(const Graphics::RenderDraw& draw : packet->m_Draws)
+				mismatches += draw.m_Depth != (float)expected;
+			EXPECT_LT(queue.GetIndex(packet), packetCount);
+			expected++;
+			queue.EndRead();
+		}
+		writer.join();
+		EXPECT_EQ(expected, frameCount + 1);
+		EXPECT_EQ(mismatches, 0u);
+	}
+}
+
+TEST(RenderPacketQueue, CloseWakesThreads)
+{
+	Graphics::RenderPacketQueue queue;
+	queue.Init(2);
+
+	// a reader waiting on an empty queue gets nullptr
+	std::thread reader([&queue]() { EXPECT_EQ(queue.BeginRead(), nullptr); });
+	std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	queue.Close();
+	reader.join();
+
+	// a writer waiting on a full queue gets nullptr, the packets written before the close are still read
+	queue.Init(2);
+	for(uint64 frame = 1; frame <= 2; ++frame)
+	{
+		queue.BeginWrite()->m_Frame = frame;
+		queue.EndWrite();
+	}
+	std::thread writer([&queue]() { EXPECT_EQ(queue.BeginWrite(), nullptr); });
+	std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	queue.Close();
+	writer.join();
+
+	for(uint64 frame = 1; frame <= 2; ++frame)
+	{
+		const Graphics::RenderPacket* packet = queue.BeginRead();
+		ASSERT_NE(packet, nullptr);
+		EXPECT_EQ(packet->m_Frame, frame);
+		queue.EndRead();
+	}
+	EXPECT_EQ(queue.BeginRead(), nullptr);
+}
+
+TEST(FixedTimestep, StepsAndAlpha)
+{
+	Core::FixedTimestep timestep;
+	timestep.Init(0.01f, 4);
+
+	// frames shorter than a step only move the blend along
+	EXPECT_EQ(timestep.Advance(0.004f), 0u);
+	EXPECT_NEAR(timestep.GetAlpha(), 0.4f, 1e-4f);
+	EXPECT_EQ(timestep.Advance(0.004f), 0u);
+	EXPECT_EQ(timestep.Advance(0.004f), 1u);
+	EXPECT_NEAR(timestep.GetAlpha(), 0.2f, 1e-4f);
+
+	// ten seconds at any frame rate are ten seconds of steps plus the blend
+	const float rates[] = { 144.f, 60.f, 30.f, 24.f };
+	for(float rate : rates)
+	{
+		Core::FixedTimestep timestep;
+		timestep.Init(1.f / 60.f, 8);
+		for(uint32 frame = 0; frame < (uint32)(rate * 10.f); ++frame)
+			timestep.Advance(1.f / rate);
+
+		const float simulated = (timestep.GetStepCount() + timestep.GetAlpha()) * timestep.GetStep();
+		EXPECT_NEAR(simulated, 10.f, 1e-3f);
+		EXPECT_EQ(timestep.GetDroppedTime(), 0.f);
+	}
+}
+
+TEST(FixedTimestep, CatchUpIsLimited)
+{
+	Core::FixedTimestep timestep;
+	timestep.Init(0.01f, 4);
+
+	// a long hitch runs at most four steps and drops the rest instead of spiralling
+	EXPECT_EQ(timestep.Advance(1.f), 4u);
+	EXPECT_NEAR(timestep.GetDroppedTime(), 0.96f, 1e-4f);
+	EXPECT_LT(timestep.GetAlpha(), 1.f);
+	EXPECT_EQ(timestep.Advance(0.01f), 1u);
+	EXPECT_EQ(timestep.GetStepCount(), 5u);
+}
+
+static Input::DeviceState RecordedState(uint32 frame, bool mouse)
+{
+	// the keyboard changes every tenth frame, the mouse every other
+	Input::DeviceState state;
+	const uint32 change = mouse ? frame / 2 : frame / 10;
+	state.SetDown((uint8)(change % 200));
+	if(mouse)
+	{
+		state.m_Cursor.dx = (float)change;
+		state.m_Cursor.dy = -(float)change;
+	}
+	return state;
+}
+
+TEST(InputRecording, RoundTrip)
+{
+	const char* filepath = "input_roundtrip.rec";
+	Input::InputDeviceReplay keyboard(Input::EDeviceType_Keyboard);
+	Input::InputDeviceReplay mouse(Input::EDeviceType_Mouse);
+	Input::IInputDevice* devices[] = { &keyboard, &mouse };
+
+	constexpr uint32 frameCount = 100;
+	{
+		Input::InputRecorder recorder;
+		ASSERT_TRUE(recorder.Open(filepath, devices, 2));
+		for(uint32 frame = 0; frame < frameCount; ++frame)
+		{
+			keyboard.SetState(RecordedState(frame, false));
+			mouse.SetState(RecordedState(frame, true));
+			recorder.WriteFrame(0.01f * (frame % 3 + 1));
+		}
+		EXPECT_EQ(recorder.GetFrameCount(), frameCount);
+	}
+
+	Input::InputReplay replay;
+	ASSERT_TRUE(replay.Open(filepath));
+	ASSERT_EQ(replay.GetDeviceCount(), 2u);
+	EXPECT_EQ(replay.GetDeviceType(0), Input::EDeviceType_Keyboard);
+	EXPECT_EQ(replay.GetDeviceType(1), Input::EDeviceType_Mouse);
+
+	Input::InputDeviceReplay replayKeyboard(Input::EDeviceType_Keyboard);
+	Input::InputDeviceReplay replayMouse(Input::EDeviceType_Mouse);
+	uint32 frame = 0;
+	float dt = 0.f;
+	Input::DeviceState states[2];
+	while(replay.ReadFrame(&dt, states))
+	{
+		replayKeyboard.SetState(states[0]);
+		replayMouse.SetState(states[1]);
+		EXPECT_EQ(dt, 0.01f * (frame % 3 + 1));
+
+		const uint8 key = (uint8)(frame / 10 % 200);
+		EXPECT_TRUE(replayKeyboard.IsDown(key));
+		EXPECT_EQ(replayKeyboard.OnDown(key), frame % 10 == 0);
+		EXPECT_EQ(replayMouse.GetCursor().dx, (float)(frame / 2));
+		const Input::DeviceState expected = RecordedState(frame, true);
+		EXPECT_EQ(memcmp(&states[1], &expected, sizeof(Input::DeviceState)), 0);
+		frame++;
+	}
+	EXPECT_EQ(frame, frameCount);
+
+	// only the changed states are stored: 10 keyboard and 50 mouse states on top of five bytes a frame
+	FILE* file = fopen(filepath, "rb");
+	ASSERT_NE(file, nullptr);
+	fseek(file, 0, SEEK_END);
+	const long size = ftell(file);
+	fclose(file);
+	EXPECT_EQ(size, (long)(5 * sizeof(uint32) + frameCount * 5 + 60 * sizeof(Input::DeviceState)));
+	remove(filepath);
+}
+
+TEST(InputRecording, BadFiles)
+{
+	Input::InputReplay replay;
+	EXPECT_FALSE(replay.Open("does_not_exist.rec"));
+
+	// not a recording
+	const char* filepath = "input_bad.rec";
+	FILE* file = fopen(filepath, "wb");
+	ASSERT_NE(file, nullptr);
+	fputs("definitely not input", file);
+	fclose(file);
+	EXPECT_FALSE(replay.Open(filepath));
+
+	// a recording cut off in the middle of a frame plays the frames before it
+	Input::InputDeviceReplay keyboard(Input::EDeviceType_Keyboard);
+	Input::IInputDevice* devices[] = { &keyboard };
+	{
+		Input::InputRecorder recorder;
+		ASSERT_TRUE(recorder.Open(filepath, devices, 1));
+		for(uint32 frame = 0; frame < 3; ++frame)
+		{
+			keyboard.SetState(RecordedState(frame * 10, false));
+			recorder.WriteFrame(0.016f);
+		}
+	}
+	file = fopen(filepath, "rb");
+	ASSERT_NE(file, nullptr);
+	std::vector<char> data(4096);
+	data.resize(fread(data.data(), 1, data.size(), file));
+	fclose(file);
+	file = fopen(filepath, "wb");
+	fwrite(data.data(), 1, data.size() - 1, file);
+	fclose(file);
+
+	ASSERT_TRUE(replay.Open(filepath));
+	float dt = 0.f;
+	Input::DeviceState state;
+	uint32 frames = 0;
+	while(replay.ReadFrame(&dt, &state))
+		frames++;
+	EXPECT_EQ(frames, 2u);
+	remove(filepath);
+}
+
+TEST(InputRecording, RecordReplay)
+{
+	const char* replayPath = "input_replay.rec";
+	const char* recordPath = "input_rerecord.rec";
+	constexpr uint32 frameCount = 10;
+	{
+		Input::InputDeviceReplay keyboard(Input::EDeviceType_Keyboard);
+		Input::IInputDevice* devices[] = { &keyboard };
+		Input::InputRecorder recorder;
+		ASSERT_TRUE(recorder.Open(replayPath, devices, 1));
+		for(uint32 frame = 0; frame < frameCount; ++frame)
+		{
+			keyboard.SetState(RecordedState(frame, false));
+			recorder.WriteFrame(0.01f * (frame + 1));
+		}
+	}
+
+	// recording a replay writes what the game saw, the recording ends with the replay
+	{
+		Input::InputManager manager;
+		ASSERT_TRUE(manager.StartReplay(replayPath));
+		ASSERT_TRUE(manager.StartRecording(recordPath));
+		for(uint32 frame = 0; frame < frameCount + 5; ++frame)
+			manager.Update(1.f);
+		EXPECT_FALSE(manager.IsReplaying());
+		EXPECT_FALSE(manager.IsRecording());
+	}
+
+	Input::InputReplay replay;
+	ASSERT_TRUE(replay.Open(recordPath));
+	ASSERT_EQ(replay.GetDeviceCount(), 1u);
+	uint32 frame = 0;
+	float dt = 0.f;
+	Input::DeviceState state;
+	while(replay.ReadFrame(&dt, &state))
+	{
+		EXPECT_EQ(dt, 0.01f * (frame + 1));
+		const Input::DeviceState expected = RecordedState(frame, false);
+		EXPECT_EQ(memcmp(&state, &expected, sizeof(Input::DeviceState)), 0);
+		frame++;
+	}
+	EXPECT_EQ(frame, frameCount);
+	remove(replayPath);
+	remove(recordPath);
+}
+
+TEST(SpscQueue, ProducerConsumer)
+{
+	Core::SpscQueue<uint32> queue;
+	queue.Init(64);
+	EXPECT_EQ(queue.GetCapacity(), 64u);
+
+	uint32 value = 0;
+	EXPECT_FALSE(queue.Pop(&value));
+	for(uint32 i = 0; i < 64; ++i)
+		EXPECT_TRUE(queue.Push(i));
+	EXPECT_FALSE(queue.Push(64));
+	EXPECT_TRUE(queue.Pop(&value));
+	EXPECT_EQ(value, 0u);
+	EXPECT_TRUE(queue.Push(64));
+	for(uint32 i = 1; i <= 64; ++i)
+	{
+		EXPECT_TRUE(queue.Pop(&value));
+		EXPECT_EQ(value, i);
+	}
+
+	// every value arrives once and in order while both sides run flat out
+	constexpr uint32 count = 200000;
+	std::thread producer([&queue]() {
+		for(uint32 i = 1; i <= count;)
+		{
+			if(queue.Push(i))
+				++i;
+			else
+				std::this_thread::yield();
+		}
+	});
+
+	uint32 expected = 1;
+	uint32 outOfOrder = 0;
+	while(expected <= count)
+	{
+		if(queue.Pop(&value))
+		{
+			outOfOrder += value != expected;
+			expected++;
+		}
+		else
+		{
+			std::this_thread::yield();
+		}
+	}
+	producer.join();
+	EXPECT_EQ(outOfOrder, 0u);
+	EXPECT_FALSE(queue.Pop(&value));
+}
+
+TEST(InputEvents, TapInsideFrame)
+{
+	Input::InputEventSource_Headless source;
+	Input::IInputEventSource* sources[] = { &source };
+	Input::InputManager input;
+	input.InitializeEvents(sources, 1);
+
+	Input::IInputDevice* keyboard = nullptr;
+	Input::InputDeviceEvents* mouse = nullptr;
+	input.GetDevice(Input::EDeviceType_Keyboard, &keyboard);
+	input.GetDevice(Input::EDeviceType_Mouse, &mouse);
+	ASSERT_NE(keyboard, nullptr);
+	ASSERT_NE(mouse, nullptr);
+
+	// a key that goes down and up again between two frames
+	constexpr uint8 key = 0x11;
+	Input::InputEvent event;
+	event.m_Device = Input::EDeviceType_Keyboard;
+	event.m_Button = key;
+	event.m_Time = 1000;
+	source.Inject(event);
+	event.m_Type = Input::EInputEventType_ButtonUp;
+	event.m_Time = 1500;
+	source.Inject(event);
+
+	Input::InputEvent move;
+	move.m_Device = Input::EDeviceType_Mouse;
+	move.m_Type = Input::EInputEventType_Move;
+	move.m_X = 3.f;
+	move.m_Y = -2.f;
+	source.Inject(move);
+	source.Inject(move);
+
+	// the input thread hands the events over on its own time
+	while(mouse->GetCursor().dx == 0.f)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		input.Update(0.f);
+	}
+	EXPECT_TRUE(keyboard->OnDown(key));
+	EXPECT_TRUE(keyboard->OnRelease(key));
+	EXPECT_FALSE(keyboard->IsDown(key));
+	EXPECT_EQ(static_cast<Input::InputDeviceEvents*>(keyboard)->GetDownTime(key), 1000u);
+	EXPECT_EQ(static_cast<Input::InputDeviceEvents*>(keyboard)->GetReleaseTime(key), 1500u);
+	EXPECT_EQ(mouse->GetCursor().dx, 6.f);
+	EXPECT_EQ(mouse->GetCursor().dy, -4.f);
+
+	// the next frame has no edges left
+	input.Update(0.f);
+	EXPECT_FALSE(keyboard->OnDown(key));
+	EXPECT_FALSE(keyboard->OnRelease(key));
+	EXPECT_EQ(mouse->GetCursor().dx, 0.f);
+}
+
+#ifdef __linux__
+TEST(InputEvents, EvdevSource)
+{
+	// a pipe reads like an event node, the kernel's structs are written into it
+	int fds[2];
+	ASSERT_EQ(pipe(fds), 0);
+	Input::InputEventSource_Linux source;
+	source.AddDevice(fds[0]);
+
+	auto write = [&](uint16 type, uint16 code, int32 value) {
+		input_event raw = {};
+		raw.type = type;
+		raw.code = code;
+		raw.value = value;
+		ASSERT_EQ(::write(fds[1], &raw, sizeof(raw)), (ssize_t)sizeof(raw));
+	};
+	write(EV_KEY, KEY_W, 1);
+	write(EV_KEY, KEY_W, 2); // repeat
+	write(EV_SYN, SYN_REPORT, 0);
+	write(EV_REL, REL_X, 5);
+	write(EV_REL, REL_Y, -3);
+	write(EV_SYN, SYN_REPORT, 0);
+	write(EV_KEY, BTN_RIGHT, 1);
+	write(EV_KEY, KEY_UP, 0);
+	write(EV_KEY, KEY_W, 0);
+	write(EV_SYN, SYN_REPORT, 0);
+
+	std::vector<Input::InputEvent> events;
+	source.Poll(&events);
+	close(fds[1]);
+
+	ASSERT_EQ(events.size(), 5u);
+	EXPECT_EQ(events[0].m_Device, Input::EDeviceType_Keyboard);
+	EXPECT_EQ(events[0].m_Type, Input::EInputEventType_ButtonDown);
+	EXPECT_EQ(events[0].m_Button, 0x11); // DIK_W
+	EXPECT_EQ(events[1].m_Type, Input::EInputEventType_Move);
+	EXPECT_EQ(events[1].m_X, 5.f);
+	EXPECT_EQ(events[1].m_Y, -3.f);
+	EXPECT_EQ(events[2].m_Device, Input::EDeviceType_Mouse);
+	EXPECT_EQ(events[2].m_Button, 1);
+	EXPECT_EQ(events[3].m_Button, 0xc8); // DIK_UP
+	EXPECT_EQ(events[3].m_Type, Input::EInputEventType_ButtonUp);
+	EXPECT_EQ(events[4].m_Button, 0x11);
+	EXPECT_GT(events[0].m_Time, 0u);
+}
+#endif
+
+TEST(LinearArena, MarkersAndBlocks)
+{
+	Core::LinearArena arena;
+	arena.Init(1024);
+
+	uint8* first = (uint8*)arena.Allocate(100, 16);
+	EXPECT_EQ((size_t)first % 16, 0u);
+	const Core::LinearArena::Marker marker = arena.GetMarker();
+	uint32* values = arena.Allocate<uint32>(50);
+	EXPECT_EQ((size_t)values % alignof(uint32), 0u);
+	EXPECT_GE((uint8*)values, first + 100);
+	arena.Rewind(marker);
+	EXPECT_EQ(arena.Allocate<uint32>(50), values);
+
+	// too big for the first block, a second one is allocated and the peak covers both
+	uint8* big = (uint8*)arena.Allocate(4000, 64);
+	EXPECT_EQ((size_t)big % 64, 0u);
+	EXPECT_EQ(arena.GetBlockCount(), 2u);
+	EXPECT_GE(arena.GetUsed(), 4300u);
+
+	// the next frame gets one block that holds everything
+	arena.Reset();
+	EXPECT_EQ(arena.GetUsed(), 0u);
+	EXPECT_EQ(arena.GetBlockCount(), 1u);
+	EXPECT_GE(arena.GetCapacity(), arena.GetPeak());
+	arena.Allocate(100, 16);
+	arena.Allocate<uint32>(50);
+	arena.Allocate(4000, 64);
+	EXPECT_EQ(arena.GetBlockCount(), 1u);
+
+	// scopes give their scratch memory back in reverse order
+	Core::LinearArena& scratch = Core::GetScratch();
+	const size_t scratchUsed = scratch.GetUsed();
+	{
+		Core::ScratchScope outer;
+		uint32* outerValues = outer.Allocate<uint32>(16);
+		{
+			Core::ScratchScope inner;
+			inner.Allocate<uint32>(1000);
+			EXPECT_GE(scratch.GetUsed(), scratchUsed + 4064);
+		}
+		EXPECT_EQ(outer.Allocate<uint32>(1), outerValues + 16);
+	}
+	EXPECT_EQ(scratch.GetUsed(), scratchUsed);
+}
+
+TEST(LinearArena, AllocationCount)
+{
+	// the same transient arrays on the heap and in the scratch arena, three frames each
+	auto fill = [](auto* values) {
+		for(uint32 i = 0; i < 1000; ++i)
+			values->push_back(i);
+		return values->back();
+	};
+
+	uint64 before = s_HeapAllocations.load();
+	for(uint32 frame = 0; frame < 3; ++frame)
+	{
+		std::vector<uint32> values;
+		EXPECT_EQ(fill(&values), 999u);
+	}
+	const uint64 heapAllocations = s_HeapAllocations.load() - before;
+
+	before = s_HeapAllocations.load();
+	for(uint32 frame = 0; frame < 3; ++frame)
+	{
+		Core::ScratchScope scratch;
+		Core::ArenaVector<uint32> values(scratch.GetArena());
+		EXPECT_EQ(fill(&values), 999u);
+	}
+	const uint64 arenaAllocations = s_HeapAllocations.load() - before;
+	EXPECT_GT(heapAllocations, 3u);
+	EXPECT_LE(arenaAllocations, 1u); // the scratch block, unless an earlier test on this thread took it already
+
+	// once the dirty lists and the scratch block are warmed up an update does not touch the heap
+	Core::TransformHierarchy hierarchy;
+	for(uint32 i = 0; i < 3000; ++i)
+		hierarchy.Create();
+	hierarchy.Update();
+	for(uint32 i = 0; i < 3000; ++i)
+		hierarchy.SetPosition(i, { 1.f, 2.f, 3.f, 1.f });
+	hierarchy.Update();
+
+	before = s_HeapAllocations.load();
+	for(uint32 i = 0; i < 3000; ++i)
+		hierarchy.SetPosition(i, { 4.f, 5.f, 6.f, 1.f });
+	EXPECT_EQ(hierarchy.Update(), 3000u);
+	const uint64 updateAllocations = s_HeapAllocations.load() - before;
+	EXPECT_EQ(updateAllocations, 0u);
+	EXPECT_EQ(hierarchy.GetWorld(2999).GetTranslation().y, 5.f);
+
+	printf("Heap allocations for 3 frames: %llu with std::allocator, %llu with the scratch arena, %llu per transform "
+		   "update\n",
+		   (unsigned long long)heapAllocations, (unsigned long long)arenaAllocations,
+		   (unsigned long long)updateAllocations);
+}
+
+TEST(Pool, GenerationalHandles)
+{
+	Core::Pool<Core::Vector4f> pool;
+	const uint32 a = pool.Create(1.f, 2.f, 3.f, 4.f);
+	const uint32 b = pool.Create(5.f, 6.f, 7.f, 8.f);
+	EXPECT_NE(a, 0u);
+	EXPECT_NE(a, b);
+	EXPECT_EQ(pool.Get(b)->y, 6.f);
+	EXPECT_EQ(pool.GetCount(), 2u);
+
+	// a stale handle neither resolves nor destroys the object that took over its slot
+	EXPECT_TRUE(pool.Destroy(a));
+	EXPECT_FALSE(pool.Destroy(a));
+	const uint32 c = pool.Create(9.f, 9.f, 9.f, 9.f);
+	EXPECT_EQ(Core::HandleLayout<uint32>::GetIndex(c), Core::HandleLayout<uint32>::GetIndex(a));
+	EXPECT_EQ(pool.Get(a), nullptr);
+	EXPECT_FALSE(pool.Destroy(a));
+	EXPECT_EQ(pool.Get(c)->x, 9.f);
+	EXPECT_EQ(pool.Get(0), nullptr);
+
+	// handles from before a clear stay invalid when the slots come back
+	pool.Clear();
+	EXPECT_EQ(pool.GetCount(), 0u);
+	const uint32 d = pool.Create(0.f, 0.f, 0.f, 0.f);
+	EXPECT_FALSE(pool.IsValid(b));
+	EXPECT_FALSE(pool.IsValid(c));
+	EXPECT_TRUE(pool.IsValid(d));
+
+	// 64 bit handles keep 32 bits of generation, the generation wraps around without ever being 0
+	Core::Pool<uint32, uint64> wide;
+	uint64 handle = wide.Create(7u);
+	EXPECT_EQ(Core::HandleLayout<uint64>::GetGeneration(handle), 1u);
+	for(uint32 i = 0; i < 5000; ++i)
+	{
+		wide.Destroy(handle);
+		handle = wide.Create(i);
+	}
+	EXPECT_EQ(Core::HandleLayout<uint64>::GetGeneration(handle), 5001u);
+	EXPECT_EQ(*wide.Get(handle), 4999u);
+
+	Core::Pool<uint8> narrow;
+	uint32 small = narrow.Create((uint8)1);
+	for(uint32 i = 0; i < Core::HandleLayout<uint32>::s_MaxGeneration; ++i)
+	{
+		narrow.Destroy(small);
+		small = narrow.Create((uint8)1);
+	}
+	EXPECT_EQ(Core::HandleLayout<uint32>::GetGeneration(small), 1u);
+}
+
+TEST(Pool, SlabsAndLifetime)
+{
+	static int32 alive = 0;
+	struct Tracked
+	{
+		Tracked(uint32 value)
+			: m_Value(value)
+		{
+			alive++;
+		}
+		~Tracked() { alive--; }
+		uint32 m_Value;
+	};
+
+	std::vector<uint32> handles;
+	std::vector<const Tracked*> addresses;
+	{
+		Core::Pool<Tracked> pool;
+		for(uint32 i = 0; i < 200; ++i)
+		{
+			handles.push_back(pool.Create(i));
+			addresses.push_back(pool.Get(handles.back()));
+		}
+		EXPECT_EQ(alive, 200);
+		EXPECT_EQ(pool.GetCapacity(), 256u);
+
+		// objects stay where they were created and a slab is contiguous
+		EXPECT_EQ(pool.Get(handles[1]), addresses[1]);
+		EXPECT_EQ((const uint8*)addresses[63] - (const uint8*)addresses[0],
+				  (ptrdiff_t)((const uint8*)addresses[1] - (const uint8*)addresses[0]) * 63);
+
+		// the last slot freed is the first one reused
+		for(uint32 i = 0; i < 200; i += 2)
+			pool.Destroy(handles[i]);
+		EXPECT_EQ(alive, 100);
+		EXPECT_EQ(pool.GetCount(), 100u);
+		EXPECT_EQ(pool.Get(pool.Create(1000u)), addresses[198]);
+
+		uint32 sum = 0;
+		pool.ForEach([&](uint32 handle, Tracked& tracked) {
+			EXPECT_TRUE(pool.IsValid(handle));
+			sum += tracked.m_Value;
+		});
+		EXPECT_EQ(sum, 1000u + 100u * 100u);
+		EXPECT_EQ(pool.GetCapacity(), 256u);
+	}
+	EXPECT_EQ(alive, 0);
+}
+
+TEST(MemoryTracker, TagsAndBudget)
+{
+	// the tracker is shared with everything else, GPU handles never collide with the CPU addresses in it
+	Core::MemoryTracker& tracker = Core::MemoryTracker::Get();
+	const Core::MemoryTracker::TagStats before = tracker.GetStats(Core::EMemoryTag_GpuDeviceLocal);
+
+	tracker.OnAllocate((uint64)1, 1000, Core::EMemoryTag_GpuDeviceLocal);
+	tracker.OnAllocate((uint64)2, 3000, Core::EMemoryTag_GpuDeviceLocal);
+	tracker.OnAllocate((uint64)3, 0, Core::EMemoryTag_GpuDeviceLocal);
+	tracker.OnFree((uint64)1);
+	tracker.OnFree((uint64)3);
+	tracker.OnFree((uint64)99);
+
+	Core::MemoryTracker::TagStats stats = tracker.GetStats(Core::EMemoryTag_GpuDeviceLocal);
+	EXPECT_EQ(stats.m_LiveBytes - before.m_LiveBytes, 3000u);
+	EXPECT_EQ(stats.m_LiveCount - before.m_LiveCount, 1u);
+	EXPECT_EQ(stats.m_TotalCount - before.m_TotalCount, 2u);
+	EXPECT_GE(stats.m_PeakBytes, before.m_LiveBytes + 4000u);
+
+	tracker.NewFrame();
+	stats = tracker.GetStats(Core::EMemoryTag_GpuDeviceLocal);
+	EXPECT_EQ(stats.m_FrameCount, 2u);
+	EXPECT_EQ(stats.m_FrameBytes, 4000u);
+	tracker.NewFrame();
+	EXPECT_EQ(tracker.GetStats(Core::EMemoryTag_GpuDeviceLocal).m_FrameCount, 0u);
+
+	tracker.SetBudget(Core::EMemoryTag_GpuDeviceLocal, stats.m_LiveBytes - 1);
+	EXPECT_TRUE(tracker.IsOverBudget(Core::EMemoryTag_GpuDeviceLocal));
+	tracker.OnFree((uint64)2);
+	EXPECT_FALSE(tracker.IsOverBudget(Core::EMemoryTag_GpuDeviceLocal));
+	tracker.SetBudget(Core::EMemoryTag_GpuDeviceLocal, 0);
+
+	EXPECT_EQ(tracker.GetStats(Core::EMemoryTag_GpuDeviceLocal).m_LiveBytes, before.m_LiveBytes);
+	EXPECT_STREQ(Core::MemoryTracker::GetTagName(Core::EMemoryTag_Assets), "Assets");
+}
+
+TEST(MemoryTracker, SnapshotDiff)
+{
+	Core::MemoryTracker& tracker = Core::MemoryTracker::Get();
+	const Core::MemoryTracker::Snapshot before = tracker.TakeSnapshot();
+
+	// a container that is released and one that leaks past the second snapshot
+	{
+		Core::TrackedVector<uint32, Core::EMemoryTag_Graphics> released(256);
+	}
+	Core::TrackedVector<uint32, Core::EMemoryTag_Graphics>* leaked =
+		new Core::TrackedVector<uint32, Core::EMemoryTag_Graphics>(100);
+	Core::GrowingArray<uint32>* array = new Core::GrowingArray<uint32>(16);
+
+	const Core::MemoryTracker::Snapshot diff = Core::MemoryTracker::Diff(before, tracker.TakeSnapshot());
+	EXPECT_EQ(diff.m_LiveBytes[Core::EMemoryTag_Graphics], (int64)(100 * sizeof(uint32)));
+	EXPECT_EQ(diff.m_LiveCount[Core::EMemoryTag_Graphics], 1);
+	EXPECT_EQ(diff.m_LiveCount[Core::EMemoryTag_Core], 1);
+	EXPECT_EQ(diff.m_Sequence, 3u);
+
+	std::vector<Core::MemoryTracker::Allocation> allocations;
+	tracker.GetAllocationsSince(before, &allocations);
+	ASSERT_EQ(allocations.size(), 2u);
+	EXPECT_EQ(allocations[0].m_Id, (uint64)(uintptr_t)leaked->data());
+	EXPECT_EQ(allocations[0].m_Tag, Core::EMemoryTag_Graphics);
+	EXPECT_EQ(allocations[1].m_Tag, Core::EMemoryTag_Core);
+	EXPECT_LT(allocations[0].m_Sequence, allocations[1].m_Sequence);
+
+	delete leaked;
+	delete array;
+	tracker.GetAllocationsSince(before, &allocations);
+	EXPECT_EQ(allocations.size(), 0u);
+}
 
 GTEST_API_ int main(int argc, char** argv)
 {
@@ -12,4 +12,13 @@ project "UnitTest" --project name
             "../external_libs/googletest/lib/Debug/gtest_maind.lib",
             "../external_libs/googletest/lib/Debug/gmockd.lib", 
             "../external_libs/googletest/lib/Debug/gmock_maind.lib" } --libraries to link
-    files { "*.cpp" }
\ No newline at end of file
+    files { "*.cpp",
+            "../graphics/HiZPyramid.cpp",
+            "../graphics/LightClusters.cpp",
+            "../graphics/MeshLod.cpp",
+            "../graphics/NullGraphicsDevice.cpp",
+            "../graphics/OcclusionBuffer.cpp",
+            "../graphics/RenderPacket.cpp",
+            "../graphics/RenderQueue.cpp",
+            "../graphics/ShaderReflection.cpp" } -- the graphics project needs the vulkan sdk, only pull in what is headless
+    includedirs { "$(VULKAN_SDK)/Include/" } -- vulkan_core.h for the reflection types, nothing is linked
\ No newline at end of file